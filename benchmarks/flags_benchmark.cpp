@@ -0,0 +1,83 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <benchmark/benchmark.h>
+#include <dga/flags.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+// Fits in a single word.
+enum class SmallFlag { A, B, C, D, E, F, G, H, _Count };
+// Stored as an array of 64-bit words.
+enum class LargeFlag { _Count = 200 };
+
+template <typename E> constexpr E flagAt(std::size_t i) {
+    return static_cast<E>(i % std::size_t(E::_Count));
+}
+
+template <typename E> void BM_FlagsSetAndTest(benchmark::State& state) {
+    dga::Flags<E> flags;
+    std::size_t i = 0;
+    for (auto _ : state) {
+        flags.set(flagAt<E>(i));
+        benchmark::DoNotOptimize(flags.isSet(flagAt<E>(i * 7 + 3)));
+        flags.reset(flagAt<E>(i * 13 + 5));
+        ++i;
+    }
+    benchmark::DoNotOptimize(flags);
+}
+BENCHMARK_TEMPLATE(BM_FlagsSetAndTest, SmallFlag);
+BENCHMARK_TEMPLATE(BM_FlagsSetAndTest, LargeFlag);
+
+template <typename E> void BM_FlagsBitwise(benchmark::State& state) {
+    dga::Flags<E> a;
+    dga::Flags<E> b;
+    for (std::size_t i = 0; i < std::size_t(E::_Count); i += 3) {
+        a.set(flagAt<E>(i));
+    }
+    for (std::size_t i = 0; i < std::size_t(E::_Count); i += 5) {
+        b.set(flagAt<E>(i));
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a);
+        benchmark::DoNotOptimize(b);
+        dga::Flags<E> c = (a | b) ^ (a & b);
+        benchmark::DoNotOptimize(c.any());
+    }
+}
+BENCHMARK_TEMPLATE(BM_FlagsBitwise, SmallFlag);
+BENCHMARK_TEMPLATE(BM_FlagsBitwise, LargeFlag);
+
+template <typename E> void BM_FlagsCount(benchmark::State& state) {
+    dga::Flags<E> flags;
+    for (std::size_t i = 0; i < std::size_t(E::_Count); i += 2) {
+        flags.set(flagAt<E>(i));
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(flags);
+        benchmark::DoNotOptimize(flags.count());
+    }
+}
+BENCHMARK_TEMPLATE(BM_FlagsCount, SmallFlag);
+BENCHMARK_TEMPLATE(BM_FlagsCount, LargeFlag);
+
+// Iterates over the set flags, with every range(0)th flag set.
+template <typename E> void BM_FlagsIterate(benchmark::State& state) {
+    dga::Flags<E> flags;
+    for (std::size_t i = 0; i < std::size_t(E::_Count); i += std::size_t(state.range(0))) {
+        flags.set(flagAt<E>(i));
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(flags);
+        std::size_t sum = 0;
+        for (E e : flags) {
+            sum += std::size_t(e);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.counters["set"] = double(flags.count());
+}
+BENCHMARK_TEMPLATE(BM_FlagsIterate, SmallFlag)->Arg(1)->Arg(4);
+BENCHMARK_TEMPLATE(BM_FlagsIterate, LargeFlag)->Arg(1)->Arg(4)->Arg(32);
+}  // namespace
@@ -0,0 +1,84 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <benchmark/benchmark.h>
+#include <dga/hash_combine.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+void BM_HashCombine(benchmark::State& state) {
+    const auto count = std::size_t(state.range(0));
+    std::vector<std::uint32_t> values(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        values[i] = std::uint32_t(i);
+    }
+    for (auto _ : state) {
+        std::size_t seed = 0;
+        for (std::uint32_t value : values) {
+            dga::hashCombine(seed, value);
+        }
+        benchmark::DoNotOptimize(seed);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(count));
+}
+BENCHMARK(BM_HashCombine)->Range(1, 1 << 12);
+
+void BM_HashCombineTuple(benchmark::State& state) {
+    const std::string name = "request_latency";
+    std::uint32_t id = 0;
+    for (auto _ : state) {
+        std::size_t seed = 0;
+        dga::hashCombine(seed, id++, name, 3.5, true);
+        benchmark::DoNotOptimize(seed);
+    }
+}
+BENCHMARK(BM_HashCombineTuple);
+
+void BM_HashBytes(benchmark::State& state) {
+    const std::string data(std::size_t(state.range(0)), 'x');
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(dga::hashBytes(data.data(), data.size()));
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data.size()));
+}
+BENCHMARK(BM_HashBytes)->RangeMultiplier(4)->Range(4, 1 << 16);
+
+// Hashes the points of a square grid, which is a poor input for weak hash functions as the
+// coordinates are small and highly correlated, and puts them into 2^range(0) buckets using the low
+// bits of the hash, as FlatHashMap does. There are 4 points per bucket on average. Reports the load
+// of the fullest bucket and the chi-squared statistic of the bucket loads relative to a uniform
+// distribution, which should be close to the number of buckets.
+void BM_HashCombineDistribution(benchmark::State& state) {
+    const std::size_t bucket_count = std::size_t(1) << state.range(0);
+    const std::size_t side = std::size_t(1) << ((state.range(0) + 2) / 2);
+    std::vector<std::size_t> buckets(bucket_count);
+    for (auto _ : state) {
+        std::fill(buckets.begin(), buckets.end(), 0);
+        for (std::size_t x = 0; x < side; ++x) {
+            for (std::size_t y = 0; y < side; ++y) {
+                std::size_t seed = 0;
+                dga::hashCombine(seed, x, y);
+                ++buckets[seed & (bucket_count - 1)];
+            }
+        }
+        benchmark::DoNotOptimize(buckets.data());
+    }
+
+    const double expected = double(side * side) / double(bucket_count);
+    double chi_squared = 0;
+    for (std::size_t load : buckets) {
+        chi_squared += (double(load) - expected) * (double(load) - expected) / expected;
+    }
+    state.counters["max_load"] = double(*std::max_element(buckets.begin(), buckets.end()));
+    state.counters["expected_load"] = expected;
+    state.counters["chi_squared"] = chi_squared;
+    state.counters["buckets"] = double(bucket_count);
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(side * side));
+}
+// Even powers of two only, so that the number of points is a square.
+BENCHMARK(BM_HashCombineDistribution)->DenseRange(10, 16, 2);
+}  // namespace
@@ -0,0 +1,134 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <benchmark/benchmark.h>
+#include <dga/result.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Compares returning an error through a Result with throwing an exception. Each iteration calls a
+ * function that can't be inlined on 1024 inputs, and range(0) is the percentage of calls that
+ * fail. With no failures this measures the cost of the happy path, where exceptions are usually
+ * free and Result pays for a branch and a larger return value.
+ */
+
+namespace {
+enum class ParseFailure { Negative };
+
+struct ParseException {
+    ParseFailure failure;
+};
+
+constexpr std::size_t kInputs = 1024;
+
+std::vector<int> makeInputs(std::int64_t failure_percent) {
+    std::vector<int> inputs(kInputs);
+    for (std::size_t i = 0; i < kInputs; ++i) {
+        inputs[i] = std::int64_t(i % 100) < failure_percent ? -int(i) : int(i);
+    }
+    return inputs;
+}
+
+DGA_NOINLINE dga::Result<int, ParseFailure> checkResult(int value) {
+    if (value < 0) {
+        return dga::Error{ParseFailure::Negative};
+    }
+    return value * 2;
+}
+
+DGA_NOINLINE int checkThrow(int value) {
+    if (value < 0) {
+        throw ParseException{ParseFailure::Negative};
+    }
+    return value * 2;
+}
+
+void BM_ResultReturn(benchmark::State& state) {
+    const std::vector<int> inputs = makeInputs(state.range(0));
+    for (auto _ : state) {
+        int sum = 0;
+        int failures = 0;
+        for (int input : inputs) {
+            auto result = checkResult(input);
+            if (result) {
+                sum += *result;
+            } else {
+                ++failures;
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+        benchmark::DoNotOptimize(failures);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(kInputs));
+}
+BENCHMARK(BM_ResultReturn)->Arg(0)->Arg(1)->Arg(10)->Arg(50);
+
+void BM_ExceptionReturn(benchmark::State& state) {
+    const std::vector<int> inputs = makeInputs(state.range(0));
+    for (auto _ : state) {
+        int sum = 0;
+        int failures = 0;
+        for (int input : inputs) {
+            try {
+                sum += checkThrow(input);
+            } catch (const ParseException&) {
+                ++failures;
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+        benchmark::DoNotOptimize(failures);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(kInputs));
+}
+BENCHMARK(BM_ExceptionReturn)->Arg(0)->Arg(1)->Arg(10)->Arg(50);
+
+// Propagating an error through several frames, as DGA_TRY does in real code.
+DGA_NOINLINE dga::Result<int, ParseFailure> propagateResult(int value, int depth) {
+    if (depth == 0) {
+        return checkResult(value);
+    }
+    DGA_TRY_ASSIGN(int doubled, propagateResult(value, depth - 1));
+    return doubled + 1;
+}
+
+DGA_NOINLINE int propagateThrow(int value, int depth) {
+    if (depth == 0) {
+        return checkThrow(value);
+    }
+    return propagateThrow(value, depth - 1) + 1;
+}
+
+void BM_ResultPropagate(benchmark::State& state) {
+    const std::vector<int> inputs = makeInputs(state.range(0));
+    for (auto _ : state) {
+        int failures = 0;
+        for (int input : inputs) {
+            if (!propagateResult(input, 8)) {
+                ++failures;
+            }
+        }
+        benchmark::DoNotOptimize(failures);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(kInputs));
+}
+BENCHMARK(BM_ResultPropagate)->Arg(0)->Arg(1)->Arg(10)->Arg(50);
+
+void BM_ExceptionPropagate(benchmark::State& state) {
+    const std::vector<int> inputs = makeInputs(state.range(0));
+    for (auto _ : state) {
+        int failures = 0;
+        for (int input : inputs) {
+            try {
+                benchmark::DoNotOptimize(propagateThrow(input, 8));
+            } catch (const ParseException&) {
+                ++failures;
+            }
+        }
+        benchmark::DoNotOptimize(failures);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(kInputs));
+}
+BENCHMARK(BM_ExceptionPropagate)->Arg(0)->Arg(1)->Arg(10)->Arg(50);
+}  // namespace
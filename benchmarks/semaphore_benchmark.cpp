@@ -0,0 +1,77 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <benchmark/benchmark.h>
+#include <dga/barrier.h>
+#include <dga/semaphore.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/*
+ * Hand-off latency of the synchronisation primitives. Ping-pong passes a token back and forth
+ * between two threads, so each iteration is two hand-offs. The contended and barrier benchmarks
+ * run on 1 to kMaxThreads threads at once.
+ */
+
+namespace {
+constexpr int kMaxThreads = 8;
+
+template <typename S> void BM_SemaphorePingPong(benchmark::State& state) {
+    S ping;
+    S pong;
+    std::atomic<bool> done{false};
+    std::thread partner{[&] {
+        while (true) {
+            ping.wait();
+            if (done.load(std::memory_order_relaxed)) {
+                return;
+            }
+            pong.notify();
+        }
+    }};
+    for (auto _ : state) {
+        ping.notify();
+        pong.wait();
+    }
+    done.store(true, std::memory_order_relaxed);
+    ping.notify();
+    partner.join();
+    state.SetItemsProcessed(int64_t(state.iterations()) * 2);
+}
+BENCHMARK_TEMPLATE(BM_SemaphorePingPong, dga::Semaphore)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_SemaphorePingPong, dga::LightweightSemaphore)->UseRealTime();
+
+template <typename S> void BM_SemaphoreContended(benchmark::State& state) {
+    static S semaphore;
+    for (auto _ : state) {
+        semaphore.notify();
+        semaphore.wait();
+    }
+}
+BENCHMARK_TEMPLATE(BM_SemaphoreContended, dga::Semaphore)->ThreadRange(1, kMaxThreads);
+BENCHMARK_TEMPLATE(BM_SemaphoreContended, dga::LightweightSemaphore)->ThreadRange(1, kMaxThreads);
+
+// Returns a barrier for 'threads' threads, which is shared by every thread of a benchmark run.
+template <typename B> B& sharedBarrier(int threads) {
+    static const auto barriers = [] {
+        std::vector<std::unique_ptr<B>> barriers;
+        for (int i = 1; i <= kMaxThreads; ++i) {
+            barriers.emplace_back(std::make_unique<B>(std::size_t(i)));
+        }
+        return barriers;
+    }();
+    return *barriers[std::size_t(threads - 1)];
+}
+
+template <typename B> void BM_Barrier(benchmark::State& state) {
+    B& barrier = sharedBarrier<B>(state.threads());
+    for (auto _ : state) {
+        barrier.wait();
+    }
+}
+BENCHMARK_TEMPLATE(BM_Barrier, dga::Barrier)->ThreadRange(1, kMaxThreads)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Barrier, dga::SpinBarrier<>)->ThreadRange(1, kMaxThreads)->UseRealTime();
+}  // namespace
@@ -0,0 +1,90 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <benchmark/benchmark.h>
+#include <dga/string_algorithms.h>
+
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+// Builds a comma separated string of roughly 'size' bytes, with fields of 1 to 16 characters.
+std::string makeCsvLine(std::size_t size) {
+    std::string line;
+    line.reserve(size + 16);
+    unsigned state = 1;
+    while (line.size() < size) {
+        state = state * 1103515245u + 12345u;
+        line.append(1 + (state >> 16) % 16, char('a' + (state >> 8) % 26));
+        line.push_back(',');
+    }
+    return line;
+}
+
+void BM_StrSplit(benchmark::State& state) {
+    const std::string line = makeCsvLine(std::size_t(state.range(0)));
+    std::vector<std::string_view> tokens;
+    for (auto _ : state) {
+        tokens.clear();
+        dga::strSplit(line, ',', std::back_inserter(tokens));
+        benchmark::DoNotOptimize(tokens.data());
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(line.size()));
+    state.counters["tokens"] = double(tokens.size());
+}
+BENCHMARK(BM_StrSplit)->RangeMultiplier(16)->Range(64, 1 << 20);
+
+void BM_StrSplitAny(benchmark::State& state) {
+    std::string line = makeCsvLine(std::size_t(state.range(0)));
+    for (std::size_t i = 0; i < line.size(); i += 3) {
+        if (line[i] == ',') {
+            line[i] = ';';
+        }
+    }
+    std::vector<std::string_view> tokens;
+    for (auto _ : state) {
+        tokens.clear();
+        dga::strSplitAny(line, ",;", std::back_inserter(tokens));
+        benchmark::DoNotOptimize(tokens.data());
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(line.size()));
+}
+BENCHMARK(BM_StrSplitAny)->RangeMultiplier(16)->Range(64, 1 << 20);
+
+void BM_StrJoin(benchmark::State& state) {
+    const std::string line = makeCsvLine(std::size_t(state.range(0)));
+    std::vector<std::string_view> tokens;
+    dga::strSplit(line, ',', std::back_inserter(tokens));
+    std::string output;
+    for (auto _ : state) {
+        output.clear();
+        dga::strJoin(output, tokens.begin(), tokens.end(), ", ");
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(output.size()));
+}
+BENCHMARK(BM_StrJoin)->RangeMultiplier(16)->Range(64, 1 << 20);
+
+void BM_StrReplaceAll(benchmark::State& state) {
+    const std::string line = makeCsvLine(std::size_t(state.range(0)));
+    for (auto _ : state) {
+        std::string output = dga::strReplaceAll(line, ",", ", ");
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(line.size()));
+}
+BENCHMARK(BM_StrReplaceAll)->RangeMultiplier(16)->Range(64, 1 << 20);
+
+// Replacing a string that never occurs only has to scan the input.
+void BM_StrReplaceAllNoMatch(benchmark::State& state) {
+    const std::string line = makeCsvLine(std::size_t(state.range(0)));
+    for (auto _ : state) {
+        std::string output = dga::strReplaceAll(line, "xyz", "abc");
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(line.size()));
+}
+BENCHMARK(BM_StrReplaceAllNoMatch)->RangeMultiplier(16)->Range(64, 1 << 20);
+}  // namespace
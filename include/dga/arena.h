@@ -0,0 +1,538 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#pragma once
+
+#include "../dga/platform.h"
+#include "../dga/scope.h"
+#include "../dga/small_vector.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ * Allocators for memory with a known lifetime.
+ *
+ * `Arena` is a monotonic bump allocator. Memory is carved out of a chain of chunks by advancing a
+ * pointer, and individual allocations are never freed. Instead, reset() makes the whole arena
+ * available again in O(1), and mark() / rewind() return to an earlier point, freeing everything
+ * allocated since. scopedRewind() returns a ScopeExit that rewinds at the end of the scope:
+ *
+ *     dga::Arena arena;
+ *     void handleRequest(const Request& request) {
+ *         auto rewind = arena.scopedRewind();
+ *         dga::ArenaVector<std::string_view> parts{arena};
+ *         dga::strSplit(request.path, '/', std::back_inserter(parts));
+ *         ...
+ *     }
+ *
+ * Chunks are kept when the arena is reset or rewound, so an arena that's reused for similar work
+ * stops allocating from the heap after the first iteration. Each new chunk is twice the size of
+ * the previous one, up to kMaxChunkSize. Destructors of objects created in an arena are never
+ * called, so they should either be trivially destructible, or only own memory in the same arena.
+ * An Arena is not thread-safe.
+ *
+ * `ArenaAllocator<T>` adapts an Arena to the standard allocator interface, for use with standard
+ * containers (ArenaVector and ArenaString), SmallVector (ArenaSmallVector), FlatHashMap and
+ * Result. Like std::pmr, the allocator doesn't propagate when a container is copied, moved or
+ * swapped, so elements moved between containers in different arenas are moved one at a time.
+ * Deallocating the most recent allocation gives the memory back to the arena, but a growing
+ * std::vector allocates its new buffer before it frees the old one, so the old buffers are wasted
+ * until the arena is reset or rewound. For example, 64 push_backs into an ArenaVector<int> use 508
+ * bytes of the arena (4 + 8 + ... + 256), rather than 256. Call reserve() up front when the final
+ * size is known.
+ *
+ * `Pool<T>` allocates fixed size blocks for objects of type T. Each thread caches a free list of
+ * blocks, so allocating and freeing is a few instructions with no synchronisation. When a thread's
+ * cache is empty or too large, a batch of blocks is moved from or to a free list shared by all
+ * threads, which is protected by a mutex. Objects can be freed on a different thread to the one
+ * that allocated them. There is one pool per type, and its memory is reused but never returned to
+ * the system. `PoolAllocator<T>` allocates single objects from the pool, which suits node-based
+ * containers such as std::list and std::map.
+ */
+
+namespace dga {
+namespace detail {
+[[noreturn]] DGA_COLD DGA_NOINLINE inline void arenaAllocationTooLarge() {
+#ifdef DGA_NO_EXCEPTIONS
+    fatalError("Arena: allocation is too large");
+#else
+    throw std::bad_array_new_length{};
+#endif
+}
+}  // namespace detail
+
+class Arena {
+public:
+    static constexpr std::size_t kDefaultChunkSize = 4096;
+    static constexpr std::size_t kMinChunkSize = 64;
+    static constexpr std::size_t kMaxChunkSize = std::size_t(1) << 20;
+
+    // A position in the arena, returned by mark().
+    class Marker {
+    public:
+        Marker() noexcept = default;
+
+    private:
+        void* chunk_ = nullptr;
+        char* position_ = nullptr;
+
+        Marker(void* chunk, char* position) noexcept : chunk_(chunk), position_(position) {
+        }
+
+        friend class Arena;
+    };
+
+    // Creates an arena whose first chunk has 'initial_chunk_size' bytes, or kMinChunkSize if that is
+    // larger.
+    explicit Arena(std::size_t initial_chunk_size = kDefaultChunkSize) noexcept;
+    ~Arena();
+
+    // Allocators keep a pointer to the arena, so it can't be copied or moved.
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Allocates 'size' bytes aligned to 'alignment', which must be a power of two.
+    void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t));
+
+    // Frees memory if it's the most recent allocation, otherwise does nothing.
+    void deallocate(void* p, std::size_t size) noexcept;
+
+    // Allocates an uninitialised array of 'count' objects of type T.
+    template <typename T> T* allocateArray(std::size_t count);
+
+    // Creates an object in the arena. Its destructor is never called.
+    template <typename T, typename... Args> T* create(Args&&... args);
+
+    // Frees every allocation, but keeps the chunks for reuse.
+    void reset() noexcept;
+
+    // Frees every allocation, and returns all chunks to the system.
+    void release() noexcept;
+
+    // Returns the current position, which can be passed to rewind() to free everything that's
+    // allocated after it.
+    Marker mark() const noexcept;
+    void rewind(Marker marker) noexcept;
+
+    // Returns a scope guard that rewinds the arena to the current position when destroyed.
+    auto scopedRewind() noexcept {
+        return ScopeExit{[this, marker = mark()]() noexcept { rewind(marker); }};
+    }
+
+    // Returns the number of bytes allocated from the arena since the last reset, including
+    // alignment padding and space left unused at the end of chunks.
+    std::size_t bytesUsed() const noexcept;
+
+    // Returns the total size of all chunks owned by the arena.
+    std::size_t capacity() const noexcept;
+
+private:
+    struct alignas(std::max_align_t) Chunk {
+        Chunk* next;
+        std::size_t size;
+
+        char* begin() noexcept {
+            return reinterpret_cast<char*>(this + 1);
+        }
+
+        char* end() noexcept {
+            return begin() + size;
+        }
+    };
+
+    Chunk* first_;
+    Chunk* current_;
+    char* position_;
+    char* end_;
+    std::size_t next_chunk_size_;
+    // The total size of the chunks before current_.
+    std::size_t used_before_current_;
+
+    static char* alignUp(char* p, std::size_t alignment) noexcept {
+        const auto address = reinterpret_cast<std::uintptr_t>(p);
+        return p + (((address + alignment - 1) & ~(alignment - 1)) - address);
+    }
+
+    void* allocateSlow(std::size_t size, std::size_t alignment);
+    void makeCurrent(Chunk* chunk) noexcept;
+};
+
+template <typename T> class ArenaAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::false_type;
+    using propagate_on_container_swap = std::false_type;
+    using is_always_equal = std::false_type;
+
+    ArenaAllocator(Arena& arena) noexcept : arena_(&arena) {
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena_) {
+    }
+
+    T* allocate(std::size_t n) {
+        return arena_->allocateArray<T>(n);
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        arena_->deallocate(p, n * sizeof(T));
+    }
+
+    Arena& arena() const noexcept {
+        return *arena_;
+    }
+
+    template <typename U> bool operator==(const ArenaAllocator<U>& other) const noexcept {
+        return arena_ == other.arena_;
+    }
+
+    template <typename U> bool operator!=(const ArenaAllocator<U>& other) const noexcept {
+        return arena_ != other.arena_;
+    }
+
+private:
+    Arena* arena_;
+
+    template <typename U> friend class ArenaAllocator;
+};
+
+template <typename T> using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+template <typename T, std::size_t N> using ArenaSmallVector = SmallVector<T, N, ArenaAllocator<T>>;
+using ArenaString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+
+inline Arena::Arena(std::size_t initial_chunk_size) noexcept
+    : first_(nullptr),
+      current_(nullptr),
+      position_(nullptr),
+      end_(nullptr),
+      next_chunk_size_(std::max(initial_chunk_size, kMinChunkSize)),
+      used_before_current_(0) {
+}
+
+inline Arena::~Arena() {
+    release();
+}
+
+inline void* Arena::allocate(std::size_t size, std::size_t alignment) {
+    char* p = alignUp(position_, alignment);
+    // Compare sizes rather than pointers, so that a huge size can't overflow.
+    if (DGA_LIKELY(position_ != nullptr && p <= end_ && size <= std::size_t(end_ - p))) {
+        position_ = p + size;
+        return p;
+    }
+    return allocateSlow(size, alignment);
+}
+
+inline void Arena::deallocate(void* p, std::size_t size) noexcept {
+    if (static_cast<char*>(p) + size == position_) {
+        position_ = static_cast<char*>(p);
+    }
+}
+
+template <typename T> T* Arena::allocateArray(std::size_t count) {
+    if (DGA_UNLIKELY(count > std::size_t(-1) / sizeof(T))) {
+        detail::arenaAllocationTooLarge();
+    }
+    return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+}
+
+template <typename T, typename... Args> T* Arena::create(Args&&... args) {
+    return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+}
+
+inline void Arena::reset() noexcept {
+    if (first_) {
+        used_before_current_ = 0;
+        makeCurrent(first_);
+    }
+}
+
+inline void Arena::release() noexcept {
+    Chunk* chunk = first_;
+    while (chunk) {
+        Chunk* next = chunk->next;
+        ::operator delete(chunk);
+        chunk = next;
+    }
+    first_ = current_ = nullptr;
+    position_ = end_ = nullptr;
+    used_before_current_ = 0;
+}
+
+inline Arena::Marker Arena::mark() const noexcept {
+    return Marker{current_, position_};
+}
+
+inline void Arena::rewind(Marker marker) noexcept {
+    if (!marker.chunk_) {
+        // The marker was taken before anything was allocated.
+        reset();
+        return;
+    }
+    auto* chunk = static_cast<Chunk*>(marker.chunk_);
+    if (chunk != current_) {
+        used_before_current_ = 0;
+        for (Chunk* c = first_; c != chunk; c = c->next) {
+            used_before_current_ += c->size;
+        }
+        makeCurrent(chunk);
+    }
+    position_ = marker.position_;
+}
+
+inline std::size_t Arena::bytesUsed() const noexcept {
+    return current_ ? used_before_current_ + std::size_t(position_ - current_->begin()) : 0;
+}
+
+inline std::size_t Arena::capacity() const noexcept {
+    std::size_t total = 0;
+    for (Chunk* c = first_; c; c = c->next) {
+        total += c->size;
+    }
+    return total;
+}
+
+inline void* Arena::allocateSlow(std::size_t size, std::size_t alignment) {
+    // Move on to a chunk kept from before a reset or rewind, as long as the allocation fits.
+    while (current_ && current_->next) {
+        used_before_current_ += current_->size;
+        makeCurrent(current_->next);
+        char* p = alignUp(position_, alignment);
+        if (p <= end_ && size <= std::size_t(end_ - p)) {
+            position_ = p + size;
+            return p;
+        }
+    }
+
+    // Allocate a new chunk at the end of the chain. Chunk memory is aligned to at least
+    // alignof(std::max_align_t), so only larger alignments need extra space.
+    const std::size_t padding = alignment > alignof(std::max_align_t) ? alignment : 0;
+    if (size > std::size_t(-1) / 4 - padding - sizeof(Chunk)) {
+        detail::arenaAllocationTooLarge();
+    }
+    std::size_t chunk_size = next_chunk_size_;
+    while (chunk_size < size + padding) {
+        chunk_size *= 2;
+    }
+    auto* chunk = static_cast<Chunk*>(::operator new(sizeof(Chunk) + chunk_size));
+    chunk->next = nullptr;
+    chunk->size = chunk_size;
+    if (current_) {
+        used_before_current_ += current_->size;
+        current_->next = chunk;
+    } else {
+        first_ = chunk;
+    }
+    if (next_chunk_size_ < kMaxChunkSize) {
+        next_chunk_size_ *= 2;
+    }
+    makeCurrent(chunk);
+
+    char* p = alignUp(position_, alignment);
+    position_ = p + size;
+    return p;
+}
+
+inline void Arena::makeCurrent(Chunk* chunk) noexcept {
+    current_ = chunk;
+    position_ = chunk->begin();
+    end_ = chunk->end();
+}
+
+namespace detail {
+template <typename T> class PoolState {
+public:
+    union Node {
+        Node* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    // The number of nodes moved between a thread's cache and the shared free list at a time.
+    static constexpr std::size_t kBatchSize =
+        sizeof(Node) >= 1024 ? 8 : std::size_t(16384) / sizeof(Node);
+
+    static Node* allocate() {
+        ThreadCache& cache = threadCache();
+        if (DGA_UNLIKELY(!cache.head)) {
+            refill(cache);
+        }
+        Node* node = cache.head;
+        cache.head = node->next;
+        --cache.count;
+        return node;
+    }
+
+    static void deallocate(Node* node) noexcept {
+        ThreadCache& cache = threadCache();
+        node->next = cache.head;
+        cache.head = node;
+        if (DGA_UNLIKELY(++cache.count > 2 * kBatchSize)) {
+            flush(cache, kBatchSize);
+        }
+    }
+
+    // Returns the number of free nodes in the calling thread's cache.
+    static std::size_t cachedCount() noexcept {
+        return threadCache().count;
+    }
+
+private:
+    struct ThreadCache {
+        Node* head = nullptr;
+        std::size_t count = 0;
+
+        ~ThreadCache() {
+            if (count > 0) {
+                flush(*this, count);
+            }
+        }
+    };
+
+    struct Shared {
+        std::mutex mutex;
+        Node* head = nullptr;
+        std::size_t count = 0;
+    };
+
+    static ThreadCache& threadCache() noexcept {
+        static thread_local ThreadCache cache;
+        return cache;
+    }
+
+    // Never destroyed, so that threads exiting during shutdown can still return their nodes.
+    static Shared& shared() noexcept {
+        static Shared* shared = new Shared;
+        return *shared;
+    }
+
+    DGA_NOINLINE static void refill(ThreadCache& cache) {
+        Shared& s = shared();
+        {
+            std::lock_guard<std::mutex> lock{s.mutex};
+            if (s.head) {
+                Node* last = s.head;
+                std::size_t taken = 1;
+                while (taken < kBatchSize && last->next) {
+                    last = last->next;
+                    ++taken;
+                }
+                cache.head = s.head;
+                s.head = last->next;
+                last->next = nullptr;
+                s.count -= taken;
+                cache.count = taken;
+                return;
+            }
+        }
+
+        // The shared list is empty, so carve a new block of nodes. Blocks are owned by the free
+        // lists from now on.
+        auto* block = static_cast<Node*>(
+            ::operator new(sizeof(Node) * kBatchSize, std::align_val_t{alignof(Node)}));
+        for (std::size_t i = 0; i + 1 < kBatchSize; ++i) {
+            block[i].next = &block[i + 1];
+        }
+        block[kBatchSize - 1].next = nullptr;
+        cache.head = block;
+        cache.count = kBatchSize;
+    }
+
+    DGA_NOINLINE static void flush(ThreadCache& cache, std::size_t count) noexcept {
+        Node* first = cache.head;
+        Node* last = first;
+        for (std::size_t i = 1; i < count; ++i) {
+            last = last->next;
+        }
+        cache.head = last->next;
+        cache.count -= count;
+
+        Shared& s = shared();
+        std::lock_guard<std::mutex> lock{s.mutex};
+        last->next = s.head;
+        s.head = first;
+        s.count += count;
+    }
+};
+}  // namespace detail
+
+template <typename T> class Pool {
+public:
+    Pool() = delete;
+
+    // The size and alignment of each block, which is large enough to hold a T.
+    static constexpr std::size_t block_size = sizeof(typename detail::PoolState<T>::Node);
+    static constexpr std::size_t block_alignment = alignof(typename detail::PoolState<T>::Node);
+
+    // Allocates uninitialised memory for one T.
+    static void* allocate() {
+        return detail::PoolState<T>::allocate();
+    }
+
+    // Frees memory returned by allocate().
+    static void deallocate(void* p) noexcept {
+        detail::PoolState<T>::deallocate(static_cast<typename detail::PoolState<T>::Node*>(p));
+    }
+
+    template <typename... Args> static T* create(Args&&... args) {
+        void* p = allocate();
+        ScopeFail free_on_failure{[p]() noexcept { deallocate(p); }};
+        return new (p) T(std::forward<Args>(args)...);
+    }
+
+    static void destroy(T* object) noexcept {
+        if (object) {
+            object->~T();
+            deallocate(object);
+        }
+    }
+
+    // Returns the number of free blocks cached by the calling thread.
+    static std::size_t threadCacheSize() noexcept {
+        return detail::PoolState<T>::cachedCount();
+    }
+};
+
+template <typename T> class PoolAllocator {
+public:
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    PoolAllocator() noexcept = default;
+
+    template <typename U> PoolAllocator(const PoolAllocator<U>&) noexcept {
+    }
+
+    T* allocate(std::size_t n) {
+        if (n == 1) {
+            return static_cast<T*>(Pool<T>::allocate());
+        }
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        if (n == 1) {
+            Pool<T>::deallocate(p);
+        } else {
+            std::allocator<T>{}.deallocate(p, n);
+        }
+    }
+
+    template <typename U> bool operator==(const PoolAllocator<U>&) const noexcept {
+        return true;
+    }
+
+    template <typename U> bool operator!=(const PoolAllocator<U>&) const noexcept {
+        return false;
+    }
+};
+}  // namespace dga
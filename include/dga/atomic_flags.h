@@ -0,0 +1,164 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#pragma once
+
+#include "../dga/aliases.h"
+#include "../dga/flags.h"
+#include "../dga/futex.h"
+
+#include <atomic>
+
+/*
+ * A Flags<EnumType> that can be modified concurrently from multiple threads without a lock.
+ *
+ * set, reset and toggle are a single fetch_or, fetch_and or fetch_xor on the underlying mask, and
+ * return the flags as they were before the operation. Every operation takes an optional memory
+ * order, which defaults to std::memory_order_seq_cst like std::atomic.
+ *
+ * wait(old) blocks until the flags are different from 'old', similar to C++20's
+ * std::atomic::wait. As with std::atomic, a thread that modifies the flags must call notify_one or
+ * notify_all to wake waiting threads. The mask can be any width, so waiting is implemented with a
+ * separate 32-bit epoch which notify increments before waking the futex. notify doesn't make a
+ * syscall if no threads are waiting.
+ *
+ * Only flags that fit in a single word are supported, as the whole set has to be updated
+ * atomically.
+ */
+
+namespace dga {
+template <typename EnumType> class AtomicFlags {
+public:
+    using flags_type = Flags<EnumType>;
+    using mask_type = typename flags_type::mask_type;
+
+    static_assert(flags_type::word_count == 1,
+                  "AtomicFlags only supports flags that fit into the enum's underlying type.");
+
+    static constexpr bool is_always_lock_free = std::atomic<mask_type>::is_always_lock_free;
+
+    constexpr AtomicFlags() noexcept : mask_(0), epoch_(0), waiters_(0) {
+    }
+
+    constexpr explicit AtomicFlags(flags_type flags) noexcept
+        : mask_(flags.value()), epoch_(0), waiters_(0) {
+    }
+
+    AtomicFlags(const AtomicFlags&) = delete;
+    AtomicFlags& operator=(const AtomicFlags&) = delete;
+
+    flags_type load(std::memory_order order = std::memory_order_seq_cst) const noexcept {
+        return flags_type(mask_.load(order));
+    }
+
+    void store(flags_type flags, std::memory_order order = std::memory_order_seq_cst) noexcept {
+        mask_.store(flags.value(), order);
+    }
+
+    // Replaces the flags, and returns the previous flags.
+    flags_type exchange(flags_type flags,
+                        std::memory_order order = std::memory_order_seq_cst) noexcept {
+        return flags_type(mask_.exchange(flags.value(), order));
+    }
+
+    bool compare_exchange_weak(flags_type& expected, flags_type desired,
+                               std::memory_order order = std::memory_order_seq_cst) noexcept {
+        mask_type expected_mask = expected.value();
+        const bool exchanged = mask_.compare_exchange_weak(expected_mask, desired.value(), order);
+        expected = flags_type(expected_mask);
+        return exchanged;
+    }
+
+    bool compare_exchange_strong(flags_type& expected, flags_type desired,
+                                 std::memory_order order = std::memory_order_seq_cst) noexcept {
+        mask_type expected_mask = expected.value();
+        const bool exchanged = mask_.compare_exchange_strong(expected_mask, desired.value(), order);
+        expected = flags_type(expected_mask);
+        return exchanged;
+    }
+
+    // Sets, resets or toggles flags, and returns the previous flags.
+    flags_type set(flags_type flags, std::memory_order order = std::memory_order_seq_cst) noexcept {
+        return flags_type(mask_.fetch_or(flags.value(), order));
+    }
+
+    flags_type set(EnumType e, std::memory_order order = std::memory_order_seq_cst) noexcept {
+        return set(flags_type(e), order);
+    }
+
+    flags_type reset(flags_type flags,
+                     std::memory_order order = std::memory_order_seq_cst) noexcept {
+        return flags_type(mask_.fetch_and(mask_type(~flags.value()), order));
+    }
+
+    flags_type reset(EnumType e, std::memory_order order = std::memory_order_seq_cst) noexcept {
+        return reset(flags_type(e), order);
+    }
+
+    flags_type toggle(flags_type flags,
+                      std::memory_order order = std::memory_order_seq_cst) noexcept {
+        return flags_type(mask_.fetch_xor(flags.value(), order));
+    }
+
+    flags_type toggle(EnumType e, std::memory_order order = std::memory_order_seq_cst) noexcept {
+        return toggle(flags_type(e), order);
+    }
+
+    // Sets or resets a flag, and returns true if it was previously set.
+    bool test_and_set(EnumType e, std::memory_order order = std::memory_order_seq_cst) noexcept {
+        return set(e, order).isSet(e);
+    }
+
+    bool test_and_reset(EnumType e, std::memory_order order = std::memory_order_seq_cst) noexcept {
+        return reset(e, order).isSet(e);
+    }
+
+    bool isSet(EnumType e, std::memory_order order = std::memory_order_seq_cst) const noexcept {
+        return load(order).isSet(e);
+    }
+
+    // Blocks until the flags are no longer equal to 'old'. Returns immediately if they already
+    // differ. 'order' is used when loading the flags.
+    void wait(flags_type old, std::memory_order order = std::memory_order_seq_cst) const noexcept;
+
+    // Wakes one or all threads blocked in wait.
+    void notify_one() noexcept;
+    void notify_all() noexcept;
+
+private:
+    std::atomic<mask_type> mask_;
+    mutable std::atomic<u32> epoch_;
+    mutable std::atomic<u32> waiters_;
+};
+
+template <typename EnumType>
+void AtomicFlags<EnumType>::wait(flags_type old, std::memory_order order) const noexcept {
+    if (load(order) != old) {
+        return;
+    }
+    waiters_.fetch_add(1, std::memory_order_seq_cst);
+    while (true) {
+        // Read the epoch before checking the flags, so that a notify after the check changes the
+        // epoch and futexWait returns immediately.
+        const u32 epoch = epoch_.load(std::memory_order_seq_cst);
+        if (load(order) != old) {
+            break;
+        }
+        futexWait(epoch_, epoch);
+    }
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+template <typename EnumType> void AtomicFlags<EnumType>::notify_one() noexcept {
+    epoch_.fetch_add(1, std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_seq_cst) != 0) {
+        futexWakeOne(epoch_);
+    }
+}
+
+template <typename EnumType> void AtomicFlags<EnumType>::notify_all() noexcept {
+    epoch_.fetch_add(1, std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_seq_cst) != 0) {
+        futexWakeAll(epoch_);
+    }
+}
+}  // namespace dga
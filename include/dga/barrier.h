@@ -2,11 +2,29 @@
  * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
 #pragma once
 
+#include "../dga/aliases.h"
+#include "../dga/futex.h"
+#include "../dga/platform.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
 #include <mutex>
 #include <condition_variable>
+#include <memory>
+#include <utility>
 
 /*
  * Thread barrier. Based almost entirely on https://stackoverflow.com/a/27118537
+ *
+ * SpinBarrier is a sense-reversing barrier for short phases. Arriving threads decrement an atomic
+ * counter, then spin on a generation word (the "sense", which flips to a new value every phase)
+ * for a configurable number of iterations before blocking on it with a futex. The last thread to
+ * arrive runs an optional completion function, similar to std::barrier, then releases the others.
+ *
+ * TreeBarrier has the same semantics, but threads arrive at the leaves of a combining tree, so
+ * that no single counter is contended by every thread. This scales better with many threads, and
+ * across sockets. Each thread must pass its own index in [0, count) to wait().
  */
 
 namespace dga {
@@ -38,4 +56,177 @@ inline void Barrier::wait() {
         cv_.wait(lock, [this, current_generation] { return current_generation != generation_; });
     }
 }
-}  // namespace dga
\ No newline at end of file
+
+namespace detail {
+struct NoCompletion {
+    void operator()() noexcept {
+    }
+};
+
+// The generation word that threads wait on to be released from a barrier.
+class BarrierGeneration {
+public:
+    u32 current() const noexcept {
+        return generation_.load(std::memory_order_acquire);
+    }
+
+    // Waits until the generation is no longer 'generation'.
+    void wait(u32 generation, int spin_count) noexcept {
+        for (int i = 0; i < spin_count; ++i) {
+            if (generation_.load(std::memory_order_acquire) != generation) {
+                return;
+            }
+            cpuRelax();
+        }
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        while (generation_.load(std::memory_order_acquire) == generation) {
+            futexWait(generation_, generation);
+        }
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Advances the generation, releasing all waiting threads.
+    void release(u32 generation) noexcept {
+        generation_.store(generation + 1, std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_seq_cst) != 0) {
+            futexWakeAll(generation_);
+        }
+    }
+
+private:
+    alignas(kCacheLineSize) std::atomic<u32> generation_{0};
+    std::atomic<u32> sleepers_{0};
+};
+}  // namespace detail
+
+template <typename CompletionFunction = detail::NoCompletion> class SpinBarrier {
+public:
+    static constexpr int kDefaultSpinCount = 4096;
+
+    explicit SpinBarrier(std::size_t count, CompletionFunction completion = CompletionFunction{},
+                         int spin_count = kDefaultSpinCount);
+    SpinBarrier(const SpinBarrier&) = delete;
+    SpinBarrier& operator=(const SpinBarrier&) = delete;
+
+    void wait();
+
+private:
+    alignas(kCacheLineSize) std::atomic<u32> remaining_;
+    u32 threshold_;
+    int spin_count_;
+    CompletionFunction completion_;
+    detail::BarrierGeneration generation_;
+};
+
+template <typename CompletionFunction>
+SpinBarrier<CompletionFunction>::SpinBarrier(std::size_t count, CompletionFunction completion,
+                                             int spin_count)
+    : remaining_(static_cast<u32>(count)),
+      threshold_(static_cast<u32>(count)),
+      spin_count_(spin_count),
+      completion_(std::move(completion)) {
+    assert(count > 0);
+}
+
+template <typename CompletionFunction> void SpinBarrier<CompletionFunction>::wait() {
+    // The generation can't advance until this thread has arrived, so it's safe to read first.
+    const u32 generation = generation_.current();
+    if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        remaining_.store(threshold_, std::memory_order_relaxed);
+        completion_();
+        generation_.release(generation);
+    } else {
+        generation_.wait(generation, spin_count_);
+    }
+}
+
+template <typename CompletionFunction = detail::NoCompletion> class TreeBarrier {
+public:
+    static constexpr int kDefaultSpinCount = 4096;
+    static constexpr std::size_t kDefaultFanIn = 4;
+
+    explicit TreeBarrier(std::size_t count, CompletionFunction completion = CompletionFunction{},
+                         std::size_t fan_in = kDefaultFanIn, int spin_count = kDefaultSpinCount);
+    TreeBarrier(const TreeBarrier&) = delete;
+    TreeBarrier& operator=(const TreeBarrier&) = delete;
+
+    // Arrives at the barrier as thread 'thread_index', which must be in [0, count) and unique
+    // among the threads using the barrier.
+    void wait(std::size_t thread_index);
+
+private:
+    // Each node is on its own cache line, so threads arriving at different nodes don't contend.
+    struct alignas(kCacheLineSize) Node {
+        std::atomic<u32> remaining;
+        u32 threshold;
+        // Index of the parent node, or kRoot.
+        u32 parent;
+    };
+
+    static constexpr u32 kRoot = ~u32(0);
+
+    std::unique_ptr<Node[]> nodes_;
+    std::size_t fan_in_;
+    int spin_count_;
+    CompletionFunction completion_;
+    detail::BarrierGeneration generation_;
+};
+
+template <typename CompletionFunction>
+TreeBarrier<CompletionFunction>::TreeBarrier(std::size_t count, CompletionFunction completion,
+                                             std::size_t fan_in, int spin_count)
+    : fan_in_(fan_in), spin_count_(spin_count), completion_(std::move(completion)) {
+    assert(count > 0);
+    assert(fan_in > 1);
+
+    // Count the nodes in the tree. The leaf level has one node per 'fan_in' threads, and each level
+    // above has one node per 'fan_in' nodes below it.
+    std::size_t node_count = 0;
+    for (std::size_t width = count; width > 1 || node_count == 0;) {
+        width = (width + fan_in - 1) / fan_in;
+        node_count += width;
+    }
+    nodes_ = std::make_unique<Node[]>(node_count);
+
+    // Link the levels together, starting from the leaves.
+    std::size_t children = count;
+    std::size_t level_begin = 0;
+    while (true) {
+        const std::size_t width = (children + fan_in - 1) / fan_in;
+        const std::size_t next_level_begin = level_begin + width;
+        for (std::size_t i = 0; i < width; ++i) {
+            Node& node = nodes_[level_begin + i];
+            node.threshold = static_cast<u32>(std::min(fan_in, children - i * fan_in));
+            node.remaining.store(node.threshold, std::memory_order_relaxed);
+            node.parent = width == 1 ? kRoot : static_cast<u32>(next_level_begin + i / fan_in);
+        }
+        if (width == 1) {
+            break;
+        }
+        children = width;
+        level_begin = next_level_begin;
+    }
+}
+
+template <typename CompletionFunction>
+void TreeBarrier<CompletionFunction>::wait(std::size_t thread_index) {
+    const u32 generation = generation_.current();
+    u32 index = static_cast<u32>(thread_index / fan_in_);
+    while (true) {
+        Node& node = nodes_[index];
+        if (node.remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            // Not the last to arrive at this node, so wait for the whole barrier.
+            generation_.wait(generation, spin_count_);
+            return;
+        }
+        // Last to arrive at this node. Reset it for the next phase, and carry on up the tree.
+        node.remaining.store(node.threshold, std::memory_order_relaxed);
+        if (node.parent == kRoot) {
+            break;
+        }
+        index = node.parent;
+    }
+    completion_();
+    generation_.release(generation);
+}
+}  // namespace dga
@@ -0,0 +1,105 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#pragma once
+
+#include "../dga/platform.h"
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#if defined(DGA_MSVC)
+#include <intrin.h>
+#endif
+
+// A subset of the bit manipulation functions from <bit>, backported from C++20. Only unsigned
+// integer types are supported, matching the standard.
+
+namespace dga {
+/// Returns the number of consecutive 0 bits, starting from the least significant bit.
+template <typename T> inline int countr_zero(T x) noexcept {
+    static_assert(std::is_unsigned_v<T>, "T must be an unsigned integer type.");
+    constexpr int digits = std::numeric_limits<T>::digits;
+    if (x == 0) {
+        return digits;
+    }
+#if defined(DGA_GCC) || defined(DGA_CLANG)
+    if constexpr (digits <= std::numeric_limits<unsigned int>::digits) {
+        return __builtin_ctz(x);
+    } else {
+        return __builtin_ctzll(x);
+    }
+#elif defined(DGA_MSVC) && defined(DGA_ARCH_64)
+    unsigned long index;
+    _BitScanForward64(&index, static_cast<unsigned __int64>(x));
+    return static_cast<int>(index);
+#else
+    int count = 0;
+    while ((x & T(1)) == 0) {
+        x >>= 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+/// Returns the number of consecutive 0 bits, starting from the most significant bit.
+template <typename T> inline int countl_zero(T x) noexcept {
+    static_assert(std::is_unsigned_v<T>, "T must be an unsigned integer type.");
+    constexpr int digits = std::numeric_limits<T>::digits;
+    if (x == 0) {
+        return digits;
+    }
+#if defined(DGA_GCC) || defined(DGA_CLANG)
+    if constexpr (digits <= std::numeric_limits<unsigned int>::digits) {
+        return __builtin_clz(x) - (std::numeric_limits<unsigned int>::digits - digits);
+    } else {
+        return __builtin_clzll(x) - (std::numeric_limits<unsigned long long>::digits - digits);
+    }
+#elif defined(DGA_MSVC) && defined(DGA_ARCH_64)
+    unsigned long index;
+    _BitScanReverse64(&index, static_cast<unsigned __int64>(x));
+    return static_cast<int>(63 - index) - (64 - digits);
+#else
+    int count = 0;
+    for (T bit = T(T(1) << (digits - 1)); (x & bit) == 0; bit >>= 1) {
+        ++count;
+    }
+    return count;
+#endif
+}
+
+/// Returns the number of 1 bits.
+template <typename T> inline int popcount(T x) noexcept {
+    static_assert(std::is_unsigned_v<T>, "T must be an unsigned integer type.");
+#if defined(DGA_GCC) || defined(DGA_CLANG)
+    if constexpr (std::numeric_limits<T>::digits <= std::numeric_limits<unsigned int>::digits) {
+        return __builtin_popcount(x);
+    } else {
+        return __builtin_popcountll(x);
+    }
+#else
+    int count = 0;
+    while (x != 0) {
+        x &= T(x - 1);
+        ++count;
+    }
+    return count;
+#endif
+}
+
+/// Returns true if 'x' is an integral power of two.
+template <typename T> constexpr bool has_single_bit(T x) noexcept {
+    static_assert(std::is_unsigned_v<T>, "T must be an unsigned integer type.");
+    return x != 0 && (x & (x - 1)) == 0;
+}
+
+/// Returns the smallest integral power of two that is not smaller than 'x'.
+template <typename T> inline T bit_ceil(T x) noexcept {
+    static_assert(std::is_unsigned_v<T>, "T must be an unsigned integer type.");
+    if (x <= 1) {
+        return T(1);
+    }
+    return T(T(1) << (std::numeric_limits<T>::digits - countl_zero(T(x - 1))));
+}
+}  // namespace dga
@@ -0,0 +1,74 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#pragma once
+
+#include "../dga/platform.h"
+
+#include <type_traits>
+#include <utility>
+
+/*
+ * CachePadded<T> holds a T aligned to, and padded out to a multiple of, kCacheLineSize. Placing
+ * values that are written by different threads in separate CachePadded wrappers keeps them on
+ * different cache lines, so a write by one thread doesn't invalidate the line that another thread
+ * is using (false sharing):
+ *
+ *     struct Stats {
+ *         dga::CachePadded<std::atomic<u64>> produced;
+ *         dga::CachePadded<std::atomic<u64>> consumed;
+ *     };
+ *
+ * The value is accessed with get(), * or ->. A default constructed CachePadded value initialises
+ * the T, so atomics and other scalars start at zero.
+ */
+
+namespace dga {
+template <typename T> class alignas(kCacheLineSize) CachePadded {
+public:
+    using value_type = T;
+
+    constexpr CachePadded() noexcept(std::is_nothrow_default_constructible_v<T>) : value_() {
+    }
+
+    template <typename U = T,
+              std::enable_if_t<std::is_constructible_v<T, U&&> &&
+                               !std::is_same_v<std::decay_t<U>, CachePadded> &&
+                               !std::is_same_v<std::decay_t<U>, std::in_place_t>>* = nullptr>
+    constexpr CachePadded(U&& value) noexcept(std::is_nothrow_constructible_v<T, U&&>)
+        : value_(std::forward<U>(value)) {
+    }
+
+    template <typename... Args>
+    constexpr explicit CachePadded(std::in_place_t, Args&&... args) noexcept(
+        std::is_nothrow_constructible_v<T, Args&&...>)
+        : value_(std::forward<Args>(args)...) {
+    }
+
+    constexpr T& get() noexcept {
+        return value_;
+    }
+
+    constexpr const T& get() const noexcept {
+        return value_;
+    }
+
+    constexpr T& operator*() noexcept {
+        return value_;
+    }
+
+    constexpr const T& operator*() const noexcept {
+        return value_;
+    }
+
+    constexpr T* operator->() noexcept {
+        return &value_;
+    }
+
+    constexpr const T* operator->() const noexcept {
+        return &value_;
+    }
+
+private:
+    T value_;
+};
+}  // namespace dga
@@ -0,0 +1,215 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#pragma once
+
+#include "../dga/aliases.h"
+#include "../dga/platform.h"
+#include "../dga/result.h"
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+#if !(defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define DGA_CHARCONV_SWAR
+#endif
+
+/*
+ * Locale independent conversions between numbers and strings, which don't allocate or throw.
+ *
+ * parse<T>(s) converts the whole of 's' to an integer or floating point number, and returns a
+ * ParseError if 's' isn't a number, is out of range for T, or has characters after the number. It
+ * accepts the same syntax as std::from_chars, so leading whitespace and '+' are not allowed:
+ *
+ *     DGA_TRY_ASSIGN(u32 port, dga::parse<u32>(field));
+ *
+ * Decimal integers are parsed eight digits at a time using SWAR (SIMD within a register) when
+ * they're short enough that they can't overflow, and everything else is passed to std::from_chars.
+ *
+ * format(value, buf) writes the shortest representation of 'value' that round trips to 'buf',
+ * which must have room for max_chars_v<T> characters, and returns a pointer to the end of the
+ * written characters. No null terminator is written. appendNumber(output, value) appends the same
+ * representation to a std::string.
+ *
+ * Floating point conversions require a standard library that supports std::from_chars and
+ * std::to_chars for floating point types (GCC 11, MSVC 2019 16.4).
+ */
+
+namespace dga {
+enum class ParseError {
+    // The string doesn't start with a number.
+    InvalidArgument,
+    // The number can't be represented by the requested type.
+    OutOfRange,
+    // The string starts with a number, but has characters after it.
+    TrailingCharacters
+};
+
+namespace detail {
+template <typename T>
+constexpr bool is_charconv_integer_v = std::is_integral_v<T> && !std::is_same_v<T, bool>;
+
+constexpr std::size_t countDigits(unsigned long long value) noexcept {
+    std::size_t digits = 1;
+    while (value >= 10) {
+        value /= 10;
+        ++digits;
+    }
+    return digits;
+}
+
+template <typename T> constexpr std::size_t maxChars() noexcept {
+    if constexpr (std::is_floating_point_v<T>) {
+        // Sign, decimal point, 'e' and exponent sign, plus the digits of the mantissa and exponent.
+        using limits = std::numeric_limits<T>;
+        return std::size_t(limits::max_digits10) + countDigits(limits::max_exponent10) + 4;
+    } else {
+        // Sign, plus digits10 + 1 digits.
+        return std::size_t(std::numeric_limits<T>::digits10) + 2;
+    }
+}
+
+inline ParseError toParseError(std::errc error) noexcept {
+    return error == std::errc::result_out_of_range ? ParseError::OutOfRange
+                                                   : ParseError::InvalidArgument;
+}
+
+#if defined(DGA_CHARCONV_SWAR)
+inline u64 loadEightBytes(const char* p) noexcept {
+    u64 value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// Returns true if all 8 bytes are ASCII digits. Adding 6 to a digit keeps its high nibble at 3,
+// whereas any byte above '9' carries into the high nibble.
+inline bool isEightDigits(u64 value) noexcept {
+    return ((value & 0xF0F0F0F0F0F0F0F0) |
+            (((value + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333;
+}
+
+// Converts 8 ASCII digits to their value, where the first digit is in the lowest byte. Adjacent
+// digits are combined into 2-digit values, then 4, then 8, using a multiply for each step.
+inline u32 parseEightDigits(u64 value) noexcept {
+    constexpr u64 kMask = 0x000000FF000000FF;
+    constexpr u64 kMul1 = 100 + (1000000ull << 32);
+    constexpr u64 kMul2 = 1 + (10000ull << 32);
+    value -= 0x3030303030303030;
+    value = (value * 10) + (value >> 8);
+    value = (((value & kMask) * kMul1) + (((value >> 16) & kMask) * kMul2)) >> 32;
+    return static_cast<u32>(value);
+}
+#endif
+
+// Parses [first, last) as decimal digits. Returns false without modifying 'value' if the range has
+// a character that isn't a digit, or has too many digits to be guaranteed to fit in T, in which
+// case the caller falls back to std::from_chars.
+template <typename T>
+bool parseDecimalFast(const char* first, const char* last, T& value) noexcept {
+    constexpr std::size_t kMaxDigits = std::size_t(std::numeric_limits<T>::digits10);
+    std::size_t size = std::size_t(last - first);
+    if (size == 0 || size > kMaxDigits) {
+        return false;
+    }
+    u64 result = 0;
+#if defined(DGA_CHARCONV_SWAR)
+    for (; size >= 8; size -= 8, first += 8) {
+        const u64 chunk = loadEightBytes(first);
+        if (!isEightDigits(chunk)) {
+            return false;
+        }
+        result = result * 100000000 + parseEightDigits(chunk);
+    }
+#endif
+    for (; first != last; ++first) {
+        const unsigned digit = unsigned(static_cast<unsigned char>(*first)) - unsigned('0');
+        if (digit > 9) {
+            return false;
+        }
+        result = result * 10 + digit;
+    }
+    value = static_cast<T>(result);
+    return true;
+}
+
+template <typename T>
+bool parseIntegerFast(const char* first, const char* last, T& value) noexcept {
+    if constexpr (std::numeric_limits<T>::digits > 64) {
+        return false;
+    } else if constexpr (std::is_signed_v<T>) {
+        if (first != last && *first == '-') {
+            T magnitude;
+            if (!parseDecimalFast(first + 1, last, magnitude)) {
+                return false;
+            }
+            value = static_cast<T>(-magnitude);
+            return true;
+        }
+        return parseDecimalFast(first, last, value);
+    } else {
+        return parseDecimalFast(first, last, value);
+    }
+}
+
+template <typename T, typename... Args>
+Result<T, ParseError> parseFromChars(std::string_view s, Args... args) noexcept {
+    T value;
+    const char* last = s.data() + s.size();
+    const std::from_chars_result result = std::from_chars(s.data(), last, value, args...);
+    if (result.ec != std::errc{}) {
+        return Error{toParseError(result.ec)};
+    }
+    if (result.ptr != last) {
+        return Error{ParseError::TrailingCharacters};
+    }
+    return value;
+}
+}  // namespace detail
+
+// The maximum number of characters written by format for a value of type T.
+template <typename T> constexpr std::size_t max_chars_v = detail::maxChars<T>();
+
+/// Parses the whole of 's' as an integer in the given base.
+template <typename T, std::enable_if_t<detail::is_charconv_integer_v<T>, int> = 0>
+Result<T, ParseError> parse(std::string_view s, int base = 10) noexcept {
+    if (base == 10) {
+        T value;
+        if (detail::parseIntegerFast(s.data(), s.data() + s.size(), value)) {
+            return value;
+        }
+    }
+    return detail::parseFromChars<T>(s, base);
+}
+
+#if defined(__cpp_lib_to_chars)
+/// Parses the whole of 's' as a floating point number.
+template <typename T, std::enable_if_t<std::is_floating_point_v<T>, int> = 0>
+Result<T, ParseError> parse(std::string_view s,
+                            std::chars_format fmt = std::chars_format::general) noexcept {
+    return detail::parseFromChars<T>(s, fmt);
+}
+#endif
+
+/// Writes the shortest representation of 'value' to 'buf', which must have room for at least
+/// max_chars_v<T> characters. Returns a pointer to the character after the last one written.
+template <typename T, std::enable_if_t<detail::is_charconv_integer_v<T> ||
+                                           std::is_floating_point_v<T>,
+                                       int> = 0>
+char* format(T value, char* buf) noexcept {
+    return std::to_chars(buf, buf + max_chars_v<T>, value).ptr;
+}
+
+/// Appends the shortest representation of 'value' to 'output'.
+template <typename T, std::enable_if_t<detail::is_charconv_integer_v<T> ||
+                                           std::is_floating_point_v<T>,
+                                       int> = 0>
+void appendNumber(std::string& output, T value) {
+    char buf[max_chars_v<T>];
+    output.append(buf, format(value, buf));
+}
+}  // namespace dga
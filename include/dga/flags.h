@@ -3,8 +3,12 @@
 #pragma once
 
 #include "../dga/aliases.h"
+#include "../dga/bit.h"
 
-#include <bitset>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <limits>
 #include <type_traits>
 
 /*
@@ -14,6 +18,14 @@
  *
  * An unchecked precondition of this class is that all flag values in `EnumType` are numbered from 0
  * to n, where n is the number of flags.
+ *
+ * If the flags fit in the unsigned version of the enum's underlying type, they're stored in a
+ * single word of that type. Otherwise, they're stored in an array of 64-bit words, and every
+ * operation works on a whole word at a time. Iterating over a Flags object visits only the flags
+ * that are set, in ascending order, using count trailing zeros to skip from one set bit to the
+ * next:
+ *
+ *     for (Component c : entity.components) { ... }
  */
 
 namespace dga {
@@ -26,131 +38,306 @@ struct is_flags_enum<EnumType, decltype(static_cast<void>(EnumType::_Count))>
     : std::is_enum<EnumType> {
     static constexpr auto size = static_cast<std::size_t>(EnumType::_Count);
 };
+
+template <typename EnumType> struct FlagsWord {
+    using underlying_mask = std::make_unsigned_t<std::underlying_type_t<EnumType>>;
+    static constexpr bool single_word =
+        is_flags_enum<EnumType>::size <= std::size_t(std::numeric_limits<underlying_mask>::digits);
+    using type = std::conditional_t<single_word, underlying_mask, u64>;
+};
 }  // namespace detail
 
 template <typename EnumType> class Flags {
 public:
-    using mask_type = std::make_unsigned_t<std::underlying_type_t<EnumType>>;
     static_assert(detail::is_flags_enum<EnumType>::value,
                   "EnumType must be an 'enum' or 'enum class' that contains a _Count member.");
 
+    // The type of each word used to store the flags. If there's only one word, then this is the
+    // unsigned version of the enum's underlying type.
+    using mask_type = typename detail::FlagsWord<EnumType>::type;
+
+    static constexpr std::size_t flag_count = detail::is_flags_enum<EnumType>::size;
+    static constexpr std::size_t word_bits = std::size_t(std::numeric_limits<mask_type>::digits);
+    static constexpr std::size_t word_count =
+        flag_count == 0 ? 1 : (flag_count + word_bits - 1) / word_bits;
+
+    class iterator;
+
     static constexpr Flags all() {
-        return Flags(
-            mask_type((mask_type(1) << detail::is_flags_enum<EnumType>::size) - mask_type(1)));
+        Flags flags;
+        for (std::size_t i = 0; i < word_count; ++i) {
+            flags.words_[i] = wordMask(i);
+        }
+        return flags;
     }
 
     static constexpr Flags none() {
-        return Flags(mask_type(0));
+        return Flags();
     }
 
     // constructors.
-    constexpr Flags() noexcept : value_(0) {
+    constexpr Flags() noexcept : words_() {
     }
 
-    constexpr explicit Flags(EnumType e) noexcept : value_(mask(e)) {
+    constexpr explicit Flags(EnumType e) noexcept : words_() {
+        words_[wordIndex(e)] = mask(e);
     }
 
-    constexpr Flags(const Flags& rhs) noexcept : value_(rhs.value_) {
-    }
+    constexpr Flags(const Flags& rhs) noexcept = default;
 
-    constexpr explicit Flags(mask_type flags) noexcept : value_(flags) {
+    template <typename M = mask_type, typename = std::enable_if_t<word_count == 1, M>>
+    constexpr explicit Flags(mask_type flags) noexcept : words_{flags} {
     }
 
+    constexpr Flags& operator=(const Flags& rhs) noexcept = default;
+
     // operations.
     void set(EnumType e) {
-        value_ |= mask(e);
+        words_[wordIndex(e)] |= mask(e);
     }
 
     void reset(EnumType e) {
-        value_ &= ~mask(e);
+        words_[wordIndex(e)] &= mask_type(~mask(e));
     }
 
     void toggle(EnumType e) {
-        value_ ^= mask(e);
+        words_[wordIndex(e)] ^= mask(e);
     }
 
     void toggleAll() {
-        value_ ^= all().value_;
+        for (std::size_t i = 0; i < word_count; ++i) {
+            words_[i] ^= wordMask(i);
+        }
     }
 
     constexpr bool isSet(EnumType e) const {
-        return (value_ & mask(e)) != 0;
+        return (words_[wordIndex(e)] & mask(e)) != 0;
     }
 
+    // Returns true if any flag is set. Use operator! to check that no flags are set.
+    constexpr bool any() const noexcept {
+        mask_type combined = 0;
+        for (std::size_t i = 0; i < word_count; ++i) {
+            combined |= words_[i];
+        }
+        return combined != 0;
+    }
+
+    // Returns the number of flags that are set.
+    std::size_t count() const noexcept {
+        std::size_t result = 0;
+        for (std::size_t i = 0; i < word_count; ++i) {
+            result += std::size_t(popcount(words_[i]));
+        }
+        return result;
+    }
+
+    // Returns the flags as a single mask. Only available if the flags fit in one word.
+    template <typename M = mask_type, typename = std::enable_if_t<word_count == 1, M>>
     constexpr mask_type value() const noexcept {
-        return value_;
+        return words_[0];
+    }
+
+    // Returns the words storing the flags. Flag n is bit (n % word_bits) of word (n / word_bits).
+    constexpr const std::array<mask_type, word_count>& words() const noexcept {
+        return words_;
+    }
+
+    // iteration over the flags that are set.
+    iterator begin() const noexcept {
+        return iterator(words_.data(), 0);
+    }
+
+    iterator end() const noexcept {
+        return iterator(words_.data(), word_count);
     }
 
     // operators.
     Flags& operator|=(const Flags& rhs) noexcept {
-        value_ |= rhs.value_;
+        for (std::size_t i = 0; i < word_count; ++i) {
+            words_[i] |= rhs.words_[i];
+        }
         return *this;
     }
 
     Flags& operator&=(const Flags& rhs) noexcept {
-        value_ &= rhs.value_;
+        for (std::size_t i = 0; i < word_count; ++i) {
+            words_[i] &= rhs.words_[i];
+        }
         return *this;
     }
 
     Flags& operator^=(const Flags& rhs) noexcept {
-        value_ ^= rhs.value_;
+        for (std::size_t i = 0; i < word_count; ++i) {
+            words_[i] ^= rhs.words_[i];
+        }
         return *this;
     }
 
     constexpr Flags operator|(const Flags& rhs) const noexcept {
-        return Flags(value_ | rhs.value_);
+        Flags result;
+        for (std::size_t i = 0; i < word_count; ++i) {
+            result.words_[i] = words_[i] | rhs.words_[i];
+        }
+        return result;
     }
 
     constexpr Flags operator|(EnumType rhs) const noexcept {
-        return Flags(value_ | mask(rhs));
+        Flags result = *this;
+        result.words_[wordIndex(rhs)] |= mask(rhs);
+        return result;
     }
 
     constexpr Flags operator&(const Flags& rhs) const noexcept {
-        return Flags(value_ & rhs.value_);
+        Flags result;
+        for (std::size_t i = 0; i < word_count; ++i) {
+            result.words_[i] = words_[i] & rhs.words_[i];
+        }
+        return result;
     }
 
     constexpr Flags operator&(EnumType rhs) const noexcept {
-        return Flags(value_ & mask(rhs));
+        Flags result;
+        result.words_[wordIndex(rhs)] = words_[wordIndex(rhs)] & mask(rhs);
+        return result;
     }
 
     constexpr Flags operator^(const Flags& rhs) const noexcept {
-        return Flags(value_ ^ rhs.value_);
+        Flags result;
+        for (std::size_t i = 0; i < word_count; ++i) {
+            result.words_[i] = words_[i] ^ rhs.words_[i];
+        }
+        return result;
     }
 
     constexpr Flags operator^(EnumType rhs) const noexcept {
-        return Flags(value_ ^ mask(rhs));
+        Flags result = *this;
+        result.words_[wordIndex(rhs)] ^= mask(rhs);
+        return result;
     }
 
     constexpr bool operator!() const noexcept {
-        return !value_;
+        return !any();
     }
 
     constexpr Flags operator~() const noexcept {
-        return Flags(value_ ^ all().value_);
+        Flags result;
+        for (std::size_t i = 0; i < word_count; ++i) {
+            result.words_[i] = words_[i] ^ wordMask(i);
+        }
+        return result;
     }
 
     constexpr bool operator==(const Flags& rhs) const noexcept {
-        return value_ == rhs.value_;
+        // Combine the differences rather than returning early, so that this compiles to a few
+        // branch-free instructions.
+        mask_type difference = 0;
+        for (std::size_t i = 0; i < word_count; ++i) {
+            difference |= words_[i] ^ rhs.words_[i];
+        }
+        return difference == 0;
     }
 
     constexpr bool operator==(EnumType rhs) const noexcept {
-        return value_ == mask(rhs);
+        return *this == Flags(rhs);
     }
 
     constexpr bool operator!=(const Flags& rhs) const noexcept {
-        return value_ != rhs.value_;
+        return !(*this == rhs);
     }
 
     constexpr bool operator!=(EnumType rhs) const noexcept {
-        return value_ != mask(rhs);
+        return !(*this == rhs);
     }
 
 private:
-    mask_type value_;
+    std::array<mask_type, word_count> words_;
+
+    static constexpr std::size_t wordIndex(EnumType e) {
+        if constexpr (word_count == 1) {
+            return 0;
+        } else {
+            return std::size_t(e) / word_bits;
+        }
+    }
 
-    static mask_type mask(EnumType e) {
-        return mask_type(mask_type(1u) << std::size_t(e));
+    static constexpr mask_type mask(EnumType e) {
+        if constexpr (word_count == 1) {
+            return mask_type(mask_type(1u) << std::size_t(e));
+        } else {
+            return mask_type(mask_type(1u) << (std::size_t(e) % word_bits));
+        }
     }
+
+    // The bits of word 'i' that correspond to a flag.
+    static constexpr mask_type wordMask(std::size_t i) {
+        const std::size_t bits = flag_count - i * word_bits;
+        if (bits >= word_bits) {
+            return std::numeric_limits<mask_type>::max();
+        }
+        return mask_type((mask_type(1u) << bits) - 1u);
+    }
+};
+
+// Forward iterator over the flags that are set.
+template <typename EnumType> class Flags<EnumType>::iterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = EnumType;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = EnumType;
+
+    iterator() noexcept : words_(nullptr), index_(word_count), remaining_(0) {
+    }
+
+    EnumType operator*() const noexcept {
+        return EnumType(index_ * word_bits + std::size_t(countr_zero(remaining_)));
+    }
+
+    iterator& operator++() noexcept {
+        // Clear the lowest set bit.
+        remaining_ &= mask_type(remaining_ - 1u);
+        skipEmptyWords();
+        return *this;
+    }
+
+    iterator operator++(int) noexcept {
+        iterator copy = *this;
+        ++*this;
+        return copy;
+    }
+
+    bool operator==(const iterator& rhs) const noexcept {
+        return index_ == rhs.index_ && remaining_ == rhs.remaining_;
+    }
+
+    bool operator!=(const iterator& rhs) const noexcept {
+        return !(*this == rhs);
+    }
+
+private:
+    const mask_type* words_;
+    std::size_t index_;
+    mask_type remaining_;
+
+    iterator(const mask_type* words, std::size_t index) noexcept
+        : words_(words), index_(index), remaining_(index < word_count ? words[index] : 0) {
+        skipEmptyWords();
+    }
+
+    void skipEmptyWords() noexcept {
+        if constexpr (word_count > 1) {
+            while (remaining_ == 0 && index_ + 1 < word_count) {
+                remaining_ = words_[++index_];
+            }
+        }
+        if (remaining_ == 0) {
+            index_ = word_count;
+        }
+    }
+
+    friend class Flags;
 };
 
 template <typename EnumType>
@@ -0,0 +1,1058 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#pragma once
+
+#include "../dga/aliases.h"
+#include "../dga/bit.h"
+#include "../dga/hash_combine.h"
+#include "../dga/platform.h"
+
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Select the kernel used to scan groups of control bytes.
+#if defined(DGA_HAS_SSE2)
+#define DGA_HASH_GROUP_SSE2
+#include <emmintrin.h>
+#elif defined(DGA_HAS_NEON)
+#define DGA_HASH_GROUP_NEON
+#include <arm_neon.h>
+#endif
+
+/*
+ * Open addressing hash map, based on the design of Abseil's SwissTable
+ * (https://abseil.io/about/design/swisstables).
+ *
+ * Keys and values are stored inline in a single array of slots, alongside a separate array with
+ * one control byte per slot. A control byte is either empty, deleted (a tombstone), or holds the
+ * low 7 bits of the hash of the key in that slot. Lookups probe a group of 16 control bytes at a
+ * time with SSE2 (or 8 at a time with NEON, or 8 at a time in a u64 otherwise), and only compare
+ * keys in slots whose control byte matches the hash. Most lookups touch a single group and a
+ * single slot.
+ *
+ * The map is kept at most 7/8 full. reserve(n) allocates enough slots that inserting until size()
+ * is n doesn't rehash. Unlike std::unordered_map, pointers and iterators to elements are
+ * invalidated by any insertion that rehashes.
+ *
+ * The default hasher is dga::Hash<K>. If both the hasher and key comparison are transparent (as
+ * they are by default for std::string keys), find, contains, count and erase accept any type that
+ * can be hashed and compared with the key, such as std::string_view.
+ *
+ * Memory for the slots and control bytes comes from Allocator, rebound to each array's type. The
+ * allocator follows the standard propagation rules on copy, move and swap, so for example a map
+ * using an ArenaAllocator (see arena.h) keeps its arena when assigned from a map in another arena.
+ */
+
+namespace dga {
+namespace detail {
+using HashCtrl = i8;
+
+// Full slots store the low 7 bits of the hash, so are always >= 0. Both special values have the
+// top bit set.
+constexpr HashCtrl kCtrlEmpty = -128;
+constexpr HashCtrl kCtrlDeleted = -2;
+
+// A set of slots in a group. Each slot is represented by 2^Shift bits of the mask, of which at
+// most one is set.
+template <typename T, int Width, int Shift> class HashBitMask {
+public:
+    explicit HashBitMask(T mask) noexcept : mask_(mask) {
+    }
+
+    explicit operator bool() const noexcept {
+        return mask_ != 0;
+    }
+
+    // Index of the first slot in the set.
+    int lowest() const noexcept {
+        return countr_zero(mask_) >> Shift;
+    }
+
+    void clearLowest() noexcept {
+        mask_ &= mask_ - 1;
+    }
+
+    // Number of slots before the first slot in the set.
+    int trailingZeros() const noexcept {
+        return countr_zero(mask_) >> Shift;
+    }
+
+    // Number of slots after the last slot in the set.
+    int leadingZeros() const noexcept {
+        constexpr int extra = std::numeric_limits<T>::digits - (Width << Shift);
+        return (countl_zero(mask_) - extra) >> Shift;
+    }
+
+private:
+    T mask_;
+};
+
+#if defined(DGA_HASH_GROUP_SSE2)
+class HashGroup {
+public:
+    static constexpr std::size_t kWidth = 16;
+    using Mask = HashBitMask<u32, 16, 0>;
+
+    explicit HashGroup(const HashCtrl* ctrl) noexcept
+        : ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))) {
+    }
+
+    Mask match(HashCtrl h2) const noexcept {
+        return Mask(static_cast<u32>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_))));
+    }
+
+    Mask matchEmpty() const noexcept {
+        return match(kCtrlEmpty);
+    }
+
+    Mask matchEmptyOrDeleted() const noexcept {
+        // Both special values are negative, so this is just the sign bits.
+        return Mask(static_cast<u32>(_mm_movemask_epi8(ctrl_)));
+    }
+
+private:
+    __m128i ctrl_;
+};
+#elif defined(DGA_HASH_GROUP_NEON)
+class HashGroup {
+public:
+    static constexpr std::size_t kWidth = 8;
+    using Mask = HashBitMask<u64, 8, 3>;
+
+    explicit HashGroup(const HashCtrl* ctrl) noexcept : ctrl_(vld1_s8(ctrl)) {
+    }
+
+    Mask match(HashCtrl h2) const noexcept {
+        return toMask(vceq_s8(vdup_n_s8(h2), ctrl_));
+    }
+
+    Mask matchEmpty() const noexcept {
+        return match(kCtrlEmpty);
+    }
+
+    Mask matchEmptyOrDeleted() const noexcept {
+        return toMask(vclt_s8(ctrl_, vdup_n_s8(0)));
+    }
+
+private:
+    int8x8_t ctrl_;
+
+    static Mask toMask(uint8x8_t matches) noexcept {
+        return Mask(vget_lane_u64(vreinterpret_u64_u8(matches), 0) & 0x8080808080808080ull);
+    }
+};
+#else
+// Portable fallback, which treats a group of 8 control bytes as a u64.
+class HashGroup {
+public:
+    static constexpr std::size_t kWidth = 8;
+    using Mask = HashBitMask<u64, 8, 3>;
+
+    explicit HashGroup(const HashCtrl* ctrl) noexcept {
+        std::memcpy(&ctrl_, ctrl, sizeof(ctrl_));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        ctrl_ = __builtin_bswap64(ctrl_);
+#endif
+    }
+
+    // May return false positives, which is fine as the keys are compared afterwards.
+    Mask match(HashCtrl h2) const noexcept {
+        const u64 x = ctrl_ ^ (kLsbs * static_cast<u8>(h2));
+        return Mask((x - kLsbs) & ~x & kMsbs);
+    }
+
+    Mask matchEmpty() const noexcept {
+        // Empty is the only value with the top bit set and the second lowest bit clear.
+        return Mask(ctrl_ & ~(ctrl_ << 6) & kMsbs);
+    }
+
+    Mask matchEmptyOrDeleted() const noexcept {
+        return Mask(ctrl_ & kMsbs);
+    }
+
+private:
+    static constexpr u64 kLsbs = 0x0101010101010101ull;
+    static constexpr u64 kMsbs = 0x8080808080808080ull;
+
+    u64 ctrl_;
+};
+#endif
+
+template <typename T, typename = void> struct HashIsTransparent : std::false_type {};
+template <typename T>
+struct HashIsTransparent<T, std::void_t<typename T::is_transparent>> : std::true_type {};
+
+// Resolves to K if heterogeneous lookup is enabled, and the key type otherwise.
+template <bool Transparent> struct HashKeyArg {
+    template <typename K, typename Key> using type = Key;
+};
+
+template <> struct HashKeyArg<true> {
+    template <typename K, typename Key> using type = K;
+};
+
+[[noreturn]] DGA_COLD DGA_NOINLINE inline void hashMapKeyNotFound() {
+#ifdef DGA_NO_EXCEPTIONS
+    fatalError("FlatHashMap::at: key not found");
+#else
+    throw std::out_of_range("FlatHashMap::at: key not found");
+#endif
+}
+}  // namespace detail
+
+template <typename K, typename V, typename Hash = dga::Hash<K>,
+          typename KeyEqual = std::equal_to<>,
+          typename Allocator = std::allocator<std::pair<const K, V>>>
+class FlatHashMap {
+    static constexpr bool kTransparent =
+        detail::HashIsTransparent<Hash>::value && detail::HashIsTransparent<KeyEqual>::value;
+
+    template <typename Key>
+    using key_arg = typename detail::HashKeyArg<kTransparent>::template type<Key, K>;
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<const K, V>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using allocator_type = Allocator;
+
+private:
+    // The map hands out references to pair<const K, V>, but moves elements during a rehash as
+    // pair<K, V>, so that keys are moved instead of copied. This is the same trick as Abseil's
+    // map_slot_type.
+    union Slot {
+        Slot() {
+        }
+        ~Slot() {
+        }
+
+        value_type value;
+        std::pair<K, V> mutable_value;
+    };
+
+    template <bool Const> class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename FlatHashMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+        using reference = std::conditional_t<Const, const value_type&, value_type&>;
+
+        Iterator() noexcept = default;
+
+        template <bool C = Const, std::enable_if_t<C>* = nullptr>
+        Iterator(const Iterator<false>& other) noexcept
+            : ctrl_(other.ctrl_), slot_(other.slot_), end_(other.end_) {
+        }
+
+        reference operator*() const noexcept {
+            return slot_->value;
+        }
+
+        pointer operator->() const noexcept {
+            return &slot_->value;
+        }
+
+        Iterator& operator++() noexcept {
+            ++ctrl_;
+            ++slot_;
+            skipEmpty();
+            return *this;
+        }
+
+        Iterator operator++(int) noexcept {
+            Iterator it = *this;
+            ++*this;
+            return it;
+        }
+
+        friend bool operator==(const Iterator& a, const Iterator& b) noexcept {
+            return a.ctrl_ == b.ctrl_;
+        }
+
+        friend bool operator!=(const Iterator& a, const Iterator& b) noexcept {
+            return a.ctrl_ != b.ctrl_;
+        }
+
+    private:
+        friend class FlatHashMap;
+        template <bool> friend class Iterator;
+
+        Iterator(const detail::HashCtrl* ctrl, Slot* slot, const detail::HashCtrl* end) noexcept
+            : ctrl_(ctrl), slot_(slot), end_(end) {
+        }
+
+        void skipEmpty() noexcept {
+            while (ctrl_ != end_ && *ctrl_ < 0) {
+                ++ctrl_;
+                ++slot_;
+            }
+        }
+
+        const detail::HashCtrl* ctrl_ = nullptr;
+        Slot* slot_ = nullptr;
+        const detail::HashCtrl* end_ = nullptr;
+    };
+
+public:
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    FlatHashMap() = default;
+    explicit FlatHashMap(const Allocator& alloc);
+    explicit FlatHashMap(size_type capacity, const Hash& hash = Hash{},
+                         const KeyEqual& equal = KeyEqual{}, const Allocator& alloc = Allocator{});
+    FlatHashMap(std::initializer_list<value_type> init, const Hash& hash = Hash{},
+                const KeyEqual& equal = KeyEqual{}, const Allocator& alloc = Allocator{});
+    template <typename InputIt> FlatHashMap(InputIt first, InputIt last);
+    FlatHashMap(const FlatHashMap& other);
+    FlatHashMap(const FlatHashMap& other, const Allocator& alloc);
+    FlatHashMap(FlatHashMap&& other) noexcept;
+    FlatHashMap(FlatHashMap&& other, const Allocator& alloc);
+    ~FlatHashMap();
+
+    FlatHashMap& operator=(const FlatHashMap& other);
+    FlatHashMap& operator=(FlatHashMap&& other) noexcept(
+        std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value ||
+        std::allocator_traits<Allocator>::is_always_equal::value);
+
+    allocator_type get_allocator() const noexcept {
+        return alloc_;
+    }
+
+    iterator begin() noexcept;
+    const_iterator begin() const noexcept;
+    const_iterator cbegin() const noexcept;
+    iterator end() noexcept;
+    const_iterator end() const noexcept;
+    const_iterator cend() const noexcept;
+
+    bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    size_type size() const noexcept {
+        return size_;
+    }
+
+    // Number of slots in the table.
+    size_type capacity() const noexcept {
+        return capacity_;
+    }
+
+    float load_factor() const noexcept {
+        return capacity_ == 0 ? 0.0f : float(size_) / float(capacity_);
+    }
+
+    hasher hash_function() const {
+        return hash_;
+    }
+
+    key_equal key_eq() const {
+        return equal_;
+    }
+
+    void clear() noexcept;
+    // Ensures that 'count' elements can be stored without rehashing.
+    void reserve(size_type count);
+
+    std::pair<iterator, bool> insert(const value_type& value);
+    std::pair<iterator, bool> insert(value_type&& value);
+    template <typename InputIt> void insert(InputIt first, InputIt last);
+    void insert(std::initializer_list<value_type> init);
+    template <typename M> std::pair<iterator, bool> insert_or_assign(const K& key, M&& value);
+    template <typename M> std::pair<iterator, bool> insert_or_assign(K&& key, M&& value);
+    template <typename... Args> std::pair<iterator, bool> emplace(Args&&... args);
+    template <typename... Args> std::pair<iterator, bool> try_emplace(const K& key, Args&&... args);
+    template <typename... Args> std::pair<iterator, bool> try_emplace(K&& key, Args&&... args);
+
+    iterator erase(iterator pos);
+    iterator erase(const_iterator pos);
+    template <typename Key = K> size_type erase(const key_arg<Key>& key);
+
+    void swap(FlatHashMap& other) noexcept;
+
+    V& operator[](const K& key);
+    V& operator[](K&& key);
+    template <typename Key = K> V& at(const key_arg<Key>& key);
+    template <typename Key = K> const V& at(const key_arg<Key>& key) const;
+
+    template <typename Key = K> iterator find(const key_arg<Key>& key);
+    template <typename Key = K> const_iterator find(const key_arg<Key>& key) const;
+    template <typename Key = K> bool contains(const key_arg<Key>& key) const;
+    template <typename Key = K> size_type count(const key_arg<Key>& key) const;
+
+private:
+    static constexpr std::size_t kGroupWidth = detail::HashGroup::kWidth;
+    static constexpr std::size_t kNotFound = ~std::size_t(0);
+
+    detail::HashCtrl* ctrl_ = nullptr;
+    Slot* slots_ = nullptr;
+    size_type size_ = 0;
+    size_type capacity_ = 0;
+    // Number of empty slots that can be filled before the table must grow.
+    size_type growth_left_ = 0;
+    Hash hash_;
+    KeyEqual equal_;
+    Allocator alloc_;
+
+    // The top bits of the hash pick the starting group, and the low 7 bits are stored in the
+    // control byte.
+    static std::size_t h1(std::size_t hash) noexcept {
+        return hash >> 7;
+    }
+
+    static detail::HashCtrl h2(std::size_t hash) noexcept {
+        return static_cast<detail::HashCtrl>(hash & 0x7f);
+    }
+
+    // A table may be filled to 7/8 of its capacity.
+    static size_type maxGrowth(size_type capacity) noexcept {
+        return capacity - capacity / 8;
+    }
+
+    static size_type capacityFor(size_type count) noexcept;
+
+    iterator iteratorAt(std::size_t index) noexcept {
+        return {ctrl_ + index, slots_ + index, ctrl_ + capacity_};
+    }
+
+    const_iterator iteratorAt(std::size_t index) const noexcept {
+        return {ctrl_ + index, slots_ + index, ctrl_ + capacity_};
+    }
+
+    void setCtrl(std::size_t index, detail::HashCtrl h) noexcept;
+
+    // Returns the index of the slot containing 'key', or kNotFound.
+    template <typename Key> std::size_t findIndex(const Key& key, std::size_t hash) const;
+    // Returns the index of the first empty or deleted slot in the probe sequence for 'hash'.
+    std::size_t findInsertIndex(std::size_t hash) const noexcept;
+    // Returns the index that a new element with 'hash' should be inserted at, growing the table if
+    // needed. The slot isn't marked as full until commitInsert() is called.
+    std::size_t prepareInsert(std::size_t hash);
+    void commitInsert(std::size_t index, std::size_t hash) noexcept;
+
+    template <typename Key, typename... Args>
+    std::pair<iterator, bool> tryEmplaceImpl(Key&& key, Args&&... args);
+    void eraseAt(std::size_t index) noexcept;
+
+    using AllocTraits = std::allocator_traits<Allocator>;
+    using SlotAllocator = typename AllocTraits::template rebind_alloc<Slot>;
+    using CtrlAllocator = typename AllocTraits::template rebind_alloc<detail::HashCtrl>;
+
+    // Copies or moves every element of 'other' into this map, which must have enough capacity.
+    template <typename Other> void insertUnique(Other&& other);
+
+    void allocate(size_type capacity);
+    void deallocate() noexcept;
+    void freeArrays(detail::HashCtrl* ctrl, Slot* slots, size_type capacity) noexcept;
+
+    // Swaps everything except the allocator, which is only swapped if it propagates.
+    void swapStorage(FlatHashMap& other) noexcept;
+    // Swaps everything including the allocator, for use when 'other' is a temporary.
+    void swapWithAllocator(FlatHashMap& other) noexcept;
+    void destroyAll() noexcept;
+    void resize(size_type capacity);
+};
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::FlatHashMap(const Allocator& alloc) : alloc_(alloc) {
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::FlatHashMap(size_type capacity, const Hash& hash,
+                                                          const KeyEqual& equal,
+                                                          const Allocator& alloc)
+    : hash_(hash), equal_(equal), alloc_(alloc) {
+    reserve(capacity);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::FlatHashMap(std::initializer_list<value_type> init,
+                                                          const Hash& hash, const KeyEqual& equal,
+                                                          const Allocator& alloc)
+    : FlatHashMap(init.size(), hash, equal, alloc) {
+    insert(init);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+template <typename InputIt>
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::FlatHashMap(InputIt first, InputIt last) {
+    insert(first, last);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::FlatHashMap(const FlatHashMap& other)
+    : FlatHashMap(other, AllocTraits::select_on_container_copy_construction(other.alloc_)) {
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::FlatHashMap(const FlatHashMap& other,
+                                                          const Allocator& alloc)
+    : hash_(other.hash_), equal_(other.equal_), alloc_(alloc) {
+    reserve(other.size_);
+    insertUnique(other);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::FlatHashMap(FlatHashMap&& other) noexcept
+    : ctrl_(other.ctrl_),
+      slots_(other.slots_),
+      size_(other.size_),
+      capacity_(other.capacity_),
+      growth_left_(other.growth_left_),
+      hash_(std::move(other.hash_)),
+      equal_(std::move(other.equal_)),
+      alloc_(std::move(other.alloc_)) {
+    other.ctrl_ = nullptr;
+    other.slots_ = nullptr;
+    other.size_ = 0;
+    other.capacity_ = 0;
+    other.growth_left_ = 0;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::FlatHashMap(FlatHashMap&& other,
+                                                          const Allocator& alloc)
+    : hash_(other.hash_), equal_(other.equal_), alloc_(alloc) {
+    if (alloc_ == other.alloc_) {
+        swap(other);
+    } else {
+        // The memory belongs to a different allocator, so the elements have to be moved one by one.
+        reserve(other.size_);
+        insertUnique(std::move(other));
+        other.clear();
+    }
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::~FlatHashMap() {
+    destroyAll();
+    deallocate();
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>&
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::operator=(const FlatHashMap& other) {
+    if (this != &other) {
+        FlatHashMap copy{other, AllocTraits::propagate_on_container_copy_assignment::value
+                                    ? other.alloc_
+                                    : alloc_};
+        swapWithAllocator(copy);
+    }
+    return *this;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>&
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::operator=(
+    FlatHashMap&& other) noexcept(AllocTraits::propagate_on_container_move_assignment::value ||
+                                  AllocTraits::is_always_equal::value) {
+    if (this != &other) {
+        if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+            FlatHashMap moved{std::move(other)};
+            swapWithAllocator(moved);
+        } else {
+            // The allocator doesn't propagate, so if it's different from other's allocator, the
+            // elements are moved one by one into memory from this map's allocator.
+            FlatHashMap moved{std::move(other), alloc_};
+            swapWithAllocator(moved);
+        }
+    }
+    return *this;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+typename FlatHashMap<K, V, Hash, KeyEqual, Allocator>::iterator
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::begin() noexcept {
+    iterator it = iteratorAt(0);
+    it.skipEmpty();
+    return it;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+typename FlatHashMap<K, V, Hash, KeyEqual, Allocator>::const_iterator
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::begin() const noexcept {
+    const_iterator it = iteratorAt(0);
+    it.skipEmpty();
+    return it;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+typename FlatHashMap<K, V, Hash, KeyEqual, Allocator>::const_iterator
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::cbegin() const noexcept {
+    return begin();
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+typename FlatHashMap<K, V, Hash, KeyEqual, Allocator>::iterator
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::end() noexcept {
+    return iteratorAt(capacity_);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+typename FlatHashMap<K, V, Hash, KeyEqual, Allocator>::const_iterator
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::end() const noexcept {
+    return iteratorAt(capacity_);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+typename FlatHashMap<K, V, Hash, KeyEqual, Allocator>::const_iterator
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::cend() const noexcept {
+    return end();
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+void FlatHashMap<K, V, Hash, KeyEqual, Allocator>::clear() noexcept {
+    destroyAll();
+    if (capacity_ > 0) {
+        std::memset(ctrl_, detail::kCtrlEmpty, capacity_ + kGroupWidth);
+    }
+    size_ = 0;
+    growth_left_ = maxGrowth(capacity_);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+void FlatHashMap<K, V, Hash, KeyEqual, Allocator>::reserve(size_type count) {
+    if (count == 0) {
+        return;
+    }
+    const size_type capacity = capacityFor(count);
+    if (capacity > capacity_) {
+        resize(capacity);
+    } else if (growth_left_ < count - std::min(count, size_)) {
+        // There's enough space, but too much of it is taken by tombstones.
+        resize(capacity_);
+    }
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+std::pair<typename FlatHashMap<K, V, Hash, KeyEqual, Allocator>::iterator, bool>
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::insert(const value_type& value) {
+    return tryEmplaceImpl(value.first, value.second);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+std::pair<typename FlatHashMap<K, V, Hash, KeyEqual, Allocator>::iterator, bool>
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::insert(value_type&& value) {
+    return tryEmplaceImpl(value.first, std::move(value.second));
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+template <typename InputIt>
+void FlatHashMap<K, V, Hash, KeyEqual, Allocator>::insert(InputIt first, InputIt last) {
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag,
+                                    typename std::iterator_traits<InputIt>::iterator_category>) {
+        reserve(size_ + static_cast<size_type>(std::distance(first, last)));
+    }
+    for (; first != last; ++first) {
+        insert(*first);
+    }
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+void FlatHashMap<K, V, Hash, KeyEqual, Allocator>::insert(std::initializer_list<value_type> init) {
+    insert(init.begin(), init.end());
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+template <typename M>
+std::pair<typename FlatHashMap<K, V, Hash, KeyEqual, Allocator>::iterator, bool>
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::insert_or_assign(const K& key, M&& value) {
+    auto result = tryEmplaceImpl(key, std::forward<M>(value));
+    if (!result.second) {
+        result.first->second = std::forward<M>(value);
+    }
+    return result;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+template <typename M>
+std::pair<typename FlatHashMap<K, V, Hash, KeyEqual, Allocator>::iterator, bool>
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::insert_or_assign(K&& key, M&& value) {
+    auto result = tryEmplaceImpl(std::move(key), std::forward<M>(value));
+    if (!result.second) {
+        result.first->second = std::forward<M>(value);
+    }
+    return result;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+template <typename... Args>
+std::pair<typename FlatHashMap<K, V, Hash, KeyEqual, Allocator>::iterator, bool>
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::emplace(Args&&... args) {
+    // The key has to be constructed before we know where the element goes.
+    std::pair<K, V> value(std::forward<Args>(args)...);
+    return tryEmplaceImpl(std::move(value.first), std::move(value.second));
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+template <typename... Args>
+std::pair<typename FlatHashMap<K, V, Hash, KeyEqual, Allocator>::iterator, bool>
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::try_emplace(const K& key, Args&&... args) {
+    return tryEmplaceImpl(key, std::forward<Args>(args)...);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+template <typename... Args>
+std::pair<typename FlatHashMap<K, V, Hash, KeyEqual, Allocator>::iterator, bool>
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::try_emplace(K&& key, Args&&... args) {
+    return tryEmplaceImpl(std::move(key), std::forward<Args>(args)...);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+typename FlatHashMap<K, V, Hash, KeyEqual, Allocator>::iterator
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::erase(
+    iterator pos) {
+    iterator next = pos;
+    ++next;
+    eraseAt(static_cast<std::size_t>(pos.ctrl_ - ctrl_));
+    return next;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+typename FlatHashMap<K, V, Hash, KeyEqual, Allocator>::iterator
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::erase(
+    const_iterator pos) {
+    return erase(iterator{pos.ctrl_, pos.slot_, pos.end_});
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+template <typename Key>
+typename FlatHashMap<K, V, Hash, KeyEqual, Allocator>::size_type
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::erase(
+    const key_arg<Key>& key) {
+    const std::size_t index = findIndex(key, hash_(key));
+    if (index == kNotFound) {
+        return 0;
+    }
+    eraseAt(index);
+    return 1;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+void FlatHashMap<K, V, Hash, KeyEqual, Allocator>::swap(FlatHashMap& other) noexcept {
+    swapStorage(other);
+    if constexpr (AllocTraits::propagate_on_container_swap::value) {
+        using std::swap;
+        swap(alloc_, other.alloc_);
+    }
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+V& FlatHashMap<K, V, Hash, KeyEqual, Allocator>::operator[](const K& key) {
+    return tryEmplaceImpl(key).first->second;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+V& FlatHashMap<K, V, Hash, KeyEqual, Allocator>::operator[](K&& key) {
+    return tryEmplaceImpl(std::move(key)).first->second;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+template <typename Key>
+V& FlatHashMap<K, V, Hash, KeyEqual, Allocator>::at(const key_arg<Key>& key) {
+    const std::size_t index = findIndex(key, hash_(key));
+    if (DGA_UNLIKELY(index == kNotFound)) {
+        detail::hashMapKeyNotFound();
+    }
+    return slots_[index].value.second;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+template <typename Key>
+const V& FlatHashMap<K, V, Hash, KeyEqual, Allocator>::at(const key_arg<Key>& key) const {
+    const std::size_t index = findIndex(key, hash_(key));
+    if (DGA_UNLIKELY(index == kNotFound)) {
+        detail::hashMapKeyNotFound();
+    }
+    return slots_[index].value.second;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+template <typename Key>
+typename FlatHashMap<K, V, Hash, KeyEqual, Allocator>::iterator
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::find(
+    const key_arg<Key>& key) {
+    const std::size_t index = findIndex(key, hash_(key));
+    return index == kNotFound ? end() : iteratorAt(index);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+template <typename Key>
+typename FlatHashMap<K, V, Hash, KeyEqual, Allocator>::const_iterator
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::find(const key_arg<Key>& key) const {
+    const std::size_t index = findIndex(key, hash_(key));
+    return index == kNotFound ? end() : iteratorAt(index);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+template <typename Key>
+bool FlatHashMap<K, V, Hash, KeyEqual, Allocator>::contains(const key_arg<Key>& key) const {
+    return findIndex(key, hash_(key)) != kNotFound;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+template <typename Key>
+typename FlatHashMap<K, V, Hash, KeyEqual, Allocator>::size_type
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::count(
+    const key_arg<Key>& key) const {
+    return contains<Key>(key) ? 1 : 0;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+typename FlatHashMap<K, V, Hash, KeyEqual, Allocator>::size_type
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::capacityFor(size_type count) noexcept {
+    size_type capacity = kGroupWidth;
+    while (maxGrowth(capacity) < count) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+void FlatHashMap<K, V, Hash, KeyEqual, Allocator>::setCtrl(std::size_t index,
+                                                           detail::HashCtrl h) noexcept {
+    ctrl_[index] = h;
+    // The first group is mirrored after the end, so that a group can be loaded from any index
+    // without wrapping around.
+    if (index < kGroupWidth) {
+        ctrl_[capacity_ + index] = h;
+    }
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+template <typename Key>
+std::size_t
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::findIndex(const Key& key, std::size_t hash) const {
+    if (capacity_ == 0) {
+        return kNotFound;
+    }
+    const std::size_t mask = capacity_ - 1;
+    const detail::HashCtrl tag = h2(hash);
+    std::size_t index = h1(hash) & mask;
+    // Triangular probing over groups, which visits every group when the capacity is a power of
+    // two.
+    for (std::size_t step = kGroupWidth;; step += kGroupWidth) {
+        const detail::HashGroup group{ctrl_ + index};
+        for (auto match = group.match(tag); match; match.clearLowest()) {
+            const std::size_t candidate = (index + match.lowest()) & mask;
+            if (DGA_LIKELY(equal_(slots_[candidate].value.first, key))) {
+                return candidate;
+            }
+        }
+        if (DGA_LIKELY(group.matchEmpty())) {
+            return kNotFound;
+        }
+        index = (index + step) & mask;
+    }
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::findInsertIndex(std::size_t hash) const noexcept {
+    const std::size_t mask = capacity_ - 1;
+    std::size_t index = h1(hash) & mask;
+    for (std::size_t step = kGroupWidth;; step += kGroupWidth) {
+        if (auto match = detail::HashGroup{ctrl_ + index}.matchEmptyOrDeleted()) {
+            return (index + match.lowest()) & mask;
+        }
+        index = (index + step) & mask;
+    }
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t FlatHashMap<K, V, Hash, KeyEqual, Allocator>::prepareInsert(std::size_t hash) {
+    if (capacity_ == 0) {
+        resize(kGroupWidth);
+        return findInsertIndex(hash);
+    }
+    std::size_t index = findInsertIndex(hash);
+    // Reusing a tombstone doesn't reduce the number of empty slots, so never needs to grow.
+    if (DGA_UNLIKELY(growth_left_ == 0 && ctrl_[index] == detail::kCtrlEmpty)) {
+        // If tombstones are taking up more than half of the space, clean them up instead of
+        // growing.
+        resize(size_ * 2 < maxGrowth(capacity_) ? capacity_ : capacity_ * 2);
+        index = findInsertIndex(hash);
+    }
+    return index;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+void FlatHashMap<K, V, Hash, KeyEqual, Allocator>::commitInsert(std::size_t index,
+                                                                std::size_t hash) noexcept {
+    if (ctrl_[index] == detail::kCtrlEmpty) {
+        --growth_left_;
+    }
+    setCtrl(index, h2(hash));
+    ++size_;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+template <typename Key, typename... Args>
+std::pair<typename FlatHashMap<K, V, Hash, KeyEqual, Allocator>::iterator, bool>
+FlatHashMap<K, V, Hash, KeyEqual, Allocator>::tryEmplaceImpl(Key&& key, Args&&... args) {
+    const std::size_t hash = hash_(key);
+    std::size_t index = findIndex(key, hash);
+    if (index != kNotFound) {
+        return {iteratorAt(index), false};
+    }
+    index = prepareInsert(hash);
+    new (&slots_[index].value)
+        value_type(std::piecewise_construct, std::forward_as_tuple(std::forward<Key>(key)),
+                   std::forward_as_tuple(std::forward<Args>(args)...));
+    commitInsert(index, hash);
+    return {iteratorAt(index), true};
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+void FlatHashMap<K, V, Hash, KeyEqual, Allocator>::eraseAt(std::size_t index) noexcept {
+    slots_[index].value.~value_type();
+    --size_;
+
+    // If there has never been a full group of slots around 'index', then no probe sequence can
+    // have passed over it, and the slot can be marked as empty rather than as a tombstone.
+    const std::size_t mask = capacity_ - 1;
+    const auto empty_before = detail::HashGroup{ctrl_ + ((index - kGroupWidth) & mask)}.matchEmpty();
+    const auto empty_after = detail::HashGroup{ctrl_ + index}.matchEmpty();
+    const bool was_never_full =
+        empty_before && empty_after &&
+        std::size_t(empty_after.trailingZeros() + empty_before.leadingZeros()) < kGroupWidth;
+    if (was_never_full) {
+        setCtrl(index, detail::kCtrlEmpty);
+        ++growth_left_;
+    } else {
+        setCtrl(index, detail::kCtrlDeleted);
+    }
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+void FlatHashMap<K, V, Hash, KeyEqual, Allocator>::allocate(size_type capacity) {
+    CtrlAllocator ctrl_alloc{alloc_};
+    SlotAllocator slot_alloc{alloc_};
+    detail::HashCtrl* ctrl =
+        std::allocator_traits<CtrlAllocator>::allocate(ctrl_alloc, capacity + kGroupWidth);
+#ifndef DGA_HAS_EXCEPTIONS
+    slots_ = std::allocator_traits<SlotAllocator>::allocate(slot_alloc, capacity);
+#else
+    try {
+        slots_ = std::allocator_traits<SlotAllocator>::allocate(slot_alloc, capacity);
+    } catch (...) {
+        std::allocator_traits<CtrlAllocator>::deallocate(ctrl_alloc, ctrl, capacity + kGroupWidth);
+        throw;
+    }
+#endif
+    ctrl_ = ctrl;
+    std::memset(ctrl_, detail::kCtrlEmpty, capacity + kGroupWidth);
+    capacity_ = capacity;
+    growth_left_ = maxGrowth(capacity);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+void FlatHashMap<K, V, Hash, KeyEqual, Allocator>::deallocate() noexcept {
+    if (capacity_ > 0) {
+        freeArrays(ctrl_, slots_, capacity_);
+    }
+    ctrl_ = nullptr;
+    slots_ = nullptr;
+    capacity_ = 0;
+    growth_left_ = 0;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+void FlatHashMap<K, V, Hash, KeyEqual, Allocator>::freeArrays(detail::HashCtrl* ctrl, Slot* slots,
+                                                              size_type capacity) noexcept {
+    CtrlAllocator ctrl_alloc{alloc_};
+    SlotAllocator slot_alloc{alloc_};
+    // Free in the opposite order to allocate(), which lets a stack-like allocator (such as an
+    // ArenaAllocator) reclaim both arrays.
+    std::allocator_traits<SlotAllocator>::deallocate(slot_alloc, slots, capacity);
+    std::allocator_traits<CtrlAllocator>::deallocate(ctrl_alloc, ctrl, capacity + kGroupWidth);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+template <typename Other>
+void FlatHashMap<K, V, Hash, KeyEqual, Allocator>::insertUnique(Other&& other) {
+    // Every key is unique, so there's no need to look for an existing element.
+    for (auto& value : other) {
+        const std::size_t hash = hash_(value.first);
+        const std::size_t index = findInsertIndex(hash);
+        if constexpr (std::is_lvalue_reference_v<Other>) {
+            new (&slots_[index].value) value_type(value);
+        } else {
+            new (&slots_[index].value) value_type(std::move(value.first), std::move(value.second));
+        }
+        commitInsert(index, hash);
+    }
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+void FlatHashMap<K, V, Hash, KeyEqual, Allocator>::swapStorage(FlatHashMap& other) noexcept {
+    using std::swap;
+    swap(ctrl_, other.ctrl_);
+    swap(slots_, other.slots_);
+    swap(size_, other.size_);
+    swap(capacity_, other.capacity_);
+    swap(growth_left_, other.growth_left_);
+    swap(hash_, other.hash_);
+    swap(equal_, other.equal_);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+void FlatHashMap<K, V, Hash, KeyEqual, Allocator>::swapWithAllocator(FlatHashMap& other) noexcept {
+    using std::swap;
+    swapStorage(other);
+    swap(alloc_, other.alloc_);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+void FlatHashMap<K, V, Hash, KeyEqual, Allocator>::destroyAll() noexcept {
+    if constexpr (!std::is_trivially_destructible_v<value_type>) {
+        for (std::size_t i = 0; i < capacity_; ++i) {
+            if (ctrl_[i] >= 0) {
+                slots_[i].value.~value_type();
+            }
+        }
+    }
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+void FlatHashMap<K, V, Hash, KeyEqual, Allocator>::resize(size_type capacity) {
+    detail::HashCtrl* old_ctrl = ctrl_;
+    Slot* old_slots = slots_;
+    const size_type old_capacity = capacity_;
+
+    allocate(capacity);
+    for (std::size_t i = 0; i < old_capacity; ++i) {
+        if (old_ctrl[i] >= 0) {
+            auto& old_value = old_slots[i].mutable_value;
+            const std::size_t hash = hash_(old_value.first);
+            const std::size_t index = findInsertIndex(hash);
+            new (&slots_[index].mutable_value) std::pair<K, V>(std::move(old_value));
+            old_value.~pair();
+            // Only the control byte changes, as the size is unaffected.
+            setCtrl(index, h2(hash));
+            --growth_left_;
+        }
+    }
+
+    if (old_capacity > 0) {
+        freeArrays(old_ctrl, old_slots, old_capacity);
+    }
+}
+}  // namespace dga
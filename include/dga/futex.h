@@ -0,0 +1,181 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#pragma once
+
+#include "../dga/aliases.h"
+#include "../dga/platform.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+
+#if DGA_PLATFORM == DGA_LINUX && !defined(DGA_EMSCRIPTEN)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#define DGA_FUTEX_LINUX
+#elif DGA_PLATFORM == DGA_WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#if defined(DGA_MSVC)
+#pragma comment(lib, "Synchronization.lib")
+#endif
+#define DGA_FUTEX_WIN32
+#elif DGA_PLATFORM == DGA_MACOS
+#define DGA_FUTEX_MACOS
+#else
+#include <condition_variable>
+#include <mutex>
+#define DGA_FUTEX_PARKING_LOT
+#endif
+
+#if defined(DGA_ARCH_X86_64) || defined(DGA_ARCH_X86)
+#include <emmintrin.h>
+#endif
+
+/*
+ * Low level primitives to block a thread until a 32-bit atomic word changes. These are built on
+ * the futex syscall on Linux, WaitOnAddress on Windows and __ulock_wait on macOS. Other platforms
+ * fall back to a small table of mutexes and condition variables.
+ *
+ * As with the underlying syscalls, waits can return spuriously, so the caller must always re-check
+ * the condition that it's waiting for in a loop.
+ */
+
+#if defined(DGA_FUTEX_MACOS)
+extern "C" int __ulock_wait(uint32_t operation, void* addr, uint64_t value, uint32_t timeout_us);
+extern "C" int __ulock_wake(uint32_t operation, void* addr, uint64_t wake_value);
+#endif
+
+namespace dga {
+/// Hints to the CPU that the current thread is in a spin loop.
+DGA_FORCE_INLINE void cpuRelax() noexcept {
+#if defined(DGA_ARCH_X86_64) || defined(DGA_ARCH_X86)
+    _mm_pause();
+#elif (defined(DGA_ARCH_ARM64) || defined(DGA_ARCH_ARM)) && !defined(DGA_MSVC)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+namespace detail {
+#if defined(DGA_FUTEX_MACOS)
+constexpr uint32_t kUlockCompareAndWait = 1;
+constexpr uint32_t kUlockWakeAll = 0x00000100;
+constexpr uint32_t kUlockNoErrno = 0x01000000;
+#elif defined(DGA_FUTEX_PARKING_LOT)
+struct ParkingBucket {
+    std::mutex mutex;
+    std::condition_variable cv;
+};
+
+inline ParkingBucket& parkingBucket(const void* address) noexcept {
+    static ParkingBucket buckets[64];
+    return buckets[(reinterpret_cast<uintptr>(address) >> 4) % 64];
+}
+#endif
+
+inline u32* futexAddress(std::atomic<u32>& word) noexcept {
+    static_assert(sizeof(std::atomic<u32>) == sizeof(u32) && std::atomic<u32>::is_always_lock_free,
+                  "std::atomic<u32> must have the same representation as u32.");
+    return reinterpret_cast<u32*>(&word);
+}
+}  // namespace detail
+
+/// Blocks the calling thread while 'word' contains 'expected'.
+inline void futexWait(std::atomic<u32>& word, u32 expected) noexcept {
+#if defined(DGA_FUTEX_LINUX)
+    syscall(SYS_futex, detail::futexAddress(word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr,
+            0);
+#elif defined(DGA_FUTEX_WIN32)
+    WaitOnAddress(detail::futexAddress(word), &expected, sizeof(u32), INFINITE);
+#elif defined(DGA_FUTEX_MACOS)
+    __ulock_wait(detail::kUlockCompareAndWait | detail::kUlockNoErrno, detail::futexAddress(word),
+                 expected, 0);
+#else
+    auto& bucket = detail::parkingBucket(&word);
+    std::unique_lock<std::mutex> lock{bucket.mutex};
+    if (word.load(std::memory_order_relaxed) == expected) {
+        bucket.cv.wait(lock);
+    }
+#endif
+}
+
+/// Blocks the calling thread while 'word' contains 'expected', for at most 'timeout'. Returns false
+/// if the timeout expired.
+template <class Rep, class Period>
+bool futexWaitFor(std::atomic<u32>& word, u32 expected,
+                  const std::chrono::duration<Rep, Period>& timeout) noexcept {
+    using namespace std::chrono;
+    if (timeout <= timeout.zero()) {
+        return word.load(std::memory_order_relaxed) != expected;
+    }
+    const auto ns = duration_cast<nanoseconds>(timeout).count();
+#if defined(DGA_FUTEX_LINUX)
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(ns / 1000000000);
+    ts.tv_nsec = static_cast<long>(ns % 1000000000);
+    return syscall(SYS_futex, detail::futexAddress(word), FUTEX_WAIT_PRIVATE, expected, &ts,
+                   nullptr, 0) == 0 ||
+           errno != ETIMEDOUT;
+#elif defined(DGA_FUTEX_WIN32)
+    // Round up, so that we never wake before the timeout.
+    const auto ms = (ns + 999999) / 1000000;
+    const DWORD wait_ms = ms >= INFINITE ? INFINITE - 1 : static_cast<DWORD>(ms);
+    return WaitOnAddress(detail::futexAddress(word), &expected, sizeof(u32), wait_ms) ||
+           GetLastError() != ERROR_TIMEOUT;
+#elif defined(DGA_FUTEX_MACOS)
+    const auto us = (ns + 999) / 1000;
+    const uint32_t wait_us = us >= UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(us);
+    const int result =
+        __ulock_wait(detail::kUlockCompareAndWait | detail::kUlockNoErrno,
+                     detail::futexAddress(word), expected, wait_us);
+    return result != -ETIMEDOUT;
+#else
+    auto& bucket = detail::parkingBucket(&word);
+    std::unique_lock<std::mutex> lock{bucket.mutex};
+    if (word.load(std::memory_order_relaxed) != expected) {
+        return true;
+    }
+    return bucket.cv.wait_for(lock, nanoseconds{ns}) == std::cv_status::no_timeout;
+#endif
+}
+
+/// Wakes up to 'count' threads that are blocked in futexWait on 'word'.
+inline void futexWake(std::atomic<u32>& word, u32 count) noexcept {
+#if defined(DGA_FUTEX_LINUX)
+    syscall(SYS_futex, detail::futexAddress(word), FUTEX_WAKE_PRIVATE,
+            count > u32(INT_MAX) ? INT_MAX : static_cast<int>(count), nullptr, nullptr, 0);
+#elif defined(DGA_FUTEX_WIN32)
+    if (count == 1) {
+        WakeByAddressSingle(detail::futexAddress(word));
+    } else {
+        WakeByAddressAll(detail::futexAddress(word));
+    }
+#elif defined(DGA_FUTEX_MACOS)
+    __ulock_wake(detail::kUlockCompareAndWait | detail::kUlockNoErrno |
+                     (count == 1 ? 0 : detail::kUlockWakeAll),
+                 detail::futexAddress(word), 0);
+#else
+    // Buckets are shared between addresses, so every waiter has to be woken.
+    auto& bucket = detail::parkingBucket(&word);
+    {
+        std::lock_guard<std::mutex> lock{bucket.mutex};
+    }
+    bucket.cv.notify_all();
+#endif
+}
+
+/// Wakes one thread that is blocked in futexWait on 'word'.
+inline void futexWakeOne(std::atomic<u32>& word) noexcept {
+    futexWake(word, 1);
+}
+
+/// Wakes all threads that are blocked in futexWait on 'word'.
+inline void futexWakeAll(std::atomic<u32>& word) noexcept {
+    futexWake(word, ~u32(0));
+}
+}  // namespace dga
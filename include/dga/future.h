@@ -0,0 +1,421 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#pragma once
+
+#include "../dga/aliases.h"
+#include "../dga/arena.h"
+#include "../dga/futex.h"
+#include "../dga/platform.h"
+#include "../dga/result.h"
+#include "../dga/thread_pool.h"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/*
+ * A one-shot Promise and Future which carry a Result<T, E>, so a value computed on another thread
+ * (or received from the network) arrives with a typed error rather than an exception:
+ *
+ *     dga::Promise<Reply, RpcError> promise;
+ *     dga::Future<Reply, RpcError> future = promise.get_future();
+ *     client.send(request, [p = std::move(promise)](Reply reply) mutable { p.set_value(reply); });
+ *     DGA_TRY_ASSIGN(Reply reply, future.get());
+ *
+ * A promise is completed exactly once, with set_value, set_error or set_result, which also
+ * releases it. Completing a promise twice is a bug, and is caught by an assert. Destroying (or
+ * assigning over) a promise whose future has been retrieved, without completing it, would leave
+ * the future waiting forever, so it calls fatalError instead, in every build.
+ *
+ * The promise and future share a small state block, which is allocated from a Pool rather than
+ * with malloc, and is freed when both sides have let go of it. Completion is signalled through a
+ * single 32-bit word: waiting blocks on it with futexWait, and completing only enters the kernel to
+ * wake a thread if one is actually waiting.
+ *
+ * then(f) attaches a continuation, which is called with the Result<T, E> once it's available, and
+ * returns a future for the continuation's result. If the continuation returns a Result<U, G>, the
+ * new future is a Future<U, G>, otherwise a continuation returning U gives a Future<U, E> (so
+ * returning void gives a Future<void, E>). then(f) runs the continuation inline, on the thread that
+ * completes the promise, or on the calling thread if the future is already complete. then(pool, f)
+ * submits the continuation to a ThreadPool instead, which suits continuations that do real work.
+ * Either way, then() consumes the future. Continuations mustn't throw, and should report failures
+ * through the Result that they return.
+ *
+ * Blocking in get() or wait() inside a ThreadPool task can deadlock if the promise is completed by
+ * another task on the same pool, so tasks should chain work with then() instead.
+ */
+
+namespace dga {
+template <typename T, typename E> class Future;
+template <typename T, typename E> class Promise;
+
+namespace detail {
+[[noreturn]] DGA_COLD DGA_NOINLINE inline void promiseAbandoned() {
+    fatalError("Promise destroyed without being completed");
+}
+
+// A type erased continuation. invoke() is called exactly once, and frees the callback.
+class FutureCallback {
+public:
+    virtual void invoke() noexcept = 0;
+
+protected:
+    ~FutureCallback() = default;
+};
+
+template <typename F> class FutureCallbackImpl final : public FutureCallback {
+public:
+    template <typename G> explicit FutureCallbackImpl(G&& g) : fn_(std::forward<G>(g)) {
+    }
+
+    void invoke() noexcept override {
+        fn_();
+        Pool<FutureCallbackImpl>::destroy(this);
+    }
+
+private:
+    F fn_;
+};
+
+template <typename F> FutureCallback* makeFutureCallback(F&& f) {
+    return Pool<FutureCallbackImpl<std::decay_t<F>>>::create(std::forward<F>(f));
+}
+
+// The state shared by a promise and its future.
+template <typename T, typename E> class FutureState {
+public:
+    static constexpr u32 kReady = 1;
+    static constexpr u32 kHasCallback = 2;
+    static constexpr u32 kWaiting = 4;
+
+    explicit FutureState(u32 references) noexcept : references_(references) {
+    }
+
+    ~FutureState() {
+        if (flags_.load(std::memory_order_relaxed) & kReady) {
+            result_.~Result<T, E>();
+        }
+    }
+
+    FutureState(const FutureState&) = delete;
+    FutureState& operator=(const FutureState&) = delete;
+
+    static FutureState* create(u32 references) {
+        return Pool<FutureState>::create(references);
+    }
+
+    void acquire() noexcept {
+        references_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release() noexcept {
+        if (references_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            Pool<FutureState>::destroy(this);
+        }
+    }
+
+    bool ready() const noexcept {
+        return flags_.load(std::memory_order_acquire) & kReady;
+    }
+
+    Result<T, E>& result() noexcept {
+        assert(ready());
+        return result_;
+    }
+
+    // Constructs the result from 'args', then wakes any waiters and runs the callback if one has
+    // been set.
+    template <typename... Args> void complete(Args&&... args) {
+        new (&result_) Result<T, E>(std::forward<Args>(args)...);
+        const u32 previous = flags_.fetch_or(kReady, std::memory_order_acq_rel);
+        assert(!(previous & kReady));
+        if (previous & kWaiting) {
+            futexWakeAll(flags_);
+        }
+        if (previous & kHasCallback) {
+            callback_->invoke();
+        }
+    }
+
+    // Sets the callback to run on completion. If the state is already complete, the callback runs
+    // now.
+    void setCallback(FutureCallback* callback) noexcept {
+        callback_ = callback;
+        const u32 previous = flags_.fetch_or(kHasCallback, std::memory_order_acq_rel);
+        if (previous & kReady) {
+            callback_->invoke();
+        }
+    }
+
+    void wait() noexcept {
+        u32 flags = flags_.load(std::memory_order_acquire);
+        while (!(flags & kReady)) {
+            if (!(flags & kWaiting)) {
+                if (!flags_.compare_exchange_weak(flags, flags | kWaiting,
+                                                  std::memory_order_acquire)) {
+                    continue;
+                }
+                flags |= kWaiting;
+            }
+            futexWait(flags_, flags);
+            flags = flags_.load(std::memory_order_acquire);
+        }
+    }
+
+    template <class Clock, class Duration>
+    bool wait_until(const std::chrono::time_point<Clock, Duration>& deadline) noexcept {
+        u32 flags = flags_.load(std::memory_order_acquire);
+        while (!(flags & kReady)) {
+            if (!(flags & kWaiting)) {
+                if (!flags_.compare_exchange_weak(flags, flags | kWaiting,
+                                                  std::memory_order_acquire)) {
+                    continue;
+                }
+                flags |= kWaiting;
+            }
+            const auto now = Clock::now();
+            if (now >= deadline) {
+                return false;
+            }
+            futexWaitFor(flags_, flags, deadline - now);
+            flags = flags_.load(std::memory_order_acquire);
+        }
+        return true;
+    }
+
+private:
+    std::atomic<u32> flags_{0};
+    std::atomic<u32> references_;
+    FutureCallback* callback_ = nullptr;
+    union {
+        Result<T, E> result_;
+    };
+};
+
+// Calls a continuation, and converts whatever it returns to a Result.
+template <typename E, typename F, typename Arg> auto invokeContinuation(F& fn, Arg&& arg) {
+    using R = std::invoke_result_t<F&, Arg&&>;
+    if constexpr (is_result_v<R>) {
+        return fn(std::forward<Arg>(arg));
+    } else if constexpr (std::is_void_v<R>) {
+        fn(std::forward<Arg>(arg));
+        return Result<void, E>{};
+    } else {
+        return Result<R, E>{fn(std::forward<Arg>(arg))};
+    }
+}
+
+template <typename T, typename E, typename F>
+using continuation_result_t =
+    decltype(invokeContinuation<E>(std::declval<F&>(), std::declval<Result<T, E>&&>()));
+}  // namespace detail
+
+template <typename T, typename E> class Future {
+public:
+    using value_type = T;
+    using error_type = E;
+
+    // Constructs a future that isn't associated with a promise.
+    Future() noexcept = default;
+
+    Future(Future&& rhs) noexcept : state_(std::exchange(rhs.state_, nullptr)) {
+    }
+
+    Future& operator=(Future&& rhs) noexcept {
+        if (this != &rhs) {
+            reset();
+            state_ = std::exchange(rhs.state_, nullptr);
+        }
+        return *this;
+    }
+
+    Future(const Future&) = delete;
+    Future& operator=(const Future&) = delete;
+
+    ~Future() {
+        reset();
+    }
+
+    // Returns true if the future refers to a promise, i.e. it hasn't been consumed by get() or
+    // then().
+    bool valid() const noexcept {
+        return state_ != nullptr;
+    }
+
+    // Returns true if the result is available, so get() won't block.
+    bool is_ready() const noexcept {
+        assert(valid());
+        return state_->ready();
+    }
+
+    // Blocks until the result is available.
+    void wait() const noexcept {
+        assert(valid());
+        state_->wait();
+    }
+
+    // Blocks until the result is available or 'timeout' has passed. Returns false on timeout.
+    template <class Rep, class Period>
+    bool wait_for(const std::chrono::duration<Rep, Period>& timeout) const noexcept {
+        return wait_until(std::chrono::steady_clock::now() + timeout);
+    }
+
+    template <class Clock, class Duration>
+    bool wait_until(const std::chrono::time_point<Clock, Duration>& deadline) const noexcept {
+        assert(valid());
+        return state_->wait_until(deadline);
+    }
+
+    // Blocks until the result is available, and returns it. The future is no longer valid
+    // afterwards.
+    Result<T, E> get() {
+        assert(valid());
+        state_->wait();
+        Result<T, E> result{std::move(state_->result())};
+        reset();
+        return result;
+    }
+
+    // Calls fn(Result<T, E>) once the result is available, on the thread that completes the
+    // promise, or immediately if the result is already available.
+    template <typename F> auto then(F&& fn) {
+        return chain(std::forward<F>(fn), [](auto&& continuation) {
+            return detail::makeFutureCallback(std::forward<decltype(continuation)>(continuation));
+        });
+    }
+
+    // Submits fn(Result<T, E>) to 'pool' once the result is available.
+    template <typename F> auto then(ThreadPool& pool, F&& fn) {
+        return chain(std::forward<F>(fn), [&pool](auto&& continuation) {
+            return detail::makeFutureCallback(
+                [&pool, c = std::forward<decltype(continuation)>(continuation)]() mutable {
+                    pool.submit(std::move(c));
+                });
+        });
+    }
+
+private:
+    detail::FutureState<T, E>* state_ = nullptr;
+
+    explicit Future(detail::FutureState<T, E>* state) noexcept : state_(state) {
+    }
+
+    void reset() noexcept {
+        if (state_) {
+            std::exchange(state_, nullptr)->release();
+        }
+    }
+
+    template <typename F, typename MakeCallback> auto chain(F&& fn, MakeCallback make_callback) {
+        using R = detail::continuation_result_t<T, E, std::decay_t<F>>;
+        assert(valid());
+
+        Promise<typename R::value_type, typename R::error_type> promise;
+        auto next = promise.get_future();
+        // The callback takes over this future's reference to the state.
+        detail::FutureState<T, E>* state = std::exchange(state_, nullptr);
+        auto continuation = [state, promise = std::move(promise),
+                             fn = std::forward<F>(fn)]() mutable {
+            promise.set_result(detail::invokeContinuation<E>(fn, std::move(state->result())));
+            state->release();
+        };
+        state->setCallback(make_callback(std::move(continuation)));
+        return next;
+    }
+
+    template <typename U, typename G> friend class Future;
+    friend class Promise<T, E>;
+    template <typename U, typename G> friend Future<U, G> makeReadyFuture(Result<U, G> result);
+};
+
+template <typename T, typename E> class Promise {
+public:
+    // Creates a promise with a new shared state.
+    Promise() : state_(detail::FutureState<T, E>::create(1)) {
+    }
+
+    Promise(Promise&& rhs) noexcept
+        : state_(std::exchange(rhs.state_, nullptr)),
+          future_retrieved_(std::exchange(rhs.future_retrieved_, false)) {
+    }
+
+    Promise& operator=(Promise&& rhs) noexcept {
+        if (this != &rhs) {
+            reset();
+            state_ = std::exchange(rhs.state_, nullptr);
+            future_retrieved_ = std::exchange(rhs.future_retrieved_, false);
+        }
+        return *this;
+    }
+
+    Promise(const Promise&) = delete;
+    Promise& operator=(const Promise&) = delete;
+
+    ~Promise() {
+        reset();
+    }
+
+    // Returns the future associated with this promise. May only be called once.
+    Future<T, E> get_future() noexcept {
+        assert(state_ && !future_retrieved_);
+        future_retrieved_ = true;
+        state_->acquire();
+        return Future<T, E>{state_};
+    }
+
+    // Completes the promise with a value constructed from 'args'.
+    template <typename... Args> void set_value(Args&&... args) {
+        if constexpr (std::is_void_v<T>) {
+            static_assert(sizeof...(Args) == 0, "A Promise<void, E> is completed with no value.");
+            set_result(Result<T, E>{});
+        } else {
+            set_result(Result<T, E>{T(std::forward<Args>(args)...)});
+        }
+    }
+
+    // Completes the promise with an error constructed from 'args'.
+    template <typename... Args> void set_error(Args&&... args) {
+        complete(Error<E>{E(std::forward<Args>(args)...)});
+    }
+
+    // Completes the promise with 'result'. Continuations attached with then(f) run before this
+    // returns.
+    void set_result(Result<T, E> result) {
+        complete(std::move(result));
+    }
+
+private:
+    detail::FutureState<T, E>* state_;
+    bool future_retrieved_ = false;
+
+    // Constructs the result in the shared state, so that set_error doesn't need to move a
+    // temporary Result.
+    template <typename... Args> void complete(Args&&... args) {
+        assert(state_ && "The promise has already been completed.");
+        detail::FutureState<T, E>* state = std::exchange(state_, nullptr);
+        state->complete(std::forward<Args>(args)...);
+        state->release();
+    }
+
+    // Nothing can be waiting on a promise that was never asked for its future, so it's only fatal
+    // to abandon one that was.
+    void reset() noexcept {
+        if (state_) {
+            if (DGA_UNLIKELY(future_retrieved_)) {
+                detail::promiseAbandoned();
+            }
+            std::exchange(state_, nullptr)->release();
+        }
+    }
+};
+
+/// Returns a future which already holds 'result'.
+template <typename T, typename E> Future<T, E> makeReadyFuture(Result<T, E> result) {
+    auto* state = detail::FutureState<T, E>::create(1);
+    state->complete(std::move(result));
+    return Future<T, E>{state};
+}
+}  // namespace dga
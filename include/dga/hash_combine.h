@@ -2,20 +2,253 @@
  * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
 #pragma once
 
+#include "../dga/aliases.h"
+#include "../dga/platform.h"
+
+#include <cstring>
 #include <functional>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#if defined(DGA_MSVC) && defined(DGA_ARCH_X86_64)
+#include <intrin.h>
+#endif
 
 /*
  * Extended version of boost::hash_combine that supports multiple values at once.
+ *
+ * The mixing is based on wyhash (https://github.com/wangyi-fudan/wyhash): values are folded
+ * together with a 64x64->128 bit multiply, then the high and low halves are xor'd together. This
+ * avalanches well even when the input hashes are poor, such as std::hash for integers, which is
+ * the identity function on libstdc++ and libc++.
+ *
+ * dga::Hash<T> is the hash function used by hashCombine. It hashes integers, enums and pointers
+ * with a single multiply-fold, and strings as a block of bytes with hashBytes. Pointers are hashed
+ * by address, including const char*. Other types with a std::hash<T> specialization use it,
+ * followed by a finalizer, so a type whose std::hash agrees with a custom operator== keeps working.
+ * Types without one are hashed as one block of memory if their object representation is unique (a
+ * struct of integers with no padding, for example). Specialize is_trivially_hashable to opt such a
+ * type in or out of being hashed as raw memory, or specialize Hash<T> itself to customize it
+ * entirely.
+ *
+ * Hash values may differ between platforms and library versions, so shouldn't be persisted.
+ *
+ * hashString is a constexpr FNV-1a hash, which gives the same value at compile time and at run
+ * time. Together with the _h literal, it can be used to switch on strings:
+ *
+ *     using namespace dga::literals;
+ *     switch (dga::hashString(method)) {
+ *     case "GET"_h: ...
+ *     case "POST"_h: ...
+ *     }
+ *
+ * A different string can have the same hash as one of the labels, so each case should still
+ * compare the string itself if the input isn't trusted. hashesAreDistinct checks a set of labels
+ * for collisions at compile time. Unlike the other hashes here, hashString is stable across
+ * platforms, as it only depends on the bytes of the string.
  */
 
 namespace dga {
+namespace detail {
+constexpr u64 kHashSecret[4] = {0xa0761d6478bd642full, 0xe7037ed1a0b428dbull,
+                                0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull};
+
+// 64x64->128 bit multiply, storing the low half in 'a' and the high half in 'b'.
+inline void hashMultiply(u64& a, u64& b) noexcept {
+#if defined(__SIZEOF_INT128__)
+    const unsigned __int128 r = static_cast<unsigned __int128>(a) * b;
+    a = static_cast<u64>(r);
+    b = static_cast<u64>(r >> 64);
+#elif defined(DGA_MSVC) && defined(DGA_ARCH_X86_64)
+    a = _umul128(a, b, &b);
+#else
+    const u64 ha = a >> 32, hb = b >> 32, la = static_cast<u32>(a), lb = static_cast<u32>(b);
+    const u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    const u64 t = rl + (rm0 << 32);
+    u64 carry = t < rl;
+    const u64 lo = t + (rm1 << 32);
+    carry += lo < t;
+    a = lo;
+    b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+}
+
+// Multiplies 'a' and 'b', then folds the 128 bit result into 64 bits.
+inline u64 hashMix(u64 a, u64 b) noexcept {
+    hashMultiply(a, b);
+    return a ^ b;
+}
+
+inline u64 hashRead8(const u8* p) noexcept {
+    u64 v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+inline u64 hashRead4(const u8* p) noexcept {
+    u32 v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+// Reads 1-3 bytes.
+inline u64 hashRead3(const u8* p, std::size_t k) noexcept {
+    return (u64(p[0]) << 16) | (u64(p[k >> 1]) << 8) | p[k - 1];
+}
+}  // namespace detail
+
+// Hashes a single 64-bit value.
+inline u64 hash64(u64 value) noexcept {
+    return detail::hashMix(value ^ detail::kHashSecret[0], detail::kHashSecret[1]);
+}
+
+// Combines a hash 'value' into 'seed'. The result depends on the order that values are combined.
+inline u64 hashCombine64(u64 seed, u64 value) noexcept {
+    return detail::hashMix(seed ^ detail::kHashSecret[0], value ^ detail::kHashSecret[1]);
+}
+
+// Hashes 'size' bytes starting at 'data' as a single contiguous block.
+inline u64 hashBytes(const void* data, std::size_t size, u64 seed = 0) noexcept {
+    using detail::hashMix;
+    using detail::hashRead3;
+    using detail::hashRead4;
+    using detail::hashRead8;
+    constexpr const u64* s = detail::kHashSecret;
+
+    const u8* p = static_cast<const u8*>(data);
+    seed ^= hashMix(seed ^ s[0], s[1]);
+    u64 a, b;
+    if (DGA_LIKELY(size <= 16)) {
+        if (size >= 4) {
+            // Read two (possibly overlapping) 4 byte words from each end.
+            const std::size_t offset = (size >> 3) << 2;
+            a = (hashRead4(p) << 32) | hashRead4(p + offset);
+            b = (hashRead4(p + size - 4) << 32) | hashRead4(p + size - 4 - offset);
+        } else if (size > 0) {
+            a = hashRead3(p, size);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        std::size_t remaining = size;
+        if (DGA_UNLIKELY(remaining > 48)) {
+            // Three independent lanes, so the multiplies can run in parallel.
+            u64 seed1 = seed, seed2 = seed;
+            do {
+                seed = hashMix(hashRead8(p) ^ s[1], hashRead8(p + 8) ^ seed);
+                seed1 = hashMix(hashRead8(p + 16) ^ s[2], hashRead8(p + 24) ^ seed1);
+                seed2 = hashMix(hashRead8(p + 32) ^ s[3], hashRead8(p + 40) ^ seed2);
+                p += 48;
+                remaining -= 48;
+            } while (DGA_LIKELY(remaining > 48));
+            seed ^= seed1 ^ seed2;
+        }
+        while (DGA_UNLIKELY(remaining > 16)) {
+            seed = hashMix(hashRead8(p) ^ s[1], hashRead8(p + 8) ^ seed);
+            p += 16;
+            remaining -= 16;
+        }
+        // The last 16 bytes, which may overlap with bytes that have already been hashed.
+        a = hashRead8(p + remaining - 16);
+        b = hashRead8(p + remaining - 8);
+    }
+    a ^= s[1];
+    b ^= seed;
+    detail::hashMultiply(a, b);
+    return hashMix(a ^ s[0] ^ size, b ^ s[1]);
+}
+
+// Whether a T can be hashed by hashing its object representation. True by default for types
+// where equal values always have identical bytes, such as integers and structs of integers
+// without padding.
+template <typename T>
+struct is_trivially_hashable : std::bool_constant<std::has_unique_object_representations_v<T>> {
+};
+
+template <typename T>
+inline constexpr bool is_trivially_hashable_v = is_trivially_hashable<T>::value;
+
+namespace detail {
+// True if std::hash<T> is enabled, i.e. the standard library or the user has specialized it.
+// Disabled specializations are not default constructible.
+template <typename T>
+constexpr bool has_std_hash_v = std::is_default_constructible_v<std::hash<T>> &&
+                                std::is_invocable_r_v<std::size_t, const std::hash<T>&, const T&>;
+}  // namespace detail
+
+template <typename T, typename Enable = void> struct Hash {
+    std::size_t operator()(const T& value) const noexcept {
+        if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+            return static_cast<std::size_t>(hash64(static_cast<u64>(value)));
+        } else if constexpr (std::is_pointer_v<T>) {
+            return static_cast<std::size_t>(hash64(reinterpret_cast<uintptr>(value)));
+        } else if constexpr (detail::has_std_hash_v<T>) {
+            return static_cast<std::size_t>(hash64(std::hash<T>{}(value)));
+        } else {
+            static_assert(is_trivially_hashable_v<T>,
+                          "dga::Hash<T> requires std::hash<T>, or a T that is trivially hashable.");
+            return static_cast<std::size_t>(hashBytes(&value, sizeof(T)));
+        }
+    }
+};
+
+// Strings are hashed by their contents. The string hashers are transparent, so any of them can be
+// used to look up std::string keys by std::string_view or a string literal. Hash<const char*> is
+// not a string hasher, and hashes the pointer.
+struct StringHash {
+    using is_transparent = void;
+
+    std::size_t operator()(std::string_view s) const noexcept {
+        return static_cast<std::size_t>(hashBytes(s.data(), s.size()));
+    }
+};
+
+template <typename Allocator>
+struct Hash<std::basic_string<char, std::char_traits<char>, Allocator>> : StringHash {};
+template <> struct Hash<std::string_view> : StringHash {};
+
+constexpr u64 kFnvOffsetBasis = 0xcbf29ce484222325ull;
+constexpr u64 kFnvPrime = 0x100000001b3ull;
+
+// Hashes a string with 64-bit FNV-1a. Can be evaluated at compile time.
+constexpr u64 hashString(std::string_view s) noexcept {
+    u64 hash = kFnvOffsetBasis;
+    for (char c : s) {
+        hash ^= static_cast<u8>(c);
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+// Returns true if none of 'strings' have the same hashString. Duplicate strings are counted as a
+// collision. Intended for use in a static_assert next to a switch on hashString.
+constexpr bool hashesAreDistinct(std::initializer_list<std::string_view> strings) noexcept {
+    for (auto i = strings.begin(); i != strings.end(); ++i) {
+        for (auto j = i + 1; j != strings.end(); ++j) {
+            if (hashString(*i) == hashString(*j)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+namespace literals {
+constexpr u64 operator""_h(const char* s, std::size_t size) noexcept {
+    return hashString(std::string_view{s, size});
+}
+}  // namespace literals
+
 inline void hashCombine(std::size_t& seed) {
 }
 
 template <typename T, typename... Ts>
 inline void hashCombine(std::size_t& seed, const T& v, const Ts&... vs) {
-    std::hash<T> hasher;
-    seed ^= hasher(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    Hash<T> hasher;
+    seed = static_cast<std::size_t>(hashCombine64(seed, hasher(v)));
     hashCombine(seed, vs...);
 }
 }  // namespace dga
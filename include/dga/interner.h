@@ -0,0 +1,316 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#pragma once
+
+#include "../dga/aliases.h"
+#include "../dga/arena.h"
+#include "../dga/bit.h"
+#include "../dga/flat_hash_map.h"
+#include "../dga/hash_combine.h"
+#include "../dga/platform.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string_view>
+
+/*
+ * String interning. A StringInterner stores each distinct string once, and returns an
+ * InternedString handle for it. Handles are a single pointer to the stored string, so comparing or
+ * hashing them is O(1) and never touches the characters, which makes them cheap keys for hash maps:
+ *
+ *     dga::StringInterner names;
+ *     dga::FlatHashMap<dga::InternedString, Metric> metrics;
+ *     metrics[names.intern(field)].add(value);
+ *
+ * Strings are copied into an Arena owned by the interner, and are stored with their hash, length,
+ * a null terminator and an id. Ids are assigned consecutively from 0 in the order that strings are
+ * first interned, so they can be used to index side tables. The characters and the handles stay
+ * valid until the interner is destroyed. Handles from different interners must not be compared.
+ *
+ * Each string is hashed once with hashBytes, and the hash is reused to probe a FlatHashMap. Looking
+ * up a string that's already interned doesn't allocate.
+ *
+ * A StringInterner is not thread-safe. ConcurrentStringInterner can be shared between threads. It
+ * splits the strings into shards by their hash, and each shard has its own arena, map and
+ * reader-writer lock, so threads interning different strings rarely contend. Strings that are
+ * already interned only take the lock in shared mode.
+ */
+
+namespace dga {
+namespace detail {
+// The header of an interned string, which is followed by the characters and a null terminator.
+struct InternEntry {
+    u64 hash;
+    u32 size;
+    u32 id;
+
+    const char* data() const noexcept {
+        return reinterpret_cast<const char*>(this + 1);
+    }
+};
+
+class InternTable;
+}  // namespace detail
+
+/// A handle to a string stored in a StringInterner or ConcurrentStringInterner. A default
+/// constructed handle doesn't refer to any string, and has an empty view.
+class InternedString {
+public:
+    static constexpr u32 kNoId = std::numeric_limits<u32>::max();
+
+    constexpr InternedString() noexcept = default;
+
+    std::string_view view() const noexcept {
+        return entry_ ? std::string_view(entry_->data(), entry_->size) : std::string_view();
+    }
+
+    operator std::string_view() const noexcept {
+        return view();
+    }
+
+    // Returns a null terminated string.
+    const char* c_str() const noexcept {
+        return entry_ ? entry_->data() : "";
+    }
+
+    std::size_t size() const noexcept {
+        return entry_ ? entry_->size : 0;
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    // Returns the index of the string in the order that strings were interned, or kNoId for a
+    // default constructed handle.
+    u32 id() const noexcept {
+        return entry_ ? entry_->id : kNoId;
+    }
+
+    // Returns true if this handle refers to a string.
+    explicit operator bool() const noexcept {
+        return entry_ != nullptr;
+    }
+
+    friend bool operator==(InternedString a, InternedString b) noexcept {
+        return a.entry_ == b.entry_;
+    }
+
+    friend bool operator!=(InternedString a, InternedString b) noexcept {
+        return a.entry_ != b.entry_;
+    }
+
+    // Orders strings by id, rather than by their contents.
+    friend bool operator<(InternedString a, InternedString b) noexcept {
+        return a.id() < b.id();
+    }
+
+private:
+    explicit InternedString(const detail::InternEntry* entry) noexcept : entry_(entry) {
+    }
+
+    const detail::InternEntry* entry_ = nullptr;
+
+    friend class detail::InternTable;
+    friend struct Hash<InternedString>;
+};
+
+// Interned strings are hashed by address.
+template <> struct Hash<InternedString> {
+    std::size_t operator()(InternedString s) const noexcept {
+        return static_cast<std::size_t>(hash64(reinterpret_cast<uintptr>(s.entry_)));
+    }
+};
+
+namespace detail {
+[[noreturn]] DGA_COLD DGA_NOINLINE inline void internedStringTooLong() {
+#ifdef DGA_NO_EXCEPTIONS
+    fatalError("StringInterner: string is too long");
+#else
+    throw std::length_error("StringInterner: string is too long");
+#endif
+}
+
+// A string and its hash, used as the key of the intern table so that each string is only hashed
+// once.
+struct InternKey {
+    std::string_view view;
+    u64 hash;
+};
+
+struct InternKeyHash {
+    std::size_t operator()(const InternKey& key) const noexcept {
+        return static_cast<std::size_t>(key.hash);
+    }
+};
+
+struct InternKeyEqual {
+    bool operator()(const InternKey& a, const InternKey& b) const noexcept {
+        return a.hash == b.hash && a.view == b.view;
+    }
+};
+
+// The storage and index shared by both interners.
+class InternTable {
+public:
+    InternedString find(std::string_view s, u64 hash) const {
+        auto it = map_.find(InternKey{s, hash});
+        return InternedString{it != map_.end() ? it->second : nullptr};
+    }
+
+    // Stores a string that isn't in the table yet.
+    InternedString insert(std::string_view s, u64 hash, u32 id) {
+        if (DGA_UNLIKELY(s.size() > std::numeric_limits<u32>::max())) {
+            internedStringTooLong();
+        }
+        void* memory = arena_.allocate(sizeof(InternEntry) + s.size() + 1, alignof(InternEntry));
+        auto* entry = new (memory) InternEntry{hash, u32(s.size()), id};
+        char* data = reinterpret_cast<char*>(entry + 1);
+        std::memcpy(data, s.data(), s.size());
+        data[s.size()] = '\0';
+        map_.try_emplace(InternKey{std::string_view(data, s.size()), hash}, entry);
+        return InternedString{entry};
+    }
+
+    void reserve(std::size_t count) {
+        map_.reserve(count);
+    }
+
+    std::size_t size() const noexcept {
+        return map_.size();
+    }
+
+    // Bytes used by the strings and their headers, not including the map.
+    std::size_t bytesUsed() const noexcept {
+        return arena_.bytesUsed();
+    }
+
+private:
+    Arena arena_;
+    FlatHashMap<InternKey, const InternEntry*, InternKeyHash, InternKeyEqual> map_;
+};
+}  // namespace detail
+
+class StringInterner {
+public:
+    StringInterner() = default;
+
+    StringInterner(const StringInterner&) = delete;
+    StringInterner& operator=(const StringInterner&) = delete;
+
+    /// Returns the handle for 's', storing a copy of it first if it hasn't been interned before.
+    InternedString intern(std::string_view s) {
+        const u64 hash = hashBytes(s.data(), s.size());
+        InternedString result = table_.find(s, hash);
+        if (DGA_LIKELY(result)) {
+            return result;
+        }
+        return table_.insert(s, hash, u32(table_.size()));
+    }
+
+    /// Returns the handle for 's' if it has been interned, or a default constructed handle.
+    InternedString find(std::string_view s) const {
+        return table_.find(s, hashBytes(s.data(), s.size()));
+    }
+
+    /// Ensures that 'count' strings can be interned without rehashing.
+    void reserve(std::size_t count) {
+        table_.reserve(count);
+    }
+
+    /// Returns the number of distinct strings.
+    std::size_t size() const noexcept {
+        return table_.size();
+    }
+
+    std::size_t bytesUsed() const noexcept {
+        return table_.bytesUsed();
+    }
+
+private:
+    detail::InternTable table_;
+};
+
+class ConcurrentStringInterner {
+public:
+    static constexpr std::size_t kDefaultShardCount = 16;
+    static constexpr std::size_t kMaxShardCount = 256;
+
+    /// Creates an interner with 'shard_count' shards, rounded up to a power of two, and at most
+    /// kMaxShardCount.
+    explicit ConcurrentStringInterner(std::size_t shard_count = kDefaultShardCount)
+        : shard_count_(shard_count <= 1 ? 1
+                                        : bit_ceil(std::min(shard_count, kMaxShardCount))),
+          shards_(new Shard[shard_count_]) {
+    }
+
+    ConcurrentStringInterner(const ConcurrentStringInterner&) = delete;
+    ConcurrentStringInterner& operator=(const ConcurrentStringInterner&) = delete;
+
+    /// Returns the handle for 's', storing a copy of it first if it hasn't been interned before.
+    InternedString intern(std::string_view s) {
+        const u64 hash = hashBytes(s.data(), s.size());
+        Shard& shard = shardFor(hash);
+        {
+            std::shared_lock<std::shared_mutex> lock{shard.mutex};
+            if (InternedString result = shard.table.find(s, hash)) {
+                return result;
+            }
+        }
+        std::lock_guard<std::shared_mutex> lock{shard.mutex};
+        // Another thread may have inserted the string after the shared lock was released.
+        if (InternedString result = shard.table.find(s, hash)) {
+            return result;
+        }
+        return shard.table.insert(s, hash, next_id_.fetch_add(1, std::memory_order_relaxed));
+    }
+
+    /// Returns the handle for 's' if it has been interned, or a default constructed handle.
+    InternedString find(std::string_view s) const {
+        const u64 hash = hashBytes(s.data(), s.size());
+        const Shard& shard = shardFor(hash);
+        std::shared_lock<std::shared_mutex> lock{shard.mutex};
+        return shard.table.find(s, hash);
+    }
+
+    /// Returns the number of distinct strings.
+    std::size_t size() const noexcept {
+        return next_id_.load(std::memory_order_relaxed);
+    }
+
+    std::size_t shardCount() const noexcept {
+        return shard_count_;
+    }
+
+private:
+    struct alignas(kCacheLineSize) Shard {
+        mutable std::shared_mutex mutex;
+        detail::InternTable table;
+    };
+
+    std::size_t shard_count_;
+    std::unique_ptr<Shard[]> shards_;
+    std::atomic<u32> next_id_{0};
+
+    // FlatHashMap probes with the low bits of the hash, so shards are picked with the top bits.
+    Shard& shardFor(u64 hash) noexcept {
+        return shards_[std::size_t(hash >> 56) & (shard_count_ - 1)];
+    }
+
+    const Shard& shardFor(u64 hash) const noexcept {
+        return shards_[std::size_t(hash >> 56) & (shard_count_ - 1)];
+    }
+};
+}  // namespace dga
+
+namespace std {
+template <> struct hash<dga::InternedString> : dga::Hash<dga::InternedString> {};
+}  // namespace std
@@ -0,0 +1,272 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#pragma once
+
+#include "../dga/aliases.h"
+#include "../dga/flags.h"
+#include "../dga/platform.h"
+#include "../dga/result.h"
+#include "../dga/scope.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#if DGA_PLATFORM == DGA_WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#define DGA_MAPPED_FILE_WIN32
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define DGA_MAPPED_FILE_POSIX
+#endif
+
+/*
+ * A read-only memory mapping of a whole file. The contents are exposed as a std::string_view
+ * without copying them, so they can be tokenized directly with strSplit or StrSplitRange:
+ *
+ *     auto file = dga::MappedFile::open("data.csv");
+ *     if (!file) { ... }
+ *     for (std::string_view line : dga::strSplitRange(file->view(), '\n')) { ... }
+ *
+ * Pages are read from the page cache on demand, so opening a file is cheap regardless of its size,
+ * and the mapped pages are shared with the page cache rather than counting twice towards resident
+ * memory.
+ *
+ * MapHint describes how the mapping will be accessed, and is passed to the kernel when the file is
+ * mapped. Hints that aren't supported by the platform are ignored:
+ * - Sequential: the file will be read from start to end, so the kernel reads ahead aggressively
+ *   and can drop pages behind the reader. MADV_SEQUENTIAL on POSIX, FILE_FLAG_SEQUENTIAL_SCAN on
+ *   Windows.
+ * - Random: the file will be accessed in a random order, so read-ahead is disabled. MADV_RANDOM
+ *   on POSIX, FILE_FLAG_RANDOM_ACCESS on Windows.
+ * - WillNeed: starts reading the whole file into the page cache in the background. MADV_WILLNEED
+ *   on POSIX, PrefetchVirtualMemory on Windows.
+ * - Populate: reads the whole file and maps every page before open returns, so that later accesses
+ *   don't page fault. MAP_POPULATE on Linux.
+ * - HugePages: asks for the mapping to be backed by transparent huge pages, which reduces TLB
+ *   misses when scanning very large files. MADV_HUGEPAGE on Linux, which only has an effect on file
+ *   mappings if the kernel supports huge pages in the page cache.
+ *
+ * A MappedFile can't be copied, and unmaps the file when it's destroyed. Mapping an empty file
+ * succeeds, and results in an empty view.
+ */
+
+namespace dga {
+enum class MapHint { Sequential, Random, WillNeed, Populate, HugePages, _Count };
+using MapHints = Flags<MapHint>;
+
+namespace detail {
+struct FileMapping {
+    const char* data = nullptr;
+    std::size_t size = 0;
+};
+
+struct UnmapFile {
+    void operator()(const FileMapping& mapping) const noexcept {
+#if defined(DGA_MAPPED_FILE_WIN32)
+        UnmapViewOfFile(mapping.data);
+#else
+        munmap(const_cast<char*>(mapping.data), mapping.size);
+#endif
+    }
+};
+
+inline std::error_code lastSystemError() noexcept {
+#if defined(DGA_MAPPED_FILE_WIN32)
+    return std::error_code(static_cast<int>(GetLastError()), std::system_category());
+#else
+    return std::error_code(errno, std::system_category());
+#endif
+}
+}  // namespace detail
+
+class MappedFile {
+public:
+    using size_type = std::size_t;
+
+    // Constructs an empty MappedFile which doesn't refer to any file.
+    MappedFile() noexcept = default;
+
+    MappedFile(MappedFile&& rhs) noexcept : mapping_(std::exchange(rhs.mapping_, {})) {
+    }
+
+    MappedFile& operator=(MappedFile&& rhs) noexcept {
+        mapping_ = std::exchange(rhs.mapping_, {});
+        return *this;
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Maps the file at 'path' into memory for reading.
+    static Result<MappedFile, std::error_code>
+    open(const char* path, MapHints hints = MapHints{MapHint::Sequential});
+
+    static Result<MappedFile, std::error_code>
+    open(const std::string& path, MapHints hints = MapHints{MapHint::Sequential}) {
+        return open(path.c_str(), hints);
+    }
+
+    // Applies new access hints to the whole mapping. Populate has no effect after the file is
+    // mapped.
+    void advise(MapHints hints) const noexcept;
+
+    // Unmaps the file, leaving this MappedFile empty.
+    void close() noexcept {
+        mapping_ = {};
+    }
+
+    const char* data() const noexcept {
+        return mapping_.get().data;
+    }
+
+    size_type size() const noexcept {
+        return mapping_.get().size;
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    std::string_view view() const noexcept {
+        return std::string_view(data(), size());
+    }
+
+    operator std::string_view() const noexcept {
+        return view();
+    }
+
+private:
+    explicit MappedFile(detail::FileMapping mapping) noexcept
+        : mapping_(mapping, detail::UnmapFile{}) {
+    }
+
+    UniqueResource<detail::FileMapping, detail::UnmapFile> mapping_;
+};
+
+#if defined(DGA_MAPPED_FILE_WIN32)
+inline Result<MappedFile, std::error_code> MappedFile::open(const char* path, MapHints hints) {
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if (hints.isSet(MapHint::Sequential)) {
+        flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+    } else if (hints.isSet(MapHint::Random)) {
+        flags |= FILE_FLAG_RANDOM_ACCESS;
+    }
+    auto file = makeUniqueResourceChecked(
+        CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr),
+        INVALID_HANDLE_VALUE, &CloseHandle);
+    if (!file.owns()) {
+        return Error{detail::lastSystemError()};
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file.get(), &file_size)) {
+        return Error{detail::lastSystemError()};
+    }
+    if (file_size.QuadPart == 0) {
+        return MappedFile{};
+    }
+    if (static_cast<unsigned long long>(file_size.QuadPart) > SIZE_MAX) {
+        return Error{std::make_error_code(std::errc::file_too_large)};
+    }
+
+    auto mapping = makeUniqueResourceChecked(
+        CreateFileMappingA(file.get(), nullptr, PAGE_READONLY, 0, 0, nullptr), nullptr,
+        &CloseHandle);
+    if (!mapping.owns()) {
+        return Error{detail::lastSystemError()};
+    }
+    const void* data = MapViewOfFile(mapping.get(), FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr) {
+        return Error{detail::lastSystemError()};
+    }
+
+    // The view keeps the file mapping object alive, so both handles can be closed now.
+    MappedFile mapped_file{
+        detail::FileMapping{static_cast<const char*>(data), std::size_t(file_size.QuadPart)}};
+    if (hints.isSet(MapHint::WillNeed) || hints.isSet(MapHint::Populate)) {
+        mapped_file.advise(MapHints{MapHint::WillNeed});
+    }
+    return mapped_file;
+}
+
+inline void MappedFile::advise(MapHints hints) const noexcept {
+#if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+    if (hints.isSet(MapHint::WillNeed) && !empty()) {
+        WIN32_MEMORY_RANGE_ENTRY range{const_cast<char*>(data()), size()};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+#else
+    static_cast<void>(hints);
+#endif
+}
+#else
+inline Result<MappedFile, std::error_code> MappedFile::open(const char* path, MapHints hints) {
+    auto fd = makeUniqueResourceChecked(::open(path, O_RDONLY | O_CLOEXEC), -1, &::close);
+    if (!fd.owns()) {
+        return Error{detail::lastSystemError()};
+    }
+
+    struct stat file_stat;
+    if (fstat(fd.get(), &file_stat) != 0) {
+        return Error{detail::lastSystemError()};
+    }
+    if (!S_ISREG(file_stat.st_mode)) {
+        return Error{std::make_error_code(std::errc::invalid_argument)};
+    }
+    if (file_stat.st_size == 0) {
+        return MappedFile{};
+    }
+    if (static_cast<unsigned long long>(file_stat.st_size) > SIZE_MAX) {
+        return Error{std::make_error_code(std::errc::file_too_large)};
+    }
+
+    const std::size_t size = std::size_t(file_stat.st_size);
+    int map_flags = MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+    if (hints.isSet(MapHint::Populate)) {
+        map_flags |= MAP_POPULATE;
+    }
+#endif
+    void* data = mmap(nullptr, size, PROT_READ, map_flags, fd.get(), 0);
+    if (data == MAP_FAILED) {
+        return Error{detail::lastSystemError()};
+    }
+
+    // The mapping holds its own reference to the file, so the descriptor can be closed now.
+    MappedFile mapped_file{detail::FileMapping{static_cast<const char*>(data), size}};
+    mapped_file.advise(hints);
+    return mapped_file;
+}
+
+inline void MappedFile::advise(MapHints hints) const noexcept {
+    if (empty()) {
+        return;
+    }
+    void* address = const_cast<char*>(data());
+    if (hints.isSet(MapHint::Sequential)) {
+        madvise(address, size(), MADV_SEQUENTIAL);
+    } else if (hints.isSet(MapHint::Random)) {
+        madvise(address, size(), MADV_RANDOM);
+    }
+    if (hints.isSet(MapHint::WillNeed)) {
+        madvise(address, size(), MADV_WILLNEED);
+    }
+#if defined(MADV_HUGEPAGE)
+    if (hints.isSet(MapHint::HugePages)) {
+        madvise(address, size(), MADV_HUGEPAGE);
+    }
+#endif
+}
+#endif
+}  // namespace dga
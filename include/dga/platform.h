@@ -2,16 +2,47 @@
  * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
 #pragma once
 
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
 // Determine C++ version.
 #if ((defined(_MSVC_LANG) && _MSVC_LANG >= 201703L) || __cplusplus >= 201703L)
 #define DGA_HAS_CPP17
 #endif
 
-// Determine architecture.
+// Determine architecture. DGA_ARCH_64 and DGA_ARCH_32 describe the pointer width, and the
+// remaining macros describe the instruction set.
 #if defined(__x86_64__) || defined(_M_X64)
 #define DGA_ARCH_64
+#define DGA_ARCH_X86_64
 #elif defined(__i386__) || defined(_M_IX86)
 #define DGA_ARCH_32
+#define DGA_ARCH_X86
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define DGA_ARCH_64
+#define DGA_ARCH_ARM64
+#elif defined(__arm__) || defined(_M_ARM)
+#define DGA_ARCH_32
+#define DGA_ARCH_ARM
+#endif
+
+// Determine SIMD instruction sets enabled at compile time.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DGA_HAS_SSE2
+#endif
+#if defined(__SSE4_2__) || (defined(DGA_HAS_SSE2) && defined(__AVX__))
+#define DGA_HAS_SSE4_2
+#endif
+#if defined(__AVX2__)
+#define DGA_HAS_AVX2
+#endif
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+#define DGA_HAS_AVX512
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define DGA_HAS_NEON
 #endif
 
 // Determine platform.
@@ -88,3 +119,183 @@
 #else
 #define DGA_UNREACHABLE void
 #endif
+
+// Define branch prediction hints.
+#if defined(DGA_GCC) || defined(DGA_CLANG)
+#define DGA_LIKELY(x) __builtin_expect(!!(x), 1)
+#define DGA_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define DGA_LIKELY(x) (x)
+#define DGA_UNLIKELY(x) (x)
+#endif
+
+// Determine whether exceptions are enabled. DGA_HAS_EXCEPTIONS is defined if the compiler supports
+// them, and gates code that must run during stack unwinding, such as cleanup in catch blocks.
+// DGA_NO_EXCEPTIONS is defined otherwise, and can also be defined manually to avoid throwing
+// exceptions in a build that has them enabled. Exceptions from elsewhere, such as std::bad_alloc,
+// can still be thrown in that case, so it must not change how they're handled.
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#define DGA_HAS_EXCEPTIONS
+#elif !defined(DGA_NO_EXCEPTIONS)
+#define DGA_NO_EXCEPTIONS
+#endif
+
+// Define inlining and aliasing markers. DGA_COLD marks a function as unlikely to be called, such as
+// an error handler, so that it is optimised for size and kept away from hot code.
+#if defined(DGA_GCC) || defined(DGA_CLANG)
+#define DGA_FORCE_INLINE inline __attribute__((always_inline))
+#define DGA_NOINLINE __attribute__((noinline))
+#define DGA_COLD __attribute__((cold))
+#define DGA_RESTRICT __restrict__
+#elif defined(DGA_MSVC)
+#define DGA_FORCE_INLINE __forceinline
+#define DGA_NOINLINE __declspec(noinline)
+#define DGA_COLD
+#define DGA_RESTRICT __restrict
+#else
+#define DGA_FORCE_INLINE inline
+#define DGA_NOINLINE
+#define DGA_COLD
+#define DGA_RESTRICT
+#endif
+
+// Define a marker that compiles a single function for a specific instruction set, such as
+// DGA_TARGET("avx2"). The function must only be called if cpuFeatures() reports that the
+// instruction set is supported. MSVC allows intrinsics to be used without this.
+#if defined(DGA_GCC) || defined(DGA_CLANG)
+#define DGA_TARGET(isa) __attribute__((target(isa)))
+#else
+#define DGA_TARGET(isa)
+#endif
+
+// Runtime CPU feature detection.
+#if defined(DGA_ARCH_X86_64) || defined(DGA_ARCH_X86)
+#if defined(DGA_MSVC)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#elif (defined(DGA_ARCH_ARM64) || defined(DGA_ARCH_ARM)) && DGA_PLATFORM == DGA_LINUX && \
+    !defined(DGA_EMSCRIPTEN)
+#include <sys/auxv.h>
+#define DGA_HAS_GETAUXVAL
+#endif
+
+namespace dga {
+// The size of a cache line, which is the minimum distance between two objects to avoid false
+// sharing. Apple's ARM64 cores use 128 byte cache lines.
+#if defined(DGA_ARCH_ARM64) && DGA_PLATFORM == DGA_MACOS
+#define DGA_CACHE_LINE_SIZE 128
+#else
+#define DGA_CACHE_LINE_SIZE 64
+#endif
+constexpr std::size_t kCacheLineSize = DGA_CACHE_LINE_SIZE;
+
+// Handler called by fatalError. It may log the message or terminate the program in some other way,
+// but must not return.
+using FatalErrorHandler = void (*)(const char* message);
+
+namespace detail {
+inline std::atomic<FatalErrorHandler>& fatalErrorHandler() noexcept {
+    static std::atomic<FatalErrorHandler> handler{nullptr};
+    return handler;
+}
+}  // namespace detail
+
+// Sets the handler called by fatalError, and returns the previous handler. Passing nullptr restores
+// the default handler, which prints the message to stderr and calls std::abort.
+inline FatalErrorHandler setFatalErrorHandler(FatalErrorHandler handler) noexcept {
+    return detail::fatalErrorHandler().exchange(handler);
+}
+
+// Reports an unrecoverable error. Used in place of throwing an exception when DGA_NO_EXCEPTIONS is
+// defined.
+[[noreturn]] DGA_COLD DGA_NOINLINE inline void fatalError(const char* message) noexcept {
+    if (FatalErrorHandler handler = detail::fatalErrorHandler().load()) {
+        handler(message);
+    }
+    std::fprintf(stderr, "%s\n", message);
+    std::abort();
+}
+
+// Instruction sets supported by the CPU that the program is running on.
+struct CpuFeatures {
+    bool sse2 = false;
+    bool sse4_2 = false;
+    bool popcnt = false;
+    bool avx2 = false;
+    bool bmi2 = false;
+    bool avx512 = false;  // AVX-512 F and BW.
+    bool neon = false;
+    bool sve = false;
+};
+
+namespace detail {
+inline CpuFeatures detectCpuFeatures() noexcept {
+    CpuFeatures features;
+#if defined(DGA_ARCH_X86_64) || defined(DGA_ARCH_X86)
+    auto cpuid = [](unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+#if defined(DGA_MSVC)
+        int r[4];
+        __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+        for (int i = 0; i < 4; ++i) {
+            regs[i] = static_cast<unsigned>(r[i]);
+        }
+#else
+        __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    };
+    unsigned regs[4];
+    cpuid(0, 0, regs);
+    const unsigned max_leaf = regs[0];
+    if (max_leaf < 1) {
+        return features;
+    }
+    cpuid(1, 0, regs);
+    features.sse2 = (regs[3] >> 26) & 1;
+    features.sse4_2 = (regs[2] >> 20) & 1;
+    features.popcnt = (regs[2] >> 23) & 1;
+
+    // AVX registers can only be used if the OS saves them on a context switch, which is checked
+    // with xgetbv.
+    const bool osxsave = (regs[2] >> 27) & 1;
+    unsigned long long xcr0 = 0;
+    if (osxsave) {
+#if defined(DGA_MSVC)
+        xcr0 = _xgetbv(0);
+#else
+        unsigned eax, edx;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        xcr0 = (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+    }
+    const bool os_avx = (xcr0 & 0x6) == 0x6;
+    const bool os_avx512 = (xcr0 & 0xe6) == 0xe6;
+    if (max_leaf >= 7) {
+        cpuid(7, 0, regs);
+        features.avx2 = os_avx && ((regs[1] >> 5) & 1);
+        features.bmi2 = (regs[1] >> 8) & 1;
+        features.avx512 = os_avx512 && ((regs[1] >> 16) & 1) && ((regs[1] >> 30) & 1);
+    }
+#elif defined(DGA_HAS_GETAUXVAL)
+    const unsigned long hwcap = getauxval(AT_HWCAP);
+#if defined(DGA_ARCH_ARM64)
+    features.neon = (hwcap >> 1) & 1;   // HWCAP_ASIMD
+    features.sve = (hwcap >> 22) & 1;   // HWCAP_SVE
+#else
+    features.neon = (hwcap >> 12) & 1;  // HWCAP_NEON
+#endif
+#elif defined(DGA_HAS_NEON)
+    features.neon = true;
+#endif
+    return features;
+}
+}  // namespace detail
+
+// Returns the instruction sets supported by the current CPU. The CPU is only queried the first
+// time this is called.
+inline const CpuFeatures& cpuFeatures() noexcept {
+    static const CpuFeatures features = detail::detectCpuFeatures();
+    return features;
+}
+}  // namespace dga
@@ -0,0 +1,491 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#pragma once
+
+#include "../dga/aliases.h"
+#include "../dga/bit.h"
+#include "../dga/platform.h"
+#include "../dga/semaphore.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/*
+ * Bounded lock-free queues.
+ *
+ * SpscQueue is a wait-free ring buffer for exactly one producer thread and one consumer thread.
+ * Each side keeps a cached copy of the other side's index, so the shared indices are only read
+ * when the queue looks full or empty.
+ *
+ * MpmcQueue supports any number of producers and consumers. It is based on Dmitry Vyukov's bounded
+ * MPMC queue: https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue. Each
+ * slot has a sequence number which says whether it is ready to be written or read in the current
+ * lap around the buffer, so producers and consumers only contend on their own index.
+ *
+ * Both queues round the capacity up to a power of two, and support moving batches of elements
+ * with try_push_n/try_pop_n.
+ *
+ * BlockingQueue wraps either queue with a pair of LightweightSemaphore's counting the filled and
+ * empty slots, to provide push() and pop() operations that block until they can proceed.
+ */
+
+namespace dga {
+namespace detail {
+// Uninitialised storage for a single T.
+template <typename T> struct QueueSlot {
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    template <typename... Args> void construct(Args&&... args) {
+        new (storage) T(std::forward<Args>(args)...);
+    }
+
+    T& get() noexcept {
+        return *std::launder(reinterpret_cast<T*>(storage));
+    }
+
+    void destroy() noexcept {
+        get().~T();
+    }
+};
+
+// An output iterator which move constructs the element written to it into a QueueSlot, so that
+// elements can be popped without default constructing a T first.
+template <typename T> class QueueSlotWriter {
+public:
+    explicit QueueSlotWriter(QueueSlot<T>& slot) noexcept : slot_(&slot) {
+    }
+
+    QueueSlotWriter& operator=(T&& value) {
+        slot_->construct(std::move(value));
+        return *this;
+    }
+
+    QueueSlotWriter& operator*() noexcept {
+        return *this;
+    }
+
+    QueueSlotWriter& operator++() noexcept {
+        return *this;
+    }
+
+    QueueSlotWriter operator++(int) noexcept {
+        return *this;
+    }
+
+private:
+    QueueSlot<T>* slot_;
+};
+
+inline std::size_t queueCapacity(std::size_t capacity) noexcept {
+    assert(capacity > 0);
+    return bit_ceil(capacity);
+}
+}  // namespace detail
+
+template <typename T> class SpscQueue {
+public:
+    using value_type = T;
+
+    explicit SpscQueue(std::size_t capacity);
+    ~SpscQueue();
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer operations.
+    template <typename... Args> bool try_emplace(Args&&... args);
+    bool try_push(const T& value);
+    bool try_push(T&& value);
+    // Moves up to 'n' elements from 'first' into the queue. Returns the number of elements moved.
+    template <typename InputIt> std::size_t try_push_n(InputIt first, std::size_t n);
+
+    // Consumer operations.
+    bool try_pop(T& value);
+    // Moves up to 'n' elements out of the queue into 'output'. Returns the number of elements
+    // moved.
+    template <typename OutputIt> std::size_t try_pop_n(OutputIt output, std::size_t n);
+
+    // Returns the number of elements in the queue. Only exact if called from the producer or
+    // consumer when the other side is idle.
+    std::size_t size_approx() const noexcept;
+
+    std::size_t capacity() const noexcept {
+        return mask_ + 1;
+    }
+
+private:
+    std::unique_ptr<detail::QueueSlot<T>[]> slots_;
+    std::size_t mask_;
+
+    // Written by the consumer.
+    alignas(kCacheLineSize) std::atomic<std::size_t> head_{0};
+    std::size_t cached_tail_ = 0;
+
+    // Written by the producer.
+    alignas(kCacheLineSize) std::atomic<std::size_t> tail_{0};
+    std::size_t cached_head_ = 0;
+
+    // Returns the number of free slots, as seen by the producer. The consumer's index is only
+    // reloaded if the cached copy shows fewer than 'wanted' free slots.
+    std::size_t freeSlots(std::size_t tail, std::size_t wanted) noexcept;
+    // Returns the number of filled slots, as seen by the consumer. The producer's index is only
+    // reloaded if the cached copy shows fewer than 'wanted' filled slots.
+    std::size_t filledSlots(std::size_t head, std::size_t wanted) noexcept;
+};
+
+template <typename T>
+SpscQueue<T>::SpscQueue(std::size_t capacity)
+    : slots_(new detail::QueueSlot<T>[detail::queueCapacity(capacity)]),
+      mask_(detail::queueCapacity(capacity) - 1) {
+}
+
+template <typename T> SpscQueue<T>::~SpscQueue() {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    for (std::size_t i = head_.load(std::memory_order_relaxed); i != tail; ++i) {
+        slots_[i & mask_].destroy();
+    }
+}
+
+template <typename T> template <typename... Args> bool SpscQueue<T>::try_emplace(Args&&... args) {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (freeSlots(tail, 1) == 0) {
+        return false;
+    }
+    slots_[tail & mask_].construct(std::forward<Args>(args)...);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T> bool SpscQueue<T>::try_push(const T& value) {
+    return try_emplace(value);
+}
+
+template <typename T> bool SpscQueue<T>::try_push(T&& value) {
+    return try_emplace(std::move(value));
+}
+
+template <typename T>
+template <typename InputIt>
+std::size_t SpscQueue<T>::try_push_n(InputIt first, std::size_t n) {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    const std::size_t count = std::min(n, freeSlots(tail, n));
+    for (std::size_t i = 0; i < count; ++i, ++first) {
+        slots_[(tail + i) & mask_].construct(std::move(*first));
+    }
+    tail_.store(tail + count, std::memory_order_release);
+    return count;
+}
+
+template <typename T> bool SpscQueue<T>::try_pop(T& value) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (filledSlots(head, 1) == 0) {
+        return false;
+    }
+    auto& slot = slots_[head & mask_];
+    value = std::move(slot.get());
+    slot.destroy();
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+template <typename OutputIt>
+std::size_t SpscQueue<T>::try_pop_n(OutputIt output, std::size_t n) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    const std::size_t count = std::min(n, filledSlots(head, n));
+    for (std::size_t i = 0; i < count; ++i) {
+        auto& slot = slots_[(head + i) & mask_];
+        *output++ = std::move(slot.get());
+        slot.destroy();
+    }
+    head_.store(head + count, std::memory_order_release);
+    return count;
+}
+
+template <typename T> std::size_t SpscQueue<T>::size_approx() const noexcept {
+    const std::size_t head = head_.load(std::memory_order_acquire);
+    const std::size_t tail = tail_.load(std::memory_order_acquire);
+    return tail >= head ? tail - head : 0;
+}
+
+template <typename T> std::size_t SpscQueue<T>::freeSlots(std::size_t tail,
+                                                         std::size_t wanted) noexcept {
+    std::size_t free = capacity() - (tail - cached_head_);
+    if (free < wanted) {
+        cached_head_ = head_.load(std::memory_order_acquire);
+        free = capacity() - (tail - cached_head_);
+    }
+    return free;
+}
+
+template <typename T> std::size_t SpscQueue<T>::filledSlots(std::size_t head,
+                                                           std::size_t wanted) noexcept {
+    std::size_t filled = cached_tail_ - head;
+    if (filled < wanted) {
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+        filled = cached_tail_ - head;
+    }
+    return filled;
+}
+
+template <typename T> class MpmcQueue {
+public:
+    using value_type = T;
+
+    explicit MpmcQueue(std::size_t capacity);
+    ~MpmcQueue();
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    template <typename... Args> bool try_emplace(Args&&... args);
+    bool try_push(const T& value);
+    bool try_push(T&& value);
+    // Moves up to 'n' elements from 'first' into the queue. Returns the number of elements moved.
+    template <typename InputIt> std::size_t try_push_n(InputIt first, std::size_t n);
+
+    bool try_pop(T& value);
+    // Moves up to 'n' elements out of the queue into 'output'. Returns the number of elements
+    // moved.
+    template <typename OutputIt> std::size_t try_pop_n(OutputIt output, std::size_t n);
+
+    // Returns the number of elements in the queue. Only useful as a hint when other threads are
+    // accessing the queue.
+    std::size_t size_approx() const noexcept;
+
+    std::size_t capacity() const noexcept {
+        return mask_ + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        detail::QueueSlot<T> slot;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    std::size_t mask_;
+
+    alignas(kCacheLineSize) std::atomic<std::size_t> enqueue_pos_{0};
+    alignas(kCacheLineSize) std::atomic<std::size_t> dequeue_pos_{0};
+
+    // Claims up to 'n' consecutive cells whose sequence number is 'pos + offset', where 'pos' is
+    // the current value of 'index'. Returns the first claimed position and the number of cells.
+    std::pair<std::size_t, std::size_t> claim(std::atomic<std::size_t>& index, std::size_t offset,
+                                              std::size_t n) noexcept;
+};
+
+template <typename T>
+MpmcQueue<T>::MpmcQueue(std::size_t capacity)
+    : cells_(new Cell[detail::queueCapacity(capacity)]),
+      mask_(detail::queueCapacity(capacity) - 1) {
+    for (std::size_t i = 0; i <= mask_; ++i) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <typename T> MpmcQueue<T>::~MpmcQueue() {
+    const std::size_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+    for (std::size_t i = dequeue_pos_.load(std::memory_order_relaxed); i != tail; ++i) {
+        cells_[i & mask_].slot.destroy();
+    }
+}
+
+template <typename T> template <typename... Args> bool MpmcQueue<T>::try_emplace(Args&&... args) {
+    auto [pos, count] = claim(enqueue_pos_, 0, 1);
+    if (count == 0) {
+        return false;
+    }
+    Cell& cell = cells_[pos & mask_];
+    cell.slot.construct(std::forward<Args>(args)...);
+    cell.sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T> bool MpmcQueue<T>::try_push(const T& value) {
+    return try_emplace(value);
+}
+
+template <typename T> bool MpmcQueue<T>::try_push(T&& value) {
+    return try_emplace(std::move(value));
+}
+
+template <typename T>
+template <typename InputIt>
+std::size_t MpmcQueue<T>::try_push_n(InputIt first, std::size_t n) {
+    auto [pos, count] = claim(enqueue_pos_, 0, n);
+    for (std::size_t i = 0; i < count; ++i, ++first) {
+        Cell& cell = cells_[(pos + i) & mask_];
+        cell.slot.construct(std::move(*first));
+        cell.sequence.store(pos + i + 1, std::memory_order_release);
+    }
+    return count;
+}
+
+template <typename T> bool MpmcQueue<T>::try_pop(T& value) {
+    auto [pos, count] = claim(dequeue_pos_, 1, 1);
+    if (count == 0) {
+        return false;
+    }
+    Cell& cell = cells_[pos & mask_];
+    value = std::move(cell.slot.get());
+    cell.slot.destroy();
+    cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+template <typename OutputIt>
+std::size_t MpmcQueue<T>::try_pop_n(OutputIt output, std::size_t n) {
+    auto [pos, count] = claim(dequeue_pos_, 1, n);
+    for (std::size_t i = 0; i < count; ++i) {
+        Cell& cell = cells_[(pos + i) & mask_];
+        *output++ = std::move(cell.slot.get());
+        cell.slot.destroy();
+        cell.sequence.store(pos + i + mask_ + 1, std::memory_order_release);
+    }
+    return count;
+}
+
+template <typename T> std::size_t MpmcQueue<T>::size_approx() const noexcept {
+    const std::size_t head = dequeue_pos_.load(std::memory_order_relaxed);
+    const std::size_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+    return tail >= head ? tail - head : 0;
+}
+
+template <typename T>
+std::pair<std::size_t, std::size_t> MpmcQueue<T>::claim(std::atomic<std::size_t>& index,
+                                                        std::size_t offset,
+                                                        std::size_t n) noexcept {
+    std::size_t pos = index.load(std::memory_order_relaxed);
+    while (true) {
+        // Count the cells from 'pos' that are ready in this lap.
+        std::size_t count = 0;
+        bool behind = false;
+        for (; count < n && count <= mask_; ++count) {
+            const std::size_t sequence =
+                cells_[(pos + count) & mask_].sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(sequence - (pos + count + offset));
+            if (diff != 0) {
+                // If the sequence is ahead, another thread has already claimed this cell, so
+                // 'pos' is stale.
+                behind = diff > 0;
+                break;
+            }
+        }
+        if (count == 0 && !behind) {
+            // The queue is full (for producers) or empty (for consumers).
+            return {pos, 0};
+        }
+        if (count > 0 && index.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed,
+                                                     std::memory_order_relaxed)) {
+            return {pos, count};
+        }
+        if (count == 0) {
+            pos = index.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <typename T, typename Queue = MpmcQueue<T>> class BlockingQueue {
+public:
+    using value_type = T;
+
+    explicit BlockingQueue(std::size_t capacity)
+        : queue_(capacity), filled_(0), empty_(queue_.capacity()) {
+    }
+
+    void push(const T& value) {
+        empty_.wait();
+        while (!queue_.try_push(value)) {
+            cpuRelax();
+        }
+        filled_.notify();
+    }
+
+    void push(T&& value) {
+        empty_.wait();
+        while (!queue_.try_push(std::move(value))) {
+            cpuRelax();
+        }
+        filled_.notify();
+    }
+
+    bool try_push(const T& value) {
+        if (!empty_.try_wait()) {
+            return false;
+        }
+        while (!queue_.try_push(value)) {
+            cpuRelax();
+        }
+        filled_.notify();
+        return true;
+    }
+
+    bool try_push(T&& value) {
+        if (!empty_.try_wait()) {
+            return false;
+        }
+        while (!queue_.try_push(std::move(value))) {
+            cpuRelax();
+        }
+        filled_.notify();
+        return true;
+    }
+
+    T pop() {
+        filled_.wait();
+        detail::QueueSlot<T> slot;
+        while (queue_.try_pop_n(detail::QueueSlotWriter<T>{slot}, 1) == 0) {
+            cpuRelax();
+        }
+        empty_.notify();
+        T value(std::move(slot.get()));
+        slot.destroy();
+        return value;
+    }
+
+    bool try_pop(T& value) {
+        if (!filled_.try_wait()) {
+            return false;
+        }
+        while (!queue_.try_pop(value)) {
+            cpuRelax();
+        }
+        empty_.notify();
+        return true;
+    }
+
+    template <class Rep, class Period>
+    bool pop_for(T& value, const std::chrono::duration<Rep, Period>& d) {
+        if (!filled_.wait_for(d)) {
+            return false;
+        }
+        while (!queue_.try_pop(value)) {
+            cpuRelax();
+        }
+        empty_.notify();
+        return true;
+    }
+
+    std::size_t size_approx() const noexcept {
+        return queue_.size_approx();
+    }
+
+    std::size_t capacity() const noexcept {
+        return queue_.capacity();
+    }
+
+private:
+    Queue queue_;
+    // The semaphores count the slots that are guaranteed to be filled or empty. A slot is only
+    // released to the other semaphore after the queue operation completes, so once a semaphore
+    // has been acquired, the queue operation can only fail transiently.
+    LightweightSemaphore filled_;
+    LightweightSemaphore empty_;
+};
+}  // namespace dga
@@ -7,6 +7,6 @@
 // A simple alias for std::remove_cv_t<std::remove_reference<T>>, backported from C++20.
 
 namespace dga {
-template <typename T> struct remove_cvref : std::remove_cv<std::remove_reference<T>> {};
+template <typename T> struct remove_cvref : std::remove_cv<std::remove_reference_t<T>> {};
 template <typename T> using remove_cvref_t = typename remove_cvref<T>::type;
 }  // namespace dga
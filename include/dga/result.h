@@ -5,9 +5,17 @@
 #include <type_traits>
 #include <utility>
 #include <cassert>
-#include <exception>
+#include <cstring>
+#include <memory>
+#include <new>
+#include "../dga/aliases.h"
+#include "../dga/platform.h"
 #include "../dga/remove_cvref.h"
 
+#ifndef DGA_NO_EXCEPTIONS
+#include <exception>
+#endif
+
 /*
  * Result type similar to Rust's Result<T, E>.
  *
@@ -20,6 +28,35 @@
  * This object can be in two states, either in the value state storing a T, or the error state
  * storing an E. It's also possible to construct an object Error<E> to distinguish between OK values
  * and error values in the case where the type is the same.
+ *
+ * Result is trivially copyable, movable and destructible whenever T and E are, so that small
+ * results such as Result<int, ErrorCode> can be passed in registers.
+ *
+ * By default, a Result stores a union of T and E alongside a bool. Two more compact "niche"
+ * layouts are used where possible, which don't need the separate bool:
+ *
+ * - Result<P*, E>, where E is trivially copyable and fits in half of a pointer. The discriminant is
+ *   stored in the low bit of the pointer, which is always zero for an aligned pointer, and the
+ *   error is stored in the other half of the word. This is enabled for pointers to arithmetic
+ *   types and pointers, and can be enabled for any other type that's aligned to at least 2 bytes
+ *   by specialising dga::pointer_niche<P> as std::true_type.
+ *
+ * - Result<void, E>, where error_niche<E> has been specialised with a static constexpr member
+ *   'value'. That value of E is used to represent success, and must never be used as an error:
+ *
+ *       template <> struct dga::error_niche<ErrorCode> {
+ *           static constexpr ErrorCode value = ErrorCode::None;
+ *       };
+ *
+ * In both cases, sizeof(Result<T, E>) == sizeof(T) (or sizeof(E) for void).
+ *
+ * Result is marked [[nodiscard]], so a warning is emitted if a function returning a Result is
+ * called without checking it.
+ *
+ * Calling value() on a Result that holds an error throws MissingResultValue. If DGA_NO_EXCEPTIONS
+ * is defined (which happens automatically when compiling with -fno-exceptions), dga::fatalError is
+ * called instead, which calls the handler installed with dga::setFatalErrorHandler. Either way, the
+ * error path is kept out of line so that value() inlines to a single check.
  */
 
 namespace dga {
@@ -87,211 +124,576 @@ template <typename R> struct is_result : std::false_type {};
 template <typename T, typename E> struct is_result<Result<T, E>> : std::true_type {};
 template <typename R> constexpr auto is_result_v = is_result<R>::value;
 
+// Niche customisation points. See above.
+template <typename E> struct error_niche {};
+
+namespace detail {
+template <typename P> struct IsAlignedForPointerNiche : std::bool_constant<(alignof(P) >= 2)> {};
+}  // namespace detail
+
+template <typename P>
+struct pointer_niche
+    : std::conjunction<std::disjunction<std::is_arithmetic<P>, std::is_pointer<P>>,
+                       detail::IsAlignedForPointerNiche<P>> {};
+
 namespace detail {
 struct uninitialised_tag {};
+struct value_tag {};
+struct error_tag {};
 
 struct void_placeholder {};
 
-// Implements the storage of the result type. If either the value or error is trivially
-// destructable, then ResultStorage should be trivially destructable.
-template <typename T, typename E, bool = std::is_trivially_destructible_v<T>,
-          bool = std::is_trivially_destructible_v<E>>
-struct ResultStorage {
-    constexpr ResultStorage() : value_(T{}), has_value_(true) {
+// The type actually stored for the value of a Result<T, E>.
+template <typename T>
+using ResultValue = std::conditional_t<std::is_void_v<T>, void_placeholder, T>;
+
+// Every storage type below implements the same interface:
+//
+// - Constructors taking uninitialised_tag, which leaves the storage without a value or error (and
+//   must be followed by a call to constructValue or constructError), and value_tag / error_tag
+//   followed by constructor arguments.
+// - hasValue(), valueRef() and errorRef() to access the contents.
+// - constructValue(args...) and constructError(args...), which may only be called when the
+//   storage is uninitialised or has just been destroyed.
+// - destroy(), which destroys the current value or error.
+
+// Default layout: a union of the value and error, plus a flag. If both T and E are trivially
+// destructible, then the storage is trivially destructible too.
+template <typename T, typename E,
+          bool = std::is_trivially_destructible_v<ResultValue<T>> &&
+                 std::is_trivially_destructible_v<E>>
+struct ResultUnionStorage {
+    using V = ResultValue<T>;
+
+    constexpr ResultUnionStorage(uninitialised_tag) noexcept : no_value_(), has_value_(false) {
     }
 
-    // Special constructor in the case where we want to defer initialisation of the value to later
-    // i.e. implementing a copy constructor of Result without having to initialise T or E first.
-    constexpr ResultStorage(uninitialised_tag) : no_value_(), has_value_(false) {
+    template <typename... Args>
+    constexpr ResultUnionStorage(value_tag, Args&&... args)
+        : value_(std::forward<Args>(args)...), has_value_(true) {
     }
 
-    template <typename U = T, std::enable_if_t<std::is_convertible_v<U, T>>* = nullptr>
-    constexpr explicit ResultStorage(U&& value) : value_(std::forward<U>(value)), has_value_(true) {
+    template <typename... Args>
+    constexpr ResultUnionStorage(error_tag, Args&&... args)
+        : error_(std::forward<Args>(args)...), has_value_(false) {
     }
 
-    template <typename G, std::enable_if_t<std::is_convertible_v<G, E>>* = nullptr>
-    constexpr ResultStorage(const Error<G>& error) : error_(error.value()), has_value_(false) {
+    constexpr bool hasValue() const noexcept {
+        return has_value_;
     }
 
-    template <typename G, std::enable_if_t<std::is_convertible_v<G, E>>* = nullptr>
-    constexpr ResultStorage(Error<G>&& error)
-        : error_(std::move(error).value()), has_value_(false) {
+    constexpr V& valueRef() noexcept {
+        return value_;
     }
 
-    constexpr ResultStorage(const ResultStorage& other) {
-        if (other.has_value_) {
-        }
+    constexpr const V& valueRef() const noexcept {
+        return value_;
     }
 
-    ~ResultStorage() {
-        destruct();
+    constexpr Error<E>& errorRef() noexcept {
+        return error_;
     }
 
-    void destruct() {
-        if (has_value_) {
-            destructValue();
-        } else {
-            destructError();
-        }
+    constexpr const Error<E>& errorRef() const noexcept {
+        return error_;
     }
 
-    void destructValue() {
-        assert(has_value_);
-        value_.~T();
+    template <typename... Args> void constructValue(Args&&... args) {
+        new (std::addressof(value_)) V(std::forward<Args>(args)...);
+        has_value_ = true;
     }
 
-    void destructError() {
-        assert(!has_value_);
-        error_.~Error<E>();
+    template <typename... Args> void constructError(Args&&... args) {
+        new (std::addressof(error_)) Error<E>(std::forward<Args>(args)...);
+        has_value_ = false;
+    }
+
+    void destroy() noexcept {
     }
 
     union {
-        T value_;
+        V value_;
         Error<E> error_;
         char no_value_;
     };
     bool has_value_;
 };
 
-// TODO: Consider implementing specialisations for when T or E (or both) are trivially destructable.
+template <typename T, typename E> struct ResultUnionStorage<T, E, false> {
+    using V = ResultValue<T>;
 
-// Void specialisation.
-template <typename E> struct ResultStorage<void, E, false, false> {
-    constexpr ResultStorage() : value_(), has_value_(true) {
+    constexpr ResultUnionStorage(uninitialised_tag) noexcept : no_value_(), has_value_(false) {
     }
 
-    // Special constructor in the case where we want to defer initialisation of the value to later
-    // i.e. implementing a copy constructor of Result without having to initialise T or E first.
-    constexpr ResultStorage(uninitialised_tag) : no_value_(), has_value_(false) {
+    template <typename... Args>
+    constexpr ResultUnionStorage(value_tag, Args&&... args)
+        : value_(std::forward<Args>(args)...), has_value_(true) {
     }
 
-    template <typename G, std::enable_if_t<std::is_convertible_v<G, E>>* = nullptr>
-    constexpr ResultStorage(const Error<G>& error) : error_(error.value()), has_value_(false) {
+    template <typename... Args>
+    constexpr ResultUnionStorage(error_tag, Args&&... args)
+        : error_(std::forward<Args>(args)...), has_value_(false) {
     }
 
-    template <typename G, std::enable_if_t<std::is_convertible_v<G, E>>* = nullptr>
-    constexpr ResultStorage(Error<G>&& error)
-        : error_(std::move(error).value()), has_value_(false) {
+    ~ResultUnionStorage() {
+        destroy();
     }
 
-    ~ResultStorage() {
-        destruct();
+    constexpr bool hasValue() const noexcept {
+        return has_value_;
     }
 
-    void destruct() {
-        if (!has_value_) {
-            destructError();
-        }
+    constexpr V& valueRef() noexcept {
+        return value_;
+    }
+
+    constexpr const V& valueRef() const noexcept {
+        return value_;
+    }
+
+    constexpr Error<E>& errorRef() noexcept {
+        return error_;
+    }
+
+    constexpr const Error<E>& errorRef() const noexcept {
+        return error_;
     }
 
-    void destructValue() {
+    template <typename... Args> void constructValue(Args&&... args) {
+        new (std::addressof(value_)) V(std::forward<Args>(args)...);
+        has_value_ = true;
     }
 
-    void destructError() {
-        assert(!has_value_);
-        error_.~Error<E>();
+    template <typename... Args> void constructError(Args&&... args) {
+        new (std::addressof(error_)) Error<E>(std::forward<Args>(args)...);
+        has_value_ = false;
+    }
+
+    void destroy() noexcept {
+        if (has_value_) {
+            value_.~V();
+        } else {
+            error_.~Error<E>();
+        }
     }
 
     union {
-        void_placeholder value_;
+        V value_;
         Error<E> error_;
         char no_value_;
     };
     bool has_value_;
 };
 
-template <typename E> struct ResultStorage<void, E, false, true> {
-    constexpr ResultStorage() : value_(), has_value_(true) {
+// Pointer niche layout. The word holds either an aligned pointer with the low bit clear, or a tag
+// with the low bit set and the error in the other half of the word.
+template <typename T, typename E> struct ResultPointerNicheStorage {
+    static_assert(alignof(std::remove_pointer_t<T>) >= 2,
+                  "pointer_niche requires a type aligned to at least 2 bytes.");
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    static constexpr std::size_t kErrorOffset = 0;
+#else
+    static constexpr std::size_t kErrorOffset = sizeof(T) / 2;
+#endif
+    static constexpr uintptr kErrorTag = 1;
+
+    ResultPointerNicheStorage(uninitialised_tag) noexcept {
+        std::memcpy(storage_, &kErrorTag, sizeof(kErrorTag));
     }
 
-    // Special constructor in the case where we want to defer initialisation of the value to later
-    // i.e. implementing a copy constructor of Result without having to initialise T or E first.
-    constexpr ResultStorage(uninitialised_tag) : no_value_(), has_value_(false) {
+    template <typename... Args> ResultPointerNicheStorage(value_tag, Args&&... args) {
+        constructValue(std::forward<Args>(args)...);
     }
 
-    template <typename G, std::enable_if_t<std::is_convertible_v<G, E>>* = nullptr>
-    constexpr ResultStorage(const Error<G>& error) : error_(error.value()), has_value_(false) {
+    template <typename... Args> ResultPointerNicheStorage(error_tag, Args&&... args) {
+        constructError(std::forward<Args>(args)...);
     }
 
-    template <typename G, std::enable_if_t<std::is_convertible_v<G, E>>* = nullptr>
-    constexpr ResultStorage(Error<G>&& error)
-        : error_(std::move(error).value()), has_value_(false) {
+    bool hasValue() const noexcept {
+        uintptr word;
+        std::memcpy(&word, storage_, sizeof(word));
+        return (word & kErrorTag) == 0;
     }
 
-    ~ResultStorage() {
+    T& valueRef() noexcept {
+        return *std::launder(reinterpret_cast<T*>(storage_));
     }
 
-    void destruct() {
+    const T& valueRef() const noexcept {
+        return *std::launder(reinterpret_cast<const T*>(storage_));
     }
 
-    void destructValue() {
+    Error<E>& errorRef() noexcept {
+        return *std::launder(reinterpret_cast<Error<E>*>(storage_ + kErrorOffset));
     }
 
-    void destructError() {
+    const Error<E>& errorRef() const noexcept {
+        return *std::launder(reinterpret_cast<const Error<E>*>(storage_ + kErrorOffset));
     }
 
-    union {
-        void_placeholder value_;
-        Error<E> error_;
-        char no_value_;
-    };
-    bool has_value_;
+    template <typename... Args> void constructValue(Args&&... args) {
+        new (storage_) T(std::forward<Args>(args)...);
+        assert(hasValue() && "Pointer stored in a Result is misaligned.");
+    }
+
+    template <typename... Args> void constructError(Args&&... args) {
+        std::memcpy(storage_, &kErrorTag, sizeof(kErrorTag));
+        new (storage_ + kErrorOffset) Error<E>(std::forward<Args>(args)...);
+    }
+
+    void destroy() noexcept {
+    }
+
+    alignas(T) unsigned char storage_[sizeof(T)];
 };
 
-// Controls whether the result is default constructible. The default constructor should be deleted
-// if the type is not default constructable and not void.
-template <typename T, typename E, bool = std::is_default_constructible_v<T> || std::is_void_v<T>>
-struct ResultStorageDefaultConstructible : ResultStorage<T, E> {
-    using ResultStorage<T, E>::ResultStorage;
+// Error niche layout for Result<void, E>. Only an E is stored, with error_niche<E>::value
+// representing success.
+template <typename E> struct ResultErrorNicheStorage {
+    constexpr ResultErrorNicheStorage(uninitialised_tag) noexcept
+        : error_(error_niche<E>::value) {
+    }
+
+    constexpr ResultErrorNicheStorage(value_tag) noexcept : error_(error_niche<E>::value) {
+    }
+
+    template <typename... Args>
+    constexpr ResultErrorNicheStorage(error_tag, Args&&... args)
+        : error_(std::forward<Args>(args)...) {
+        assert(!hasValue() && "The error niche value can't be used as an error.");
+    }
+
+    constexpr bool hasValue() const noexcept {
+        return error_.value() == error_niche<E>::value;
+    }
+
+    constexpr Error<E>& errorRef() noexcept {
+        return error_;
+    }
+
+    constexpr const Error<E>& errorRef() const noexcept {
+        return error_;
+    }
+
+    void constructValue() noexcept {
+        new (std::addressof(error_)) Error<E>(error_niche<E>::value);
+    }
+
+    template <typename... Args> void constructError(Args&&... args) {
+        new (std::addressof(error_)) Error<E>(std::forward<Args>(args)...);
+        assert(!hasValue() && "The error niche value can't be used as an error.");
+    }
+
+    void destroy() noexcept {
+    }
+
+    Error<E> error_;
 };
 
+template <typename E, typename = void> struct HasErrorNiche : std::false_type {};
+template <typename E>
+struct HasErrorNiche<E, std::void_t<decltype(error_niche<E>::value)>> : std::true_type {};
+
 template <typename T, typename E>
-struct ResultStorageDefaultConstructible<T, E, false> : ResultStorage<T, E> {
-    using ResultStorage<T, E>::ResultStorage;
+struct ErrorFitsInPointerNiche
+    : std::bool_constant<std::is_trivially_copyable_v<E> && sizeof(Error<E>) <= sizeof(T) / 2 &&
+                         alignof(Error<E>) <= sizeof(T) / 2> {};
 
-    // Delete default constructor.
-    ResultStorageDefaultConstructible() = delete;
-};
+template <typename T, typename E>
+constexpr bool kUsePointerNiche =
+    std::conjunction_v<std::is_pointer<T>,
+                       pointer_niche<std::remove_cv_t<std::remove_pointer_t<T>>>,
+                       ErrorFitsInPointerNiche<T, E>>;
 
-// Common operations used by storage types.
 template <typename T, typename E>
-struct ResultStorageWithOperations : ResultStorageDefaultConstructible<T, E> {
-    using ResultStorageDefaultConstructible<T, E>::ResultStorageDefaultConstructible;
+constexpr bool kUseErrorNiche =
+    std::conjunction_v<std::is_void<T>, HasErrorNiche<E>, std::is_trivially_copyable<E>>;
 
-    template <typename... Args>
-    void constructValue(Args&&... args) noexcept(std::is_nothrow_constructible_v<T>) {
-        if constexpr (std::is_void_v<T>) {
-            this->value_ = void_placeholder{};
+template <typename T, typename E>
+using ResultStorage = std::conditional_t<
+    kUsePointerNiche<T, E>, ResultPointerNicheStorage<T, E>,
+    std::conditional_t<kUseErrorNiche<T, E>, ResultErrorNicheStorage<E>, ResultUnionStorage<T, E>>>;
+
+// Operations shared by the copy and assignment layers below.
+template <typename T, typename E> struct ResultOperations : ResultStorage<T, E> {
+    using ResultStorage<T, E>::ResultStorage;
+
+    // Replaces the error with a value.
+    template <typename... Args> void reinitValue(Args&&... args) {
+        assert(!this->hasValue());
+        if constexpr (std::is_nothrow_constructible_v<ResultValue<T>, Args&&...>) {
+            this->destroy();
+            this->constructValue(std::forward<Args>(args)...);
         } else {
-            new (std::addressof(this->value_)) T(std::forward<Args>(args)...);
+            // Construct the new value first, so that the error is kept if it throws.
+            ResultValue<T> tmp(std::forward<Args>(args)...);
+            this->destroy();
+            this->constructValue(std::move(tmp));
         }
-        this->has_value_ = true;
     }
 
-    template <typename... Args>
-    void constructError(Args&&... args) noexcept(std::is_nothrow_constructible_v<Error<E>>) {
-        new (std::addressof(this->error_)) Error<E>(std::forward<Args>(args)...);
-        this->has_value_ = false;
+    // Replaces the value with an error.
+    template <typename... Args> void reinitError(Args&&... args) {
+        assert(this->hasValue());
+        if constexpr (std::is_nothrow_constructible_v<Error<E>, Args&&...>) {
+            this->destroy();
+            this->constructError(std::forward<Args>(args)...);
+        } else {
+            Error<E> tmp(std::forward<Args>(args)...);
+            this->destroy();
+            this->constructError(std::move(tmp));
+        }
     }
 
-    template <typename U, std::enable_if_t<!std::is_void_v<U>>* = nullptr>
-    void assignValue(U&& value) {
-        this->value_ = std::forward<U>(value);
-        this->has_value_ = true;
+    template <typename Other> void constructFrom(Other&& other) {
+        if (other.hasValue()) {
+            if constexpr (std::is_void_v<T>) {
+                this->constructValue();
+            } else {
+                this->constructValue(forwardValue<Other>(other));
+            }
+        } else {
+            this->constructError(forwardError<Other>(other));
+        }
     }
 
-    void assignError(const E& value) {
-        this->error_ = value;
-        this->has_value_ = false;
+    template <typename Other> void assignFrom(Other&& other) {
+        if (this->hasValue() && other.hasValue()) {
+            if constexpr (!std::is_void_v<T>) {
+                this->valueRef() = forwardValue<Other>(other);
+            }
+        } else if (!this->hasValue() && !other.hasValue()) {
+            this->errorRef() = forwardError<Other>(other);
+        } else if (other.hasValue()) {
+            if constexpr (std::is_void_v<T>) {
+                this->reinitValue();
+            } else {
+                this->reinitValue(forwardValue<Other>(other));
+            }
+        } else {
+            this->reinitError(forwardError<Other>(other));
+        }
+    }
+
+    // Returns the value or error of 'other', moved if Other is an rvalue.
+    template <typename Other> static decltype(auto) forwardValue(Other& other) noexcept {
+        if constexpr (std::is_lvalue_reference_v<Other>) {
+            return (other.valueRef());
+        } else {
+            return std::move(other.valueRef());
+        }
+    }
+
+    template <typename Other> static decltype(auto) forwardError(Other& other) noexcept {
+        if constexpr (std::is_lvalue_reference_v<Other>) {
+            return (other.errorRef());
+        } else {
+            return std::move(other.errorRef());
+        }
     }
+};
+
+// The layers below make each special member trivial if it's trivial for both T and E, deleted if
+// either T or E doesn't support it, or implemented in terms of the storage otherwise.
+template <typename T, typename E>
+constexpr bool kResultTriviallyCopyConstructible =
+    std::is_trivially_copy_constructible_v<ResultValue<T>> &&
+    std::is_trivially_copy_constructible_v<E>;
 
-    void assignError(E&& value) {
-        this->error_ = std::move(value);
-        this->has_value_ = false;
+template <typename T, typename E>
+constexpr bool kResultCopyConstructible =
+    std::is_copy_constructible_v<ResultValue<T>> && std::is_copy_constructible_v<E>;
+
+template <typename T, typename E>
+constexpr bool kResultTriviallyMoveConstructible =
+    std::is_trivially_move_constructible_v<ResultValue<T>> &&
+    std::is_trivially_move_constructible_v<E>;
+
+template <typename T, typename E>
+constexpr bool kResultMoveConstructible =
+    std::is_move_constructible_v<ResultValue<T>> && std::is_move_constructible_v<E>;
+
+template <typename T, typename E>
+constexpr bool kResultTriviallyCopyAssignable =
+    kResultTriviallyCopyConstructible<T, E> &&
+    std::is_trivially_copy_assignable_v<ResultValue<T>> && std::is_trivially_copy_assignable_v<E> &&
+    std::is_trivially_destructible_v<ResultValue<T>> && std::is_trivially_destructible_v<E>;
+
+template <typename T, typename E>
+constexpr bool kResultCopyAssignable = kResultCopyConstructible<T, E> &&
+                                       std::is_copy_assignable_v<ResultValue<T>> &&
+                                       std::is_copy_assignable_v<E>;
+
+template <typename T, typename E>
+constexpr bool kResultTriviallyMoveAssignable =
+    kResultTriviallyMoveConstructible<T, E> &&
+    std::is_trivially_move_assignable_v<ResultValue<T>> && std::is_trivially_move_assignable_v<E> &&
+    std::is_trivially_destructible_v<ResultValue<T>> && std::is_trivially_destructible_v<E>;
+
+template <typename T, typename E>
+constexpr bool kResultMoveAssignable = kResultMoveConstructible<T, E> &&
+                                       std::is_move_assignable_v<ResultValue<T>> &&
+                                       std::is_move_assignable_v<E>;
+
+template <typename T, typename E, bool = kResultTriviallyCopyConstructible<T, E>,
+          bool = kResultCopyConstructible<T, E>>
+struct ResultCopyConstructBase : ResultOperations<T, E> {
+    using ResultOperations<T, E>::ResultOperations;
+};
+
+template <typename T, typename E>
+struct ResultCopyConstructBase<T, E, false, true> : ResultOperations<T, E> {
+    using ResultOperations<T, E>::ResultOperations;
+
+    ResultCopyConstructBase(const ResultCopyConstructBase& other)
+        : ResultOperations<T, E>(uninitialised_tag{}) {
+        this->constructFrom(other);
     }
+    ResultCopyConstructBase(ResultCopyConstructBase&&) = default;
+    ResultCopyConstructBase& operator=(const ResultCopyConstructBase&) = default;
+    ResultCopyConstructBase& operator=(ResultCopyConstructBase&&) = default;
+};
+
+template <typename T, typename E>
+struct ResultCopyConstructBase<T, E, false, false> : ResultOperations<T, E> {
+    using ResultOperations<T, E>::ResultOperations;
+
+    ResultCopyConstructBase(const ResultCopyConstructBase&) = delete;
+    ResultCopyConstructBase(ResultCopyConstructBase&&) = default;
+    ResultCopyConstructBase& operator=(const ResultCopyConstructBase&) = default;
+    ResultCopyConstructBase& operator=(ResultCopyConstructBase&&) = default;
 };
+
+template <typename T, typename E, bool = kResultTriviallyMoveConstructible<T, E>,
+          bool = kResultMoveConstructible<T, E>>
+struct ResultMoveConstructBase : ResultCopyConstructBase<T, E> {
+    using ResultCopyConstructBase<T, E>::ResultCopyConstructBase;
+};
+
+template <typename T, typename E>
+struct ResultMoveConstructBase<T, E, false, true> : ResultCopyConstructBase<T, E> {
+    using ResultCopyConstructBase<T, E>::ResultCopyConstructBase;
+
+    ResultMoveConstructBase(const ResultMoveConstructBase&) = default;
+    ResultMoveConstructBase(ResultMoveConstructBase&& other) noexcept(
+        std::is_nothrow_move_constructible_v<ResultValue<T>> &&
+        std::is_nothrow_move_constructible_v<E>)
+        : ResultCopyConstructBase<T, E>(uninitialised_tag{}) {
+        this->constructFrom(std::move(other));
+    }
+    ResultMoveConstructBase& operator=(const ResultMoveConstructBase&) = default;
+    ResultMoveConstructBase& operator=(ResultMoveConstructBase&&) = default;
+};
+
+template <typename T, typename E>
+struct ResultMoveConstructBase<T, E, false, false> : ResultCopyConstructBase<T, E> {
+    using ResultCopyConstructBase<T, E>::ResultCopyConstructBase;
+
+    ResultMoveConstructBase(const ResultMoveConstructBase&) = default;
+    ResultMoveConstructBase(ResultMoveConstructBase&&) = delete;
+    ResultMoveConstructBase& operator=(const ResultMoveConstructBase&) = default;
+    ResultMoveConstructBase& operator=(ResultMoveConstructBase&&) = default;
+};
+
+template <typename T, typename E, bool = kResultTriviallyCopyAssignable<T, E>,
+          bool = kResultCopyAssignable<T, E>>
+struct ResultCopyAssignBase : ResultMoveConstructBase<T, E> {
+    using ResultMoveConstructBase<T, E>::ResultMoveConstructBase;
+};
+
+template <typename T, typename E>
+struct ResultCopyAssignBase<T, E, false, true> : ResultMoveConstructBase<T, E> {
+    using ResultMoveConstructBase<T, E>::ResultMoveConstructBase;
+
+    ResultCopyAssignBase(const ResultCopyAssignBase&) = default;
+    ResultCopyAssignBase(ResultCopyAssignBase&&) = default;
+    ResultCopyAssignBase& operator=(const ResultCopyAssignBase& other) {
+        this->assignFrom(other);
+        return *this;
+    }
+    ResultCopyAssignBase& operator=(ResultCopyAssignBase&&) = default;
+};
+
+template <typename T, typename E>
+struct ResultCopyAssignBase<T, E, false, false> : ResultMoveConstructBase<T, E> {
+    using ResultMoveConstructBase<T, E>::ResultMoveConstructBase;
+
+    ResultCopyAssignBase(const ResultCopyAssignBase&) = default;
+    ResultCopyAssignBase(ResultCopyAssignBase&&) = default;
+    ResultCopyAssignBase& operator=(const ResultCopyAssignBase&) = delete;
+    ResultCopyAssignBase& operator=(ResultCopyAssignBase&&) = default;
+};
+
+template <typename T, typename E, bool = kResultTriviallyMoveAssignable<T, E>,
+          bool = kResultMoveAssignable<T, E>>
+struct ResultMoveAssignBase : ResultCopyAssignBase<T, E> {
+    using ResultCopyAssignBase<T, E>::ResultCopyAssignBase;
+};
+
+template <typename T, typename E>
+struct ResultMoveAssignBase<T, E, false, true> : ResultCopyAssignBase<T, E> {
+    using ResultCopyAssignBase<T, E>::ResultCopyAssignBase;
+
+    ResultMoveAssignBase(const ResultMoveAssignBase&) = default;
+    ResultMoveAssignBase(ResultMoveAssignBase&&) = default;
+    ResultMoveAssignBase& operator=(const ResultMoveAssignBase&) = default;
+    ResultMoveAssignBase& operator=(ResultMoveAssignBase&& other) noexcept(
+        std::is_nothrow_move_assignable_v<ResultValue<T>> &&
+        std::is_nothrow_move_constructible_v<ResultValue<T>> &&
+        std::is_nothrow_move_assignable_v<E> && std::is_nothrow_move_constructible_v<E>) {
+        this->assignFrom(std::move(other));
+        return *this;
+    }
+};
+
+template <typename T, typename E>
+struct ResultMoveAssignBase<T, E, false, false> : ResultCopyAssignBase<T, E> {
+    using ResultCopyAssignBase<T, E>::ResultCopyAssignBase;
+
+    ResultMoveAssignBase(const ResultMoveAssignBase&) = default;
+    ResultMoveAssignBase(ResultMoveAssignBase&&) = default;
+    ResultMoveAssignBase& operator=(const ResultMoveAssignBase&) = default;
+    ResultMoveAssignBase& operator=(ResultMoveAssignBase&&) = delete;
+};
+
+// Result of invoking a combinator's function object with the value or error of a Result. Self is
+// the (possibly const, possibly reference) Result type that the combinator was called on.
+template <typename Self>
+constexpr bool kResultIsVoid = std::is_void_v<typename remove_cvref_t<Self>::value_type>;
+
+template <typename F, typename Self, bool = kResultIsVoid<Self>>
+struct ResultValueInvoke {
+    using arg_type = decltype(*std::declval<Self>());
+    using type = std::invoke_result_t<F, arg_type>;
+    static constexpr bool nothrow = std::is_nothrow_invocable_v<F, arg_type>;
+};
+
+template <typename F, typename Self> struct ResultValueInvoke<F, Self, true> {
+    using type = std::invoke_result_t<F>;
+    static constexpr bool nothrow = std::is_nothrow_invocable_v<F>;
+};
+
+template <typename F, typename Self> struct ResultErrorInvoke {
+    using arg_type = decltype(std::declval<Self>().error());
+    using type = std::invoke_result_t<F, arg_type>;
+    static constexpr bool nothrow = std::is_nothrow_invocable_v<F, arg_type>;
+};
+
+// Whether R can be constructed from the value or error of Self without throwing.
+template <typename R, typename Self, bool = kResultIsVoid<Self>>
+constexpr bool kResultNothrowFromValue =
+    std::is_nothrow_constructible_v<R, decltype(*std::declval<Self>())>;
+
+template <typename R, typename Self>
+constexpr bool kResultNothrowFromValue<R, Self, true> = std::is_nothrow_default_constructible_v<R>;
+
+template <typename R, typename Self>
+constexpr bool kResultNothrowFromError =
+    std::is_nothrow_constructible_v<R, decltype(std::declval<Self>().wrapped_error())>;
 }  // namespace detail
 
+#ifndef DGA_NO_EXCEPTIONS
 template <typename E> class MissingResultValue : public std::exception {
 public:
     explicit MissingResultValue(E e) : error_(e) {
@@ -330,186 +732,157 @@ public:
         return "Missing result value.";
     }
 };
+#endif
+
+namespace detail {
+// Called by Result::value() when there's no value. Kept out of line, so that the check in value()
+// is all that's inlined into the caller.
+template <typename G> [[noreturn]] DGA_COLD DGA_NOINLINE void missingResultValue(G&& error) {
+#ifdef DGA_NO_EXCEPTIONS
+    (void)error;
+    fatalError("Missing result value.");
+#else
+    throw MissingResultValue<remove_cvref_t<G>>(std::forward<G>(error));
+#endif
+}
+}  // namespace detail
+
+template <typename T, typename E> class [[nodiscard]] Result : detail::ResultMoveAssignBase<T, E> {
+    using Base = detail::ResultMoveAssignBase<T, E>;
 
-template <typename T, typename E> class Result : detail::ResultStorageWithOperations<T, E> {
 public:
     using value_type = T;
     using error_type = E;
 
     // Constructors.
-    using detail::ResultStorageWithOperations<T, E>::ResultStorageWithOperations;
+    template <typename U = T,
+              std::enable_if_t<std::is_default_constructible_v<detail::ResultValue<U>>>* = nullptr>
+    constexpr Result() noexcept(std::is_nothrow_default_constructible_v<detail::ResultValue<T>>)
+        : Base(detail::value_tag{}) {
+    }
 
-    constexpr Result(const Result& other)
-        : detail::ResultStorageWithOperations<T, E>(detail::uninitialised_tag{}) {
-        if (other.has_value()) {
-            if constexpr (!std::is_void_v<T>) {
-                this->constructValue(other.value());
-            } else {
-                this->constructValue();
-            }
-        } else {
-            this->constructError(other.error());
-        }
+    // Construct from a universal reference.
+    // Requirements:
+    // * T must not be void.
+    // * U must be convertible to T.
+    // * remove_cvref_t<U> must be not equal Result<T, E>
+    // * remove_cvref_t<U> must not be an Error type.
+    template <typename U = T,
+              std::enable_if_t<!std::is_void_v<T> && std::is_convertible_v<U, T>>* = nullptr,
+              std::enable_if_t<!std::is_same_v<remove_cvref_t<U>, Result>>* = nullptr,
+              std::enable_if_t<!is_error_v<remove_cvref_t<U>>>* = nullptr>
+    constexpr Result(U&& value) noexcept(std::is_nothrow_constructible_v<T, U&&>)
+        : Base(detail::value_tag{}, std::forward<U>(value)) {
     }
 
-    constexpr Result(Result&& other) noexcept(
-        std::is_nothrow_move_constructible_v<T>&& std::is_nothrow_move_constructible_v<E>)
-        : detail::ResultStorageWithOperations<T, E>(detail::uninitialised_tag{}) {
-        if (other.has_value()) {
-            if constexpr (!std::is_void_v<T>) {
-                this->constructValue(std::move(other).value());
-            } else {
-                this->constructValue();
-            }
-        } else {
-            this->constructError(std::move(other.error()));
-        }
+    template <typename G, std::enable_if_t<std::is_convertible_v<const G&, E>>* = nullptr>
+    constexpr Result(const Error<G>& error) noexcept(std::is_nothrow_constructible_v<E, const G&>)
+        : Base(detail::error_tag{}, error.value()) {
     }
 
-    template <typename U, typename G>
-    explicit constexpr Result(const Result<U, G>& other)
-        : detail::ResultStorageWithOperations<T, E>(detail::uninitialised_tag{}) {
-        if (other.has_value()) {
-            if constexpr (!std::is_void_v<T>) {
-                this->constructValue(other.value());
-            } else {
-                this->constructValue();
-            }
-        } else {
-            this->constructError(other.error());
-        }
+    template <typename G, std::enable_if_t<std::is_convertible_v<G, E>>* = nullptr>
+    constexpr Result(Error<G>&& error) noexcept(std::is_nothrow_constructible_v<E, G&&>)
+        : Base(detail::error_tag{}, std::move(error).value()) {
     }
 
     template <typename U, typename G>
-    explicit constexpr Result(Result<U, G>&& other) noexcept(
-        std::is_nothrow_move_constructible_v<T>&& std::is_nothrow_move_constructible_v<E>)
-        : detail::ResultStorageWithOperations<T, E>(detail::uninitialised_tag{}) {
+    explicit constexpr Result(const Result<U, G>& other) : Base(detail::uninitialised_tag{}) {
         if (other.has_value()) {
-            if constexpr (!std::is_void_v<T>) {
-                this->constructValue(std::move(other).value());
-            } else {
+            if constexpr (std::is_void_v<T>) {
                 this->constructValue();
-            }
-        } else {
-            this->constructError(std::move(other.error()));
-        }
-    }
-
-    // Destructor.
-    ~Result() = default;
-
-    // Assignment.
-    Result& operator=(const Result& other) {
-        this->destruct();
-        if (other.has_value()) {
-            if constexpr (!std::is_void_v<T>) {
-                this->assignValue(other.value());
             } else {
-                this->constructValue();
+                this->constructValue(*other);
             }
         } else {
-            this->assignError(other.error());
+            this->constructError(E(other.error()));
         }
-        return *this;
     }
 
-    Result& operator=(Result&& other) noexcept(
-        std::is_nothrow_move_assignable_v<T>&& std::is_nothrow_move_assignable_v<E>) {
-        this->destruct();
+    template <typename U, typename G>
+    explicit constexpr Result(Result<U, G>&& other) : Base(detail::uninitialised_tag{}) {
         if (other.has_value()) {
-            if constexpr (!std::is_void_v<T>) {
-                this->assignValue(std::move(other).value());
-            } else {
+            if constexpr (std::is_void_v<T>) {
                 this->constructValue();
+            } else {
+                this->constructValue(*std::move(other));
             }
         } else {
-            this->assignError(std::move(other).error());
+            this->constructError(E(std::move(other).error()));
         }
-        return *this;
     }
 
+    // Copy and move construction, assignment and destruction are provided by the base classes, and
+    // are trivial when they're trivial for both T and E.
+
+    // Assignment.
     template <typename U, typename G> Result& operator=(const Result<U, G>& other) {
-        this->destruct();
         if (other.has_value()) {
-            if constexpr (!std::is_void_v<T>) {
-                this->assignValue(other.value());
+            if constexpr (std::is_void_v<T>) {
+                emplace();
             } else {
-                this->constructValue();
+                *this = *other;
             }
         } else {
-            this->assignError(other.error());
+            *this = Error<E>(E(other.error()));
         }
         return *this;
     }
 
-    template <typename U, typename G>
-    Result& operator=(Result<U, G>&& other) noexcept(
-        std::is_nothrow_move_assignable_v<T>&& std::is_nothrow_move_assignable_v<E>) {
-        this->destruct();
+    template <typename U, typename G> Result& operator=(Result<U, G>&& other) {
         if (other.has_value()) {
-            if constexpr (!std::is_void_v<T>) {
-                this->assignValue(std::move(other).value());
+            if constexpr (std::is_void_v<T>) {
+                emplace();
             } else {
-                this->constructValue();
+                *this = *std::move(other);
             }
         } else {
-            this->assignError(std::move(other).error());
+            *this = Error<E>(E(std::move(other).error()));
         }
         return *this;
     }
 
-    // Construct from a universal reference.
-    // Requirements:
-    // * U must be convertible to T.
-    // * remove_cvref_t<U> must be not equal Result<T, E>
-    // * remove_cvref_t<U> must not be an Error type.
-    template <class U = T, std::enable_if_t<std::is_convertible_v<U, T>>* = nullptr,
+    // Assign from a universal reference, with the same requirements as the constructor.
+    template <typename U = T,
+              std::enable_if_t<!std::is_void_v<T> && std::is_convertible_v<U, T>>* = nullptr,
               std::enable_if_t<!std::is_same_v<remove_cvref_t<U>, Result>>* = nullptr,
               std::enable_if_t<!is_error_v<remove_cvref_t<U>>>* = nullptr>
     Result& operator=(U&& value) {
         if (has_value()) {
-            this->value_ = std::forward<U>(value);
+            this->valueRef() = std::forward<U>(value);
         } else {
-            this->destructError();
-            this->constructValue(std::forward<U>(value));
+            this->reinitValue(std::forward<U>(value));
         }
         return *this;
     }
 
-    template <class G = E> Result& operator=(const Error<G>& error) {
+    template <typename G = E> Result& operator=(const Error<G>& error) {
         if (!has_value()) {
-            this->error_ = error;
+            this->errorRef() = E(error.value());
         } else {
-            this->destructValue();
-            this->constructError(error);
+            this->reinitError(E(error.value()));
         }
         return *this;
     }
 
-    template <class G = E> Result& operator=(Error<G>&& error) {
+    template <typename G = E> Result& operator=(Error<G>&& error) {
         if (!has_value()) {
-            this->error_ = std::move(error);
+            this->errorRef() = E(std::move(error).value());
         } else {
-            this->destructValue();
-            this->constructError(std::move(error));
+            this->reinitError(E(std::move(error).value()));
         }
         return *this;
     }
 
-    template <class... Args,
-              typename = std::enable_if_t<std::is_nothrow_constructible_v<T, Args&&...>>>
+    template <typename... Args, typename U = T,
+              typename = std::enable_if_t<std::is_nothrow_constructible_v<U, Args&&...>>>
     void emplace(Args&&... args) {
-        if (has_value()) {
-            this->value_ = T(std::forward<Args>(args)...);
-        } else {
-            this->destructError();
-            this->constructValue(std::forward<Args>(args)...);
-        }
+        this->destroy();
+        this->constructValue(std::forward<Args>(args)...);
     }
 
     template <typename U = T, std::enable_if_t<std::is_void_v<U>>* = nullptr> void emplace() {
         if (!has_value()) {
-            this->destructError();
+            this->destroy();
             this->constructValue();
         }
     }
@@ -520,28 +893,34 @@ public:
         std::enable_if_t<std::is_nothrow_move_constructible_v<U> ||
                          std::is_nothrow_move_constructible_v<G> || std::is_void_v<U>>* = nullptr>
     void swap(Result& other) {
+        using std::swap;
         if (has_value() && other.has_value()) {
-            std::swap(this->value_, other.value_);
+            if constexpr (!std::is_void_v<T>) {
+                swap(this->valueRef(), other.valueRef());
+            }
         } else if (!has_value() && !other.has_value()) {
-            std::swap(this->error_, other.error_);
+            swap(this->errorRef(), other.errorRef());
         } else if (!has_value() && other.has_value()) {
             other.swap(*this);
         } else {
+            // This object has a value, and other has an error.
             if constexpr (std::is_void_v<T>) {
-                this->constructError(std::move(other.error_));
-                other.destructError();
+                Error<E> tmp(std::move(other.errorRef()));
+                other.destroy();
                 other.constructValue();
+                this->destroy();
+                this->constructError(std::move(tmp));
             } else if constexpr (std::is_nothrow_move_constructible_v<E>) {
-                auto tmp = std::move(other.error_);
-                other.destructError();
-                other.constructValue(std::move(this->value_));
-                this->destructValue();
+                Error<E> tmp(std::move(other.errorRef()));
+                other.destroy();
+                other.constructValue(std::move(this->valueRef()));
+                this->destroy();
                 this->constructError(std::move(tmp));
-            } else if constexpr (std::is_nothrow_move_constructible_v<T>) {
-                auto tmp = std::move(this->value_);
-                this->destructValue();
-                this->constructError(std::move(other->error_));
-                other.destructError();
+            } else {
+                T tmp(std::move(this->valueRef()));
+                this->destroy();
+                this->constructError(std::move(other.errorRef()));
+                other.destroy();
                 other.constructValue(std::move(tmp));
             }
         }
@@ -551,97 +930,97 @@ public:
     template <typename U = T, typename = std::enable_if_t<!std::is_void_v<U>>>
     constexpr const T* operator->() const {
         assert(has_value());
-        return &this->value_;
+        return std::addressof(this->valueRef());
     }
 
     template <typename U = T, typename = std::enable_if_t<!std::is_void_v<U>>>
     constexpr T* operator->() {
         assert(has_value());
-        return &this->value_;
+        return std::addressof(this->valueRef());
     }
 
     template <typename U = T, typename = std::enable_if_t<!std::is_void_v<U>>>
     constexpr const U& operator*() const& {
         assert(has_value());
-        return this->value_;
+        return this->valueRef();
     }
 
     template <typename U = T, typename = std::enable_if_t<!std::is_void_v<U>>>
     constexpr U& operator*() & {
         assert(has_value());
-        return this->value_;
+        return this->valueRef();
     }
 
     template <typename U = T, typename = std::enable_if_t<!std::is_void_v<U>>>
     constexpr const U&& operator*() const&& {
         assert(has_value());
-        return std::move(this->value_);
+        return std::move(this->valueRef());
     }
 
     template <typename U = T, typename = std::enable_if_t<!std::is_void_v<U>>>
     constexpr U&& operator*() && {
         assert(has_value());
-        return std::move(this->value_);
+        return std::move(this->valueRef());
     }
 
     constexpr explicit operator bool() const noexcept {
-        return this->has_value_;
+        return this->hasValue();
     }
 
     constexpr bool has_value() const noexcept {
-        return this->has_value_;
+        return this->hasValue();
     }
 
     template <typename U = T, typename = std::enable_if_t<!std::is_void_v<U>>>
     constexpr const U& value() const& {
-        if (!has_value()) {
-            throw MissingResultValue(this->error_.value());
+        if (DGA_UNLIKELY(!has_value())) {
+            detail::missingResultValue(this->errorRef().value());
         }
-        return this->value_;
+        return this->valueRef();
     }
 
     template <typename U = T, typename = std::enable_if_t<!std::is_void_v<U>>>
     constexpr U& value() & {
-        if (!has_value()) {
-            throw MissingResultValue(this->error_.value());
+        if (DGA_UNLIKELY(!has_value())) {
+            detail::missingResultValue(this->errorRef().value());
         }
-        return this->value_;
+        return this->valueRef();
     }
 
     template <typename U = T, typename = std::enable_if_t<!std::is_void_v<U>>>
     constexpr const U&& value() const&& {
-        if (!has_value()) {
-            throw MissingResultValue(std::move(this->error_).value());
+        if (DGA_UNLIKELY(!has_value())) {
+            detail::missingResultValue(std::move(this->errorRef()).value());
         }
-        return std::move(this->value_);
+        return std::move(this->valueRef());
     }
 
     template <typename U = T, typename = std::enable_if_t<!std::is_void_v<U>>>
     constexpr U&& value() && {
-        if (!has_value()) {
-            throw MissingResultValue(std::move(this->error_).value());
+        if (DGA_UNLIKELY(!has_value())) {
+            detail::missingResultValue(std::move(this->errorRef()).value());
         }
-        return std::move(this->value_);
+        return std::move(this->valueRef());
     }
 
     constexpr const E& error() const& {
         assert(!has_value());
-        return this->error_.value();
+        return this->errorRef().value();
     }
 
     constexpr E& error() & {
         assert(!has_value());
-        return this->error_.value();
+        return this->errorRef().value();
     }
 
     constexpr const E&& error() const&& {
         assert(!has_value());
-        return std::move(this->error_).value();
+        return std::move(this->errorRef()).value();
     }
 
     constexpr E&& error() && {
         assert(!has_value());
-        return std::move(this->error_).value();
+        return std::move(this->errorRef()).value();
     }
 
     template <typename U = T, typename = std::enable_if_t<!std::is_void_v<U>>>
@@ -649,7 +1028,7 @@ public:
         static_assert(std::is_copy_constructible<T>::value && std::is_convertible<U&&, T>::value,
                       "T must be copy-constructible and convertible to from U&&");
         if (has_value()) {
-            return value();
+            return this->valueRef();
         } else {
             return static_cast<T>(std::forward<U>(other_value));
         }
@@ -657,36 +1036,445 @@ public:
 
     template <typename U = T, typename = std::enable_if_t<!std::is_void_v<U>>>
     T value_or(U&& other_value) && {
-        static_assert(std::is_copy_constructible<T>::value && std::is_convertible<U&&, T>::value,
-                      "T must be copy-constructible and convertible to from U&&");
+        static_assert(std::is_move_constructible<T>::value && std::is_convertible<U&&, T>::value,
+                      "T must be move-constructible and convertible to from U&&");
         if (has_value()) {
-            return std::move(value());
+            return std::move(this->valueRef());
         } else {
             return static_cast<T>(std::forward<U>(other_value));
         }
     }
 
-    // A workaround to access the Error<T> wrapper when we have a reference to another Result type.
-    // Due to private inheritance rules, we can't access other.error_ directly when implementing a
-    // copy constructor for Result<U, G>.
+    // Combinators. Each of these has &, const&, && and const&& overloads which forward the value or
+    // error into the function, so a chain of combinators on an rvalue moves the contents through
+    // without copying them. For Result<void, E>, functions which take the value take no arguments.
+
+    // If this has a value, returns Result<U, E> holding f(value), otherwise returns the error.
+    // U may be void.
+    template <typename F>
+    constexpr auto map(F&& f) & noexcept(
+        noexcept(mapImpl(std::declval<Result&>(), std::declval<F>()))) {
+        return mapImpl(*this, std::forward<F>(f));
+    }
+
+    template <typename F>
+    constexpr auto map(F&& f) const& noexcept(
+        noexcept(mapImpl(std::declval<const Result&>(), std::declval<F>()))) {
+        return mapImpl(*this, std::forward<F>(f));
+    }
+
+    template <typename F>
+    constexpr auto map(F&& f) && noexcept(
+        noexcept(mapImpl(std::declval<Result>(), std::declval<F>()))) {
+        return mapImpl(std::move(*this), std::forward<F>(f));
+    }
+
+    template <typename F>
+    constexpr auto map(F&& f) const&& noexcept(
+        noexcept(mapImpl(std::declval<const Result>(), std::declval<F>()))) {
+        return mapImpl(std::move(*this), std::forward<F>(f));
+    }
+
+    // If this has a value, returns f(value), otherwise returns the error. f must return a Result
+    // whose error type can be constructed from E.
+    template <typename F>
+    constexpr auto and_then(F&& f) & noexcept(
+        noexcept(andThenImpl(std::declval<Result&>(), std::declval<F>()))) {
+        return andThenImpl(*this, std::forward<F>(f));
+    }
+
+    template <typename F>
+    constexpr auto and_then(F&& f) const& noexcept(
+        noexcept(andThenImpl(std::declval<const Result&>(), std::declval<F>()))) {
+        return andThenImpl(*this, std::forward<F>(f));
+    }
+
+    template <typename F>
+    constexpr auto and_then(F&& f) && noexcept(
+        noexcept(andThenImpl(std::declval<Result>(), std::declval<F>()))) {
+        return andThenImpl(std::move(*this), std::forward<F>(f));
+    }
+
+    template <typename F>
+    constexpr auto and_then(F&& f) const&& noexcept(
+        noexcept(andThenImpl(std::declval<const Result>(), std::declval<F>()))) {
+        return andThenImpl(std::move(*this), std::forward<F>(f));
+    }
+
+    // If this has an error, returns f(error), otherwise returns the value. f must return a Result
+    // whose value type can be constructed from T.
+    template <typename F>
+    constexpr auto or_else(F&& f) & noexcept(
+        noexcept(orElseImpl(std::declval<Result&>(), std::declval<F>()))) {
+        return orElseImpl(*this, std::forward<F>(f));
+    }
+
+    template <typename F>
+    constexpr auto or_else(F&& f) const& noexcept(
+        noexcept(orElseImpl(std::declval<const Result&>(), std::declval<F>()))) {
+        return orElseImpl(*this, std::forward<F>(f));
+    }
+
+    template <typename F>
+    constexpr auto or_else(F&& f) && noexcept(
+        noexcept(orElseImpl(std::declval<Result>(), std::declval<F>()))) {
+        return orElseImpl(std::move(*this), std::forward<F>(f));
+    }
+
+    template <typename F>
+    constexpr auto or_else(F&& f) const&& noexcept(
+        noexcept(orElseImpl(std::declval<const Result>(), std::declval<F>()))) {
+        return orElseImpl(std::move(*this), std::forward<F>(f));
+    }
+
+    // If this has an error, returns Result<T, G> holding the error f(error), otherwise returns the
+    // value.
+    template <typename F>
+    constexpr auto transform_error(F&& f) & noexcept(
+        noexcept(transformErrorImpl(std::declval<Result&>(), std::declval<F>()))) {
+        return transformErrorImpl(*this, std::forward<F>(f));
+    }
+
+    template <typename F>
+    constexpr auto transform_error(F&& f) const& noexcept(
+        noexcept(transformErrorImpl(std::declval<const Result&>(), std::declval<F>()))) {
+        return transformErrorImpl(*this, std::forward<F>(f));
+    }
+
+    template <typename F>
+    constexpr auto transform_error(F&& f) && noexcept(
+        noexcept(transformErrorImpl(std::declval<Result>(), std::declval<F>()))) {
+        return transformErrorImpl(std::move(*this), std::forward<F>(f));
+    }
+
+    template <typename F>
+    constexpr auto transform_error(F&& f) const&& noexcept(
+        noexcept(transformErrorImpl(std::declval<const Result>(), std::declval<F>()))) {
+        return transformErrorImpl(std::move(*this), std::forward<F>(f));
+    }
+
+    // Returns the value if there is one, otherwise f(error) converted to a T.
+    template <typename F>
+    constexpr auto value_or_else(F&& f) & noexcept(
+        noexcept(valueOrElseImpl(std::declval<Result&>(), std::declval<F>()))) {
+        return valueOrElseImpl(*this, std::forward<F>(f));
+    }
+
+    template <typename F>
+    constexpr auto value_or_else(F&& f) const& noexcept(
+        noexcept(valueOrElseImpl(std::declval<const Result&>(), std::declval<F>()))) {
+        return valueOrElseImpl(*this, std::forward<F>(f));
+    }
+
+    template <typename F>
+    constexpr auto value_or_else(F&& f) && noexcept(
+        noexcept(valueOrElseImpl(std::declval<Result>(), std::declval<F>()))) {
+        return valueOrElseImpl(std::move(*this), std::forward<F>(f));
+    }
+
+    template <typename F>
+    constexpr auto value_or_else(F&& f) const&& noexcept(
+        noexcept(valueOrElseImpl(std::declval<const Result>(), std::declval<F>()))) {
+        return valueOrElseImpl(std::move(*this), std::forward<F>(f));
+    }
+
+    // Access to the Error<E> wrapper, for example to forward an error to a Result of another type.
     constexpr const Error<E>& wrapped_error() const& {
         assert(!has_value());
-        return this->error_;
+        return this->errorRef();
     }
 
     constexpr Error<E>& wrapped_error() & {
         assert(!has_value());
-        return this->error_;
+        return this->errorRef();
     }
 
     constexpr const Error<E>&& wrapped_error() const&& {
         assert(!has_value());
-        return std::move(this->error_);
+        return std::move(this->errorRef());
     }
 
     constexpr Error<E>&& wrapped_error() && {
         assert(!has_value());
-        return std::move(this->error_);
+        return std::move(this->errorRef());
+    }
+
+private:
+    template <typename Self, typename F>
+    static constexpr decltype(auto) invokeWithValue(Self&& self, F&& f) noexcept(
+        detail::ResultValueInvoke<F&&, Self&&>::nothrow) {
+        if constexpr (std::is_void_v<T>) {
+            return std::forward<F>(f)();
+        } else {
+            return std::forward<F>(f)(*std::forward<Self>(self));
+        }
+    }
+
+    template <typename Self, typename F,
+              typename U = remove_cvref_t<typename detail::ResultValueInvoke<F&&, Self&&>::type>,
+              typename R = Result<U, E>>
+    static constexpr R mapImpl(Self&& self, F&& f) noexcept(
+        detail::ResultValueInvoke<F&&, Self&&>::nothrow &&
+        (std::is_void_v<U> || std::is_nothrow_move_constructible_v<U>) &&
+        detail::kResultNothrowFromError<R, Self&&>) {
+        if (self.has_value()) {
+            if constexpr (std::is_void_v<U>) {
+                invokeWithValue(std::forward<Self>(self), std::forward<F>(f));
+                return R{};
+            } else {
+                return R(invokeWithValue(std::forward<Self>(self), std::forward<F>(f)));
+            }
+        }
+        return R(std::forward<Self>(self).wrapped_error());
+    }
+
+    template <typename Self, typename F,
+              typename R = remove_cvref_t<typename detail::ResultValueInvoke<F&&, Self&&>::type>>
+    static constexpr R andThenImpl(Self&& self, F&& f) noexcept(
+        detail::ResultValueInvoke<F&&, Self&&>::nothrow &&
+        detail::kResultNothrowFromError<R, Self&&>) {
+        static_assert(is_result_v<R>, "The function passed to and_then must return a Result.");
+        if (self.has_value()) {
+            return invokeWithValue(std::forward<Self>(self), std::forward<F>(f));
+        }
+        return R(std::forward<Self>(self).wrapped_error());
+    }
+
+    template <typename Self, typename F,
+              typename R = remove_cvref_t<typename detail::ResultErrorInvoke<F&&, Self&&>::type>>
+    static constexpr R orElseImpl(Self&& self, F&& f) noexcept(
+        detail::ResultErrorInvoke<F&&, Self&&>::nothrow &&
+        detail::kResultNothrowFromValue<R, Self&&>) {
+        static_assert(is_result_v<R>, "The function passed to or_else must return a Result.");
+        if (!self.has_value()) {
+            return std::forward<F>(f)(std::forward<Self>(self).error());
+        }
+        if constexpr (std::is_void_v<T>) {
+            return R{};
+        } else {
+            return R(*std::forward<Self>(self));
+        }
+    }
+
+    template <typename Self, typename F,
+              typename G = remove_cvref_t<typename detail::ResultErrorInvoke<F&&, Self&&>::type>,
+              typename R = Result<T, G>>
+    static constexpr R transformErrorImpl(Self&& self, F&& f) noexcept(
+        detail::ResultErrorInvoke<F&&, Self&&>::nothrow &&
+        std::is_nothrow_move_constructible_v<G> &&
+        detail::kResultNothrowFromValue<R, Self&&>) {
+        if (!self.has_value()) {
+            return R(Error<G>(std::forward<F>(f)(std::forward<Self>(self).error())));
+        }
+        if constexpr (std::is_void_v<T>) {
+            return R{};
+        } else {
+            return R(*std::forward<Self>(self));
+        }
+    }
+
+    template <typename Self, typename F, typename U = T,
+              typename = std::enable_if_t<!std::is_void_v<U>>>
+    static constexpr U valueOrElseImpl(Self&& self, F&& f) noexcept(
+        detail::ResultErrorInvoke<F&&, Self&&>::nothrow &&
+        std::is_nothrow_constructible_v<U, decltype(*std::forward<Self>(self))> &&
+        std::is_nothrow_constructible_v<U, typename detail::ResultErrorInvoke<F&&, Self&&>::type>) {
+        if (self.has_value()) {
+            return *std::forward<Self>(self);
+        }
+        return static_cast<U>(std::forward<F>(f)(std::forward<Self>(self).error()));
     }
 };
 }  // namespace dga
+
+// Early return helpers. DGA_TRY(expr) evaluates a Result, and returns its error from the enclosing
+// function if it has one. DGA_TRY_ASSIGN(decl, expr) does the same, but otherwise initialises or
+// assigns 'decl' with the value:
+//
+//     Result<Config, ParseError> loadConfig(std::string_view path) {
+//         DGA_TRY_ASSIGN(auto text, readFile(path));
+//         DGA_TRY_ASSIGN(Config config, parseConfig(text));
+//         DGA_TRY(validate(config));
+//         return config;
+//     }
+//
+// The enclosing function can return any Result whose error type can be constructed from the error
+// type of 'expr'. DGA_TRY_ASSIGN expands to more than one statement, so it can't be used as the
+// body of an if statement without braces.
+#define DGA_RESULT_CONCAT_IMPL(a, b) a##b
+#define DGA_RESULT_CONCAT(a, b) DGA_RESULT_CONCAT_IMPL(a, b)
+
+#define DGA_TRY(expr)                                                                              \
+    do {                                                                                           \
+        auto&& dga_try_result = (expr);                                                            \
+        if (DGA_UNLIKELY(!dga_try_result.has_value())) {                                           \
+            return std::forward<decltype(dga_try_result)>(dga_try_result).wrapped_error();         \
+        }                                                                                          \
+    } while (false)
+
+#define DGA_TRY_ASSIGN(decl, expr) \
+    DGA_TRY_ASSIGN_IMPL(DGA_RESULT_CONCAT(dga_try_result_, __COUNTER__), decl, expr)
+
+#define DGA_TRY_ASSIGN_IMPL(tmp, decl, expr)                                                       \
+    auto&& tmp = (expr);                                                                           \
+    if (DGA_UNLIKELY(!tmp.has_value())) {                                                          \
+        return std::forward<decltype(tmp)>(tmp).wrapped_error();                                   \
+    }                                                                                              \
+    decl = *std::forward<decltype(tmp)>(tmp)
+
+// C++20 coroutine support. A function returning Result<T, E> can be written as a coroutine, which
+// can co_await other Results. If the awaited Result has an error, the coroutine stops and returns
+// that error, otherwise co_await evaluates to the value:
+//
+//     Result<Config, ParseError> loadConfig(std::string_view path) {
+//         auto text = co_await readFile(path);
+//         Config config = co_await parseConfig(text);
+//         co_await validate(config);
+//         co_return config;
+//     }
+//
+// Coroutines returning Result<void, E> must finish with 'co_return {};'.
+//
+// Each call allocates a coroutine frame, unless the compiler is able to elide it (Clang usually
+// can when the coroutine is inlined into its caller, GCC currently can't), so DGA_TRY is still
+// preferred on hot paths.
+//
+// This relies on the return object being converted to the Result when the coroutine first returns
+// to the caller rather than when it starts. The standard allows either, so coroutine support is
+// only enabled for compilers that are known to delay the conversion: GCC, and Clang 17 or later
+// (Apple Clang 16 or later). MSVC and older versions of Clang convert it straight away, before the
+// coroutine has produced a Result.
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#if defined(DGA_GCC) ||                                                                            \
+    (defined(DGA_CLANG) && defined(__apple_build_version__) && __clang_major__ >= 16) ||           \
+    (defined(DGA_CLANG) && !defined(__apple_build_version__) && __clang_major__ >= 17)
+#define DGA_HAS_RESULT_COROUTINES
+#endif
+#endif
+#endif
+
+#ifdef DGA_HAS_RESULT_COROUTINES
+#include <coroutine>
+#include <optional>
+
+namespace dga {
+namespace detail {
+template <typename T, typename E> struct ResultPromise;
+
+// Returned by get_return_object, and converted to a Result once the coroutine has either
+// finished or stopped at a co_await of an error.
+template <typename T, typename E> class ResultCoroutineReturn {
+public:
+    using Handle = std::coroutine_handle<ResultPromise<T, E>>;
+
+    explicit ResultCoroutineReturn(Handle handle) noexcept : handle_(handle) {
+    }
+
+    ResultCoroutineReturn(ResultCoroutineReturn&& other) noexcept
+        : handle_(std::exchange(other.handle_, nullptr)) {
+    }
+
+    ResultCoroutineReturn(const ResultCoroutineReturn&) = delete;
+    ResultCoroutineReturn& operator=(const ResultCoroutineReturn&) = delete;
+    ResultCoroutineReturn& operator=(ResultCoroutineReturn&&) = delete;
+
+    ~ResultCoroutineReturn() {
+        // If an exception escaped the coroutine, the frame is destroyed as the exception leaves
+        // the coroutine's ramp function.
+        if (handle_ && !handle_.promise().exception_escaped_) {
+            handle_.destroy();
+        }
+    }
+
+    operator Result<T, E>() {
+        auto& result = handle_.promise().result_;
+        assert(result.has_value() && "The coroutine hasn't produced a Result yet.");
+        Result<T, E> value = std::move(*result);
+        std::exchange(handle_, nullptr).destroy();
+        return value;
+    }
+
+private:
+    Handle handle_;
+};
+
+template <typename T, typename E> struct ResultPromise {
+    ResultCoroutineReturn<T, E> get_return_object() noexcept {
+        return ResultCoroutineReturn<T, E>{
+            std::coroutine_handle<ResultPromise>::from_promise(*this)};
+    }
+
+    std::suspend_never initial_suspend() const noexcept {
+        return {};
+    }
+
+    // Stay suspended at the end, so that the return object can read the result before destroying
+    // the coroutine.
+    std::suspend_always final_suspend() const noexcept {
+        return {};
+    }
+
+    template <typename U = Result<T, E>> void return_value(U&& value) {
+        result_.emplace(std::forward<U>(value));
+    }
+
+    // The coroutine never suspends before it finishes, so an exception always escapes before its
+    // first suspension, which destroys the frame.
+    void unhandled_exception() {
+#ifdef DGA_HAS_EXCEPTIONS
+        exception_escaped_ = true;
+        throw;
+#else
+        fatalError("Unhandled exception in a Result coroutine.");
+#endif
+    }
+
+    std::optional<Result<T, E>> result_;
+    bool exception_escaped_ = false;
+};
+
+// Awaiter for co_await on a Result. R is Result<T, E>& or Result<T, E>.
+template <typename R> struct ResultAwaiter {
+    bool await_ready() const noexcept {
+        return result_.has_value();
+    }
+
+    // Only called if the Result has an error. The coroutine is left suspended, and is destroyed by
+    // the return object after it has taken the error.
+    template <typename U, typename G>
+    void await_suspend(std::coroutine_handle<ResultPromise<U, G>> handle) {
+        handle.promise().result_.emplace(std::forward<R>(result_).wrapped_error());
+    }
+
+    decltype(auto) await_resume() {
+        if constexpr (!std::is_void_v<typename remove_cvref_t<R>::value_type>) {
+            return *std::forward<R>(result_);
+        }
+    }
+
+    R&& result_;
+};
+}  // namespace detail
+
+template <typename T, typename E> detail::ResultAwaiter<Result<T, E>&> operator co_await(
+    Result<T, E>& result) noexcept {
+    return {result};
+}
+
+template <typename T, typename E> detail::ResultAwaiter<const Result<T, E>&> operator co_await(
+    const Result<T, E>& result) noexcept {
+    return {result};
+}
+
+template <typename T, typename E> detail::ResultAwaiter<Result<T, E>> operator co_await(
+    Result<T, E>&& result) noexcept {
+    return {std::move(result)};
+}
+}  // namespace dga
+
+template <typename T, typename E, typename... Args>
+struct std::coroutine_traits<dga::Result<T, E>, Args...> {
+    using promise_type = dga::detail::ResultPromise<T, E>;
+};
+#endif
@@ -4,6 +4,8 @@
 
 #include <type_traits>
 #include <exception>
+#include <utility>
+#include "../dga/platform.h"
 #include "../dga/remove_cvref.h"
 
 /*
@@ -23,6 +25,30 @@
  * block and an exception is thrown.
  * * `ScopeSuccess` will call EF at the end of the scope _unless_ it is constructed inside a
  * block and an exception is thrown.
+ *
+ * ScopeFail and ScopeSuccess call std::uncaught_exceptions() when they are constructed and
+ * destroyed, which is an out of line call into the C++ runtime. Where that matters, `ScopeRollback`
+ * is an alternative that doesn't query the exception state. It calls EF at the end of the scope
+ * unless commit() was called first, so the guard is just a bool:
+ *
+ *     auto rollback = dga::ScopeRollback{[&] { undo(); }};
+ *     doSomethingThatMayFail();
+ *     rollback.commit();
+ *
+ * If exceptions are disabled in the compiler, a scope can only be left normally. ScopeFail never
+ * calls EF and doesn't store any state, and ScopeSuccess behaves exactly like ScopeExit. This
+ * depends on DGA_HAS_EXCEPTIONS rather than DGA_NO_EXCEPTIONS, so defining DGA_NO_EXCEPTIONS in a
+ * build that still has exceptions enabled doesn't stop ScopeFail from running during unwinding.
+ *
+ * `UniqueResource<R, D>` owns a resource handle R, such as a file descriptor or a mapped address,
+ * and calls the deleter D with it when it's destroyed or reset. makeUniqueResourceChecked creates
+ * a UniqueResource that doesn't own anything if the handle is equal to an invalid value, such as
+ * -1 returned by a failed call to open():
+ *
+ *     auto fd = dga::makeUniqueResourceChecked(::open(path, O_RDONLY), -1, &::close);
+ *
+ * R must be an object type. If constructing R or D throws while taking ownership of a resource, the
+ * deleter is called with the resource before the exception propagates.
  */
 
 namespace dga {
@@ -46,6 +72,26 @@ private:
     bool execute_;
 };
 
+#ifndef DGA_HAS_EXCEPTIONS
+// Without exceptions, a ScopeFail can never be executed and a ScopeSuccess is always executed
+// unless it's released.
+class OnFailPolicy {
+public:
+    explicit OnFailPolicy(bool) noexcept {
+    }
+
+    void release() noexcept {
+    }
+
+    constexpr bool shouldExecute() const noexcept {
+        return false;
+    }
+
+    constexpr static bool execute_on_constructor_failure = true;
+};
+
+using OnSuccessPolicy = OnExitPolicy;
+#else
 class OnFailPolicy {
 public:
     explicit OnFailPolicy(bool execute)
@@ -85,6 +131,7 @@ public:
 private:
     int uncaught_on_creation_;
 };
+#endif
 
 template <typename EF, typename Policy> class ScopeGuardBase {
 public:
@@ -101,6 +148,10 @@ public:
     template <typename EFP, std::enable_if_t<!std::is_same_v<remove_cvref_t<EFP>, Policy>, int> = 0,
               std::enable_if_t<std::is_constructible_v<EF, EFP&>, int> = 0,
               std::enable_if_t<std::is_lvalue_reference_v<EFP>, int> = 0>
+#ifndef DGA_HAS_EXCEPTIONS
+    explicit ScopeGuardBase(EFP&& f) : exit_function(f), execution_policy(true) {
+    }
+#else
     explicit ScopeGuardBase(EFP&& f) try : exit_function(f), execution_policy(true) {
     } catch (...) {
         // If initialisation of exit_function throws, call f() depending on the policy, then
@@ -110,6 +161,7 @@ public:
         }
         throw;
     }
+#endif
 
     template <
         std::enable_if_t<
@@ -139,6 +191,20 @@ private:
     EF exit_function;
     Policy execution_policy;
 };
+
+// Moves 'value' if Move is true, otherwise returns it as a const reference so that it's copied.
+template <bool Move, typename T>
+constexpr std::conditional_t<Move, T&&, const T&> moveIf(T& value) noexcept {
+    return std::move(value);
+}
+
+template <typename R, typename D, typename RR, typename DD>
+constexpr bool is_nothrow_resource_construct_v =
+    std::is_nothrow_constructible_v<R, RR> && std::is_nothrow_constructible_v<D, DD>;
+
+template <typename R, typename D>
+constexpr bool is_nothrow_resource_move_v =
+    std::is_nothrow_move_constructible_v<R> && std::is_nothrow_move_constructible_v<D>;
 }  // namespace detail
 
 template <typename EF> class ScopeExit : public detail::ScopeGuardBase<EF, detail::OnExitPolicy> {
@@ -159,4 +225,177 @@ public:
     using detail::ScopeGuardBase<EF, detail::OnSuccessPolicy>::ScopeGuardBase;
 };
 template <typename EF> ScopeSuccess(EF)->ScopeSuccess<EF>;
+
+// Calls EF at the end of the scope unless commit() has been called. Unlike ScopeFail, this doesn't
+// depend on whether an exception is in flight, so early returns also roll back.
+template <typename EF>
+class ScopeRollback : public detail::ScopeGuardBase<EF, detail::OnExitPolicy> {
+public:
+    using detail::ScopeGuardBase<EF, detail::OnExitPolicy>::ScopeGuardBase;
+
+    void commit() noexcept {
+        this->release();
+    }
+};
+template <typename EF> ScopeRollback(EF)->ScopeRollback<EF>;
+
+template <typename R, typename D> class UniqueResource {
+public:
+    static_assert(std::is_object_v<R>, "UniqueResource only supports object resource types.");
+
+    template <typename RR = R, typename DD = D,
+              std::enable_if_t<std::is_default_constructible_v<RR> &&
+                                   std::is_default_constructible_v<DD>,
+                               int> = 0>
+    UniqueResource() noexcept(std::is_nothrow_default_constructible_v<R> &&
+                              std::is_nothrow_default_constructible_v<D>)
+        : resource_(), deleter_(), execute_on_reset_(false) {
+    }
+
+    template <typename RR, typename DD,
+              std::enable_if_t<std::is_constructible_v<R, RR> && std::is_constructible_v<D, DD> &&
+                                   (detail::is_nothrow_resource_construct_v<R, D, RR, DD> ||
+                                    (std::is_constructible_v<R, RR&> &&
+                                     std::is_constructible_v<D, DD&>)),
+                               int> = 0>
+    UniqueResource(RR&& r, DD&& d) noexcept(detail::is_nothrow_resource_construct_v<R, D, RR, DD>)
+        : UniqueResource(std::forward<RR>(r), std::forward<DD>(d), true) {
+    }
+
+    UniqueResource(UniqueResource&& rhs) noexcept(detail::is_nothrow_resource_move_v<R, D>)
+        : resource_(detail::moveIf<detail::is_nothrow_resource_move_v<R, D>>(rhs.resource_)),
+          deleter_(detail::moveIf<detail::is_nothrow_resource_move_v<R, D>>(rhs.deleter_)),
+          execute_on_reset_(std::exchange(rhs.execute_on_reset_, false)) {
+    }
+
+    ~UniqueResource() {
+        reset();
+    }
+
+    UniqueResource& operator=(UniqueResource&& rhs) noexcept(
+        std::is_nothrow_move_assignable_v<R> && std::is_nothrow_move_assignable_v<D>) {
+        if (this != &rhs) {
+            reset();
+            resource_ = std::move(rhs.resource_);
+            deleter_ = std::move(rhs.deleter_);
+            execute_on_reset_ = std::exchange(rhs.execute_on_reset_, false);
+        }
+        return *this;
+    }
+
+    UniqueResource(const UniqueResource&) = delete;
+    UniqueResource& operator=(const UniqueResource&) = delete;
+
+    // Calls the deleter if a resource is owned, and then gives up ownership.
+    void reset() noexcept {
+        if (execute_on_reset_) {
+            execute_on_reset_ = false;
+            deleter_(resource_);
+        }
+    }
+
+    // Deletes the current resource and takes ownership of 'r'. If assigning 'r' throws, the deleter
+    // is called with 'r'.
+    template <typename RR, std::enable_if_t<std::is_assignable_v<R&, RR>, int> = 0>
+    void reset(RR&& r) {
+        reset();
+#ifndef DGA_HAS_EXCEPTIONS
+        resource_ = std::forward<RR>(r);
+#else
+        try {
+            resource_ = std::forward<RR>(r);
+        } catch (...) {
+            deleter_(r);
+            throw;
+        }
+#endif
+        execute_on_reset_ = true;
+    }
+
+    // Gives up ownership without calling the deleter.
+    void release() noexcept {
+        execute_on_reset_ = false;
+    }
+
+    const R& get() const noexcept {
+        return resource_;
+    }
+
+    const D& get_deleter() const noexcept {
+        return deleter_;
+    }
+
+    // Returns true if a resource is owned.
+    bool owns() const noexcept {
+        return execute_on_reset_;
+    }
+
+    template <typename RR = R,
+              std::enable_if_t<std::is_pointer_v<RR> && !std::is_void_v<std::remove_pointer_t<RR>>,
+                               int> = 0>
+    std::add_lvalue_reference_t<std::remove_pointer_t<RR>> operator*() const noexcept {
+        return *resource_;
+    }
+
+    template <typename RR = R, std::enable_if_t<std::is_pointer_v<RR>, int> = 0>
+    R operator->() const noexcept {
+        return resource_;
+    }
+
+private:
+    template <typename RR, typename DD, typename S>
+    friend UniqueResource<std::decay_t<RR>, std::decay_t<DD>>
+    makeUniqueResourceChecked(RR&& r, const S& invalid, DD&& d) noexcept(
+        std::is_nothrow_constructible_v<std::decay_t<RR>, RR> &&
+        std::is_nothrow_constructible_v<std::decay_t<DD>, DD>);
+
+    // Takes ownership of 'r' only if 'owns' is true, so that the deleter is never called with an
+    // invalid resource, even if construction throws.
+    template <typename RR, typename DD>
+    UniqueResource(RR&& r, DD&& d,
+                   bool owns) noexcept(detail::is_nothrow_resource_construct_v<R, D, RR, DD>)
+        : UniqueResource(
+              std::forward<RR>(r), std::forward<DD>(d), owns,
+              std::bool_constant<detail::is_nothrow_resource_construct_v<R, D, RR, DD>>{}) {
+    }
+
+    template <typename RR, typename DD>
+    UniqueResource(RR&& r, DD&& d, bool owns, std::true_type) noexcept
+        : resource_(std::forward<RR>(r)), deleter_(std::forward<DD>(d)), execute_on_reset_(owns) {
+    }
+
+    // Construction may throw, so 'r' and 'd' are copied rather than moved. They're still valid if
+    // an exception is thrown, and 'r' can then be passed to 'd'.
+    template <typename RR, typename DD>
+#ifndef DGA_HAS_EXCEPTIONS
+    UniqueResource(RR&& r, DD&& d, bool owns, std::false_type)
+        : resource_(r), deleter_(d), execute_on_reset_(owns) {
+    }
+#else
+    UniqueResource(RR&& r, DD&& d, bool owns, std::false_type) try
+        : resource_(r), deleter_(d), execute_on_reset_(owns) {
+    } catch (...) {
+        if (owns) {
+            d(r);
+        }
+        throw;
+    }
+#endif
+
+    R resource_;
+    D deleter_;
+    bool execute_on_reset_;
+};
+template <typename R, typename D> UniqueResource(R, D)->UniqueResource<R, D>;
+
+// Creates a UniqueResource that owns 'r' unless it's equal to 'invalid'.
+template <typename R, typename D, typename S = std::decay_t<R>>
+UniqueResource<std::decay_t<R>, std::decay_t<D>> makeUniqueResourceChecked(
+    R&& r, const S& invalid,
+    D&& d) noexcept(std::is_nothrow_constructible_v<std::decay_t<R>, R> &&
+                    std::is_nothrow_constructible_v<std::decay_t<D>, D>) {
+    const bool owns = !bool(r == invalid);
+    return UniqueResource<std::decay_t<R>, std::decay_t<D>>{std::forward<R>(r), std::forward<D>(d),
+                                                            owns};
+}
 }  // namespace dga
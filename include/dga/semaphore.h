@@ -2,12 +2,26 @@
  * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
 #pragma once
 
+#include "../dga/aliases.h"
+#include "../dga/futex.h"
+#include "../dga/platform.h"
+
+#include <atomic>
+#include <cassert>
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
 
 /*
  * Semaphore. Based almost entirely on https://stackoverflow.com/a/27852868.
+ *
+ * LightweightSemaphore has the same interface, but keeps the count in an atomic. notify() and
+ * wait() don't take a lock, and only enter the kernel when a thread actually needs to block. A
+ * waiting thread spins briefly before blocking, which avoids the syscalls entirely when the
+ * semaphore is notified shortly after.
+ *
+ * The batch variants wait(n) and notify(n) acquire and release n units at once. wait(n) blocks
+ * until n units are available, and then takes them all together.
  */
 
 namespace dga {
@@ -22,7 +36,9 @@ public:
     Semaphore& operator=(Semaphore&&) = delete;
 
     void notify();
+    void notify(std::size_t n);
     void wait();
+    void wait(std::size_t n);
     bool try_wait();
     template <class Rep, class Period> bool wait_for(const std::chrono::duration<Rep, Period>& d);
     template <class Clock, class Duration>
@@ -45,12 +61,24 @@ inline void Semaphore::notify() {
     cv_.notify_one();
 }
 
+inline void Semaphore::notify(std::size_t n) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    count_ += n;
+    cv_.notify_all();
+}
+
 inline void Semaphore::wait() {
     std::unique_lock<std::mutex> lock{mutex_};
     cv_.wait(lock, [&] { return count_ > 0; });
     --count_;
 }
 
+inline void Semaphore::wait(std::size_t n) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    cv_.wait(lock, [&] { return count_ >= n; });
+    count_ -= n;
+}
+
 inline bool Semaphore::try_wait() {
     std::lock_guard<std::mutex> lock{mutex_};
     if (count_ > 0) {
@@ -83,4 +111,160 @@ bool Semaphore::wait_until(const std::chrono::time_point<Clock, Duration>& t) {
 inline Semaphore::native_handle_type Semaphore::native_handle() {
     return cv_.native_handle();
 }
+
+class LightweightSemaphore {
+public:
+    static constexpr int kDefaultSpinCount = 512;
+
+    explicit LightweightSemaphore(std::size_t count = 0, int spin_count = kDefaultSpinCount);
+    LightweightSemaphore(const LightweightSemaphore&) = delete;
+    LightweightSemaphore(LightweightSemaphore&&) = delete;
+    LightweightSemaphore& operator=(const LightweightSemaphore&) = delete;
+    LightweightSemaphore& operator=(LightweightSemaphore&&) = delete;
+
+    void notify();
+    void notify(std::size_t n);
+    void wait();
+    void wait(std::size_t n);
+    bool try_wait();
+    template <class Rep, class Period> bool wait_for(const std::chrono::duration<Rep, Period>& d);
+    template <class Clock, class Duration>
+    bool wait_until(const std::chrono::time_point<Clock, Duration>& t);
+
+    // Returns the number of units currently available. Only useful as a hint, as the value may
+    // change immediately.
+    std::size_t count() const noexcept;
+
+private:
+    std::atomic<u32> count_;
+    std::atomic<u32> waiters_;
+    // Number of waiters in wait(n) with n > 1. Whilst there are any, notify() wakes every waiter,
+    // as waking a single thread could pick a waiter that still can't proceed.
+    std::atomic<u32> batch_waiters_;
+    int spin_count_;
+
+    bool tryAcquire(u32 n) noexcept;
+    bool spinAcquire(u32 n) noexcept;
+    void wake(u32 n) noexcept;
+};
+
+inline LightweightSemaphore::LightweightSemaphore(std::size_t count, int spin_count)
+    : count_(static_cast<u32>(count)), waiters_(0), batch_waiters_(0), spin_count_(spin_count) {
+    assert(count <= ~u32(0));
+}
+
+inline void LightweightSemaphore::notify() {
+    count_.fetch_add(1, std::memory_order_seq_cst);
+    wake(1);
+}
+
+inline void LightweightSemaphore::notify(std::size_t n) {
+    if (n == 0) {
+        return;
+    }
+    count_.fetch_add(static_cast<u32>(n), std::memory_order_seq_cst);
+    wake(static_cast<u32>(n));
+}
+
+inline void LightweightSemaphore::wait() {
+    wait(1);
+}
+
+inline void LightweightSemaphore::wait(std::size_t n) {
+    const u32 units = static_cast<u32>(n);
+    if (DGA_LIKELY(spinAcquire(units))) {
+        return;
+    }
+    if (units > 1) {
+        batch_waiters_.fetch_add(1, std::memory_order_seq_cst);
+    }
+    waiters_.fetch_add(1, std::memory_order_seq_cst);
+    while (true) {
+        const u32 current = count_.load(std::memory_order_seq_cst);
+        if (current >= units) {
+            if (tryAcquire(units)) {
+                break;
+            }
+            continue;
+        }
+        futexWait(count_, current);
+    }
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+    if (units > 1) {
+        batch_waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+inline bool LightweightSemaphore::try_wait() {
+    return tryAcquire(1);
+}
+
+template <class Rep, class Period>
+bool LightweightSemaphore::wait_for(const std::chrono::duration<Rep, Period>& d) {
+    return wait_until(std::chrono::steady_clock::now() + d);
+}
+
+template <class Clock, class Duration>
+bool LightweightSemaphore::wait_until(const std::chrono::time_point<Clock, Duration>& t) {
+    if (spinAcquire(1)) {
+        return true;
+    }
+    waiters_.fetch_add(1, std::memory_order_seq_cst);
+    bool acquired = false;
+    while (true) {
+        const u32 current = count_.load(std::memory_order_seq_cst);
+        if (current > 0) {
+            if (tryAcquire(1)) {
+                acquired = true;
+                break;
+            }
+            continue;
+        }
+        const auto remaining = t - Clock::now();
+        if (remaining <= remaining.zero()) {
+            break;
+        }
+        futexWaitFor(count_, current, remaining);
+    }
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+    return acquired;
+}
+
+inline std::size_t LightweightSemaphore::count() const noexcept {
+    return count_.load(std::memory_order_relaxed);
+}
+
+inline bool LightweightSemaphore::tryAcquire(u32 n) noexcept {
+    u32 current = count_.load(std::memory_order_relaxed);
+    while (current >= n) {
+        if (count_.compare_exchange_weak(current, current - n, std::memory_order_acquire,
+                                         std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline bool LightweightSemaphore::spinAcquire(u32 n) noexcept {
+    for (int i = 0; i < spin_count_; ++i) {
+        if (tryAcquire(n)) {
+            return true;
+        }
+        cpuRelax();
+    }
+    return tryAcquire(n);
+}
+
+inline void LightweightSemaphore::wake(u32 n) noexcept {
+    // This load is ordered after the increment of count_ by seq_cst. Either a waiter sees the new
+    // count before blocking, or we see the waiter here.
+    if (waiters_.load(std::memory_order_seq_cst) == 0) {
+        return;
+    }
+    if (batch_waiters_.load(std::memory_order_relaxed) != 0) {
+        futexWakeAll(count_);
+    } else {
+        futexWake(count_, n);
+    }
+}
 }  // namespace dga
@@ -0,0 +1,167 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#pragma once
+
+#include "../dga/aliases.h"
+#include "../dga/bit.h"
+#include "../dga/cache_padded.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+/*
+ * Counters for statistics that are updated by many threads, but rarely read.
+ *
+ * A single std::atomic<u64> that every thread increments is slow under contention. Each increment
+ * has to take ownership of the counter's cache line, so the line moves between cores on every
+ * update. ShardedCounter splits the count into shards, each on its own cache line. A thread always
+ * adds to the same shard, using a relaxed fetch_add, so with at least as many shards as threads,
+ * increments never contend. load() sums the shards, so reads are O(shards):
+ *
+ *     dga::ShardedCounter requests;
+ *     requests.add();                       // On each request, from any thread.
+ *     report("requests", requests.load());  // Periodically.
+ *
+ * Threads are assigned to shards round robin, the first time that they touch any sharded counter.
+ * The default shard count is the number of hardware threads, rounded up to a power of two. Shards
+ * are per thread rather than per CPU, as finding the current CPU isn't cheap or portable, and a
+ * thread's shard stays in its core's cache for as long as the thread isn't migrated.
+ *
+ * ShardedGauge is the signed equivalent, for values that go up and down, such as the number of
+ * requests in flight. It supports add() and sub(), but not set(), as that can't be done atomically
+ * across the shards.
+ *
+ * load() isn't a snapshot: shards are read one at a time, so updates made during a load() may or
+ * may not be included. A gauge that is incremented on one thread and decremented on another can
+ * transiently read as negative.
+ */
+
+namespace dga {
+namespace detail {
+// Returns a small integer that identifies the calling thread, assigned on first use.
+inline std::size_t threadShardIndex() noexcept {
+    static std::atomic<std::size_t> next_index{0};
+    static thread_local const std::size_t index =
+        next_index.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+template <typename T> class ShardedSum {
+public:
+    static constexpr std::size_t kMaxShardCount = 256;
+
+    explicit ShardedSum(std::size_t shard_count)
+        : shard_count_(shard_count <= 1 ? 1
+                                        : bit_ceil(std::min(shard_count, kMaxShardCount))),
+          shards_(new CachePadded<std::atomic<T>>[shard_count_]) {
+    }
+
+    ShardedSum(const ShardedSum&) = delete;
+    ShardedSum& operator=(const ShardedSum&) = delete;
+
+    void add(T n) noexcept {
+        shards_[threadShardIndex() & (shard_count_ - 1)]->fetch_add(n, std::memory_order_relaxed);
+    }
+
+    T load() const noexcept {
+        T sum = 0;
+        for (std::size_t i = 0; i < shard_count_; ++i) {
+            sum += shards_[i]->load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+    T reset() noexcept {
+        T sum = 0;
+        for (std::size_t i = 0; i < shard_count_; ++i) {
+            sum += shards_[i]->exchange(0, std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+    std::size_t shardCount() const noexcept {
+        return shard_count_;
+    }
+
+private:
+    std::size_t shard_count_;
+    std::unique_ptr<CachePadded<std::atomic<T>>[]> shards_;
+};
+
+inline std::size_t defaultShardCount() noexcept {
+    return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+}
+}  // namespace detail
+
+class ShardedCounter {
+public:
+    static constexpr std::size_t kMaxShardCount = detail::ShardedSum<u64>::kMaxShardCount;
+
+    /// Creates a counter with 'shard_count' shards, rounded up to a power of two, and at most
+    /// kMaxShardCount.
+    explicit ShardedCounter(std::size_t shard_count = detail::defaultShardCount())
+        : sum_(shard_count) {
+    }
+
+    void add(u64 n = 1) noexcept {
+        sum_.add(n);
+    }
+
+    /// Returns the sum of all shards.
+    u64 load() const noexcept {
+        return sum_.load();
+    }
+
+    /// Sets the count to zero, and returns the count before it was reset. Concurrent updates are
+    /// either included in the result or counted afterwards, but never lost.
+    u64 reset() noexcept {
+        return sum_.reset();
+    }
+
+    std::size_t shardCount() const noexcept {
+        return sum_.shardCount();
+    }
+
+private:
+    detail::ShardedSum<u64> sum_;
+};
+
+class ShardedGauge {
+public:
+    static constexpr std::size_t kMaxShardCount = detail::ShardedSum<i64>::kMaxShardCount;
+
+    /// Creates a gauge with 'shard_count' shards, rounded up to a power of two, and at most
+    /// kMaxShardCount.
+    explicit ShardedGauge(std::size_t shard_count = detail::defaultShardCount())
+        : sum_(shard_count) {
+    }
+
+    void add(i64 n = 1) noexcept {
+        sum_.add(n);
+    }
+
+    void sub(i64 n = 1) noexcept {
+        sum_.add(-n);
+    }
+
+    /// Returns the sum of all shards.
+    i64 load() const noexcept {
+        return sum_.load();
+    }
+
+    /// Sets the gauge to zero, and returns its value before it was reset.
+    i64 reset() noexcept {
+        return sum_.reset();
+    }
+
+    std::size_t shardCount() const noexcept {
+        return sum_.shardCount();
+    }
+
+private:
+    detail::ShardedSum<i64> sum_;
+};
+}  // namespace dga
@@ -0,0 +1,692 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#pragma once
+
+#include "../dga/platform.h"
+#include "../dga/scope.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/*
+ * A vector that stores up to N elements inline, and only allocates from the heap (or any other
+ * Allocator) when it grows beyond that. Most useful for short lists of a size that usually has a
+ * small bound, such as the tokens of a line split with strSplit:
+ *
+ *     dga::SmallVector<std::string_view, 8> tokens;
+ *     dga::strSplit(line, ' ', std::back_inserter(tokens));
+ *
+ * The interface matches std::vector, with the same iterator invalidation rules, except that
+ * moving or swapping a SmallVector whose elements are stored inline moves the elements one by
+ * one, so invalidates iterators to those elements.
+ *
+ * When growing, elements of a type that is trivially relocatable are moved to the new buffer with
+ * memcpy, rather than being moved and destroyed individually. By default, this is any trivially
+ * copyable type. Specialise dga::is_trivially_relocatable for other types that can be moved
+ * bit by bit, such as most types that hold a std::unique_ptr.
+ */
+
+namespace dga {
+// Whether a T can be moved to a new address by copying its bytes, without calling its move
+// constructor or destructor.
+template <typename T> struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+namespace detail {
+[[noreturn]] DGA_COLD DGA_NOINLINE inline void smallVectorOutOfRange() {
+#ifdef DGA_NO_EXCEPTIONS
+    fatalError("SmallVector::at: index out of range");
+#else
+    throw std::out_of_range("SmallVector::at: index out of range");
+#endif
+}
+}  // namespace detail
+
+template <typename T, std::size_t N, typename Allocator = std::allocator<T>> class SmallVector {
+    static_assert(N > 0, "SmallVector must have an inline capacity of at least one element.");
+
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = T*;
+    using const_iterator = const T*;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    static constexpr size_type inline_capacity = N;
+
+    SmallVector() noexcept(noexcept(Allocator())) : SmallVector(Allocator()) {
+    }
+
+    explicit SmallVector(const Allocator& alloc) noexcept
+        : data_(inlineData()), size_(0), capacity_(N), alloc_(alloc) {
+    }
+
+    explicit SmallVector(size_type count, const Allocator& alloc = Allocator())
+        : SmallVector(alloc) {
+        resize(count);
+    }
+
+    SmallVector(size_type count, const T& value, const Allocator& alloc = Allocator())
+        : SmallVector(alloc) {
+        assign(count, value);
+    }
+
+    template <typename InputIt,
+              typename = typename std::iterator_traits<InputIt>::iterator_category>
+    SmallVector(InputIt first, InputIt last, const Allocator& alloc = Allocator())
+        : SmallVector(alloc) {
+        assign(first, last);
+    }
+
+    SmallVector(std::initializer_list<T> init, const Allocator& alloc = Allocator())
+        : SmallVector(alloc) {
+        assign(init.begin(), init.end());
+    }
+
+    SmallVector(const SmallVector& other)
+        : SmallVector(other, AllocTraits::select_on_container_copy_construction(other.alloc_)) {
+    }
+
+    SmallVector(const SmallVector& other, const Allocator& alloc) : SmallVector(alloc) {
+        assign(other.begin(), other.end());
+    }
+
+    SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : SmallVector(other.alloc_) {
+        takeFrom(other);
+    }
+
+    SmallVector(SmallVector&& other, const Allocator& alloc) : SmallVector(alloc) {
+        takeFrom(other);
+    }
+
+    ~SmallVector() {
+        destroyAll();
+        freeHeap();
+    }
+
+    SmallVector& operator=(const SmallVector& other);
+    SmallVector& operator=(SmallVector&& other) noexcept(
+        std::is_nothrow_move_constructible_v<T> &&
+        (std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value ||
+         std::allocator_traits<Allocator>::is_always_equal::value));
+
+    SmallVector& operator=(std::initializer_list<T> init) {
+        assign(init.begin(), init.end());
+        return *this;
+    }
+
+    void assign(size_type count, const T& value);
+    template <typename InputIt,
+              typename = typename std::iterator_traits<InputIt>::iterator_category>
+    void assign(InputIt first, InputIt last);
+    void assign(std::initializer_list<T> init) {
+        assign(init.begin(), init.end());
+    }
+
+    allocator_type get_allocator() const noexcept {
+        return alloc_;
+    }
+
+    // element access.
+    reference at(size_type pos) {
+        if (DGA_UNLIKELY(pos >= size_)) {
+            detail::smallVectorOutOfRange();
+        }
+        return data_[pos];
+    }
+
+    const_reference at(size_type pos) const {
+        if (DGA_UNLIKELY(pos >= size_)) {
+            detail::smallVectorOutOfRange();
+        }
+        return data_[pos];
+    }
+
+    reference operator[](size_type pos) noexcept {
+        return data_[pos];
+    }
+
+    const_reference operator[](size_type pos) const noexcept {
+        return data_[pos];
+    }
+
+    reference front() noexcept {
+        return data_[0];
+    }
+
+    const_reference front() const noexcept {
+        return data_[0];
+    }
+
+    reference back() noexcept {
+        return data_[size_ - 1];
+    }
+
+    const_reference back() const noexcept {
+        return data_[size_ - 1];
+    }
+
+    T* data() noexcept {
+        return data_;
+    }
+
+    const T* data() const noexcept {
+        return data_;
+    }
+
+    // iterators.
+    iterator begin() noexcept {
+        return data_;
+    }
+
+    const_iterator begin() const noexcept {
+        return data_;
+    }
+
+    const_iterator cbegin() const noexcept {
+        return data_;
+    }
+
+    iterator end() noexcept {
+        return data_ + size_;
+    }
+
+    const_iterator end() const noexcept {
+        return data_ + size_;
+    }
+
+    const_iterator cend() const noexcept {
+        return data_ + size_;
+    }
+
+    reverse_iterator rbegin() noexcept {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator rbegin() const noexcept {
+        return const_reverse_iterator(end());
+    }
+
+    const_reverse_iterator crbegin() const noexcept {
+        return const_reverse_iterator(end());
+    }
+
+    reverse_iterator rend() noexcept {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rend() const noexcept {
+        return const_reverse_iterator(begin());
+    }
+
+    const_reverse_iterator crend() const noexcept {
+        return const_reverse_iterator(begin());
+    }
+
+    // capacity.
+    bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    size_type size() const noexcept {
+        return size_;
+    }
+
+    size_type max_size() const noexcept {
+        return AllocTraits::max_size(alloc_);
+    }
+
+    size_type capacity() const noexcept {
+        return capacity_;
+    }
+
+    // Returns true if the elements are stored inline, rather than in memory from the allocator.
+    bool isInline() const noexcept {
+        return data_ == inlineData();
+    }
+
+    void reserve(size_type new_capacity) {
+        if (new_capacity > capacity_) {
+            reallocate(new_capacity);
+        }
+    }
+
+    // Moves the elements back to the inline storage if they fit, or otherwise into an allocation
+    // that's no larger than necessary.
+    void shrink_to_fit();
+
+    // modifiers.
+    void clear() noexcept {
+        destroyAll();
+        size_ = 0;
+    }
+
+    iterator insert(const_iterator pos, const T& value) {
+        return emplace(pos, value);
+    }
+
+    iterator insert(const_iterator pos, T&& value) {
+        return emplace(pos, std::move(value));
+    }
+
+    iterator insert(const_iterator pos, size_type count, const T& value);
+    template <typename InputIt,
+              typename = typename std::iterator_traits<InputIt>::iterator_category>
+    iterator insert(const_iterator pos, InputIt first, InputIt last);
+    iterator insert(const_iterator pos, std::initializer_list<T> init) {
+        return insert(pos, init.begin(), init.end());
+    }
+
+    template <typename... Args> iterator emplace(const_iterator pos, Args&&... args);
+
+    iterator erase(const_iterator pos) {
+        return erase(pos, pos + 1);
+    }
+
+    iterator erase(const_iterator first, const_iterator last);
+
+    void push_back(const T& value) {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value) {
+        emplace_back(std::move(value));
+    }
+
+    template <typename... Args> reference emplace_back(Args&&... args) {
+        if (DGA_LIKELY(size_ < capacity_)) {
+            T* element = new (data_ + size_) T(std::forward<Args>(args)...);
+            ++size_;
+            return *element;
+        }
+        return emplaceBackSlow(std::forward<Args>(args)...);
+    }
+
+    void pop_back() noexcept {
+        data_[--size_].~T();
+    }
+
+    void resize(size_type count);
+    void resize(size_type count, const T& value);
+
+    void swap(SmallVector& other) noexcept(std::is_nothrow_move_constructible_v<T> &&
+                                           std::is_nothrow_swappable_v<T>);
+
+private:
+    using AllocTraits = std::allocator_traits<Allocator>;
+
+    T* data_;
+    size_type size_;
+    size_type capacity_;
+    Allocator alloc_;
+    alignas(T) unsigned char inline_storage_[N * sizeof(T)];
+
+    T* inlineData() noexcept {
+        return reinterpret_cast<T*>(inline_storage_);
+    }
+
+    const T* inlineData() const noexcept {
+        return reinterpret_cast<const T*>(inline_storage_);
+    }
+
+    size_type grownCapacity(size_type required) const noexcept {
+        return std::max(required, capacity_ * 2);
+    }
+
+    // Moves 'count' elements from 'from' to uninitialised memory at 'to', and destroys the
+    // originals.
+    static void relocate(T* from, size_type count, T* to) noexcept(
+        is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>);
+
+    void reallocate(size_type new_capacity);
+    template <typename... Args> DGA_NOINLINE reference emplaceBackSlow(Args&&... args);
+    // Takes the elements of 'other', stealing its allocation if the allocators are equal.
+    void takeFrom(SmallVector& other);
+    void destroyAll() noexcept;
+    void freeHeap() noexcept;
+};
+
+template <typename T, std::size_t N, typename Allocator>
+SmallVector<T, N, Allocator>& SmallVector<T, N, Allocator>::operator=(const SmallVector& other) {
+    if (this != &other) {
+        if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
+            if (alloc_ != other.alloc_) {
+                // Memory from the old allocator must be freed before it's replaced.
+                clear();
+                freeHeap();
+                data_ = inlineData();
+                capacity_ = N;
+            }
+            alloc_ = other.alloc_;
+        }
+        assign(other.begin(), other.end());
+    }
+    return *this;
+}
+
+template <typename T, std::size_t N, typename Allocator>
+SmallVector<T, N, Allocator>& SmallVector<T, N, Allocator>::operator=(SmallVector&& other) noexcept(
+    std::is_nothrow_move_constructible_v<T> &&
+    (std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value ||
+     std::allocator_traits<Allocator>::is_always_equal::value)) {
+    if (this != &other) {
+        clear();
+        if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+            if (alloc_ != other.alloc_) {
+                freeHeap();
+                data_ = inlineData();
+                capacity_ = N;
+            }
+            alloc_ = std::move(other.alloc_);
+        }
+        takeFrom(other);
+    }
+    return *this;
+}
+
+template <typename T, std::size_t N, typename Allocator>
+void SmallVector<T, N, Allocator>::assign(size_type count, const T& value) {
+    // 'value' may refer to an element of this vector, so it's copied before the elements are
+    // destroyed, and otherwise only read before the element it refers to is destroyed.
+    if (count > capacity_) {
+        T copy = value;
+        clear();
+        reserve(count);
+        std::uninitialized_fill_n(data_, count, copy);
+    } else if (count > size_) {
+        std::fill_n(data_, size_, value);
+        std::uninitialized_fill_n(data_ + size_, count - size_, value);
+    } else {
+        std::fill_n(data_, count, value);
+        std::destroy(begin() + count, end());
+    }
+    size_ = count;
+}
+
+template <typename T, std::size_t N, typename Allocator>
+template <typename InputIt, typename>
+void SmallVector<T, N, Allocator>::assign(InputIt first, InputIt last) {
+    clear();
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag,
+                                    typename std::iterator_traits<InputIt>::iterator_category>) {
+        const auto count = size_type(std::distance(first, last));
+        reserve(count);
+        std::uninitialized_copy(first, last, data_);
+        size_ = count;
+    } else {
+        for (; first != last; ++first) {
+            emplace_back(*first);
+        }
+    }
+}
+
+template <typename T, std::size_t N, typename Allocator>
+void SmallVector<T, N, Allocator>::shrink_to_fit() {
+    if (isInline() || size_ == capacity_) {
+        return;
+    }
+    T* old_data = data_;
+    const size_type old_capacity = capacity_;
+    if (size_ <= N) {
+        relocate(old_data, size_, inlineData());
+        data_ = inlineData();
+        capacity_ = N;
+    } else {
+        T* new_data = AllocTraits::allocate(alloc_, size_);
+        relocate(old_data, size_, new_data);
+        data_ = new_data;
+        capacity_ = size_;
+    }
+    AllocTraits::deallocate(alloc_, old_data, old_capacity);
+}
+
+template <typename T, std::size_t N, typename Allocator>
+typename SmallVector<T, N, Allocator>::iterator
+SmallVector<T, N, Allocator>::insert(const_iterator pos, size_type count, const T& value) {
+    const auto index = size_type(pos - begin());
+    const size_type old_size = size_;
+    // Append, then rotate the new elements into place. This is also correct if 'value' refers to
+    // an element of this vector.
+    if (size_ + count > capacity_) {
+        T copy = value;
+        reserve(grownCapacity(size_ + count));
+        std::uninitialized_fill_n(data_ + size_, count, copy);
+    } else {
+        std::uninitialized_fill_n(data_ + size_, count, value);
+    }
+    size_ += count;
+    std::rotate(begin() + index, begin() + old_size, end());
+    return begin() + index;
+}
+
+template <typename T, std::size_t N, typename Allocator>
+template <typename InputIt, typename>
+typename SmallVector<T, N, Allocator>::iterator
+SmallVector<T, N, Allocator>::insert(const_iterator pos, InputIt first, InputIt last) {
+    const auto index = size_type(pos - begin());
+    const size_type old_size = size_;
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag,
+                                    typename std::iterator_traits<InputIt>::iterator_category>) {
+        const auto count = size_type(std::distance(first, last));
+        if (size_ + count > capacity_) {
+            reserve(grownCapacity(size_ + count));
+        }
+        std::uninitialized_copy(first, last, data_ + size_);
+        size_ += count;
+    } else {
+        for (; first != last; ++first) {
+            emplace_back(*first);
+        }
+    }
+    std::rotate(begin() + index, begin() + old_size, end());
+    return begin() + index;
+}
+
+template <typename T, std::size_t N, typename Allocator>
+template <typename... Args>
+typename SmallVector<T, N, Allocator>::iterator
+SmallVector<T, N, Allocator>::emplace(const_iterator pos, Args&&... args) {
+    const auto index = size_type(pos - begin());
+    emplace_back(std::forward<Args>(args)...);
+    std::rotate(begin() + index, end() - 1, end());
+    return begin() + index;
+}
+
+template <typename T, std::size_t N, typename Allocator>
+typename SmallVector<T, N, Allocator>::iterator
+SmallVector<T, N, Allocator>::erase(const_iterator first, const_iterator last) {
+    const auto index = size_type(first - begin());
+    const auto count = size_type(last - first);
+    if (count > 0) {
+        iterator new_end = std::move(begin() + index + count, end(), begin() + index);
+        std::destroy(new_end, end());
+        size_ -= count;
+    }
+    return begin() + index;
+}
+
+template <typename T, std::size_t N, typename Allocator>
+void SmallVector<T, N, Allocator>::resize(size_type count) {
+    if (count < size_) {
+        std::destroy(begin() + count, end());
+    } else if (count > size_) {
+        reserve(count);
+        std::uninitialized_value_construct(data_ + size_, data_ + count);
+    }
+    size_ = count;
+}
+
+template <typename T, std::size_t N, typename Allocator>
+void SmallVector<T, N, Allocator>::resize(size_type count, const T& value) {
+    if (count <= size_) {
+        resize(count);
+    } else {
+        insert(end(), count - size_, value);
+    }
+}
+
+template <typename T, std::size_t N, typename Allocator>
+void SmallVector<T, N, Allocator>::swap(SmallVector& other) noexcept(
+    std::is_nothrow_move_constructible_v<T> && std::is_nothrow_swappable_v<T>) {
+    if (this == &other) {
+        return;
+    }
+    if (isInline() && other.isInline()) {
+        // Swap the common elements, then move the rest of the longer vector to the shorter one.
+        SmallVector& longer = size_ > other.size_ ? *this : other;
+        SmallVector& shorter = size_ > other.size_ ? other : *this;
+        std::swap_ranges(shorter.begin(), shorter.end(), longer.begin());
+        relocate(longer.data_ + shorter.size_, longer.size_ - shorter.size_, shorter.end());
+        std::swap(size_, other.size_);
+    } else if (isInline() || other.isInline()) {
+        // The heap allocation changes owner, and the inline elements are moved across.
+        SmallVector& small = isInline() ? *this : other;
+        SmallVector& large = isInline() ? other : *this;
+        T* heap_data = large.data_;
+        const size_type heap_size = large.size_;
+        const size_type heap_capacity = large.capacity_;
+        relocate(small.data_, small.size_, large.inlineData());
+        large.data_ = large.inlineData();
+        large.size_ = small.size_;
+        large.capacity_ = N;
+        small.data_ = heap_data;
+        small.size_ = heap_size;
+        small.capacity_ = heap_capacity;
+    } else {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        std::swap(capacity_, other.capacity_);
+    }
+    if constexpr (AllocTraits::propagate_on_container_swap::value) {
+        using std::swap;
+        swap(alloc_, other.alloc_);
+    }
+}
+
+template <typename T, std::size_t N, typename Allocator>
+void SmallVector<T, N, Allocator>::relocate(T* from, size_type count, T* to) noexcept(
+    is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>) {
+    if constexpr (is_trivially_relocatable_v<T>) {
+        if (count > 0) {
+            std::memcpy(static_cast<void*>(to), static_cast<const void*>(from), count * sizeof(T));
+        }
+    } else {
+        if constexpr (std::is_nothrow_move_constructible_v<T> ||
+                      !std::is_copy_constructible_v<T>) {
+            std::uninitialized_move(from, from + count, to);
+        } else {
+            std::uninitialized_copy(from, from + count, to);
+        }
+        std::destroy(from, from + count);
+    }
+}
+
+template <typename T, std::size_t N, typename Allocator>
+void SmallVector<T, N, Allocator>::reallocate(size_type new_capacity) {
+    T* new_data = AllocTraits::allocate(alloc_, new_capacity);
+    {
+        ScopeFail free_on_failure{
+            [&]() noexcept { AllocTraits::deallocate(alloc_, new_data, new_capacity); }};
+        relocate(data_, size_, new_data);
+    }
+    freeHeap();
+    data_ = new_data;
+    capacity_ = new_capacity;
+}
+
+template <typename T, std::size_t N, typename Allocator>
+template <typename... Args>
+typename SmallVector<T, N, Allocator>::reference
+SmallVector<T, N, Allocator>::emplaceBackSlow(Args&&... args) {
+    const size_type new_capacity = grownCapacity(size_ + 1);
+    T* new_data = AllocTraits::allocate(alloc_, new_capacity);
+    {
+        ScopeFail free_on_failure{
+            [&]() noexcept { AllocTraits::deallocate(alloc_, new_data, new_capacity); }};
+        // Construct the new element before moving the existing ones, as the arguments may refer to
+        // an existing element.
+        new (new_data + size_) T(std::forward<Args>(args)...);
+        ScopeFail destroy_on_failure{[&]() noexcept { new_data[size_].~T(); }};
+        relocate(data_, size_, new_data);
+    }
+    freeHeap();
+    data_ = new_data;
+    capacity_ = new_capacity;
+    return data_[size_++];
+}
+
+template <typename T, std::size_t N, typename Allocator>
+void SmallVector<T, N, Allocator>::takeFrom(SmallVector& other) {
+    // Precondition: this vector is empty.
+    if (!other.isInline() && alloc_ == other.alloc_) {
+        freeHeap();
+        data_ = other.data_;
+        size_ = other.size_;
+        capacity_ = other.capacity_;
+        other.data_ = other.inlineData();
+        other.size_ = 0;
+        other.capacity_ = N;
+        return;
+    }
+    reserve(other.size_);
+    if constexpr (is_trivially_relocatable_v<T>) {
+        relocate(other.data_, other.size_, data_);
+    } else {
+        std::uninitialized_move(other.begin(), other.end(), data_);
+        std::destroy(other.begin(), other.end());
+    }
+    size_ = other.size_;
+    other.size_ = 0;
+}
+
+template <typename T, std::size_t N, typename Allocator>
+void SmallVector<T, N, Allocator>::destroyAll() noexcept {
+    std::destroy(begin(), end());
+}
+
+template <typename T, std::size_t N, typename Allocator>
+void SmallVector<T, N, Allocator>::freeHeap() noexcept {
+    if (!isInline()) {
+        AllocTraits::deallocate(alloc_, data_, capacity_);
+    }
+}
+
+template <typename T, std::size_t N, typename Allocator>
+void swap(SmallVector<T, N, Allocator>& lhs,
+          SmallVector<T, N, Allocator>& rhs) noexcept(noexcept(lhs.swap(rhs))) {
+    lhs.swap(rhs);
+}
+
+template <typename T, std::size_t N, typename Allocator>
+bool operator==(const SmallVector<T, N, Allocator>& lhs, const SmallVector<T, N, Allocator>& rhs) {
+    return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename T, std::size_t N, typename Allocator>
+bool operator!=(const SmallVector<T, N, Allocator>& lhs, const SmallVector<T, N, Allocator>& rhs) {
+    return !(lhs == rhs);
+}
+
+template <typename T, std::size_t N, typename Allocator>
+bool operator<(const SmallVector<T, N, Allocator>& lhs, const SmallVector<T, N, Allocator>& rhs) {
+    return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+}  // namespace dga
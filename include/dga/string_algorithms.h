@@ -2,44 +2,977 @@
  * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
 #pragma once
 
+#include "../dga/aliases.h"
+#include "../dga/bit.h"
+#include "../dga/platform.h"
+
 #include <string>
+#include <string_view>
 #include <sstream>
+#include <iterator>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Select the SIMD kernel used to scan for delimiters.
+#if defined(DGA_HAS_AVX2)
+#define DGA_STR_SIMD_AVX2
+#include <immintrin.h>
+#elif defined(DGA_HAS_SSE2)
+#define DGA_STR_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(DGA_HAS_NEON)
+#define DGA_STR_SIMD_NEON
+#include <arm_neon.h>
+#endif
 
 namespace dga {
+namespace detail {
+// SIMD helpers used to scan a string for delimiters a block at a time. Each kernel compares an
+// entire block against the delimiter(s), then reduces the comparison to a bit mask where each
+// matching byte sets 'kMaskStride' bits. Matches are then walked with countr_zero.
+namespace simd {
+#if defined(DGA_STR_SIMD_AVX2)
+#define DGA_STR_SIMD
+using Block = __m256i;
+using Mask = u32;
+constexpr std::size_t kBlockSize = 32;
+constexpr int kMaskStride = 1;
+
+inline Block load(const char* p) noexcept {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+inline Block splat(char c) noexcept {
+    return _mm256_set1_epi8(c);
+}
+
+inline Block equal(Block a, Block b) noexcept {
+    return _mm256_cmpeq_epi8(a, b);
+}
+
+inline Block bitOr(Block a, Block b) noexcept {
+    return _mm256_or_si256(a, b);
+}
+
+inline Mask toMask(Block b) noexcept {
+    return static_cast<Mask>(_mm256_movemask_epi8(b));
+}
+
+constexpr Mask kAllMask = ~Mask(0);
+
+inline void store(char* p, Block b) noexcept {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), b);
+}
+
+inline Block bitAnd(Block a, Block b) noexcept {
+    return _mm256_and_si256(a, b);
+}
+
+inline Block bitXor(Block a, Block b) noexcept {
+    return _mm256_xor_si256(a, b);
+}
+
+// Matches bytes in [lo, hi]. Both must be ASCII, as the comparisons are signed, which also means
+// that bytes above 0x7F never match.
+inline Block inRange(Block b, char lo, char hi) noexcept {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(b, splat(char(lo - 1))),
+                            _mm256_cmpgt_epi8(splat(char(hi + 1)), b));
+}
+#elif defined(DGA_STR_SIMD_SSE2)
+#define DGA_STR_SIMD
+using Block = __m128i;
+using Mask = u32;
+constexpr std::size_t kBlockSize = 16;
+constexpr int kMaskStride = 1;
+
+inline Block load(const char* p) noexcept {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+inline Block splat(char c) noexcept {
+    return _mm_set1_epi8(c);
+}
+
+inline Block equal(Block a, Block b) noexcept {
+    return _mm_cmpeq_epi8(a, b);
+}
+
+inline Block bitOr(Block a, Block b) noexcept {
+    return _mm_or_si128(a, b);
+}
+
+inline Mask toMask(Block b) noexcept {
+    return static_cast<Mask>(_mm_movemask_epi8(b));
+}
+
+constexpr Mask kAllMask = 0xFFFF;
+
+inline void store(char* p, Block b) noexcept {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), b);
+}
+
+inline Block bitAnd(Block a, Block b) noexcept {
+    return _mm_and_si128(a, b);
+}
+
+inline Block bitXor(Block a, Block b) noexcept {
+    return _mm_xor_si128(a, b);
+}
+
+// Matches bytes in [lo, hi]. Both must be ASCII, as the comparisons are signed, which also means
+// that bytes above 0x7F never match.
+inline Block inRange(Block b, char lo, char hi) noexcept {
+    return _mm_and_si128(_mm_cmpgt_epi8(b, splat(char(lo - 1))),
+                         _mm_cmpgt_epi8(splat(char(hi + 1)), b));
+}
+#elif defined(DGA_STR_SIMD_NEON)
+#define DGA_STR_SIMD
+using Block = uint8x16_t;
+using Mask = u64;
+constexpr std::size_t kBlockSize = 16;
+// NEON has no movemask instruction. Instead, we narrow each 16-bit lane by 4 bits, which produces
+// a 64-bit mask with 4 bits per byte. Only the top bit of each nibble is kept, so each match sets
+// exactly one bit.
+constexpr int kMaskStride = 4;
+
+inline Block load(const char* p) noexcept {
+    return vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+}
+
+inline Block splat(char c) noexcept {
+    return vdupq_n_u8(static_cast<uint8_t>(c));
+}
+
+inline Block equal(Block a, Block b) noexcept {
+    return vceqq_u8(a, b);
+}
+
+inline Block bitOr(Block a, Block b) noexcept {
+    return vorrq_u8(a, b);
+}
+
+inline Mask toMask(Block b) noexcept {
+    uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(b), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ull;
+}
+
+constexpr Mask kAllMask = 0x8888888888888888ull;
+
+inline void store(char* p, Block b) noexcept {
+    vst1q_u8(reinterpret_cast<uint8_t*>(p), b);
+}
+
+inline Block bitAnd(Block a, Block b) noexcept {
+    return vandq_u8(a, b);
+}
+
+inline Block bitXor(Block a, Block b) noexcept {
+    return veorq_u8(a, b);
+}
+
+// Matches bytes in [lo, hi].
+inline Block inRange(Block b, char lo, char hi) noexcept {
+    return vandq_u8(vcgeq_u8(b, splat(lo)), vcleq_u8(b, splat(hi)));
+}
+#endif
+}  // namespace simd
+
+// Matches a single byte.
+class ByteMatcher {
+public:
+    explicit ByteMatcher(char c) noexcept
+        : c_(c)
+#if defined(DGA_STR_SIMD)
+          ,
+          splat_(simd::splat(c))
+#endif
+    {
+    }
+
+    bool matches(char c) const noexcept {
+        return c == c_;
+    }
+
+#if defined(DGA_STR_SIMD)
+    simd::Block matchBlock(simd::Block block) const noexcept {
+        return simd::equal(block, splat_);
+    }
+#endif
+
+private:
+    char c_;
+#if defined(DGA_STR_SIMD)
+    simd::Block splat_;
+#endif
+};
+
+// Matches any byte in a set. Small sets are compared one delimiter at a time in each block. Large
+// sets only use a lookup table, as comparing against every delimiter stops being profitable.
+class ByteSetMatcher {
+public:
+    static constexpr std::size_t kMaxSimdBytes = 8;
+
+    explicit ByteSetMatcher(std::string_view bytes) noexcept : table_{} {
+        for (char c : bytes) {
+            auto b = static_cast<unsigned char>(c);
+            table_[b / 64] |= u64(1) << (b % 64);
+        }
+#if defined(DGA_STR_SIMD)
+        // Use the table to skip duplicates.
+        for (unsigned b = 0; b < 256 && count_ <= kMaxSimdBytes; ++b) {
+            if ((table_[b / 64] >> (b % 64)) & 1) {
+                if (count_ < kMaxSimdBytes) {
+                    splats_[count_] = simd::splat(static_cast<char>(b));
+                }
+                ++count_;
+            }
+        }
+#endif
+    }
+
+    bool matches(char c) const noexcept {
+        auto b = static_cast<unsigned char>(c);
+        return (table_[b / 64] >> (b % 64)) & 1;
+    }
+
+#if defined(DGA_STR_SIMD)
+    bool useSimd() const noexcept {
+        return count_ > 0 && count_ <= kMaxSimdBytes;
+    }
+
+    simd::Block matchBlock(simd::Block block) const noexcept {
+        simd::Block result = simd::equal(block, splats_[0]);
+        for (std::size_t i = 1; i < count_; ++i) {
+            result = simd::bitOr(result, simd::equal(block, splats_[i]));
+        }
+        return result;
+    }
+#endif
+
+private:
+    u64 table_[4];
+#if defined(DGA_STR_SIMD)
+    std::size_t count_ = 0;
+    simd::Block splats_[kMaxSimdBytes];
+#endif
+};
+
+template <typename Matcher> bool useSimd(const Matcher&) noexcept {
+    return true;
+}
+
+inline bool useSimd(const ByteSetMatcher& matcher) noexcept {
+#if defined(DGA_STR_SIMD)
+    return matcher.useSimd();
+#else
+    static_cast<void>(matcher);
+    return false;
+#endif
+}
+
+// Calls 'f' with the index of each byte in [data, data + size) that matches 'matcher', in
+// ascending order.
+template <typename Matcher, typename F>
+void forEachMatch(const char* data, std::size_t size, const Matcher& matcher, F&& f) {
+    std::size_t i = 0;
+#if defined(DGA_STR_SIMD)
+    if (useSimd(matcher)) {
+        for (; i + simd::kBlockSize <= size; i += simd::kBlockSize) {
+            simd::Mask mask = simd::toMask(matcher.matchBlock(simd::load(data + i)));
+            while (mask != 0) {
+                f(i + std::size_t(countr_zero(mask) / simd::kMaskStride));
+                mask &= mask - 1;
+            }
+        }
+    }
+#endif
+    for (; i < size; ++i) {
+        if (matcher.matches(data[i])) {
+            f(i);
+        }
+    }
+}
+
+// Returns the index of the first byte in [data + from, data + size) that matches 'matcher', or
+// std::string_view::npos if there are no matches.
+template <typename Matcher>
+std::size_t findFirst(const char* data, std::size_t size, std::size_t from,
+                      const Matcher& matcher) noexcept {
+    std::size_t i = from;
+#if defined(DGA_STR_SIMD)
+    if (useSimd(matcher)) {
+        for (; i + simd::kBlockSize <= size; i += simd::kBlockSize) {
+            simd::Mask mask = simd::toMask(matcher.matchBlock(simd::load(data + i)));
+            if (mask != 0) {
+                return i + std::size_t(countr_zero(mask) / simd::kMaskStride);
+            }
+        }
+    }
+#endif
+    for (; i < size; ++i) {
+        if (matcher.matches(data[i])) {
+            return i;
+        }
+    }
+    return std::string_view::npos;
+}
+
+// Returns the number of bytes in [data, data + size) that match 'matcher'.
+template <typename Matcher>
+std::size_t countMatches(const char* data, std::size_t size, const Matcher& matcher) noexcept {
+    std::size_t i = 0;
+    std::size_t count = 0;
+#if defined(DGA_STR_SIMD)
+    if (useSimd(matcher)) {
+        for (; i + simd::kBlockSize <= size; i += simd::kBlockSize) {
+            count += std::size_t(popcount(simd::toMask(matcher.matchBlock(simd::load(data + i)))));
+        }
+    }
+#endif
+    for (; i < size; ++i) {
+        if (matcher.matches(data[i])) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+// Writes a token to an output iterator. If the destination accepts a std::string_view directly
+// (for example, a std::vector<std::string_view>), the view is written without copying. Otherwise,
+// the token is copied into a std::string.
+template <typename OutputIt> void emitToken(OutputIt& output_iterator, std::string_view token) {
+    if constexpr (std::is_assignable_v<decltype(*output_iterator), std::string_view>) {
+        *output_iterator++ = token;
+    } else {
+        *output_iterator++ = std::string(token);
+    }
+}
+
+// Splits 's' at each byte that matches 'matcher'. Has the same semantics as strSplit.
+template <typename Matcher, typename OutputIt>
+void splitMatches(std::string_view s, const Matcher& matcher, OutputIt& output_iterator) {
+    std::size_t start = 0;
+    forEachMatch(s.data(), s.size(), matcher, [&](std::size_t pos) {
+        emitToken(output_iterator, s.substr(start, pos - start));
+        start = pos + 1;
+    });
+    if (start < s.size()) {
+        emitToken(output_iterator, s.substr(start));
+    }
+}
+
+constexpr bool isAsciiWhitespace(char c) noexcept {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+constexpr char toLowerAscii(char c) noexcept {
+    return (c >= 'A' && c <= 'Z') ? char(c | 0x20) : c;
+}
+
+constexpr char toUpperAscii(char c) noexcept {
+    return (c >= 'a' && c <= 'z') ? char(c & ~0x20) : c;
+}
+
+#if defined(DGA_STR_SIMD)
+// Flips the case of every letter in [lo, hi] in a block.
+inline simd::Block flipCaseBlock(simd::Block block, char lo, char hi) noexcept {
+    return simd::bitXor(block, simd::bitAnd(simd::inRange(block, lo, hi), simd::splat(0x20)));
+}
+#endif
+
+// Converts the ASCII letters in [src, src + size) to lower or upper case, and writes the result to
+// 'dst', which may be equal to 'src'. Other bytes are copied unchanged.
+template <bool Upper>
+void convertCaseAscii(const char* src, char* dst, std::size_t size) noexcept {
+    std::size_t i = 0;
+#if defined(DGA_STR_SIMD)
+    for (; i + simd::kBlockSize <= size; i += simd::kBlockSize) {
+        const simd::Block block = simd::load(src + i);
+        simd::store(dst + i,
+                    Upper ? flipCaseBlock(block, 'a', 'z') : flipCaseBlock(block, 'A', 'Z'));
+    }
+#endif
+    for (; i < size; ++i) {
+        dst[i] = Upper ? toUpperAscii(src[i]) : toLowerAscii(src[i]);
+    }
+}
+
+// Returns true if [a, a + size) and [b, b + size) are equal, ignoring the case of ASCII letters.
+inline bool equalsIgnoreCaseAscii(const char* a, const char* b, std::size_t size) noexcept {
+    std::size_t i = 0;
+#if defined(DGA_STR_SIMD)
+    for (; i + simd::kBlockSize <= size; i += simd::kBlockSize) {
+        const simd::Block lower_a = flipCaseBlock(simd::load(a + i), 'A', 'Z');
+        const simd::Block lower_b = flipCaseBlock(simd::load(b + i), 'A', 'Z');
+        if (simd::toMask(simd::equal(lower_a, lower_b)) != simd::kAllMask) {
+            return false;
+        }
+    }
+#endif
+    for (; i < size; ++i) {
+        if (toLowerAscii(a[i]) != toLowerAscii(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+}  // namespace detail
+
 /// Splits a string, delimited by character 'delim' into multiple strings. These strings are stored
 /// in the 'output_iterator' iterator. Trailing delimiters are ignored.
+///
+/// If 'output_iterator' accepts a std::string_view, then each token is a view into 's' and no
+/// memory is allocated other than by the output iterator itself. In this case, 's' must outlive
+/// the tokens.
 template <typename OutputIt>
-void strSplit(const std::string& s, char delim, OutputIt output_iterator) {
-    std::istringstream ss(s);
-    std::string item;
-    while (std::getline(ss, item, delim)) {
-        *output_iterator++ = std::move(item);
+void strSplit(std::string_view s, char delim, OutputIt output_iterator) {
+    detail::splitMatches(s, detail::ByteMatcher{delim}, output_iterator);
+}
+
+/// Splits a string into multiple strings, delimited by any of the characters in 'delims'. Has the
+/// same semantics as strSplit.
+template <typename OutputIt>
+void strSplitAny(std::string_view s, std::string_view delims, OutputIt output_iterator) {
+    detail::splitMatches(s, detail::ByteSetMatcher{delims}, output_iterator);
+}
+
+/// Returns the number of occurrences of character 'c' in 's'.
+inline std::size_t strCount(std::string_view s, char c) noexcept {
+    return detail::countMatches(s.data(), s.size(), detail::ByteMatcher{c});
+}
+
+/// Returns 's' without leading ASCII whitespace (space, \t, \n, \v, \f and \r).
+constexpr std::string_view strTrimLeft(std::string_view s) noexcept {
+    std::size_t start = 0;
+    while (start < s.size() && detail::isAsciiWhitespace(s[start])) {
+        ++start;
+    }
+    return s.substr(start);
+}
+
+/// Returns 's' without trailing ASCII whitespace.
+constexpr std::string_view strTrimRight(std::string_view s) noexcept {
+    std::size_t end = s.size();
+    while (end > 0 && detail::isAsciiWhitespace(s[end - 1])) {
+        --end;
+    }
+    return s.substr(0, end);
+}
+
+/// Returns 's' without leading or trailing ASCII whitespace.
+constexpr std::string_view strTrim(std::string_view s) noexcept {
+    return strTrimRight(strTrimLeft(s));
+}
+
+/// Converts the ASCII letters in 's' to lower case in place. Other bytes, including UTF-8, are
+/// left unchanged, and the result doesn't depend on the locale.
+inline void strToLowerAsciiInPlace(std::string& s) noexcept {
+    detail::convertCaseAscii<false>(s.data(), s.data(), s.size());
+}
+
+/// Returns a copy of 's' with its ASCII letters converted to lower case.
+inline std::string strToLowerAscii(std::string_view s) {
+    std::string result(s.size(), '\0');
+    detail::convertCaseAscii<false>(s.data(), result.data(), s.size());
+    return result;
+}
+
+/// Converts the ASCII letters in 's' to upper case in place.
+inline void strToUpperAsciiInPlace(std::string& s) noexcept {
+    detail::convertCaseAscii<true>(s.data(), s.data(), s.size());
+}
+
+/// Returns a copy of 's' with its ASCII letters converted to upper case.
+inline std::string strToUpperAscii(std::string_view s) {
+    std::string result(s.size(), '\0');
+    detail::convertCaseAscii<true>(s.data(), result.data(), s.size());
+    return result;
+}
+
+/// Returns true if 'a' and 'b' are equal, ignoring the case of ASCII letters.
+inline bool strEqualsIgnoreCase(std::string_view a, std::string_view b) noexcept {
+    return a.size() == b.size() && detail::equalsIgnoreCaseAscii(a.data(), b.data(), a.size());
+}
+
+/// Returns true if 's' starts with 'prefix'.
+constexpr bool strStartsWith(std::string_view s, std::string_view prefix) noexcept {
+    return s.size() >= prefix.size() && s.compare(0, prefix.size(), prefix) == 0;
+}
+
+/// Returns true if 's' ends with 'suffix'.
+constexpr bool strEndsWith(std::string_view s, std::string_view suffix) noexcept {
+    return s.size() >= suffix.size() &&
+           s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/// Returns true if 's' starts with 'prefix', ignoring the case of ASCII letters.
+inline bool strStartsWithIgnoreCase(std::string_view s, std::string_view prefix) noexcept {
+    return s.size() >= prefix.size() &&
+           detail::equalsIgnoreCaseAscii(s.data(), prefix.data(), prefix.size());
+}
+
+/// Returns true if 's' ends with 'suffix', ignoring the case of ASCII letters.
+inline bool strEndsWithIgnoreCase(std::string_view s, std::string_view suffix) noexcept {
+    return s.size() >= suffix.size() &&
+           detail::equalsIgnoreCaseAscii(s.data() + s.size() - suffix.size(), suffix.data(),
+                                         suffix.size());
+}
+
+/// Returns the position of the first occurrence of 'needle' in 's' at or after 'from', ignoring
+/// the case of ASCII letters, or std::string_view::npos if there is none. Candidates are found by
+/// scanning for either case of the first byte of 'needle' a block at a time, and are then compared
+/// in full. An empty 'needle' matches at 'from'.
+inline std::size_t strFindIgnoreCase(std::string_view s, std::string_view needle,
+                                     std::size_t from = 0) noexcept {
+    if (needle.size() > s.size() || from > s.size() - needle.size()) {
+        return std::string_view::npos;
+    }
+    if (needle.empty()) {
+        return from;
+    }
+    const char first[2] = {detail::toLowerAscii(needle[0]), detail::toUpperAscii(needle[0])};
+    const detail::ByteSetMatcher matcher{std::string_view(first, 2)};
+    // A match can't start after 'last', so stop scanning for the first byte there.
+    const std::size_t last = s.size() - needle.size();
+    for (std::size_t pos = from; pos <= last; ++pos) {
+        pos = detail::findFirst(s.data(), last + 1, pos, matcher);
+        if (pos == std::string_view::npos) {
+            break;
+        }
+        if (detail::equalsIgnoreCaseAscii(s.data() + pos + 1, needle.data() + 1,
+                                          needle.size() - 1)) {
+            return pos;
+        }
+    }
+    return std::string_view::npos;
+}
+
+/// A forward iterator over the tokens of a string delimited by a single character. Tokens are
+/// views into the original string, and are produced lazily as the iterator is advanced. Has the
+/// same semantics as strSplit.
+class StrSplitIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const std::string_view*;
+    using reference = const std::string_view&;
+
+    // Constructs an end iterator.
+    constexpr StrSplitIterator() noexcept = default;
+
+    constexpr StrSplitIterator(std::string_view s, char delim) noexcept
+        : s_(s), delim_(delim), pos_(0), at_end_(false) {
+        advance();
+    }
+
+    constexpr reference operator*() const noexcept {
+        return token_;
+    }
+
+    constexpr pointer operator->() const noexcept {
+        return &token_;
+    }
+
+    constexpr StrSplitIterator& operator++() noexcept {
+        advance();
+        return *this;
+    }
+
+    constexpr StrSplitIterator operator++(int) noexcept {
+        StrSplitIterator tmp = *this;
+        advance();
+        return tmp;
+    }
+
+    constexpr bool operator==(const StrSplitIterator& rhs) const noexcept {
+        if (at_end_ || rhs.at_end_) {
+            return at_end_ == rhs.at_end_;
+        }
+        return s_.data() == rhs.s_.data() && pos_ == rhs.pos_;
+    }
+
+    constexpr bool operator!=(const StrSplitIterator& rhs) const noexcept {
+        return !(*this == rhs);
+    }
+
+private:
+    std::string_view s_;
+    std::string_view token_;
+    char delim_ = '\0';
+    // The position in 's_' directly after the current token (and its delimiter).
+    std::size_t pos_ = 0;
+    bool at_end_ = true;
+
+    constexpr void advance() noexcept {
+        if (pos_ >= s_.size()) {
+            at_end_ = true;
+            return;
+        }
+        std::size_t next = s_.find(delim_, pos_);
+        if (next == std::string_view::npos) {
+            next = s_.size();
+        }
+        token_ = s_.substr(pos_, next - pos_);
+        pos_ = next + 1;
+    }
+};
+
+/// A lazy range of tokens returned by strSplitRange, which can be used in a range-based for loop.
+class StrSplitRange {
+public:
+    using iterator = StrSplitIterator;
+    using const_iterator = StrSplitIterator;
+
+    constexpr StrSplitRange(std::string_view s, char delim) noexcept : s_(s), delim_(delim) {
+    }
+
+    constexpr iterator begin() const noexcept {
+        return StrSplitIterator{s_, delim_};
+    }
+
+    constexpr iterator end() const noexcept {
+        return StrSplitIterator{};
+    }
+
+private:
+    std::string_view s_;
+    char delim_;
+};
+
+/// Splits a string lazily, delimited by character 'delim'. The tokens are views into 's', so 's'
+/// must outlive the returned range. Has the same semantics as strSplit.
+constexpr StrSplitRange strSplitRange(std::string_view s, char delim) noexcept {
+    return StrSplitRange{s, delim};
+}
+
+/// Splits a stream of bytes that arrives in chunks, such as from a socket or a pipe, into tokens
+/// delimited by any of a set of characters. Each complete token is passed to a callback as soon as
+/// its delimiter has been fed, and the stream as a whole has the same semantics as strSplit.
+///
+/// A token that is entirely within one chunk is passed as a view into that chunk without being
+/// copied. Only the partial token at the end of each chunk is copied, into a buffer which is
+/// reused for the lifetime of the splitter, so memory use is bounded by the longest token rather
+/// than the size of the stream:
+///
+///     dga::StreamSplitter lines{'\n'};
+///     while (read(socket, chunk)) {
+///         lines.feed(chunk, [](std::string_view line) { ... });
+///     }
+///     lines.finish([](std::string_view line) { ... });
+///
+/// Tokens passed to the callback are only valid until it returns.
+class StreamSplitter {
+public:
+    explicit StreamSplitter(char delim) : matcher_(std::string_view(&delim, 1)) {
+    }
+
+    explicit StreamSplitter(std::string_view delims) : matcher_(delims) {
+    }
+
+    /// Scans 'chunk' for delimiters, and calls 'on_token' with each token that is completed.
+    template <typename F> void feed(std::string_view chunk, F&& on_token) {
+        std::size_t start = 0;
+        if (!pending_.empty()) {
+            const std::size_t pos = detail::findFirst(chunk.data(), chunk.size(), 0, matcher_);
+            if (pos == std::string_view::npos) {
+                pending_.append(chunk);
+                return;
+            }
+            pending_.append(chunk.data(), pos);
+            on_token(std::string_view{pending_});
+            pending_.clear();
+            start = pos + 1;
+        }
+        const std::size_t base = start;
+        detail::forEachMatch(chunk.data() + base, chunk.size() - base, matcher_,
+                             [&](std::size_t pos) {
+                                 on_token(chunk.substr(start, base + pos - start));
+                                 start = base + pos + 1;
+                             });
+        pending_.append(chunk.data() + start, chunk.size() - start);
+    }
+
+    /// Ends the stream, and calls 'on_token' with the final token if it isn't empty. The splitter
+    /// can then be reused for a new stream.
+    template <typename F> void finish(F&& on_token) {
+        if (!pending_.empty()) {
+            on_token(std::string_view{pending_});
+            pending_.clear();
+        }
+    }
+
+    /// Discards the partial token, if any.
+    void reset() noexcept {
+        pending_.clear();
+    }
+
+    /// Returns the partial token that has been fed since the last delimiter.
+    std::string_view pending() const noexcept {
+        return pending_;
+    }
+
+private:
+    detail::ByteSetMatcher matcher_;
+    std::string pending_;
+};
+
+/// Joins a range of strings specified with iterators 'first' and 'last', with a separator between
+/// each string, and appends the result to 'output'. This allows the buffer in 'output' to be
+/// reused between calls.
+///
+/// If the elements are string-like (convertible to std::string_view), and the range can be
+/// traversed more than once, then the size of the result is calculated up front, so 'output' is
+/// grown at most once. Other element types are formatted with operator<<.
+template <typename InputIt>
+void strJoin(std::string& output, InputIt first, InputIt last, std::string_view separator) {
+    using reference = typename std::iterator_traits<InputIt>::reference;
+    using category = typename std::iterator_traits<InputIt>::iterator_category;
+    if constexpr (std::is_convertible_v<reference, std::string_view>) {
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>) {
+            if (first == last) {
+                return;
+            }
+            std::size_t size = 0;
+            std::size_t count = 0;
+            for (InputIt it = first; it != last; ++it) {
+                size += std::string_view{*it}.size();
+                ++count;
+            }
+            output.reserve(output.size() + size + separator.size() * (count - 1));
+        }
+        if (first != last) {
+            output.append(std::string_view{*first++});
+        }
+        while (first != last) {
+            output.append(separator);
+            output.append(std::string_view{*first++});
+        }
+    } else {
+        std::ostringstream ss;
+        if (first != last) {
+            ss << *first++;
+        }
+        while (first != last) {
+            ss << separator;
+            ss << *first++;
+        }
+        output.append(ss.str());
     }
 }
 
 /// Joins a range of strings specified with iterators 'first' and 'last' into a single string, with
 /// a separator between each string.
 template <typename InputIt>
-std::string strJoin(InputIt first, InputIt last, const std::string& separator) {
-    std::ostringstream ss;
-    if (first != last) {
-        ss << *first++;
+std::string strJoin(InputIt first, InputIt last, std::string_view separator) {
+    std::string output;
+    strJoin(output, first, last, separator);
+    return output;
+}
+
+/// Performs an exhaustive search and replace in string 'subject'. The result is built in a single
+/// pass, so the cost is linear in the size of 'subject' regardless of the number of matches. An
+/// empty 'search' string matches nothing.
+inline std::string strReplaceAll(std::string_view subject, std::string_view search,
+                                 std::string_view replace) {
+    std::size_t pos = search.empty() ? std::string_view::npos : subject.find(search);
+    if (pos == std::string_view::npos) {
+        return std::string(subject);
     }
-    while (first != last) {
-        ss << separator;
-        ss << *first++;
+    std::string result;
+    result.reserve(subject.size());
+    std::size_t last = 0;
+    while (pos != std::string_view::npos) {
+        result.append(subject, last, pos - last);
+        result.append(replace);
+        last = pos + search.size();
+        pos = subject.find(search, last);
     }
-    return ss.str();
+    result.append(subject, last, std::string_view::npos);
+    return result;
 }
 
-/// Performs an exhaustive search and replace in string 'subject'.
-inline std::string strReplaceAll(std::string subject, const std::string& search,
-                                 const std::string& replace) {
-    size_t pos = 0;
-    while ((pos = subject.find(search, pos)) != std::string::npos) {
-        subject.replace(pos, search.length(), replace);
-        pos += replace.length();
+/// A table of (pattern, replacement) pairs used by strReplaceMany. The patterns are compiled into
+/// an Aho-Corasick automaton when the table is constructed, so a table can be built once and
+/// reused to search any number of strings in a single pass.
+///
+/// Matches are found leftmost-longest: the match that starts earliest wins, and if several
+/// patterns match at the same position, the longest one wins. Empty patterns are ignored, and if
+/// a pattern appears more than once, the first replacement is used.
+class StrReplaceTable {
+public:
+    struct Match {
+        std::size_t position;
+        std::size_t length;
+        // Index of the matching pattern, in the order given to the constructor.
+        std::size_t index;
+    };
+
+    StrReplaceTable(std::initializer_list<std::pair<std::string_view, std::string_view>> entries)
+        : StrReplaceTable(entries.begin(), entries.end()) {
+    }
+
+    /// Constructs a table from a range of pairs that are convertible to std::string_view.
+    template <typename InputIt> StrReplaceTable(InputIt first, InputIt last) {
+        for (; first != last; ++first) {
+            patterns_.emplace_back(first->first);
+            replacements_.emplace_back(first->second);
+        }
+        build();
+    }
+
+    std::size_t size() const noexcept {
+        return patterns_.size();
     }
-    return subject;
+
+    const std::string& pattern(std::size_t index) const noexcept {
+        return patterns_[index];
+    }
+
+    const std::string& replacement(std::size_t index) const noexcept {
+        return replacements_[index];
+    }
+
+    /// Finds the leftmost-longest match in 's' that starts at or after 'from'. If there is no
+    /// match, the position of the returned Match is std::string_view::npos.
+    Match find(std::string_view s, std::size_t from = 0) const noexcept {
+        Match best{std::string_view::npos, 0, 0};
+        u32 state = 0;
+        for (std::size_t i = from; i < s.size(); ++i) {
+            state = transitions_[state * class_count_ + classes_[static_cast<u8>(s[i])]];
+            const u32 output = outputs_[state];
+            if (output != kNoState) {
+                const std::size_t length = patterns_[output].size();
+                const std::size_t position = i + 1 - length;
+                if (position <= best.position) {
+                    best = Match{position, length, output};
+                }
+            }
+            // The automaton state represents the longest suffix of the input that is a prefix of
+            // a pattern. Once that suffix starts after the best match, no later match can start
+            // at or before it, so the best match is final.
+            if (best.position != std::string_view::npos && i + 1 - depths_[state] > best.position) {
+                break;
+            }
+        }
+        return best;
+    }
+
+private:
+    static constexpr u32 kNoState = ~u32(0);
+
+    std::vector<std::string> patterns_;
+    std::vector<std::string> replacements_;
+
+    // Bytes that don't appear in any pattern share equivalence class 0, which keeps the transition
+    // table small.
+    u16 classes_[256] = {};
+    std::size_t class_count_ = 1;
+
+    // Per state: the transition table row, the depth in the trie, and the longest pattern that is a
+    // suffix of the state (or kNoState).
+    std::vector<u32> transitions_;
+    std::vector<u32> depths_;
+    std::vector<u32> outputs_;
+
+    u32 addState(u32 depth) {
+        transitions_.resize(transitions_.size() + class_count_, kNoState);
+        depths_.push_back(depth);
+        outputs_.push_back(kNoState);
+        return u32(depths_.size() - 1);
+    }
+
+    void build() {
+        for (const std::string& pattern : patterns_) {
+            for (char c : pattern) {
+                u16& cls = classes_[static_cast<u8>(c)];
+                if (cls == 0) {
+                    cls = u16(class_count_++);
+                }
+            }
+        }
+
+        // Build the trie of patterns.
+        addState(0);
+        for (std::size_t index = 0; index < patterns_.size(); ++index) {
+            if (patterns_[index].empty()) {
+                continue;
+            }
+            u32 state = 0;
+            for (char c : patterns_[index]) {
+                u32& next = transitions_[state * class_count_ + classes_[static_cast<u8>(c)]];
+                if (next == kNoState) {
+                    // addState may reallocate the transition table, so look up the entry again.
+                    const u32 new_state = addState(depths_[state] + 1);
+                    transitions_[state * class_count_ + classes_[static_cast<u8>(c)]] = new_state;
+                    state = new_state;
+                } else {
+                    state = next;
+                }
+            }
+            if (outputs_[state] == kNoState) {
+                outputs_[state] = u32(index);
+            }
+        }
+
+        // Compute failure links in breadth first order, and fold them into the transition table
+        // so that searching takes exactly one lookup per byte.
+        std::vector<u32> failure(depths_.size(), 0);
+        std::vector<u32> queue;
+        queue.reserve(depths_.size());
+        for (std::size_t c = 0; c < class_count_; ++c) {
+            u32& next = transitions_[c];
+            if (next == kNoState) {
+                next = 0;
+            } else {
+                queue.push_back(next);
+            }
+        }
+        for (std::size_t head = 0; head < queue.size(); ++head) {
+            const u32 state = queue[head];
+            if (outputs_[state] == kNoState) {
+                outputs_[state] = outputs_[failure[state]];
+            }
+            for (std::size_t c = 0; c < class_count_; ++c) {
+                u32& next = transitions_[state * class_count_ + c];
+                const u32 fallback = transitions_[failure[state] * class_count_ + c];
+                if (next == kNoState) {
+                    next = fallback;
+                } else {
+                    failure[next] = fallback;
+                    queue.push_back(next);
+                }
+            }
+        }
+    }
+};
+
+/// Replaces every match of the patterns in 'table' in 'subject' with the corresponding
+/// replacement, in a single pass over 'subject'. Replacements are not searched again.
+inline std::string strReplaceMany(std::string_view subject, const StrReplaceTable& table) {
+    std::string result;
+    result.reserve(subject.size());
+    std::size_t pos = 0;
+    while (pos < subject.size()) {
+        StrReplaceTable::Match match = table.find(subject, pos);
+        if (match.position == std::string_view::npos) {
+            break;
+        }
+        result.append(subject, pos, match.position - pos);
+        result.append(table.replacement(match.index));
+        pos = match.position + match.length;
+    }
+    result.append(subject, pos, std::string_view::npos);
+    return result;
+}
+
+/// Replaces every match of the (pattern, replacement) pairs in 'entries' in 'subject'. Prefer
+/// building a StrReplaceTable once if the same patterns are used repeatedly.
+inline std::string strReplaceMany(
+    std::string_view subject,
+    std::initializer_list<std::pair<std::string_view, std::string_view>> entries) {
+    return strReplaceMany(subject, StrReplaceTable{entries});
 }
 }  // namespace dga
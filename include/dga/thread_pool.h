@@ -0,0 +1,472 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#pragma once
+
+#include "../dga/aliases.h"
+#include "../dga/arena.h"
+#include "../dga/futex.h"
+#include "../dga/platform.h"
+#include "../dga/semaphore.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ * Work stealing thread pool.
+ *
+ * Each worker owns a Chase-Lev deque (as described in "Correct and Efficient Work-Stealing for
+ * Weak Memory Models" by Lê et al.). Tasks submitted from a worker are pushed onto the bottom of
+ * its own deque, and the worker pops from the bottom itself, so the common case never touches
+ * shared state. An idle worker steals from the top of the deque of a randomly chosen victim.
+ * Tasks submitted from outside the pool go onto a shared injection queue. Tasks are allocated from
+ * a Pool (see arena.h), so once its free lists are warm, submitting a task doesn't call malloc.
+ *
+ * Workers that can't find any work park on a LightweightSemaphore, and are woken when new tasks
+ * are submitted.
+ *
+ * WaitGroup provides fork/join: add() a unit for each task, done() when a task completes, and
+ * wait() until the count reaches zero. ThreadPool::wait(group) runs other tasks from the pool
+ * whilst it waits, so it's safe to call from inside a task.
+ */
+
+namespace dga {
+class WaitGroup {
+public:
+    explicit WaitGroup(std::size_t count = 0);
+    WaitGroup(const WaitGroup&) = delete;
+    WaitGroup& operator=(const WaitGroup&) = delete;
+
+    void add(std::size_t n = 1);
+    void done();
+    // Returns true if the count is zero.
+    bool try_wait() const;
+    // Blocks until the count is zero.
+    void wait();
+
+private:
+    std::atomic<u32> count_;
+    std::atomic<u32> waiters_;
+};
+
+inline WaitGroup::WaitGroup(std::size_t count) : count_(static_cast<u32>(count)), waiters_(0) {
+}
+
+inline void WaitGroup::add(std::size_t n) {
+    count_.fetch_add(static_cast<u32>(n), std::memory_order_relaxed);
+}
+
+inline void WaitGroup::done() {
+    const u32 previous = count_.fetch_sub(1, std::memory_order_seq_cst);
+    assert(previous > 0);
+    if (previous == 1 && waiters_.load(std::memory_order_seq_cst) != 0) {
+        futexWakeAll(count_);
+    }
+}
+
+inline bool WaitGroup::try_wait() const {
+    return count_.load(std::memory_order_acquire) == 0;
+}
+
+inline void WaitGroup::wait() {
+    if (try_wait()) {
+        return;
+    }
+    waiters_.fetch_add(1, std::memory_order_seq_cst);
+    while (true) {
+        const u32 count = count_.load(std::memory_order_seq_cst);
+        if (count == 0) {
+            break;
+        }
+        futexWait(count_, count);
+    }
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+namespace detail {
+// A unit of work. run() is called exactly once, and frees the task.
+struct Task {
+    virtual void run() = 0;
+
+protected:
+    ~Task() = default;
+};
+
+// Tasks are allocated from a Pool, so submitting a task doesn't call malloc.
+template <typename F> struct FunctionTask final : Task {
+    template <typename G> explicit FunctionTask(G&& g) : fn(std::forward<G>(g)) {
+    }
+
+    void run() override {
+        ScopeExit destroy{[this]() noexcept { Pool<FunctionTask>::destroy(this); }};
+        fn();
+    }
+
+    F fn;
+};
+
+// Chase-Lev work stealing deque. push() and pop() may only be called by the owning thread, and
+// steal() may be called by any thread.
+template <typename T> class WorkStealingDeque {
+public:
+    static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable.");
+
+    explicit WorkStealingDeque(std::size_t capacity = 64);
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    void push(T value);
+    bool pop(T& value);
+    bool steal(T& value);
+
+    bool empty() const noexcept;
+
+private:
+    struct Array {
+        explicit Array(std::size_t capacity)
+            : mask(capacity - 1), data(new std::atomic<T>[capacity]) {
+        }
+
+        std::size_t capacity() const noexcept {
+            return mask + 1;
+        }
+
+        T get(i64 index) const noexcept {
+            return data[static_cast<std::size_t>(index) & mask].load(std::memory_order_relaxed);
+        }
+
+        void put(i64 index, T value) noexcept {
+            data[static_cast<std::size_t>(index) & mask].store(value, std::memory_order_relaxed);
+        }
+
+        std::size_t mask;
+        std::unique_ptr<std::atomic<T>[]> data;
+    };
+
+    alignas(kCacheLineSize) std::atomic<i64> top_{0};
+    alignas(kCacheLineSize) std::atomic<i64> bottom_{0};
+    std::atomic<Array*> array_;
+    // Every array that has been allocated. Old arrays are kept alive after growing, as a thief may
+    // still be reading from them.
+    std::vector<std::unique_ptr<Array>> arrays_;
+};
+
+template <typename T> WorkStealingDeque<T>::WorkStealingDeque(std::size_t capacity) {
+    assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+    arrays_.emplace_back(std::make_unique<Array>(capacity));
+    array_.store(arrays_.back().get(), std::memory_order_relaxed);
+}
+
+template <typename T> void WorkStealingDeque<T>::push(T value) {
+    const i64 bottom = bottom_.load(std::memory_order_relaxed);
+    const i64 top = top_.load(std::memory_order_acquire);
+    Array* array = array_.load(std::memory_order_relaxed);
+    if (bottom - top > static_cast<i64>(array->capacity()) - 1) {
+        auto grown = std::make_unique<Array>(array->capacity() * 2);
+        for (i64 i = top; i < bottom; ++i) {
+            grown->put(i, array->get(i));
+        }
+        array = grown.get();
+        arrays_.emplace_back(std::move(grown));
+        array_.store(array, std::memory_order_release);
+    }
+    array->put(bottom, value);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+}
+
+template <typename T> bool WorkStealingDeque<T>::pop(T& value) {
+    const i64 bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    Array* array = array_.load(std::memory_order_relaxed);
+    bottom_.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    i64 top = top_.load(std::memory_order_relaxed);
+    if (top > bottom) {
+        // Empty.
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+        return false;
+    }
+    value = array->get(bottom);
+    if (top == bottom) {
+        // Last element, so race against any thieves for it.
+        const bool won = top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                      std::memory_order_relaxed);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+        return won;
+    }
+    return true;
+}
+
+template <typename T> bool WorkStealingDeque<T>::steal(T& value) {
+    i64 top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const i64 bottom = bottom_.load(std::memory_order_acquire);
+    if (top >= bottom) {
+        return false;
+    }
+    Array* array = array_.load(std::memory_order_acquire);
+    value = array->get(top);
+    return top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed);
+}
+
+template <typename T> bool WorkStealingDeque<T>::empty() const noexcept {
+    return top_.load(std::memory_order_relaxed) >= bottom_.load(std::memory_order_relaxed);
+}
+}  // namespace detail
+
+class ThreadPool {
+public:
+    // Creates a pool with 'thread_count' workers. If 'thread_count' is 0, one worker is created
+    // for each hardware thread.
+    explicit ThreadPool(std::size_t thread_count = 0);
+    // Runs any remaining tasks, then joins the workers.
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Schedules 'f' to run on the pool.
+    template <typename F> void submit(F&& f);
+    // Schedules 'f' to run on the pool as part of 'group'. The group is incremented now, and
+    // decremented once 'f' has run.
+    template <typename F> void submit(WaitGroup& group, F&& f);
+
+    // Blocks until 'group' is done, running tasks from the pool in the meantime.
+    void wait(WaitGroup& group);
+
+    // Calls fn(i) for each i in [begin, end), in parallel. The range is split in half recursively
+    // until each part has at most 'grain' iterations, so that idle workers can steal large parts of
+    // the range. Returns once every iteration has completed.
+    template <typename Index, typename F>
+    void parallel_for(Index begin, Index end, Index grain, F&& fn);
+
+    std::size_t thread_count() const noexcept {
+        return worker_count_;
+    }
+
+private:
+    struct alignas(kCacheLineSize) Worker {
+        detail::WorkStealingDeque<detail::Task*> deque;
+        u64 rng_state = 0;
+        std::thread thread;
+    };
+
+    std::unique_ptr<Worker[]> workers_;
+    std::size_t worker_count_;
+
+    std::mutex injection_mutex_;
+    std::deque<detail::Task*> injection_queue_;
+    std::atomic<std::size_t> injection_size_{0};
+
+    alignas(kCacheLineSize) std::atomic<u32> sleeping_{0};
+    std::atomic<bool> stop_{false};
+    LightweightSemaphore wakeup_;
+
+    // Returns the worker of this pool running on the calling thread, or nullptr.
+    Worker* currentWorker() const noexcept;
+    static const ThreadPool*& currentPool() noexcept;
+    static Worker*& currentPoolWorker() noexcept;
+
+    void schedule(detail::Task* task);
+    detail::Task* findTask(Worker* self);
+    detail::Task* popInjected();
+    detail::Task* steal(Worker* self);
+    static void run(detail::Task* task);
+    void workerLoop(Worker& self);
+
+    template <typename Index, typename F>
+    void parallelForRange(WaitGroup& group, Index begin, Index end, Index grain, F& fn);
+};
+
+inline ThreadPool::ThreadPool(std::size_t thread_count) {
+    if (thread_count == 0) {
+        thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    worker_count_ = thread_count;
+    workers_ = std::make_unique<Worker[]>(worker_count_);
+    for (std::size_t i = 0; i < worker_count_; ++i) {
+        // Any odd seed works for xorshift, so just make them distinct.
+        workers_[i].rng_state = (0x9e3779b97f4a7c15ull * (i + 1)) | 1;
+    }
+    for (std::size_t i = 0; i < worker_count_; ++i) {
+        workers_[i].thread = std::thread{[this, i] { workerLoop(workers_[i]); }};
+    }
+}
+
+inline ThreadPool::~ThreadPool() {
+    stop_.store(true, std::memory_order_seq_cst);
+    wakeup_.notify(worker_count_);
+    for (std::size_t i = 0; i < worker_count_; ++i) {
+        workers_[i].thread.join();
+    }
+    assert(injection_queue_.empty());
+}
+
+template <typename F> void ThreadPool::submit(F&& f) {
+    schedule(Pool<detail::FunctionTask<std::decay_t<F>>>::create(std::forward<F>(f)));
+}
+
+template <typename F> void ThreadPool::submit(WaitGroup& group, F&& f) {
+    group.add(1);
+    submit([&group, fn = std::forward<F>(f)]() mutable {
+        fn();
+        group.done();
+    });
+}
+
+inline void ThreadPool::wait(WaitGroup& group) {
+    Worker* self = currentWorker();
+    while (!group.try_wait()) {
+        detail::Task* task = findTask(self);
+        if (!task) {
+            // Any tasks that this thread pushed onto its own deque have been taken by now, so the
+            // rest of the group is running elsewhere and it's safe to block.
+            group.wait();
+            return;
+        }
+        run(task);
+    }
+}
+
+template <typename Index, typename F>
+void ThreadPool::parallel_for(Index begin, Index end, Index grain, F&& fn) {
+    if (!(begin < end)) {
+        return;
+    }
+    WaitGroup group;
+    parallelForRange(group, begin, end, std::max(grain, Index(1)), fn);
+    wait(group);
+}
+
+template <typename Index, typename F>
+void ThreadPool::parallelForRange(WaitGroup& group, Index begin, Index end, Index grain, F& fn) {
+    // Hand off the upper half of the range until the remainder is small enough to run here.
+    while (end - begin > grain) {
+        const Index mid = begin + (end - begin) / 2;
+        submit(group, [this, &group, mid, end, grain, &fn] {
+            parallelForRange(group, mid, end, grain, fn);
+        });
+        end = mid;
+    }
+    for (Index i = begin; i < end; ++i) {
+        fn(i);
+    }
+}
+
+inline ThreadPool::Worker* ThreadPool::currentWorker() const noexcept {
+    return currentPool() == this ? currentPoolWorker() : nullptr;
+}
+
+inline const ThreadPool*& ThreadPool::currentPool() noexcept {
+    static thread_local const ThreadPool* pool = nullptr;
+    return pool;
+}
+
+inline ThreadPool::Worker*& ThreadPool::currentPoolWorker() noexcept {
+    static thread_local Worker* worker = nullptr;
+    return worker;
+}
+
+inline void ThreadPool::schedule(detail::Task* task) {
+    if (Worker* self = currentWorker()) {
+        self->deque.push(task);
+    } else {
+        std::lock_guard<std::mutex> lock{injection_mutex_};
+        injection_queue_.push_back(task);
+        injection_size_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Pairs with the fence in workerLoop. Either a parking worker sees the new task, or we see
+    // that it's parking and wake it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_relaxed) != 0) {
+        wakeup_.notify();
+    }
+}
+
+inline detail::Task* ThreadPool::findTask(Worker* self) {
+    detail::Task* task = nullptr;
+    if (self && self->deque.pop(task)) {
+        return task;
+    }
+    if ((task = popInjected())) {
+        return task;
+    }
+    return steal(self);
+}
+
+inline detail::Task* ThreadPool::popInjected() {
+    if (injection_size_.load(std::memory_order_relaxed) == 0) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock{injection_mutex_};
+    if (injection_queue_.empty()) {
+        return nullptr;
+    }
+    detail::Task* task = injection_queue_.front();
+    injection_queue_.pop_front();
+    injection_size_.fetch_sub(1, std::memory_order_relaxed);
+    return task;
+}
+
+inline detail::Task* ThreadPool::steal(Worker* self) {
+    // Threads outside the pool don't have a random state of their own, so they always start
+    // from the first worker.
+    std::size_t start = 0;
+    if (self) {
+        u64 x = self->rng_state;
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        self->rng_state = x;
+        start = static_cast<std::size_t>(x % worker_count_);
+    }
+    detail::Task* task = nullptr;
+    for (std::size_t i = 0; i < worker_count_; ++i) {
+        Worker& victim = workers_[(start + i) % worker_count_];
+        if (&victim != self && victim.deque.steal(task)) {
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+inline void ThreadPool::run(detail::Task* task) {
+    task->run();
+}
+
+inline void ThreadPool::workerLoop(Worker& self) {
+    currentPool() = this;
+    currentPoolWorker() = &self;
+    while (true) {
+        if (detail::Task* task = findTask(&self)) {
+            run(task);
+            continue;
+        }
+
+        // Announce that we're about to park, then check for work once more, so that a task
+        // submitted in the meantime isn't missed.
+        sleeping_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (detail::Task* task = findTask(&self)) {
+            sleeping_.fetch_sub(1, std::memory_order_relaxed);
+            run(task);
+            continue;
+        }
+        if (stop_.load(std::memory_order_seq_cst)) {
+            sleeping_.fetch_sub(1, std::memory_order_relaxed);
+            break;
+        }
+        wakeup_.wait();
+        sleeping_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    currentPool() = nullptr;
+    currentPoolWorker() = nullptr;
+}
+}  // namespace dga
@@ -0,0 +1,658 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#pragma once
+
+#include "../dga/aliases.h"
+#include "../dga/bit.h"
+#include "../dga/platform.h"
+#include "../dga/scope.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#if defined(DGA_ARCH_X86_64) || defined(DGA_ARCH_X86)
+#if defined(DGA_MSVC)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+/*
+ * Low overhead instrumentation of scopes.
+ *
+ *     void handleRequest(const Request& request) {
+ *         DGA_TRACE_SCOPE("handleRequest");
+ *         ...
+ *     }
+ *
+ * DGA_TRACE_SCOPE declares a ScopeExit that reads TraceClock on entry and on exit, and then
+ * records the interval in two places:
+ * - A latency histogram for the call site owned by the calling thread, which counts every call.
+ *   TraceSite::histogram merges the histograms of every thread, so they can be read at any time
+ *   with TraceSite::forEach, and summarised with writeTraceSummary.
+ * - A ring buffer owned by the calling thread, which keeps up to the most recent
+ *   DGA_TRACE_BUFFER_EVENTS intervals. writeChromeTrace exports them as Chrome trace event JSON,
+ *   which can be opened in chrome://tracing or https://ui.perfetto.dev.
+ *
+ * Recording doesn't lock or allocate, apart from the first time a thread records anything, and
+ * the first time it records at each site. Each thread records into its own histograms, so
+ * recording doesn't slow down as more threads trace the same scope. On x86, TraceClock reads the
+ * timestamp counter, which is converted to nanoseconds using a ratio measured against
+ * std::chrono::steady_clock the first time it's needed. The name must be a string literal, or
+ * otherwise outlive the program.
+ *
+ * Tracing is only enabled if DGA_ENABLE_TRACING is defined. Otherwise, DGA_TRACE_SCOPE expands to
+ * nothing, and the exporters write empty reports.
+ */
+
+#ifndef DGA_TRACE_BUFFER_EVENTS
+#define DGA_TRACE_BUFFER_EVENTS 16384
+#endif
+
+namespace dga {
+// A monotonic clock with the lowest overhead available on the platform.
+struct TraceClock {
+    static u64 now() noexcept {
+#if defined(DGA_ARCH_X86_64) || defined(DGA_ARCH_X86)
+        return __rdtsc();
+#elif defined(DGA_ARCH_ARM64) && !defined(DGA_MSVC)
+        u64 ticks;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+        return ticks;
+#else
+        return u64(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    // Returns the length of a tick in nanoseconds. The first call may take a few milliseconds, to
+    // measure the tick rate.
+    static double nanosecondsPerTick() noexcept;
+
+    static double toNanoseconds(u64 ticks) noexcept {
+        return double(ticks) * nanosecondsPerTick();
+    }
+};
+
+inline double TraceClock::nanosecondsPerTick() noexcept {
+#if defined(DGA_ARCH_X86_64) || defined(DGA_ARCH_X86) || \
+    (defined(DGA_ARCH_ARM64) && !defined(DGA_MSVC))
+    static const double ratio = [] {
+        using namespace std::chrono;
+        const auto start_time = steady_clock::now();
+        const u64 start_ticks = now();
+        auto end_time = start_time;
+        while (end_time - start_time < milliseconds(10)) {
+            end_time = steady_clock::now();
+        }
+        const u64 end_ticks = now();
+        return double(duration_cast<nanoseconds>(end_time - start_time).count()) /
+               double(std::max<u64>(end_ticks - start_ticks, 1));
+    }();
+    return ratio;
+#else
+    using Period = std::chrono::steady_clock::period;
+    return double(Period::num) * 1e9 / double(Period::den);
+#endif
+}
+
+// A histogram of durations (or any other u64 values) with log-linear buckets, similar to
+// HdrHistogram. Values below 2^kSubBucketBits are counted exactly, and larger values are rounded
+// down to kSubBucketBits significant bits, so percentiles have a relative error below 2^-5 (about
+// 3%) over the full range of a u64.
+class LatencyHistogram {
+public:
+    static constexpr int kSubBucketBits = 5;
+    static constexpr std::size_t kSubBucketCount = std::size_t(1) << kSubBucketBits;
+    static constexpr std::size_t kBucketCount = (65 - kSubBucketBits) * kSubBucketCount;
+
+    static std::size_t bucketIndex(u64 value) noexcept {
+        if (value < kSubBucketCount) {
+            return std::size_t(value);
+        }
+        const int exponent = 63 - countl_zero(value);
+        const int shift = exponent - kSubBucketBits;
+        return std::size_t(shift + 1) * kSubBucketCount +
+               std::size_t((value >> shift) & (kSubBucketCount - 1));
+    }
+
+    // Returns the smallest and largest value that are counted by a bucket.
+    static constexpr u64 bucketLowerBound(std::size_t index) noexcept {
+        if (index < kSubBucketCount) {
+            return u64(index);
+        }
+        const std::size_t shift = index / kSubBucketCount - 1;
+        return (u64(kSubBucketCount) + u64(index % kSubBucketCount)) << shift;
+    }
+
+    static constexpr u64 bucketUpperBound(std::size_t index) noexcept {
+        if (index < kSubBucketCount) {
+            return u64(index);
+        }
+        const std::size_t shift = index / kSubBucketCount - 1;
+        return bucketLowerBound(index) + ((u64(1) << shift) - 1);
+    }
+
+    void record(u64 value, u64 count = 1) noexcept {
+        counts_[bucketIndex(value)] += count;
+        total_count_ += count;
+        sum_ += value * count;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+
+    void merge(const LatencyHistogram& other) noexcept;
+    void reset() noexcept {
+        *this = LatencyHistogram{};
+    }
+
+    u64 count() const noexcept {
+        return total_count_;
+    }
+
+    u64 bucketCount(std::size_t index) const noexcept {
+        return counts_[index];
+    }
+
+    // Returns 0 if the histogram is empty.
+    u64 min() const noexcept {
+        return total_count_ == 0 ? 0 : min_;
+    }
+
+    u64 max() const noexcept {
+        return max_;
+    }
+
+    double mean() const noexcept {
+        return total_count_ == 0 ? 0.0 : double(sum_) / double(total_count_);
+    }
+
+    // Returns the value below which 'fraction' (between 0 and 1) of the recorded values fall,
+    // rounded up to the top of its bucket, and clamped to the largest recorded value.
+    u64 percentile(double fraction) const noexcept;
+
+private:
+    u64 counts_[kBucketCount] = {};
+    u64 total_count_ = 0;
+    u64 sum_ = 0;
+    u64 min_ = ~u64(0);
+    u64 max_ = 0;
+
+    friend class AtomicLatencyHistogram;
+};
+
+inline void LatencyHistogram::merge(const LatencyHistogram& other) noexcept {
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    total_count_ += other.total_count_;
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+inline u64 LatencyHistogram::percentile(double fraction) const noexcept {
+    if (total_count_ == 0) {
+        return 0;
+    }
+    const double clamped = std::min(std::max(fraction, 0.0), 1.0);
+    const u64 rank = std::max<u64>(u64(clamped * double(total_count_) + 0.5), 1);
+    u64 seen = 0;
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+        seen += counts_[i];
+        if (seen >= rank) {
+            return std::min(bucketUpperBound(i), max_);
+        }
+    }
+    return max_;
+}
+
+// A LatencyHistogram that can be recorded to from multiple threads without a lock. load()
+// returns a snapshot, which may be slightly inconsistent if values are recorded at the same time.
+class AtomicLatencyHistogram {
+public:
+    constexpr AtomicLatencyHistogram() noexcept = default;
+
+    AtomicLatencyHistogram(const AtomicLatencyHistogram&) = delete;
+    AtomicLatencyHistogram& operator=(const AtomicLatencyHistogram&) = delete;
+
+    void record(u64 value) noexcept {
+        counts_[LatencyHistogram::bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+        u64 max = max_.load(std::memory_order_relaxed);
+        while (DGA_UNLIKELY(value > max) &&
+               !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+        }
+        u64 min = min_.load(std::memory_order_relaxed);
+        while (DGA_UNLIKELY(value < min) &&
+               !min_.compare_exchange_weak(min, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Like record(), but only one thread may record at a time, although any thread may still call
+    // load(). Uses plain loads and stores instead of read-modify-write instructions, which are
+    // several times faster even when there's no contention.
+    void recordExclusive(u64 value) noexcept {
+        auto add = [](std::atomic<u64>& a, u64 n) {
+            a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        };
+        add(counts_[LatencyHistogram::bucketIndex(value)], 1);
+        add(sum_, value);
+        if (DGA_UNLIKELY(value > max_.load(std::memory_order_relaxed))) {
+            max_.store(value, std::memory_order_relaxed);
+        }
+        if (DGA_UNLIKELY(value < min_.load(std::memory_order_relaxed))) {
+            min_.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    LatencyHistogram load() const noexcept;
+
+    void reset() noexcept;
+
+private:
+    std::atomic<u64> counts_[LatencyHistogram::kBucketCount] = {};
+    std::atomic<u64> sum_{0};
+    std::atomic<u64> min_{~u64(0)};
+    std::atomic<u64> max_{0};
+};
+
+inline LatencyHistogram AtomicLatencyHistogram::load() const noexcept {
+    LatencyHistogram histogram;
+    for (std::size_t i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+        histogram.counts_[i] = counts_[i].load(std::memory_order_relaxed);
+        histogram.total_count_ += histogram.counts_[i];
+    }
+    histogram.sum_ = sum_.load(std::memory_order_relaxed);
+    histogram.min_ = min_.load(std::memory_order_relaxed);
+    histogram.max_ = max_.load(std::memory_order_relaxed);
+    return histogram;
+}
+
+inline void AtomicLatencyHistogram::reset() noexcept {
+    for (auto& count : counts_) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    sum_.store(0, std::memory_order_relaxed);
+    min_.store(~u64(0), std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+// An interval recorded by DGA_TRACE_SCOPE, in TraceClock ticks.
+struct TraceEvent {
+    const char* name;
+    u64 begin;
+    u64 end;
+    u32 thread_id;
+};
+
+namespace detail {
+// A ring buffer of events with a single writer, which keeps the most recent kCapacity events.
+// Readers copy events without blocking the writer, and then discard any copies that the writer
+// may have overwritten while they were being read. The buffer also holds the writer's histogram
+// for each trace site that it has recorded at, indexed by the site's id.
+class TraceBuffer {
+public:
+    static constexpr std::size_t kCapacity = DGA_TRACE_BUFFER_EVENTS;
+    static_assert((kCapacity & (kCapacity - 1)) == 0,
+                  "DGA_TRACE_BUFFER_EVENTS must be a power of 2.");
+
+    TraceBuffer() = default;
+    ~TraceBuffer();
+
+    TraceBuffer(const TraceBuffer&) = delete;
+    TraceBuffer& operator=(const TraceBuffer&) = delete;
+
+    void push(const char* name, u64 begin, u64 end, u32 thread_id) noexcept {
+        const u64 head = head_.load(std::memory_order_relaxed);
+        // Order the previous publish of head_ before overwriting a slot, so that a reader that
+        // sees the new contents also sees the new head and discards its copy.
+        std::atomic_thread_fence(std::memory_order_release);
+        Slot& slot = slots_[head & (kCapacity - 1)];
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.begin.store(begin, std::memory_order_relaxed);
+        slot.end.store(end, std::memory_order_relaxed);
+        slot.thread_id.store(thread_id, std::memory_order_relaxed);
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    // Returns the writer's histogram for a site. Only the writer may call this.
+    AtomicLatencyHistogram& histogram(u32 site) {
+        if (DGA_LIKELY(site < histograms_.size() && histograms_[site])) {
+            return histograms_[site]->histogram;
+        }
+        return addHistogram(site);
+    }
+
+    // Appends the events in the buffer to 'events', oldest first.
+    void collect(std::vector<TraceEvent>& events) const;
+
+    // Adds the intervals recorded at a site to 'histogram'.
+    void mergeHistogram(u32 site, LatencyHistogram& histogram) const;
+
+private:
+    struct Slot {
+        std::atomic<const char*> name;
+        std::atomic<u64> begin;
+        std::atomic<u64> end;
+        std::atomic<u32> thread_id;
+    };
+
+    // Readers find histograms through a list that the writer only adds to, as they can't read
+    // histograms_ while the writer resizes it.
+    struct SiteHistogram {
+        explicit SiteHistogram(u32 site) noexcept : site(site) {
+        }
+
+        const u32 site;
+        AtomicLatencyHistogram histogram;
+        SiteHistogram* next = nullptr;
+    };
+
+    std::atomic<u64> head_{0};
+    Slot slots_[kCapacity];
+    std::vector<SiteHistogram*> histograms_;
+    std::atomic<SiteHistogram*> first_histogram_{nullptr};
+
+    DGA_NOINLINE AtomicLatencyHistogram& addHistogram(u32 site) {
+        if (site >= histograms_.size()) {
+            histograms_.resize(std::size_t(site) + 1, nullptr);
+        }
+        auto* node = new SiteHistogram{site};
+        node->next = first_histogram_.load(std::memory_order_relaxed);
+        first_histogram_.store(node, std::memory_order_release);
+        histograms_[site] = node;
+        return node->histogram;
+    }
+};
+
+inline TraceBuffer::~TraceBuffer() {
+    SiteHistogram* node = first_histogram_.load(std::memory_order_relaxed);
+    while (node) {
+        delete std::exchange(node, node->next);
+    }
+}
+
+inline void TraceBuffer::mergeHistogram(u32 site, LatencyHistogram& histogram) const {
+    for (const SiteHistogram* node = first_histogram_.load(std::memory_order_acquire); node;
+         node = node->next) {
+        if (node->site == site) {
+            histogram.merge(node->histogram.load());
+            return;
+        }
+    }
+}
+
+inline void TraceBuffer::collect(std::vector<TraceEvent>& events) const {
+    const u64 head = head_.load(std::memory_order_acquire);
+    const u64 first = head > kCapacity ? head - kCapacity : 0;
+    const std::size_t offset = events.size();
+    events.reserve(offset + std::size_t(head - first));
+    for (u64 i = first; i < head; ++i) {
+        const Slot& slot = slots_[i & (kCapacity - 1)];
+        events.push_back(TraceEvent{slot.name.load(std::memory_order_relaxed),
+                                    slot.begin.load(std::memory_order_relaxed),
+                                    slot.end.load(std::memory_order_relaxed),
+                                    slot.thread_id.load(std::memory_order_relaxed)});
+    }
+    // Event i was overwritten if the writer had started on event i + kCapacity.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const u64 new_head = head_.load(std::memory_order_relaxed);
+    if (new_head >= first + kCapacity) {
+        const auto overwritten = std::size_t(new_head + 1 - (first + kCapacity));
+        const auto erase_count = std::min(overwritten, events.size() - offset);
+        events.erase(events.begin() + std::ptrdiff_t(offset),
+                     events.begin() + std::ptrdiff_t(offset + erase_count));
+    }
+}
+
+// Owns the ring buffers of every thread that has traced a scope. Buffers of threads that have
+// exited are given to new threads, so memory use is bounded by the peak number of threads.
+class TraceRegistry {
+public:
+    static TraceRegistry& get() noexcept {
+        // Never destroyed, so that threads can still exit during static destruction.
+        static TraceRegistry* registry = new TraceRegistry;
+        return *registry;
+    }
+
+    TraceBuffer* acquire() {
+        std::lock_guard<std::mutex> lock{mutex_};
+        if (!free_.empty()) {
+            TraceBuffer* buffer = free_.back();
+            free_.pop_back();
+            return buffer;
+        }
+        buffers_.emplace_back(std::make_unique<TraceBuffer>());
+        return buffers_.back().get();
+    }
+
+    void release(TraceBuffer* buffer) {
+        std::lock_guard<std::mutex> lock{mutex_};
+        free_.emplace_back(buffer);
+    }
+
+    std::vector<TraceEvent> collect() const {
+        std::vector<TraceEvent> events;
+        std::lock_guard<std::mutex> lock{mutex_};
+        for (const auto& buffer : buffers_) {
+            buffer->collect(events);
+        }
+        return events;
+    }
+
+    // Merges every thread's histogram for a site. Histograms of threads that have exited are kept
+    // with their buffers, so they're still included.
+    LatencyHistogram histogram(u32 site) const {
+        LatencyHistogram histogram;
+        std::lock_guard<std::mutex> lock{mutex_};
+        for (const auto& buffer : buffers_) {
+            buffer->mergeHistogram(site, histogram);
+        }
+        return histogram;
+    }
+
+    u32 nextThreadId() noexcept {
+        return next_thread_id_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers_;
+    std::vector<TraceBuffer*> free_;
+    std::atomic<u32> next_thread_id_{1};
+};
+
+struct TraceThread;
+
+// The calling thread's buffer. A plain pointer, so that the fast path doesn't pay for the
+// initialisation check of a thread_local with a destructor.
+inline thread_local TraceThread* trace_thread = nullptr;
+
+struct TraceThread {
+    TraceBuffer* buffer = nullptr;
+    u32 id = 0;
+
+    ~TraceThread() {
+        trace_thread = nullptr;
+        if (buffer) {
+            TraceRegistry::get().release(buffer);
+        }
+    }
+};
+
+DGA_NOINLINE inline TraceThread& attachTraceThread() {
+    static thread_local TraceThread thread;
+    thread.buffer = TraceRegistry::get().acquire();
+    thread.id = TraceRegistry::get().nextThreadId();
+    trace_thread = &thread;
+    return thread;
+}
+}  // namespace detail
+
+// Records the intervals of a DGA_TRACE_SCOPE call site. Each site adds itself to a global list,
+// and takes the next id, the first time it records an interval.
+class TraceSite {
+public:
+    constexpr explicit TraceSite(const char* name) noexcept : name_(name) {
+    }
+
+    TraceSite(const TraceSite&) = delete;
+    TraceSite& operator=(const TraceSite&) = delete;
+
+    const char* name() const noexcept {
+        return name_;
+    }
+
+    // The durations recorded at this site by every thread, in TraceClock ticks. Takes a snapshot,
+    // which may be slightly inconsistent if intervals are recorded at the same time.
+    LatencyHistogram histogram() const {
+        const u32 id = id_.load(std::memory_order_relaxed);
+        return id == 0 ? LatencyHistogram{} : detail::TraceRegistry::get().histogram(id);
+    }
+
+    void record(u64 begin, u64 end) noexcept {
+        u32 id = id_.load(std::memory_order_relaxed);
+        if (DGA_UNLIKELY(id == 0)) {
+            id = registerSite();
+        }
+        detail::TraceThread* thread = detail::trace_thread;
+        if (DGA_UNLIKELY(!thread)) {
+            thread = &detail::attachTraceThread();
+        }
+        thread->buffer->histogram(id).recordExclusive(end - begin);
+        thread->buffer->push(name_, begin, end, thread->id);
+    }
+
+    // Calls f(const TraceSite&) for every site that has recorded an interval.
+    template <typename F> static void forEach(F&& f);
+
+private:
+    const char* name_;
+    // 0 until the site is registered.
+    std::atomic<u32> id_{0};
+    TraceSite* next_ = nullptr;
+
+    static std::atomic<TraceSite*>& head() noexcept {
+        static std::atomic<TraceSite*> head{nullptr};
+        return head;
+    }
+
+    DGA_NOINLINE u32 registerSite() noexcept {
+        static std::mutex mutex;
+        static u32 site_count = 0;
+        std::lock_guard<std::mutex> lock{mutex};
+        u32 id = id_.load(std::memory_order_relaxed);
+        if (id == 0) {
+            id = ++site_count;
+            id_.store(id, std::memory_order_relaxed);
+            next_ = head().load(std::memory_order_relaxed);
+            head().store(this, std::memory_order_release);
+        }
+        return id;
+    }
+};
+
+template <typename F> void TraceSite::forEach(F&& f) {
+    for (TraceSite* site = head().load(std::memory_order_acquire); site; site = site->next_) {
+        f(static_cast<const TraceSite&>(*site));
+    }
+}
+
+// Returns a scope guard that records the time until it's destroyed in 'site'.
+inline auto traceScope(TraceSite& site) noexcept {
+    return ScopeExit{[&site, begin = TraceClock::now()]() noexcept {
+        site.record(begin, TraceClock::now());
+    }};
+}
+
+// Returns the events in every thread's ring buffer, sorted by start time.
+inline std::vector<TraceEvent> collectTraceEvents() {
+    std::vector<TraceEvent> events = detail::TraceRegistry::get().collect();
+    std::sort(events.begin(), events.end(),
+              [](const TraceEvent& a, const TraceEvent& b) { return a.begin < b.begin; });
+    return events;
+}
+
+namespace detail {
+inline void writeJsonString(std::ostream& out, const char* s) {
+    static constexpr char kHex[] = "0123456789abcdef";
+    out << '"';
+    for (; *s; ++s) {
+        const auto c = static_cast<unsigned char>(*s);
+        if (c == '"' || c == '\\') {
+            out << '\\' << char(c);
+        } else if (c < 0x20) {
+            out << "\\u00" << kHex[c >> 4] << kHex[c & 0xf];
+        } else {
+            out << char(c);
+        }
+    }
+    out << '"';
+}
+}  // namespace detail
+
+// Writes the events in every thread's ring buffer in the Chrome trace event format. Timestamps
+// are in microseconds from the first event.
+inline void writeChromeTrace(std::ostream& out) {
+    const std::vector<TraceEvent> events = collectTraceEvents();
+    const u64 base = events.empty() ? 0 : events.front().begin;
+    const double us_per_tick = TraceClock::nanosecondsPerTick() / 1000.0;
+    const auto flags = out.flags();
+    const auto precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    for (const TraceEvent& event : events) {
+        out << (first ? "\n" : ",\n") << "{\"name\":";
+        detail::writeJsonString(out, event.name);
+        out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread_id
+            << ",\"ts\":" << double(event.begin - base) * us_per_tick
+            << ",\"dur\":" << double(event.end - event.begin) * us_per_tick << "}";
+        first = false;
+    }
+    out << "\n]}\n";
+    out.flags(flags);
+    out.precision(precision);
+}
+
+// Writes a line for each trace site, with the number of calls and latency percentiles in
+// nanoseconds.
+inline void writeTraceSummary(std::ostream& out) {
+    const double ns_per_tick = TraceClock::nanosecondsPerTick();
+    TraceSite::forEach([&](const TraceSite& site) {
+        const LatencyHistogram histogram = site.histogram();
+        auto ns = [&](u64 ticks) { return u64(double(ticks) * ns_per_tick); };
+        out << site.name() << ": count=" << histogram.count()
+            << " mean=" << u64(histogram.mean() * ns_per_tick) << "ns"
+            << " p50=" << ns(histogram.percentile(0.5)) << "ns"
+            << " p90=" << ns(histogram.percentile(0.9)) << "ns"
+            << " p99=" << ns(histogram.percentile(0.99)) << "ns"
+            << " p999=" << ns(histogram.percentile(0.999)) << "ns"
+            << " max=" << ns(histogram.max()) << "ns\n";
+    });
+}
+}  // namespace dga
+
+#define DGA_TRACE_CONCAT_IMPL(a, b) a##b
+#define DGA_TRACE_CONCAT(a, b) DGA_TRACE_CONCAT_IMPL(a, b)
+
+// Records the time from this statement to the end of the enclosing scope. 'name' must be a string
+// literal.
+#ifdef DGA_ENABLE_TRACING
+#define DGA_TRACE_SCOPE(name) DGA_TRACE_SCOPE_IMPL(name, __COUNTER__)
+#define DGA_TRACE_SCOPE_IMPL(name, id)                                                             \
+    static ::dga::TraceSite DGA_TRACE_CONCAT(dga_trace_site_, id){name};                          \
+    const auto DGA_TRACE_CONCAT(dga_trace_scope_, id) =                                            \
+        ::dga::traceScope(DGA_TRACE_CONCAT(dga_trace_site_, id))
+#else
+#define DGA_TRACE_SCOPE(name) static_cast<void>(0)
+#endif
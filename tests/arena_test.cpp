@@ -0,0 +1,280 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <gtest/gtest.h>
+#include <dga/arena.h>
+#include <dga/flat_hash_map.h>
+#include <dga/result.h>
+#include <dga/string_algorithms.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <list>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+bool isAligned(const void* p, std::size_t alignment) {
+    return reinterpret_cast<std::uintptr_t>(p) % alignment == 0;
+}
+}  // namespace
+
+TEST(Arena, AllocatesAligned) {
+    dga::Arena arena;
+    EXPECT_EQ(arena.capacity(), 0);
+    char* c = static_cast<char*>(arena.allocate(1, 1));
+    auto* i = static_cast<int*>(arena.allocate(sizeof(int), alignof(int)));
+    auto* d = static_cast<double*>(arena.allocate(sizeof(double), alignof(double)));
+    void* big = arena.allocate(64, 64);
+    EXPECT_TRUE(isAligned(i, alignof(int)));
+    EXPECT_TRUE(isAligned(d, alignof(double)));
+    EXPECT_TRUE(isAligned(big, 64));
+    EXPECT_LT(static_cast<void*>(c), static_cast<void*>(i));
+    EXPECT_LT(static_cast<void*>(i), static_cast<void*>(d));
+    EXPECT_EQ(arena.capacity(), dga::Arena::kDefaultChunkSize);
+}
+
+TEST(Arena, ChainsChunks) {
+    dga::Arena arena{64};
+    std::vector<int*> values;
+    for (int i = 0; i < 1000; ++i) {
+        values.emplace_back(arena.create<int>(i));
+    }
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(*values[i], i);
+    }
+    EXPECT_GE(arena.bytesUsed(), 1000 * sizeof(int));
+
+    // An allocation larger than a chunk gets a chunk of its own.
+    void* large = arena.allocate(100000);
+    std::memset(large, 0, 100000);
+    EXPECT_GE(arena.capacity(), 100000);
+}
+
+TEST(Arena, ZeroInitialChunkSize) {
+    dga::Arena arena{0};
+    void* p = arena.allocate(16);
+    EXPECT_NE(p, nullptr);
+    EXPECT_GE(arena.capacity(), dga::Arena::kMinChunkSize);
+    EXPECT_NE(arena.allocate(1000), nullptr);
+}
+
+TEST(Arena, ResetReusesChunks) {
+    dga::Arena arena{256};
+    void* first = arena.allocate(16);
+    for (int i = 0; i < 100; ++i) {
+        arena.allocate(100);
+    }
+    const std::size_t capacity = arena.capacity();
+    arena.reset();
+    EXPECT_EQ(arena.bytesUsed(), 0);
+    EXPECT_EQ(arena.allocate(16), first);
+    for (int i = 0; i < 100; ++i) {
+        arena.allocate(100);
+    }
+    EXPECT_EQ(arena.capacity(), capacity);
+
+    arena.release();
+    EXPECT_EQ(arena.capacity(), 0);
+    EXPECT_EQ(arena.bytesUsed(), 0);
+}
+
+TEST(Arena, Rewind) {
+    dga::Arena arena{128};
+    arena.allocate(8);
+    const std::size_t used = arena.bytesUsed();
+    const auto marker = arena.mark();
+    void* next = arena.allocate(8);
+    for (int i = 0; i < 100; ++i) {
+        arena.allocate(32);
+    }
+    arena.rewind(marker);
+    EXPECT_EQ(arena.bytesUsed(), used);
+    EXPECT_EQ(arena.allocate(8), next);
+
+    const std::size_t used_before_scope = arena.bytesUsed();
+    {
+        auto rewind = arena.scopedRewind();
+        for (int i = 0; i < 100; ++i) {
+            arena.allocate(32);
+        }
+    }
+    EXPECT_EQ(arena.bytesUsed(), used_before_scope);
+
+    // A marker taken before any allocations resets the arena.
+    dga::Arena other;
+    const auto empty = other.mark();
+    other.allocate(8);
+    other.rewind(empty);
+    EXPECT_EQ(other.bytesUsed(), 0);
+}
+
+TEST(Arena, DeallocateLastAllocation) {
+    dga::Arena arena;
+    void* a = arena.allocate(16);
+    void* b = arena.allocate(16);
+    arena.deallocate(a, 16);
+    EXPECT_EQ(arena.allocate(16), static_cast<char*>(b) + 16);
+    arena.deallocate(static_cast<char*>(b) + 16, 16);
+    EXPECT_EQ(arena.allocate(16), static_cast<char*>(b) + 16);
+}
+
+TEST(ArenaAllocator, StrSplitIntoArenaVector) {
+    dga::Arena arena;
+    {
+        auto rewind = arena.scopedRewind();
+        dga::ArenaVector<std::string_view> parts{arena};
+        dga::strSplit("a,b,c,d", ',', std::back_inserter(parts));
+        ASSERT_EQ(parts.size(), 4);
+        EXPECT_EQ(parts[3], "d");
+        EXPECT_EQ(&parts.get_allocator().arena(), &arena);
+        EXPECT_GE(arena.bytesUsed(), 4 * sizeof(std::string_view));
+    }
+    EXPECT_EQ(arena.bytesUsed(), 0);
+}
+
+TEST(ArenaAllocator, FlatHashMap) {
+    using Allocator = dga::ArenaAllocator<std::pair<const dga::ArenaString, int>>;
+    using Map = dga::FlatHashMap<dga::ArenaString, int, dga::Hash<dga::ArenaString>,
+                                 std::equal_to<>, Allocator>;
+    dga::Arena arena;
+    {
+        Map map{arena};
+        for (int i = 0; i < 100; ++i) {
+            map.emplace(dga::ArenaString{"a long key that doesn't fit inline " + std::to_string(i),
+                                         arena},
+                        i);
+        }
+        EXPECT_EQ(map.size(), 100);
+        EXPECT_EQ(map.at(dga::ArenaString{"a long key that doesn't fit inline 42", arena}), 42);
+        EXPECT_EQ(&map.get_allocator().arena(), &arena);
+        // The slots, plus each key's heap buffer.
+        EXPECT_GE(arena.bytesUsed(), 100 * (sizeof(Map::value_type) + 36));
+
+        // Moving into a map in another arena copies the elements into that arena.
+        dga::Arena other_arena;
+        Map other{other_arena};
+        other = std::move(map);
+        EXPECT_EQ(other.size(), 100);
+        EXPECT_GT(other_arena.bytesUsed(), 0);
+    }
+    const std::size_t used = arena.bytesUsed();
+    arena.reset();
+    EXPECT_EQ(arena.bytesUsed(), 0);
+    EXPECT_GT(used, 0);
+}
+
+TEST(ArenaAllocator, ResultHoldingString) {
+    dga::Arena arena;
+    auto make = [&](bool succeed) -> dga::Result<dga::ArenaString, int> {
+        if (succeed) {
+            return dga::ArenaString{"a string that is too long for the small string buffer", arena};
+        }
+        return dga::Error{1};
+    };
+    auto result = make(true);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(&result->get_allocator().arena(), &arena);
+    EXPECT_GE(arena.bytesUsed(), result->size() + 1);
+    EXPECT_EQ(make(false).error(), 1);
+}
+
+namespace {
+struct Tracked {
+    static inline int live = 0;
+    int value;
+
+    explicit Tracked(int value) : value(value) {
+        ++live;
+    }
+
+    ~Tracked() {
+        --live;
+    }
+};
+}  // namespace
+
+TEST(Pool, CreateAndDestroy) {
+    Tracked* a = dga::Pool<Tracked>::create(1);
+    Tracked* b = dga::Pool<Tracked>::create(2);
+    EXPECT_EQ(Tracked::live, 2);
+    EXPECT_EQ(a->value, 1);
+    EXPECT_EQ(b->value, 2);
+    EXPECT_NE(a, b);
+    EXPECT_TRUE(isAligned(a, alignof(Tracked)));
+
+    // Freed blocks are reused by the same thread straight away.
+    dga::Pool<Tracked>::destroy(b);
+    EXPECT_EQ(Tracked::live, 1);
+    Tracked* c = dga::Pool<Tracked>::create(3);
+    EXPECT_EQ(c, b);
+    dga::Pool<Tracked>::destroy(a);
+    dga::Pool<Tracked>::destroy(c);
+    dga::Pool<Tracked>::destroy(nullptr);
+    EXPECT_EQ(Tracked::live, 0);
+}
+
+TEST(Pool, ThreadCacheIsBounded) {
+    struct Node {
+        char data[64];
+    };
+    std::vector<void*> blocks;
+    for (int i = 0; i < 10000; ++i) {
+        blocks.emplace_back(dga::Pool<Node>::allocate());
+    }
+    for (void* block : blocks) {
+        dga::Pool<Node>::deallocate(block);
+    }
+    EXPECT_LE(dga::Pool<Node>::threadCacheSize(),
+              2 * dga::detail::PoolState<Node>::kBatchSize);
+}
+
+TEST(Pool, FreeOnAnotherThread) {
+    constexpr int kCount = 10000;
+    std::vector<int*> values(kCount);
+    std::thread producer{[&] {
+        for (int i = 0; i < kCount; ++i) {
+            values[i] = dga::Pool<int>::create(i);
+        }
+    }};
+    producer.join();
+
+    std::atomic<long> sum{0};
+    std::vector<std::thread> consumers;
+    for (int t = 0; t < 4; ++t) {
+        consumers.emplace_back([&, t] {
+            for (int i = t; i < kCount; i += 4) {
+                sum += *values[i];
+                dga::Pool<int>::destroy(values[i]);
+            }
+            // Allocate again, to reuse blocks freed by this thread and other threads.
+            std::vector<int*> mine;
+            for (int i = 0; i < kCount / 4; ++i) {
+                mine.emplace_back(dga::Pool<int>::create(i));
+            }
+            for (int* value : mine) {
+                dga::Pool<int>::destroy(value);
+            }
+        });
+    }
+    for (auto& consumer : consumers) {
+        consumer.join();
+    }
+    EXPECT_EQ(sum.load(), long(kCount) * (kCount - 1) / 2);
+}
+
+TEST(PoolAllocator, List) {
+    std::list<int, dga::PoolAllocator<int>> list;
+    for (int i = 0; i < 1000; ++i) {
+        list.push_back(i);
+    }
+    EXPECT_EQ(list.size(), 1000);
+    EXPECT_EQ(list.back(), 999);
+    list.clear();
+
+    std::vector<int, dga::PoolAllocator<int>> vector(100, 7);
+    EXPECT_EQ(vector[99], 7);
+    EXPECT_EQ(dga::PoolAllocator<int>{}, dga::PoolAllocator<long>{});
+}
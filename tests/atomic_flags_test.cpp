@@ -0,0 +1,128 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <gtest/gtest.h>
+#include <dga/atomic_flags.h>
+
+#include <thread>
+#include <vector>
+
+namespace {
+enum class Subsystem : dga::u8 { Audio, Input, Renderer, Network, _Count };
+}  // namespace
+
+using dga::AtomicFlags;
+using dga::Flags;
+
+TEST(AtomicFlags, Construct) {
+    AtomicFlags<Subsystem> empty;
+    EXPECT_EQ(empty.load(), Flags<Subsystem>::none());
+
+    AtomicFlags<Subsystem> flags{Flags{Subsystem::Audio} | Subsystem::Network};
+    EXPECT_TRUE(flags.isSet(Subsystem::Audio));
+    EXPECT_FALSE(flags.isSet(Subsystem::Input));
+    EXPECT_TRUE(flags.isSet(Subsystem::Network));
+
+    static_assert(sizeof(AtomicFlags<Subsystem>::mask_type) == 1);
+    static_assert(AtomicFlags<Subsystem>::is_always_lock_free);
+}
+
+TEST(AtomicFlags, Operations) {
+    AtomicFlags<Subsystem> flags;
+    EXPECT_EQ(flags.set(Subsystem::Audio), Flags<Subsystem>::none());
+    EXPECT_EQ(flags.set(Subsystem::Input, std::memory_order_release), Subsystem::Audio);
+    EXPECT_EQ(flags.load(std::memory_order_acquire), Flags{Subsystem::Audio} | Subsystem::Input);
+
+    EXPECT_EQ(flags.reset(Subsystem::Audio), Flags{Subsystem::Audio} | Subsystem::Input);
+    EXPECT_EQ(flags.load(), Subsystem::Input);
+
+    EXPECT_EQ(flags.toggle(Flags{Subsystem::Input} | Subsystem::Renderer), Subsystem::Input);
+    EXPECT_EQ(flags.load(), Subsystem::Renderer);
+
+    EXPECT_EQ(flags.exchange(Flags<Subsystem>::all()), Subsystem::Renderer);
+    EXPECT_EQ(flags.load(), Flags<Subsystem>::all());
+
+    flags.store(Flags{Subsystem::Network}, std::memory_order_relaxed);
+    EXPECT_EQ(flags.load(), Subsystem::Network);
+}
+
+TEST(AtomicFlags, TestAndSet) {
+    AtomicFlags<Subsystem> flags;
+    EXPECT_FALSE(flags.test_and_set(Subsystem::Renderer));
+    EXPECT_TRUE(flags.test_and_set(Subsystem::Renderer));
+    EXPECT_TRUE(flags.test_and_reset(Subsystem::Renderer));
+    EXPECT_FALSE(flags.test_and_reset(Subsystem::Renderer));
+}
+
+TEST(AtomicFlags, CompareExchange) {
+    AtomicFlags<Subsystem> flags{Flags{Subsystem::Audio}};
+    Flags<Subsystem> expected{Subsystem::Input};
+    EXPECT_FALSE(flags.compare_exchange_strong(expected, Flags{Subsystem::Network}));
+    EXPECT_EQ(expected, Subsystem::Audio);
+    EXPECT_TRUE(flags.compare_exchange_strong(expected, Flags{Subsystem::Network}));
+    EXPECT_EQ(flags.load(), Subsystem::Network);
+
+    expected = Flags{Subsystem::Network};
+    while (!flags.compare_exchange_weak(expected, expected | Subsystem::Audio)) {
+    }
+    EXPECT_EQ(flags.load(), Flags{Subsystem::Network} | Subsystem::Audio);
+}
+
+TEST(AtomicFlags, ConcurrentSet) {
+    // Each thread sets and resets its own flag, so every update must be atomic for the final state
+    // to be correct.
+    AtomicFlags<Subsystem> flags;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&flags, t] {
+            const auto flag = Subsystem(t);
+            for (int i = 0; i < 10000; ++i) {
+                EXPECT_FALSE(flags.test_and_set(flag, std::memory_order_relaxed));
+                EXPECT_TRUE(flags.test_and_reset(flag, std::memory_order_relaxed));
+            }
+            flags.set(flag);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(flags.load(), Flags<Subsystem>::all());
+}
+
+TEST(AtomicFlags, WaitAndNotify) {
+    AtomicFlags<Subsystem> flags;
+
+    // Returns immediately if the flags are already different.
+    flags.set(Subsystem::Audio);
+    flags.wait(Flags<Subsystem>::none());
+
+    std::vector<std::thread> waiters;
+    for (int i = 0; i < 3; ++i) {
+        waiters.emplace_back([&flags] {
+            auto current = flags.load(std::memory_order_acquire);
+            while (!current.isSet(Subsystem::Renderer)) {
+                flags.wait(current, std::memory_order_acquire);
+                current = flags.load(std::memory_order_acquire);
+            }
+        });
+    }
+
+    flags.set(Subsystem::Input, std::memory_order_release);
+    flags.notify_all();
+    std::this_thread::yield();
+    flags.set(Subsystem::Renderer, std::memory_order_release);
+    flags.notify_all();
+
+    for (auto& waiter : waiters) {
+        waiter.join();
+    }
+    EXPECT_TRUE(flags.isSet(Subsystem::Renderer));
+}
+
+TEST(AtomicFlags, NotifyOne) {
+    AtomicFlags<Subsystem> flags;
+    std::thread waiter([&flags] { flags.wait(Flags<Subsystem>::none()); });
+    flags.set(Subsystem::Network);
+    flags.notify_one();
+    waiter.join();
+    EXPECT_TRUE(flags.isSet(Subsystem::Network));
+}
@@ -0,0 +1,76 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <gtest/gtest.h>
+#include <dga/barrier.h>
+
+#include <thread>
+#include <vector>
+
+namespace {
+constexpr int kPhases = 200;
+
+// Runs 'thread_count' threads through a number of phases, and checks that no thread starts a
+// phase before every thread has finished the previous one.
+template <typename WaitFunction> void runPhases(int thread_count, WaitFunction&& wait) {
+    std::atomic<int> arrived{0};
+    std::atomic<bool> failed{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t] {
+            for (int phase = 0; phase < kPhases; ++phase) {
+                arrived++;
+                wait(t);
+                if (arrived.load() < (phase + 1) * thread_count) {
+                    failed = true;
+                }
+                wait(t);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_FALSE(failed);
+    EXPECT_EQ(arrived, kPhases * thread_count);
+}
+}  // namespace
+
+TEST(Barrier, Phases) {
+    dga::Barrier barrier{4};
+    runPhases(4, [&](int) { barrier.wait(); });
+}
+
+TEST(SpinBarrier, Phases) {
+    dga::SpinBarrier barrier{4};
+    runPhases(4, [&](int) { barrier.wait(); });
+}
+
+TEST(SpinBarrier, Blocking) {
+    // Without spinning, every wait blocks on the futex.
+    dga::SpinBarrier barrier{4, dga::detail::NoCompletion{}, 0};
+    runPhases(4, [&](int) { barrier.wait(); });
+}
+
+TEST(SpinBarrier, SingleThread) {
+    int calls = 0;
+    dga::SpinBarrier barrier{1, [&] { calls++; }};
+    barrier.wait();
+    barrier.wait();
+    EXPECT_EQ(calls, 2);
+}
+
+TEST(SpinBarrier, Completion) {
+    std::atomic<int> calls{0};
+    dga::SpinBarrier barrier{3, [&] { calls++; }};
+    runPhases(3, [&](int) { barrier.wait(); });
+    EXPECT_EQ(calls, kPhases * 2);
+}
+
+TEST(TreeBarrier, Phases) {
+    for (int threads : {1, 2, 3, 5, 8}) {
+        std::atomic<int> calls{0};
+        dga::TreeBarrier barrier{std::size_t(threads), [&] { calls++; }, 2};
+        runPhases(threads, [&](int t) { barrier.wait(std::size_t(t)); });
+        EXPECT_EQ(calls, kPhases * 2) << "threads: " << threads;
+    }
+}
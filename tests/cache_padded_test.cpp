@@ -0,0 +1,37 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <gtest/gtest.h>
+#include <dga/cache_padded.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+static_assert(alignof(dga::CachePadded<char>) == dga::kCacheLineSize);
+static_assert(sizeof(dga::CachePadded<char>) == dga::kCacheLineSize);
+static_assert(sizeof(dga::CachePadded<char[dga::kCacheLineSize + 1]>) ==
+              2 * dga::kCacheLineSize);
+
+TEST(CachePadded, DefaultValueInitialises) {
+    dga::CachePadded<std::atomic<int>> value;
+    EXPECT_EQ(value->load(), 0);
+    dga::CachePadded<int> plain;
+    EXPECT_EQ(*plain, 0);
+}
+
+TEST(CachePadded, Construct) {
+    dga::CachePadded<std::string> from_value{std::string{"abc"}};
+    EXPECT_EQ(from_value.get(), "abc");
+    dga::CachePadded<std::string> in_place{std::in_place, 3u, 'x'};
+    EXPECT_EQ(*in_place, "xxx");
+    EXPECT_EQ(in_place->size(), 3u);
+}
+
+TEST(CachePadded, ArrayElementsOnSeparateLines) {
+    dga::CachePadded<std::atomic<int>> values[2];
+    const auto first = reinterpret_cast<std::uintptr_t>(&values[0].get());
+    const auto second = reinterpret_cast<std::uintptr_t>(&values[1].get());
+    EXPECT_EQ(first % dga::kCacheLineSize, 0u);
+    EXPECT_GE(second - first, dga::kCacheLineSize);
+}
@@ -0,0 +1,118 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <gtest/gtest.h>
+#include <dga/charconv.h>
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+
+using dga::i32;
+using dga::i64;
+using dga::i8;
+using dga::ParseError;
+using dga::u64;
+using dga::u8;
+
+TEST(Parse, Integers) {
+    EXPECT_EQ(dga::parse<int>("0").value(), 0);
+    EXPECT_EQ(dga::parse<int>("123").value(), 123);
+    EXPECT_EQ(dga::parse<int>("-123").value(), -123);
+    EXPECT_EQ(dga::parse<int>("000042").value(), 42);
+    EXPECT_EQ(dga::parse<unsigned>("4294967295").value(), 4294967295u);
+    EXPECT_EQ(dga::parse<u8>("255").value(), 255);
+    EXPECT_EQ(dga::parse<i8>("-128").value(), -128);
+}
+
+TEST(Parse, IntegerLimits) {
+    EXPECT_EQ(dga::parse<u64>("18446744073709551615").value(), std::numeric_limits<u64>::max());
+    EXPECT_EQ(dga::parse<i64>("9223372036854775807").value(), std::numeric_limits<i64>::max());
+    EXPECT_EQ(dga::parse<i64>("-9223372036854775808").value(), std::numeric_limits<i64>::min());
+    EXPECT_EQ(dga::parse<u64>("18446744073709551616").error(), ParseError::OutOfRange);
+    EXPECT_EQ(dga::parse<i32>("2147483648").error(), ParseError::OutOfRange);
+    EXPECT_EQ(dga::parse<u8>("256").error(), ParseError::OutOfRange);
+}
+
+TEST(Parse, IntegerErrors) {
+    EXPECT_EQ(dga::parse<int>("").error(), ParseError::InvalidArgument);
+    EXPECT_EQ(dga::parse<int>("-").error(), ParseError::InvalidArgument);
+    EXPECT_EQ(dga::parse<int>("+1").error(), ParseError::InvalidArgument);
+    EXPECT_EQ(dga::parse<int>(" 1").error(), ParseError::InvalidArgument);
+    EXPECT_EQ(dga::parse<int>("abc").error(), ParseError::InvalidArgument);
+    EXPECT_EQ(dga::parse<unsigned>("-1").error(), ParseError::InvalidArgument);
+    EXPECT_EQ(dga::parse<int>("12a").error(), ParseError::TrailingCharacters);
+    EXPECT_EQ(dga::parse<int>("1 ").error(), ParseError::TrailingCharacters);
+    EXPECT_EQ(dga::parse<u64>("1234567:90").error(), ParseError::TrailingCharacters);
+    EXPECT_EQ(dga::parse<u64>("12345678/0").error(), ParseError::TrailingCharacters);
+}
+
+TEST(Parse, IntegerBase) {
+    EXPECT_EQ(dga::parse<int>("ff", 16).value(), 255);
+    EXPECT_EQ(dga::parse<int>("-101", 2).value(), -5);
+    EXPECT_EQ(dga::parse<int>("2", 2).error(), ParseError::InvalidArgument);
+}
+
+TEST(Parse, MatchesFromChars) {
+    // Compare the fast path against std::from_chars for numbers of every length.
+    std::mt19937_64 rng{42};
+    for (int i = 0; i < 10000; ++i) {
+        const u64 value = rng() >> (rng() % 64);
+        const std::string s = std::to_string(value);
+        EXPECT_EQ(dga::parse<u64>(s).value(), value) << s;
+        const i64 negative = -static_cast<i64>(value >> 1);
+        EXPECT_EQ(dga::parse<i64>(std::to_string(negative)).value(), negative);
+    }
+}
+
+TEST(Parse, FloatingPoint) {
+    EXPECT_EQ(dga::parse<double>("1.5").value(), 1.5);
+    EXPECT_EQ(dga::parse<double>("-2.5e3").value(), -2500.0);
+    EXPECT_EQ(dga::parse<float>("0.25").value(), 0.25f);
+    EXPECT_EQ(dga::parse<double>("ff", std::chars_format::hex).value(), 255.0);
+    EXPECT_EQ(dga::parse<double>("1e400").error(), ParseError::OutOfRange);
+    EXPECT_EQ(dga::parse<double>("").error(), ParseError::InvalidArgument);
+    EXPECT_EQ(dga::parse<double>("1.5x").error(), ParseError::TrailingCharacters);
+}
+
+TEST(Format, Integers) {
+    char buf[dga::max_chars_v<i64>];
+    EXPECT_EQ(std::string(buf, dga::format(i64(0), buf)), "0");
+    EXPECT_EQ(std::string(buf, dga::format(std::numeric_limits<i64>::min(), buf)),
+              "-9223372036854775808");
+    char ubuf[dga::max_chars_v<u64>];
+    EXPECT_EQ(std::string(ubuf, dga::format(std::numeric_limits<u64>::max(), ubuf)),
+              "18446744073709551615");
+}
+
+TEST(Format, FloatingPoint) {
+    char buf[dga::max_chars_v<double>];
+    EXPECT_EQ(std::string(buf, dga::format(0.1, buf)), "0.1");
+    EXPECT_EQ(std::string(buf, dga::format(-std::numeric_limits<double>::max(), buf)),
+              "-1.7976931348623157e+308");
+    EXPECT_EQ(std::string(buf, dga::format(-std::numeric_limits<double>::denorm_min(), buf)),
+              "-5e-324");
+    char fbuf[dga::max_chars_v<float>];
+    EXPECT_EQ(std::string(fbuf, dga::format(-std::numeric_limits<float>::min(), fbuf)),
+              "-1.1754944e-38");
+}
+
+TEST(Format, AppendNumber) {
+    std::string output = "value=";
+    dga::appendNumber(output, 42);
+    output += ',';
+    dga::appendNumber(output, -1.25);
+    EXPECT_EQ(output, "value=42,-1.25");
+}
+
+TEST(Format, RoundTrip) {
+    std::mt19937_64 rng{7};
+    std::uniform_real_distribution<double> distribution{-1e10, 1e10};
+    std::string s;
+    for (int i = 0; i < 1000; ++i) {
+        const double value = distribution(rng);
+        s.clear();
+        dga::appendNumber(s, value);
+        EXPECT_EQ(dga::parse<double>(s).value(), value) << s;
+    }
+}
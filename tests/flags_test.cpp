@@ -3,6 +3,8 @@
 #include <gtest/gtest.h>
 #include <dga/flags.h>
 
+#include <vector>
+
 namespace {
 enum class TestEnum { A, B, C, _Count };
 
@@ -27,6 +29,15 @@ enum class IntEnum : short {
     A15,
     _Count
 };
+
+enum class FullEnum : unsigned char { A0, A1, A2, A3, A4, A5, A6, A7, _Count };
+
+// 150 flags, which need three 64-bit words.
+enum class LargeEnum { First = 0, Middle = 64, Last = 149, _Count = 150 };
+
+LargeEnum large(int i) {
+    return LargeEnum(i);
+}
 }  // namespace
 
 using dga::Flags;
@@ -169,4 +180,113 @@ TEST(Flags, IntOverflow) {
     Flags<IntEnum> flags;
     flags.set(IntEnum::A15);
     EXPECT_TRUE(flags.isSet(IntEnum::A15));
-}
\ No newline at end of file
+}
+TEST(Flags, FullWord) {
+    static_assert(sizeof(Flags<FullEnum>) == 1);
+    EXPECT_EQ(Flags<FullEnum>::all().value(), 0xff);
+    EXPECT_EQ(Flags<FullEnum>::all().count(), 8u);
+    EXPECT_EQ(~Flags<FullEnum>::all(), Flags<FullEnum>::none());
+}
+
+TEST(Flags, CountAndAny) {
+    Flags<TestEnum> flags;
+    EXPECT_FALSE(flags.any());
+    EXPECT_TRUE(!flags);
+    EXPECT_EQ(flags.count(), 0u);
+
+    flags.set(TestEnum::A);
+    flags.set(TestEnum::C);
+    EXPECT_TRUE(flags.any());
+    EXPECT_FALSE(!flags);
+    EXPECT_EQ(flags.count(), 2u);
+    EXPECT_EQ(Flags<TestEnum>::all().count(), 3u);
+}
+
+TEST(Flags, Iterate) {
+    std::vector<TestEnum> visited;
+    for (TestEnum e : Flags{TestEnum::A} | TestEnum::C) {
+        visited.push_back(e);
+    }
+    EXPECT_EQ(visited, (std::vector<TestEnum>{TestEnum::A, TestEnum::C}));
+
+    visited.clear();
+    for (TestEnum e : Flags<TestEnum>::none()) {
+        visited.push_back(e);
+    }
+    EXPECT_TRUE(visited.empty());
+
+    std::vector<IntEnum> int_visited;
+    for (IntEnum e : Flags{IntEnum::A15}) {
+        int_visited.push_back(e);
+    }
+    EXPECT_EQ(int_visited, std::vector<IntEnum>{IntEnum::A15});
+}
+
+TEST(Flags, MultiWord) {
+    using LargeFlags = Flags<LargeEnum>;
+    static_assert(LargeFlags::word_count == 3);
+    static_assert(sizeof(LargeFlags) == 3 * sizeof(dga::u64));
+
+    LargeFlags flags;
+    EXPECT_FALSE(flags.any());
+    flags.set(LargeEnum::First);
+    flags.set(LargeEnum::Middle);
+    flags.set(LargeEnum::Last);
+    EXPECT_TRUE(flags.isSet(LargeEnum::First));
+    EXPECT_TRUE(flags.isSet(LargeEnum::Middle));
+    EXPECT_TRUE(flags.isSet(LargeEnum::Last));
+    EXPECT_FALSE(flags.isSet(large(63)));
+    EXPECT_FALSE(flags.isSet(large(65)));
+    EXPECT_EQ(flags.count(), 3u);
+
+    flags.reset(LargeEnum::Middle);
+    EXPECT_FALSE(flags.isSet(LargeEnum::Middle));
+    flags.toggle(LargeEnum::Middle);
+    EXPECT_TRUE(flags.isSet(LargeEnum::Middle));
+
+    EXPECT_EQ(LargeFlags::all().count(), 150u);
+    EXPECT_EQ(LargeFlags::all().words()[2], (dga::u64(1) << 22) - 1);
+    EXPECT_EQ((~flags).count(), 147u);
+    EXPECT_EQ(~LargeFlags::all(), LargeFlags::none());
+    EXPECT_EQ(flags & LargeEnum::Last, LargeEnum::Last);
+    EXPECT_EQ((flags ^ LargeEnum::Last).count(), 2u);
+    EXPECT_EQ((flags & ~LargeFlags{LargeEnum::First}).count(), 2u);
+    EXPECT_EQ((LargeFlags{large(100)} | flags).count(), 4u);
+
+    LargeFlags other{large(100)};
+    other |= flags;
+    EXPECT_EQ(other.count(), 4u);
+    other &= LargeFlags{large(100)} | LargeEnum::Last;
+    EXPECT_EQ(other.count(), 2u);
+    other ^= LargeFlags::all();
+    EXPECT_EQ(other.count(), 148u);
+    other.toggleAll();
+    EXPECT_EQ(other, LargeFlags{large(100)} | LargeEnum::Last);
+}
+
+TEST(Flags, MultiWordIterate) {
+    Flags<LargeEnum> flags;
+    std::vector<int> expected = {0, 1, 63, 64, 127, 128, 149};
+    for (int i : expected) {
+        flags.set(large(i));
+    }
+    std::vector<int> visited;
+    for (LargeEnum e : flags) {
+        visited.push_back(int(e));
+    }
+    EXPECT_EQ(visited, expected);
+
+    // Only the last word is set.
+    visited.clear();
+    for (LargeEnum e : Flags{LargeEnum::Last}) {
+        visited.push_back(int(e));
+    }
+    EXPECT_EQ(visited, std::vector<int>{149});
+
+    const auto all = Flags<LargeEnum>::all();
+    std::size_t count = 0;
+    for (auto it = all.begin(); it != all.end(); it++) {
+        ++count;
+    }
+    EXPECT_EQ(count, 150u);
+}
@@ -0,0 +1,272 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <gtest/gtest.h>
+#include <dga/flat_hash_map.h>
+
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+TEST(FlatHashMap, Empty) {
+    dga::FlatHashMap<int, int> map;
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.size(), 0);
+    EXPECT_EQ(map.capacity(), 0);
+    EXPECT_EQ(map.begin(), map.end());
+    EXPECT_EQ(map.find(1), map.end());
+    EXPECT_FALSE(map.contains(1));
+    EXPECT_EQ(map.erase(1), 0);
+}
+
+TEST(FlatHashMap, InsertFindErase) {
+    dga::FlatHashMap<int, std::string> map;
+    EXPECT_TRUE(map.insert({1, "one"}).second);
+    EXPECT_TRUE(map.emplace(2, "two").second);
+    EXPECT_TRUE(map.try_emplace(3, "three").second);
+    EXPECT_FALSE(map.insert({1, "uno"}).second);
+    EXPECT_FALSE(map.try_emplace(2, "dos").second);
+    EXPECT_EQ(map.size(), 3);
+
+    EXPECT_EQ(map.find(1)->second, "one");
+    EXPECT_EQ(map.at(2), "two");
+    EXPECT_EQ(map[3], "three");
+    EXPECT_EQ(map.count(3), 1);
+    EXPECT_EQ(map.count(4), 0);
+    EXPECT_THROW(map.at(4), std::out_of_range);
+
+    map[4] = "four";
+    EXPECT_EQ(map.size(), 4);
+    EXPECT_FALSE(map.insert_or_assign(4, "vier").second);
+    EXPECT_EQ(map[4], "vier");
+
+    EXPECT_EQ(map.erase(2), 1);
+    EXPECT_EQ(map.erase(2), 0);
+    EXPECT_FALSE(map.contains(2));
+    EXPECT_EQ(map.size(), 3);
+
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_FALSE(map.contains(1));
+}
+
+TEST(FlatHashMap, Iteration) {
+    dga::FlatHashMap<int, int> map;
+    for (int i = 0; i < 100; ++i) {
+        map[i] = i * i;
+    }
+    std::map<int, int> seen{map.begin(), map.end()};
+    ASSERT_EQ(seen.size(), 100);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(seen[i], i * i);
+    }
+
+    // Erase every odd key while iterating.
+    for (auto it = map.begin(); it != map.end();) {
+        if (it->first % 2 == 1) {
+            it = map.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    EXPECT_EQ(map.size(), 50);
+    const auto& const_map = map;
+    int count = 0;
+    for (dga::FlatHashMap<int, int>::const_iterator it = const_map.begin(); it != map.end(); ++it) {
+        EXPECT_EQ(it->first % 2, 0);
+        ++count;
+    }
+    EXPECT_EQ(count, 50);
+}
+
+TEST(FlatHashMap, MatchesUnorderedMap) {
+    std::mt19937 rng{1234};
+    std::uniform_int_distribution<int> keys{0, 2000};
+    std::uniform_int_distribution<int> ops{0, 3};
+    dga::FlatHashMap<int, int> map;
+    std::unordered_map<int, int> expected;
+    for (int i = 0; i < 100000; ++i) {
+        const int key = keys(rng);
+        switch (ops(rng)) {
+        case 0:
+        case 1:
+            EXPECT_EQ(map.insert({key, i}).second, expected.insert({key, i}).second);
+            break;
+        case 2:
+            EXPECT_EQ(map.erase(key), expected.erase(key));
+            break;
+        default:
+            EXPECT_EQ(map.contains(key), expected.count(key) == 1);
+            break;
+        }
+        ASSERT_EQ(map.size(), expected.size());
+    }
+    for (const auto& [key, value] : expected) {
+        ASSERT_TRUE(map.contains(key));
+        EXPECT_EQ(map.at(key), value);
+    }
+    EXPECT_LE(map.load_factor(), 0.875f);
+}
+
+TEST(FlatHashMap, HeterogeneousLookup) {
+    dga::FlatHashMap<std::string, int> map{{"apple", 1}, {"banana", 2}};
+    const std::string_view banana = "banana";
+    EXPECT_EQ(map.find(banana)->second, 2);
+    EXPECT_TRUE(map.contains("apple"));
+    EXPECT_FALSE(map.contains(std::string_view{"cherry"}));
+    EXPECT_EQ(map.at(std::string_view{"apple"}), 1);
+    EXPECT_EQ(map.erase(banana), 1);
+    EXPECT_EQ(map.size(), 1);
+}
+
+TEST(FlatHashMap, ReserveDoesNotRehash) {
+    dga::FlatHashMap<int, int> map;
+    map.reserve(1000);
+    const auto capacity = map.capacity();
+    EXPECT_GE(capacity, 1000);
+    map[0] = 0;
+    const int* first = &map[0];
+    for (int i = 1; i < 1000; ++i) {
+        map[i] = i;
+    }
+    EXPECT_EQ(map.capacity(), capacity);
+    EXPECT_EQ(first, &map[0]);
+}
+
+TEST(FlatHashMap, EraseChurnDoesNotGrow) {
+    dga::FlatHashMap<int, int> map;
+    map.reserve(100);
+    const auto capacity = map.capacity();
+    for (int i = 0; i < 100000; ++i) {
+        map[i] = i;
+        if (i >= 50) {
+            map.erase(i - 50);
+        }
+    }
+    EXPECT_EQ(map.size(), 50);
+    EXPECT_EQ(map.capacity(), capacity);
+}
+
+TEST(FlatHashMap, CopyAndMove) {
+    dga::FlatHashMap<std::string, int> map;
+    for (int i = 0; i < 100; ++i) {
+        map[std::to_string(i)] = i;
+    }
+    dga::FlatHashMap<std::string, int> copy{map};
+    EXPECT_EQ(copy.size(), 100);
+    EXPECT_EQ(copy.at("42"), 42);
+
+    dga::FlatHashMap<std::string, int> moved{std::move(copy)};
+    EXPECT_EQ(moved.size(), 100);
+    EXPECT_TRUE(copy.empty());  // NOLINT(bugprone-use-after-move)
+    EXPECT_FALSE(copy.contains("42"));
+
+    copy = moved;
+    EXPECT_EQ(copy.size(), 100);
+    moved = std::move(map);
+    EXPECT_EQ(moved.at("99"), 99);
+    copy.swap(map);
+    EXPECT_EQ(map.size(), 100);
+}
+
+TEST(FlatHashMap, MoveOnlyValues) {
+    dga::FlatHashMap<int, std::unique_ptr<int>> map;
+    for (int i = 0; i < 100; ++i) {
+        map.try_emplace(i, std::make_unique<int>(i));
+    }
+    EXPECT_EQ(*map.at(50), 50);
+}
+
+TEST(FlatHashMap, DestroysElements) {
+    auto value = std::make_shared<int>(0);
+    {
+        dga::FlatHashMap<int, std::shared_ptr<int>> map;
+        for (int i = 0; i < 100; ++i) {
+            map[i] = value;
+        }
+        EXPECT_EQ(value.use_count(), 101);
+        map.erase(0);
+        EXPECT_EQ(value.use_count(), 100);
+    }
+    EXPECT_EQ(value.use_count(), 1);
+}
+
+namespace {
+// An allocator that counts the bytes it has outstanding, and doesn't propagate.
+template <typename T> struct CountingAllocator {
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::false_type;
+    using propagate_on_container_swap = std::false_type;
+
+    explicit CountingAllocator(std::shared_ptr<std::size_t> bytes) : bytes(std::move(bytes)) {
+    }
+
+    // Allocators must compare equal after being moved from, so don't move the counter.
+    CountingAllocator(const CountingAllocator& other) = default;
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other) noexcept : bytes(other.bytes) {
+    }
+
+    T* allocate(std::size_t n) {
+        *bytes += n * sizeof(T);
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        *bytes -= n * sizeof(T);
+        std::allocator<T>{}.deallocate(p, n);
+    }
+
+    template <typename U> bool operator==(const CountingAllocator<U>& other) const noexcept {
+        return bytes == other.bytes;
+    }
+
+    template <typename U> bool operator!=(const CountingAllocator<U>& other) const noexcept {
+        return bytes != other.bytes;
+    }
+
+    std::shared_ptr<std::size_t> bytes;
+};
+}  // namespace
+
+TEST(FlatHashMap, StatefulAllocator) {
+    using Allocator = CountingAllocator<std::pair<const int, std::string>>;
+    using Map = dga::FlatHashMap<int, std::string, dga::Hash<int>, std::equal_to<>, Allocator>;
+    auto first_bytes = std::make_shared<std::size_t>(0);
+    auto second_bytes = std::make_shared<std::size_t>(0);
+    {
+        Map first{Allocator{first_bytes}};
+        for (int i = 0; i < 100; ++i) {
+            first[i] = std::to_string(i);
+        }
+        EXPECT_GT(*first_bytes, 0);
+        EXPECT_EQ(first.get_allocator(), Allocator{first_bytes});
+
+        // Copy assignment keeps the allocator of the destination.
+        Map second{Allocator{second_bytes}};
+        second = first;
+        EXPECT_EQ(second.get_allocator(), Allocator{second_bytes});
+        EXPECT_EQ(second.at(42), "42");
+        const std::size_t second_size = *second_bytes;
+        EXPECT_GT(second_size, 0);
+
+        // Moving between maps with different allocators moves the elements, rather than the
+        // memory.
+        second.clear();
+        second = std::move(first);
+        EXPECT_EQ(second.size(), 100);
+        EXPECT_EQ(second.at(99), "99");
+        EXPECT_EQ(*second_bytes, second_size);
+
+        // The move constructor takes the allocator along with the memory.
+        Map third{std::move(second)};
+        EXPECT_EQ(third.get_allocator(), Allocator{second_bytes});
+        EXPECT_EQ(third.at(7), "7");
+    }
+    EXPECT_EQ(*first_bytes, 0);
+    EXPECT_EQ(*second_bytes, 0);
+}
@@ -0,0 +1,234 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <gtest/gtest.h>
+#include <dga/future.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+enum class RpcError { Timeout, Refused };
+
+struct CountDestructions {
+    explicit CountDestructions(int& count) : count(&count) {
+    }
+    CountDestructions(CountDestructions&& other) noexcept
+        : count(std::exchange(other.count, nullptr)) {
+    }
+    ~CountDestructions() {
+        if (count) {
+            ++*count;
+        }
+    }
+
+    int* count;
+};
+}  // namespace
+
+TEST(Future, SetValue) {
+    dga::Promise<int, RpcError> promise;
+    dga::Future<int, RpcError> future = promise.get_future();
+    EXPECT_TRUE(future.valid());
+    EXPECT_FALSE(future.is_ready());
+    promise.set_value(42);
+    EXPECT_TRUE(future.is_ready());
+    dga::Result<int, RpcError> result = future.get();
+    EXPECT_FALSE(future.valid());
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, 42);
+}
+
+TEST(Future, SetError) {
+    dga::Promise<std::string, RpcError> promise;
+    auto future = promise.get_future();
+    promise.set_error(RpcError::Refused);
+    auto result = future.get();
+    ASSERT_FALSE(result.has_value());
+    EXPECT_EQ(result.error(), RpcError::Refused);
+}
+
+TEST(Future, AbandonedPromiseIsFatal) {
+    auto abandon = [] {
+        dga::Promise<int, RpcError> promise;
+        auto future = promise.get_future();
+    };
+    EXPECT_DEATH(abandon(), "Promise destroyed without being completed");
+}
+
+TEST(Future, UnusedPromiseIsNotFatal) {
+    dga::Promise<int, RpcError> a;
+    dga::Promise<int, RpcError> b;
+    a = std::move(b);
+    std::vector<dga::Promise<int, RpcError>> promises(2);
+    promises.resize(8);
+    promises.clear();
+
+    // A completed promise can be assigned over, even though its future was retrieved.
+    auto future = a.get_future();
+    a.set_value(1);
+    a = dga::Promise<int, RpcError>{};
+    EXPECT_EQ(*future.get(), 1);
+}
+
+TEST(Future, Void) {
+    dga::Promise<void, RpcError> promise;
+    auto future = promise.get_future();
+    promise.set_value();
+    EXPECT_TRUE(future.get().has_value());
+}
+
+TEST(Future, MoveOnlyValue) {
+    dga::Promise<std::unique_ptr<int>, RpcError> promise;
+    auto future = promise.get_future();
+    promise.set_value(std::make_unique<int>(7));
+    auto result = future.get();
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(**result, 7);
+}
+
+TEST(Future, ValueDestroyedOnce) {
+    int destroyed = 0;
+    {
+        dga::Promise<CountDestructions, RpcError> promise;
+        auto future = promise.get_future();
+        promise.set_value(destroyed);
+    }
+    EXPECT_EQ(destroyed, 1);
+}
+
+TEST(Future, WaitAcrossThreads) {
+    dga::Promise<int, RpcError> promise;
+    auto future = promise.get_future();
+    std::thread producer{[&promise] {
+        std::this_thread::sleep_for(10ms);
+        promise.set_value(1);
+    }};
+    future.wait();
+    EXPECT_TRUE(future.is_ready());
+    EXPECT_EQ(*future.get(), 1);
+    producer.join();
+}
+
+TEST(Future, WaitFor) {
+    dga::Promise<int, RpcError> promise;
+    auto future = promise.get_future();
+    EXPECT_FALSE(future.wait_for(1ms));
+    promise.set_value(3);
+    EXPECT_TRUE(future.wait_for(1ms));
+    EXPECT_EQ(*future.get(), 3);
+}
+
+TEST(Future, MakeReadyFuture) {
+    auto future = dga::makeReadyFuture(dga::Result<int, RpcError>{5});
+    EXPECT_TRUE(future.is_ready());
+    EXPECT_EQ(*future.get(), 5);
+}
+
+TEST(Future, ThenRunsOnCompletingThread) {
+    dga::Promise<int, RpcError> promise;
+    std::thread::id continuation_thread;
+    auto next = promise.get_future().then([&](dga::Result<int, RpcError> result) {
+        continuation_thread = std::this_thread::get_id();
+        return *result * 2;
+    });
+    static_assert(std::is_same_v<decltype(next), dga::Future<int, RpcError>>);
+    EXPECT_FALSE(next.is_ready());
+
+    std::thread::id producer_thread;
+    std::thread producer{[&] {
+        producer_thread = std::this_thread::get_id();
+        promise.set_value(21);
+    }};
+    producer.join();
+    EXPECT_EQ(continuation_thread, producer_thread);
+    EXPECT_TRUE(next.is_ready());
+    EXPECT_EQ(*next.get(), 42);
+}
+
+TEST(Future, ThenWhenAlreadyReady) {
+    bool called = false;
+    auto next = dga::makeReadyFuture(dga::Result<int, RpcError>{1})
+                    .then([&](dga::Result<int, RpcError>) { called = true; });
+    static_assert(std::is_same_v<decltype(next), dga::Future<void, RpcError>>);
+    EXPECT_TRUE(called);
+    EXPECT_TRUE(next.get().has_value());
+}
+
+TEST(Future, ThenReturningResult) {
+    dga::Promise<int, RpcError> promise;
+    auto next = promise.get_future().then(
+        [](dga::Result<int, RpcError> result) -> dga::Result<std::string, std::string> {
+            if (!result) {
+                return dga::Error{std::string{"failed"}};
+            }
+            return std::to_string(*result);
+        });
+    static_assert(std::is_same_v<decltype(next), dga::Future<std::string, std::string>>);
+    promise.set_error(RpcError::Timeout);
+    auto result = next.get();
+    ASSERT_FALSE(result.has_value());
+    EXPECT_EQ(result.error(), "failed");
+}
+
+TEST(Future, ThenChain) {
+    dga::Promise<int, RpcError> promise;
+    auto future = promise.get_future()
+                      .then([](dga::Result<int, RpcError> r) { return *r + 1; })
+                      .then([](dga::Result<int, RpcError> r) { return *r * 10; });
+    promise.set_value(1);
+    EXPECT_EQ(*future.get(), 20);
+}
+
+TEST(Future, ThenOnPool) {
+    constexpr int kRequests = 64;
+    dga::ThreadPool pool{2};
+    std::vector<dga::Promise<int, RpcError>> promises(kRequests);
+    std::vector<dga::Future<int, RpcError>> replies;
+    std::atomic<int> on_caller_thread{0};
+    const std::thread::id caller = std::this_thread::get_id();
+    for (auto& promise : promises) {
+        replies.emplace_back(
+            promise.get_future().then(pool, [&, caller](dga::Result<int, RpcError> result) {
+                if (std::this_thread::get_id() == caller) {
+                    ++on_caller_thread;
+                }
+                return *result + 1;
+            }));
+    }
+    for (int i = 0; i < kRequests; ++i) {
+        promises[i].set_value(i);
+    }
+    int sum = 0;
+    for (auto& reply : replies) {
+        sum += *reply.get();
+    }
+    EXPECT_EQ(sum, kRequests * (kRequests + 1) / 2);
+    EXPECT_EQ(on_caller_thread, 0);
+}
+
+TEST(Future, ManyWaiters) {
+    constexpr int kThreads = 4;
+    dga::Promise<int, RpcError> promise;
+    auto future = promise.get_future();
+    std::atomic<int> woken{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&] {
+            future.wait();
+            ++woken;
+        });
+    }
+    std::this_thread::sleep_for(5ms);
+    promise.set_value(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(woken, kThreads);
+}
@@ -0,0 +1,230 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <gtest/gtest.h>
+#include <dga/hash_combine.h>
+#include <dga/bit.h>
+
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+struct Packed {
+    dga::u32 a;
+    dga::u32 b;
+};
+
+struct Padded {
+    dga::u8 a;
+    dga::u32 b;
+};
+
+struct Custom {
+    float value;
+};
+
+struct OptedOut {
+    dga::u32 value;
+};
+
+// Has no padding, but equality only depends on the id.
+struct Handle {
+    dga::u32 id;
+    dga::u32 generation;
+
+    bool operator==(const Handle& other) const noexcept {
+        return id == other.id;
+    }
+};
+}  // namespace
+
+template <> struct std::hash<Custom> {
+    std::size_t operator()(const Custom& c) const noexcept {
+        return std::size_t(c.value);
+    }
+};
+
+template <> struct dga::is_trivially_hashable<OptedOut> : std::false_type {};
+
+template <> struct std::hash<Handle> {
+    std::size_t operator()(const Handle& h) const noexcept {
+        return std::size_t(h.id);
+    }
+};
+
+template <> struct std::hash<OptedOut> {
+    std::size_t operator()(const OptedOut& o) const noexcept {
+        return std::size_t(o.value);
+    }
+};
+
+TEST(HashCombine, HashBytesIsDeterministic) {
+    const std::string s = "The quick brown fox jumps over the lazy dog";
+    EXPECT_EQ(dga::hashBytes(s.data(), s.size()), dga::hashBytes(s.data(), s.size()));
+    EXPECT_NE(dga::hashBytes(s.data(), s.size()), dga::hashBytes(s.data(), s.size(), 1));
+    EXPECT_NE(dga::hashBytes(s.data(), s.size()), dga::hashBytes(s.data(), s.size() - 1));
+}
+
+TEST(HashCombine, HashBytesAllLengths) {
+    // Every prefix of a long string, which covers each of the short, medium and long paths, should
+    // hash differently. Also check that the hash only depends on the bytes in range.
+    std::string s;
+    for (int i = 0; i < 200; ++i) {
+        s.push_back(char('a' + i % 26));
+    }
+    std::set<dga::u64> hashes;
+    for (std::size_t length = 0; length <= s.size(); ++length) {
+        const std::string copy = s.substr(0, length) + "!";
+        EXPECT_EQ(dga::hashBytes(s.data(), length), dga::hashBytes(copy.data(), length));
+        hashes.insert(dga::hashBytes(s.data(), length));
+    }
+    EXPECT_EQ(hashes.size(), s.size() + 1);
+}
+
+TEST(HashCombine, HashBytesSingleBitChanges) {
+    for (std::size_t length : {1, 3, 4, 8, 16, 17, 48, 49, 100}) {
+        std::vector<dga::u8> data(length, 0);
+        const dga::u64 base = dga::hashBytes(data.data(), length);
+        for (std::size_t bit = 0; bit < length * 8; ++bit) {
+            data[bit / 8] ^= dga::u8(1u << (bit % 8));
+            EXPECT_NE(dga::hashBytes(data.data(), length), base) << length << " " << bit;
+            data[bit / 8] ^= dga::u8(1u << (bit % 8));
+        }
+    }
+}
+
+TEST(HashCombine, Hash64Avalanche) {
+    // Flipping any input bit should flip roughly half of the output bits on average.
+    int total = 0;
+    int samples = 0;
+    for (dga::u64 x = 0; x < 1000; ++x) {
+        const dga::u64 h = dga::hash64(x);
+        for (int bit = 0; bit < 64; ++bit) {
+            total += dga::popcount(h ^ dga::hash64(x ^ (dga::u64(1) << bit)));
+            ++samples;
+        }
+    }
+    const double average = double(total) / samples;
+    EXPECT_GT(average, 30.0);
+    EXPECT_LT(average, 34.0);
+}
+
+TEST(HashCombine, IntegersAreMixed) {
+    // Sequential keys should spread across the low bits, unlike an identity hash.
+    dga::Hash<int> hasher;
+    EXPECT_NE(hasher(1), 1u);
+    std::unordered_set<std::size_t> buckets;
+    for (int i = 0; i < 1024; ++i) {
+        buckets.insert(hasher(i * 1024) & 1023);
+    }
+    EXPECT_GT(buckets.size(), 550u);
+}
+
+TEST(HashCombine, TriviallyHashable) {
+    static_assert(dga::is_trivially_hashable_v<Packed>);
+    static_assert(!dga::is_trivially_hashable_v<Padded>);
+    static_assert(!dga::is_trivially_hashable_v<float>);
+    static_assert(!dga::is_trivially_hashable_v<OptedOut>);
+
+    const Packed p{1, 2};
+    EXPECT_EQ(dga::Hash<Packed>{}(p), std::size_t(dga::hashBytes(&p, sizeof(p))));
+    EXPECT_NE(dga::Hash<Packed>{}(p), dga::Hash<Packed>{}(Packed{2, 1}));
+}
+
+TEST(HashCombine, FallsBackToStdHash) {
+    EXPECT_EQ(dga::Hash<Custom>{}(Custom{5.0f}), std::size_t(dga::hash64(5)));
+    EXPECT_EQ(dga::Hash<OptedOut>{}(OptedOut{5}), std::size_t(dga::hash64(5)));
+    EXPECT_EQ(dga::Hash<float>{}(0.0f), dga::Hash<float>{}(-0.0f));
+}
+
+TEST(HashCombine, StdHashTakesPrecedenceOverBytes) {
+    // Handle has a unique object representation, but its std::hash must still be used, as hashing
+    // its bytes would disagree with its operator==.
+    static_assert(dga::is_trivially_hashable_v<Handle>);
+    EXPECT_EQ(dga::Hash<Handle>{}(Handle{7, 1}), std::size_t(dga::hash64(7)));
+    EXPECT_EQ(dga::Hash<Handle>{}(Handle{7, 1}), dga::Hash<Handle>{}(Handle{7, 2}));
+}
+
+TEST(HashCombine, PointersHashByAddress) {
+    const char a[] = "hello";
+    const char b[] = "hello";
+    const char* pa = a;
+    const char* pb = b;
+    EXPECT_EQ(dga::Hash<const char*>{}(pa),
+              std::size_t(dga::hash64(reinterpret_cast<dga::uintptr>(pa))));
+    EXPECT_NE(dga::Hash<const char*>{}(pa), dga::Hash<const char*>{}(pb));
+    const char* null = nullptr;
+    EXPECT_EQ(dga::Hash<const char*>{}(null), std::size_t(dga::hash64(0)));
+}
+
+TEST(HashCombine, Strings) {
+    const std::string s = "hello";
+    const std::size_t expected = std::size_t(dga::hashBytes(s.data(), s.size()));
+    EXPECT_EQ(dga::Hash<std::string>{}(s), expected);
+    EXPECT_EQ(dga::Hash<std::string>{}(std::string_view{"hello"}), expected);
+    EXPECT_EQ(dga::Hash<std::string_view>{}("hello"), expected);
+    EXPECT_EQ(dga::StringHash{}("hello"), expected);
+}
+
+TEST(HashCombine, Combine) {
+    std::size_t seed1 = 0;
+    dga::hashCombine(seed1, 1, std::string{"two"}, 3.0);
+    std::size_t seed2 = 0;
+    dga::hashCombine(seed2, 1, std::string{"two"}, 3.0);
+    EXPECT_EQ(seed1, seed2);
+
+    // Order matters.
+    std::size_t a = 0, b = 0;
+    dga::hashCombine(a, 1, 2);
+    dga::hashCombine(b, 2, 1);
+    EXPECT_NE(a, b);
+
+    // Combining nothing leaves the seed alone.
+    std::size_t seed = 123;
+    dga::hashCombine(seed);
+    EXPECT_EQ(seed, 123u);
+}
+
+TEST(HashCombine, HashString) {
+    using namespace dga::literals;
+
+    // FNV-1a test vectors.
+    static_assert(dga::hashString("") == 0xcbf29ce484222325ull);
+    static_assert(dga::hashString("a") == 0xaf63dc4c8601ec8cull);
+    static_assert(dga::hashString("foobar") == 0x85944171f73967e8ull);
+    static_assert("foobar"_h == dga::hashString("foobar"));
+
+    // Same result at run time.
+    const std::string foobar = "foobar";
+    EXPECT_EQ(dga::hashString(foobar), "foobar"_h);
+}
+
+TEST(HashCombine, HashesAreDistinct) {
+    static_assert(dga::hashesAreDistinct({"GET", "PUT", "POST", "DELETE", "HEAD"}));
+    static_assert(!dga::hashesAreDistinct({"GET", "PUT", "GET"}));
+    static_assert(dga::hashesAreDistinct({}));
+}
+
+namespace {
+int dispatch(std::string_view method) {
+    using namespace dga::literals;
+    switch (dga::hashString(method)) {
+    case "GET"_h:
+        return 1;
+    case "PUT"_h:
+        return 2;
+    case "POST"_h:
+        return 3;
+    default:
+        return 0;
+    }
+}
+}  // namespace
+
+TEST(HashCombine, StringSwitch) {
+    EXPECT_EQ(dispatch("GET"), 1);
+    EXPECT_EQ(dispatch(std::string{"PUT"}), 2);
+    EXPECT_EQ(dispatch("POST"), 3);
+    EXPECT_EQ(dispatch("PATCH"), 0);
+}
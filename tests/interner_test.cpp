@@ -0,0 +1,133 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <gtest/gtest.h>
+#include <dga/interner.h>
+#include <dga/string_algorithms.h>
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+using dga::ConcurrentStringInterner;
+using dga::InternedString;
+using dga::StringInterner;
+
+TEST(InternedString, Default) {
+    InternedString s;
+    EXPECT_FALSE(s);
+    EXPECT_EQ(s.view(), "");
+    EXPECT_STREQ(s.c_str(), "");
+    EXPECT_EQ(s.id(), InternedString::kNoId);
+    EXPECT_EQ(s, InternedString{});
+}
+
+TEST(StringInterner, InternsOnce) {
+    StringInterner interner;
+    std::string first = "metric.name";
+    std::string second = "metric.name";
+    InternedString a = interner.intern(first);
+    InternedString b = interner.intern(second);
+    InternedString c = interner.intern("other");
+    EXPECT_TRUE(a);
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, c);
+    EXPECT_EQ(a.view(), "metric.name");
+    EXPECT_NE(a.view().data(), first.data());
+    EXPECT_STREQ(a.c_str(), "metric.name");
+    EXPECT_EQ(interner.size(), 2u);
+}
+
+TEST(StringInterner, Ids) {
+    StringInterner interner;
+    EXPECT_EQ(interner.intern("a").id(), 0u);
+    EXPECT_EQ(interner.intern("b").id(), 1u);
+    EXPECT_EQ(interner.intern("a").id(), 0u);
+    EXPECT_EQ(interner.intern("").id(), 2u);
+    EXPECT_TRUE(interner.intern("a") < interner.intern("b"));
+}
+
+TEST(StringInterner, Find) {
+    StringInterner interner;
+    EXPECT_FALSE(interner.find("missing"));
+    InternedString s = interner.intern("present");
+    EXPECT_EQ(interner.find("present"), s);
+    EXPECT_FALSE(interner.find("missing"));
+    EXPECT_EQ(interner.size(), 1u);
+}
+
+TEST(StringInterner, HandlesAreStable) {
+    StringInterner interner;
+    std::vector<InternedString> handles;
+    for (int i = 0; i < 10000; ++i) {
+        handles.push_back(interner.intern("string" + std::to_string(i)));
+    }
+    for (int i = 0; i < 10000; ++i) {
+        EXPECT_EQ(handles[std::size_t(i)].view(), "string" + std::to_string(i));
+        EXPECT_EQ(interner.intern("string" + std::to_string(i)), handles[std::size_t(i)]);
+    }
+    EXPECT_EQ(interner.size(), 10000u);
+    EXPECT_GE(interner.bytesUsed(), 10000u * sizeof("string0"));
+}
+
+TEST(StringInterner, InternTokens) {
+    StringInterner interner;
+    dga::FlatHashMap<InternedString, int> counts;
+    for (std::string_view token : dga::strSplitRange("cpu,mem,cpu,disk,mem,cpu", ',')) {
+        counts[interner.intern(token)]++;
+    }
+    EXPECT_EQ(counts.size(), 3u);
+    EXPECT_EQ(counts[interner.intern("cpu")], 3);
+    EXPECT_EQ(counts[interner.intern("mem")], 2);
+    EXPECT_EQ(counts[interner.intern("disk")], 1);
+
+    std::unordered_set<InternedString> set{interner.intern("cpu"), interner.intern("cpu")};
+    EXPECT_EQ(set.size(), 1u);
+}
+
+TEST(ConcurrentStringInterner, ShardCount) {
+    EXPECT_EQ(ConcurrentStringInterner{0}.shardCount(), 1u);
+    EXPECT_EQ(ConcurrentStringInterner{3}.shardCount(), 4u);
+    EXPECT_EQ(ConcurrentStringInterner{100000}.shardCount(),
+              ConcurrentStringInterner::kMaxShardCount);
+}
+
+TEST(ConcurrentStringInterner, ConcurrentIntern) {
+    constexpr int kThreads = 4;
+    // A power of two, so that multiplying by an odd number permutes the indices.
+    constexpr int kStrings = 2048;
+    ConcurrentStringInterner interner;
+    std::vector<std::vector<InternedString>> results(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            // Each thread interns the same strings in a different order.
+            for (int i = 0; i < kStrings; ++i) {
+                const int n = (i * (2 * t + 1)) % kStrings;
+                results[std::size_t(t)].push_back(interner.intern("key" + std::to_string(n)));
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(interner.size(), std::size_t(kStrings));
+
+    std::vector<bool> seen_ids(kStrings, false);
+    for (int i = 0; i < kStrings; ++i) {
+        InternedString s = interner.find("key" + std::to_string(i));
+        ASSERT_TRUE(s);
+        EXPECT_EQ(s.view(), "key" + std::to_string(i));
+        ASSERT_LT(s.id(), dga::u32(kStrings));
+        EXPECT_FALSE(seen_ids[s.id()]);
+        seen_ids[s.id()] = true;
+    }
+    for (int t = 0; t < kThreads; ++t) {
+        for (int i = 0; i < kStrings; ++i) {
+            const int n = (i * (2 * t + 1)) % kStrings;
+            EXPECT_EQ(results[std::size_t(t)][std::size_t(i)],
+                      interner.find("key" + std::to_string(n)));
+        }
+    }
+}
@@ -0,0 +1,94 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <dga/mapped_file.h>
+#include <dga/string_algorithms.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using dga::MapHint;
+using dga::MapHints;
+using dga::MappedFile;
+using testing::ElementsAre;
+
+namespace {
+// Writes 'contents' to a file in the temporary directory, and removes it when destroyed.
+class TemporaryFile {
+public:
+    TemporaryFile(const std::string& name, const std::string& contents)
+        : path_(std::filesystem::temp_directory_path() / name) {
+        std::ofstream file{path_, std::ios::binary};
+        file << contents;
+    }
+
+    ~TemporaryFile() {
+        std::filesystem::remove(path_);
+    }
+
+    std::string path() const {
+        return path_.string();
+    }
+
+private:
+    std::filesystem::path path_;
+};
+}  // namespace
+
+TEST(MappedFile, DefaultIsEmpty) {
+    MappedFile file;
+    EXPECT_TRUE(file.empty());
+    EXPECT_EQ(file.view(), "");
+}
+
+TEST(MappedFile, MapsContents) {
+    TemporaryFile temp{"dga_mapped_file_contents", "hello\nworld\n"};
+    auto file = MappedFile::open(temp.path());
+    ASSERT_TRUE(file);
+    EXPECT_EQ(file->size(), 12u);
+    EXPECT_EQ(file->view(), "hello\nworld\n");
+}
+
+TEST(MappedFile, SplitWithoutCopying) {
+    TemporaryFile temp{"dga_mapped_file_split", "a,b\nc,d\ne,f"};
+    auto file = MappedFile::open(temp.path(), MapHints{MapHint::Sequential} | MapHint::WillNeed |
+                                                  MapHint::Populate | MapHint::HugePages);
+    ASSERT_TRUE(file);
+    std::vector<std::string_view> lines;
+    dga::strSplit(*file, '\n', std::back_inserter(lines));
+    EXPECT_THAT(lines, ElementsAre("a,b", "c,d", "e,f"));
+    for (std::string_view line : lines) {
+        EXPECT_GE(line.data(), file->data());
+        EXPECT_LE(line.data() + line.size(), file->data() + file->size());
+    }
+}
+
+TEST(MappedFile, EmptyFile) {
+    TemporaryFile temp{"dga_mapped_file_empty", ""};
+    auto file = MappedFile::open(temp.path());
+    ASSERT_TRUE(file);
+    EXPECT_TRUE(file->empty());
+    EXPECT_EQ(file->view(), "");
+}
+
+TEST(MappedFile, MissingFile) {
+    auto file = MappedFile::open("dga_mapped_file_that_does_not_exist");
+    ASSERT_FALSE(file);
+    EXPECT_EQ(file.error(), std::errc::no_such_file_or_directory);
+}
+
+TEST(MappedFile, MoveAndClose) {
+    TemporaryFile temp{"dga_mapped_file_move", "contents"};
+    auto file = MappedFile::open(temp.path(), MapHints{MapHint::Random});
+    ASSERT_TRUE(file);
+    MappedFile moved = std::move(*file);
+    EXPECT_TRUE(file->empty());
+    EXPECT_EQ(moved.view(), "contents");
+    moved.advise(MapHints{MapHint::Sequential});
+    moved.close();
+    EXPECT_TRUE(moved.empty());
+}
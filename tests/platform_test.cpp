@@ -0,0 +1,75 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <gtest/gtest.h>
+#include <dga/platform.h>
+
+namespace {
+DGA_NOINLINE int noinlineFunction(int x) {
+    return x + 1;
+}
+
+DGA_FORCE_INLINE int forceInlineFunction(int x) {
+    return x + 1;
+}
+
+void restrictCopy(int* DGA_RESTRICT dst, const int* DGA_RESTRICT src, int n) {
+    for (int i = 0; i < n; ++i) {
+        dst[i] = src[i];
+    }
+}
+}  // namespace
+
+TEST(Platform, Architecture) {
+#if defined(DGA_ARCH_64)
+    EXPECT_EQ(sizeof(void*), 8);
+#elif defined(DGA_ARCH_32)
+    EXPECT_EQ(sizeof(void*), 4);
+#endif
+}
+
+TEST(Platform, CacheLineSize) {
+    EXPECT_GE(dga::kCacheLineSize, 64);
+    EXPECT_EQ(dga::kCacheLineSize & (dga::kCacheLineSize - 1), 0);
+    EXPECT_EQ(dga::kCacheLineSize, DGA_CACHE_LINE_SIZE);
+}
+
+TEST(Platform, Macros) {
+    EXPECT_EQ(noinlineFunction(1), 2);
+    EXPECT_EQ(forceInlineFunction(1), 2);
+
+    int src[3] = {1, 2, 3};
+    int dst[3] = {};
+    restrictCopy(dst, src, 3);
+    EXPECT_EQ(dst[2], 3);
+
+    int calls = 0;
+    if (DGA_LIKELY(calls == 0)) {
+        calls++;
+    }
+    if (DGA_UNLIKELY(calls == 0)) {
+        calls++;
+    }
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(Platform, CpuFeaturesMatchCompileTimeFeatures) {
+    // Anything enabled at compile time must be supported by the CPU we're running on.
+    const dga::CpuFeatures& features = dga::cpuFeatures();
+#if defined(DGA_HAS_SSE2)
+    EXPECT_TRUE(features.sse2);
+#endif
+#if defined(DGA_HAS_SSE4_2)
+    EXPECT_TRUE(features.sse4_2);
+#endif
+#if defined(DGA_HAS_AVX2)
+    EXPECT_TRUE(features.avx2);
+#endif
+#if defined(DGA_HAS_AVX512)
+    EXPECT_TRUE(features.avx512);
+#endif
+#if defined(DGA_HAS_NEON)
+    EXPECT_TRUE(features.neon);
+#endif
+    // The result is cached.
+    EXPECT_EQ(&features, &dga::cpuFeatures());
+}
@@ -0,0 +1,199 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <dga/queue.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+using testing::ElementsAre;
+
+template <typename T> class QueueTest : public testing::Test {};
+
+using QueueTypeList = testing::Types<dga::SpscQueue<int>, dga::MpmcQueue<int>>;
+TYPED_TEST_SUITE(QueueTest, QueueTypeList);
+
+TYPED_TEST(QueueTest, Capacity) {
+    TypeParam queue{5};
+    EXPECT_EQ(queue.capacity(), 8);
+}
+
+TYPED_TEST(QueueTest, PushPop) {
+    TypeParam queue{4};
+    int value = 0;
+    EXPECT_FALSE(queue.try_pop(value));
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.try_push(i));
+    }
+    EXPECT_FALSE(queue.try_push(4));
+    EXPECT_EQ(queue.size_approx(), 4);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(queue.try_pop(value));
+
+    // Wrap around the buffer.
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(queue.try_push(i));
+        EXPECT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(value, i);
+    }
+}
+
+TYPED_TEST(QueueTest, Batch) {
+    TypeParam queue{4};
+    std::vector<int> input{1, 2, 3, 4, 5, 6};
+    EXPECT_EQ(queue.try_push_n(input.begin(), input.size()), 4);
+    EXPECT_EQ(queue.try_push_n(input.begin(), input.size()), 0);
+
+    std::vector<int> output;
+    EXPECT_EQ(queue.try_pop_n(std::back_inserter(output), 3), 3);
+    EXPECT_THAT(output, ElementsAre(1, 2, 3));
+    EXPECT_EQ(queue.try_push_n(input.begin() + 4, 2), 2);
+    EXPECT_EQ(queue.try_pop_n(std::back_inserter(output), 10), 3);
+    EXPECT_THAT(output, ElementsAre(1, 2, 3, 4, 5, 6));
+}
+
+TEST(SpscQueue, Threads) {
+    constexpr int kItems = 100000;
+    dga::SpscQueue<int> queue{64};
+    std::thread producer{[&] {
+        for (int i = 0; i < kItems;) {
+            if (queue.try_push(i)) {
+                ++i;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }};
+    long long sum = 0;
+    int expected = 0;
+    bool in_order = true;
+    for (int value; expected < kItems;) {
+        if (queue.try_pop(value)) {
+            in_order &= value == expected++;
+            sum += value;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    EXPECT_TRUE(in_order);
+    EXPECT_EQ(sum, (long long)kItems * (kItems - 1) / 2);
+}
+
+TEST(MpmcQueue, Threads) {
+    constexpr int kThreads = 4;
+    constexpr int kItemsPerThread = 50000;
+    dga::MpmcQueue<int> queue{64};
+    std::atomic<long long> sum{0};
+    std::atomic<int> popped{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < kItemsPerThread;) {
+                int values[3] = {i, i + 1, i + 2};
+                const auto pushed =
+                    queue.try_push_n(values, std::size_t(std::min(3, kItemsPerThread - i)));
+                if (pushed == 0) {
+                    std::this_thread::yield();
+                }
+                i += int(pushed);
+            }
+        });
+        threads.emplace_back([&] {
+            while (popped < kThreads * kItemsPerThread) {
+                int value;
+                if (queue.try_pop(value)) {
+                    sum += value;
+                    popped++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(popped, kThreads * kItemsPerThread);
+    EXPECT_EQ(sum, (long long)kThreads * kItemsPerThread * (kItemsPerThread - 1) / 2);
+}
+
+TEST(MpmcQueue, DestroysRemainingElements) {
+    auto value = std::make_shared<int>(1);
+    {
+        dga::MpmcQueue<std::shared_ptr<int>> queue{4};
+        queue.try_push(value);
+        queue.try_push(value);
+        EXPECT_EQ(value.use_count(), 3);
+    }
+    EXPECT_EQ(value.use_count(), 1);
+}
+
+TEST(BlockingQueue, Threads) {
+    constexpr int kThreads = 4;
+    constexpr int kItemsPerThread = 20000;
+    dga::BlockingQueue<int> queue{16};
+    std::atomic<long long> sum{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < kItemsPerThread; ++i) {
+                queue.push(i);
+            }
+        });
+        threads.emplace_back([&] {
+            for (int i = 0; i < kItemsPerThread; ++i) {
+                sum += queue.pop();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(sum, (long long)kThreads * kItemsPerThread * (kItemsPerThread - 1) / 2);
+    int value;
+    EXPECT_FALSE(queue.try_pop(value));
+    EXPECT_FALSE(queue.pop_for(value, std::chrono::milliseconds(1)));
+}
+
+TEST(BlockingQueue, Spsc) {
+    dga::BlockingQueue<int, dga::SpscQueue<int>> queue{2};
+    EXPECT_TRUE(queue.try_push(1));
+    EXPECT_TRUE(queue.try_push(2));
+    EXPECT_FALSE(queue.try_push(3));
+    EXPECT_EQ(queue.pop(), 1);
+    EXPECT_EQ(queue.pop(), 2);
+}
+
+namespace {
+// Move only, and not default constructible.
+class Job {
+public:
+    explicit Job(int id) : id_(std::make_unique<int>(id)) {
+    }
+
+    int id() const {
+        return *id_;
+    }
+
+private:
+    std::unique_ptr<int> id_;
+};
+}  // namespace
+
+TEST(BlockingQueue, PopWithoutDefaultConstructor) {
+    dga::BlockingQueue<Job> mpmc{4};
+    mpmc.push(Job{1});
+    mpmc.push(Job{2});
+    EXPECT_EQ(mpmc.pop().id(), 1);
+    EXPECT_EQ(mpmc.pop().id(), 2);
+
+    dga::BlockingQueue<Job, dga::SpscQueue<Job>> spsc{4};
+    spsc.push(Job{3});
+    EXPECT_EQ(spsc.pop().id(), 3);
+}
@@ -0,0 +1,106 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <gtest/gtest.h>
+#include <dga/result.h>
+
+#include <memory>
+#include <string>
+
+using dga::Error;
+using dga::Result;
+
+#ifdef DGA_HAS_RESULT_COROUTINES
+namespace {
+Result<int, int> halve(int value) {
+    if (value % 2 != 0) {
+        return Error{value};
+    }
+    return value / 2;
+}
+
+Result<int, int> quarter(int value) {
+    int half = co_await halve(value);
+    co_return co_await halve(half);
+}
+
+Result<void, std::string> check(int value, int& output) {
+    // co_await an lvalue Result after converting its error.
+    Result<int, std::string> result =
+        quarter(value).transform_error([](int error) { return std::to_string(error); });
+    output = co_await result;
+    co_return {};
+}
+
+// Counts how many times it's destroyed, to check that locals are destroyed when a coroutine stops
+// at an error.
+struct DestructorCounter {
+    explicit DestructorCounter(int& count) : count_(count) {
+    }
+
+    ~DestructorCounter() {
+        count_++;
+    }
+
+    int& count_;
+};
+
+Result<int, int> stopsEarly(int value, int& destroyed) {
+    DestructorCounter counter{destroyed};
+    int half = co_await halve(value);
+    co_return half + 1;
+}
+}  // namespace
+
+TEST(ResultCoroutine, CoAwait) {
+    EXPECT_EQ(*quarter(12), 3);
+    EXPECT_EQ(quarter(6).error(), 3);
+    EXPECT_EQ(quarter(5).error(), 5);
+}
+
+TEST(ResultCoroutine, VoidResult) {
+    int output = 0;
+    EXPECT_TRUE(check(8, output).has_value());
+    EXPECT_EQ(output, 2);
+
+    Result<void, std::string> error = check(3, output);
+    ASSERT_FALSE(error.has_value());
+    EXPECT_EQ(error.error(), "3");
+    EXPECT_EQ(output, 2);
+}
+
+TEST(ResultCoroutine, AwaitVoidResult) {
+    auto inner = [](bool fail) -> Result<void, int> {
+        if (fail) {
+            co_return Error{1};
+        }
+        co_return {};
+    };
+    auto outer = [&](bool fail) -> Result<int, int> {
+        co_await inner(fail);
+        co_return 10;
+    };
+    EXPECT_EQ(*outer(false), 10);
+    EXPECT_EQ(outer(true).error(), 1);
+}
+
+TEST(ResultCoroutine, LocalsAreDestroyed) {
+    int destroyed = 0;
+    EXPECT_EQ(*stopsEarly(4, destroyed), 3);
+    EXPECT_EQ(destroyed, 1);
+    EXPECT_EQ(stopsEarly(5, destroyed).error(), 5);
+    EXPECT_EQ(destroyed, 2);
+}
+
+TEST(ResultCoroutine, MovesValues) {
+    auto make = []() -> Result<std::unique_ptr<int>, int> { co_return std::make_unique<int>(5); };
+    auto use = [&]() -> Result<int, int> {
+        std::unique_ptr<int> pointer = co_await make();
+        co_return *pointer;
+    };
+    EXPECT_EQ(*use(), 5);
+}
+#else
+TEST(ResultCoroutine, Unsupported) {
+    GTEST_SKIP() << "Coroutines are not supported by this compiler.";
+}
+#endif
@@ -0,0 +1,39 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+// DGA_NO_EXCEPTIONS is defined manually, but this test is compiled with exceptions enabled, so
+// exceptions thrown inside a Result coroutine must still propagate to the caller.
+#define DGA_NO_EXCEPTIONS
+
+#include <gtest/gtest.h>
+#include <dga/result.h>
+
+#include <stdexcept>
+
+#ifndef DGA_HAS_EXCEPTIONS
+#error DGA_HAS_EXCEPTIONS should be defined when compiling with exceptions.
+#endif
+
+using dga::Error;
+using dga::Result;
+
+#ifdef DGA_HAS_RESULT_COROUTINES
+namespace {
+Result<int, int> throwsAfter(Result<int, int> input) {
+    int value = co_await input;
+    if (value > 0) {
+        throw std::runtime_error("coroutine failed");
+    }
+    co_return value;
+}
+}  // namespace
+
+TEST(ResultCoroutineExceptionsOverride, ExceptionPropagates) {
+    EXPECT_THROW((void)throwsAfter(1), std::runtime_error);
+    EXPECT_EQ(*throwsAfter(0), 0);
+    EXPECT_EQ(throwsAfter(Error{3}).error(), 3);
+}
+#else
+TEST(ResultCoroutineExceptionsOverride, Unsupported) {
+    GTEST_SKIP() << "Coroutines are not supported by this compiler.";
+}
+#endif
@@ -0,0 +1,41 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <gtest/gtest.h>
+#include <dga/result.h>
+
+// This test is compiled with exceptions disabled.
+#ifndef DGA_NO_EXCEPTIONS
+#error DGA_NO_EXCEPTIONS should be defined when compiling without exceptions.
+#endif
+
+using dga::Error;
+using dga::Result;
+
+namespace {
+[[noreturn]] void customFatalErrorHandler(const char* message) {
+    std::fprintf(stderr, "Custom handler: %s\n", message);
+    std::abort();
+}
+}  // namespace
+
+TEST(ResultNoExceptions, Value) {
+    Result<int, int> result{123};
+    EXPECT_EQ(result.value(), 123);
+    EXPECT_EQ(std::move(result).value(), 123);
+}
+
+TEST(ResultNoExceptionsDeathTest, MissingValueIsFatal) {
+    Result<int, int> result{Error{123}};
+    EXPECT_DEATH((void)result.value(), "Missing result value.");
+}
+
+TEST(ResultNoExceptionsDeathTest, CustomFatalErrorHandler) {
+    Result<int, int> result{Error{123}};
+    EXPECT_DEATH(
+        {
+            dga::setFatalErrorHandler(customFatalErrorHandler);
+            (void)result.value();
+        },
+        "Custom handler: Missing result value.");
+    EXPECT_EQ(dga::setFatalErrorHandler(nullptr), nullptr);
+}
@@ -463,4 +463,306 @@ TEST(Result, NonTrivial) {
         EXPECT_FALSE(bool(result));
         EXPECT_EQ(result.error(), "str");
     }
-}
\ No newline at end of file
+}
+namespace {
+enum class ErrorCode : dga::u8 { None, NotFound, AccessDenied };
+
+struct alignas(4) Node {
+    int value;
+};
+
+struct MoveOnly {
+    MoveOnly() = default;
+    MoveOnly(MoveOnly&&) = default;
+    MoveOnly& operator=(MoveOnly&&) = default;
+};
+}  // namespace
+
+template <> struct dga::pointer_niche<Node> : std::true_type {};
+
+template <> struct dga::error_niche<ErrorCode> {
+    static constexpr ErrorCode value = ErrorCode::None;
+};
+
+TEST(Result, Triviality) {
+    static_assert(std::is_trivially_copyable_v<Result<int, int>>);
+    static_assert(std::is_trivially_destructible_v<Result<int, int>>);
+    static_assert(std::is_trivially_copyable_v<Result<void, int>>);
+    static_assert(std::is_trivially_copyable_v<Result<int*, ErrorCode>>);
+    static_assert(!std::is_trivially_copyable_v<Result<std::string, int>>);
+    static_assert(!std::is_trivially_destructible_v<Result<int, std::string>>);
+
+    static_assert(std::is_copy_constructible_v<Result<std::string, int>>);
+    static_assert(!std::is_copy_constructible_v<Result<MoveOnly, int>>);
+    static_assert(!std::is_copy_assignable_v<Result<MoveOnly, int>>);
+    static_assert(std::is_nothrow_move_constructible_v<Result<MoveOnly, int>>);
+    static_assert(std::is_nothrow_move_assignable_v<Result<MoveOnly, int>>);
+}
+
+TEST(Result, NicheLayout) {
+    static_assert(sizeof(Result<int*, ErrorCode>) == sizeof(int*));
+    static_assert(sizeof(Result<const double*, ErrorCode>) == sizeof(double*));
+    static_assert(sizeof(Result<Node*, ErrorCode>) == sizeof(Node*));
+    static_assert(sizeof(Result<void, ErrorCode>) == sizeof(ErrorCode));
+
+    // char isn't aligned enough to leave a spare bit.
+    static_assert(sizeof(Result<char*, ErrorCode>) > sizeof(char*));
+}
+
+TEST(Result, PointerNiche) {
+    int value = 123;
+    Result<int*, ErrorCode> result{&value};
+    EXPECT_TRUE(result.has_value());
+    EXPECT_EQ(**result, 123);
+
+    Result<int*, ErrorCode> null_result{nullptr};
+    EXPECT_TRUE(null_result.has_value());
+    EXPECT_EQ(*null_result, nullptr);
+
+    result = Error{ErrorCode::NotFound};
+    EXPECT_FALSE(result.has_value());
+    EXPECT_EQ(result.error(), ErrorCode::NotFound);
+
+    Result<int*, ErrorCode> copy = result;
+    EXPECT_FALSE(copy.has_value());
+    EXPECT_EQ(copy.error(), ErrorCode::NotFound);
+
+    copy = &value;
+    EXPECT_TRUE(copy.has_value());
+    EXPECT_EQ(*copy, &value);
+
+    copy.swap(result);
+    EXPECT_TRUE(result.has_value());
+    EXPECT_EQ(*result, &value);
+    EXPECT_FALSE(copy.has_value());
+    EXPECT_EQ(copy.error(), ErrorCode::NotFound);
+
+    Node node{456};
+    Result<Node*, ErrorCode> node_result{&node};
+    EXPECT_EQ(node_result.value()->value, 456);
+    node_result = Error{ErrorCode::AccessDenied};
+    EXPECT_EQ(node_result.error(), ErrorCode::AccessDenied);
+    EXPECT_THROW(node_result.value(), dga::MissingResultValue<ErrorCode>);
+}
+
+TEST(Result, ErrorNiche) {
+    Result<void, ErrorCode> result;
+    EXPECT_TRUE(result.has_value());
+
+    result = Error{ErrorCode::AccessDenied};
+    EXPECT_FALSE(result.has_value());
+    EXPECT_EQ(result.error(), ErrorCode::AccessDenied);
+
+    Result<void, ErrorCode> other;
+    other.swap(result);
+    EXPECT_TRUE(result.has_value());
+    EXPECT_FALSE(other.has_value());
+    EXPECT_EQ(other.error(), ErrorCode::AccessDenied);
+
+    other.emplace();
+    EXPECT_TRUE(other.has_value());
+}
+
+TEST(Result, NonTrivialStateChanges) {
+    Result<std::string, std::string> result{std::string{"value"}};
+    Result<std::string, std::string> error{Error{std::string{"error"}}};
+
+    // Assigning an error over a value, and a value over an error, must destroy the old contents
+    // and construct the new ones in place.
+    result = error;
+    EXPECT_FALSE(result.has_value());
+    EXPECT_EQ(result.error(), "error");
+
+    result = std::string{"value again"};
+    EXPECT_TRUE(result.has_value());
+    EXPECT_EQ(*result, "value again");
+
+    error.swap(result);
+    EXPECT_TRUE(error.has_value());
+    EXPECT_EQ(*error, "value again");
+    EXPECT_FALSE(result.has_value());
+    EXPECT_EQ(result.error(), "error");
+
+    result = std::move(error);
+    EXPECT_TRUE(result.has_value());
+    EXPECT_EQ(*result, "value again");
+}
+
+namespace {
+// Counts the copies made of it, so that tests can check that combinators move their contents.
+struct CopyCounter {
+    explicit CopyCounter(int& copies) : copies_(&copies) {
+    }
+
+    CopyCounter(const CopyCounter& other) : copies_(other.copies_) {
+        (*copies_)++;
+    }
+
+    CopyCounter(CopyCounter&&) noexcept = default;
+    CopyCounter& operator=(const CopyCounter& other) = default;
+    CopyCounter& operator=(CopyCounter&&) noexcept = default;
+
+    int* copies_;
+};
+
+constexpr Result<int, int> halve(int value) {
+    if (value % 2 != 0) {
+        return Error{value};
+    }
+    return value / 2;
+}
+}  // namespace
+
+TEST(Result, Map) {
+    Result<int, std::string> result{21};
+    auto mapped = result.map([](int value) { return value * 2.0; });
+    static_assert(std::is_same_v<decltype(mapped), Result<double, std::string>>);
+    EXPECT_EQ(*mapped, 42.0);
+
+    Result<int, std::string> error{Error{std::string{"error"}}};
+    auto mapped_error = error.map([](int value) { return value * 2.0; });
+    EXPECT_FALSE(mapped_error.has_value());
+    EXPECT_EQ(mapped_error.error(), "error");
+
+    // Mapping to void.
+    int calls = 0;
+    auto mapped_void = result.map([&](int) { calls++; });
+    static_assert(std::is_same_v<decltype(mapped_void), Result<void, std::string>>);
+    EXPECT_TRUE(mapped_void.has_value());
+    EXPECT_EQ(calls, 1);
+
+    // Mapping from void.
+    Result<void, int> void_result;
+    EXPECT_EQ(*void_result.map([] { return 5; }), 5);
+    EXPECT_EQ((Result<void, int>{Error{3}}.map([] { return 5; }).error()), 3);
+}
+
+TEST(Result, AndThen) {
+    EXPECT_EQ(*halve(8).and_then(halve), 2);
+    EXPECT_EQ(halve(12).and_then(halve).and_then(halve).error(), 3);
+    EXPECT_EQ(halve(3).and_then(halve).error(), 3);
+
+    Result<void, int> void_result;
+    auto chained = void_result.and_then([]() -> Result<int, int> { return 10; });
+    EXPECT_EQ(*chained, 10);
+}
+
+TEST(Result, OrElse) {
+    auto recover = [](int error) -> Result<int, std::string> {
+        if (error == 0) {
+            return 100;
+        }
+        return Error{std::to_string(error)};
+    };
+    EXPECT_EQ(*halve(4).or_else(recover), 2);
+    EXPECT_EQ((*Result<int, int>{Error{0}}.or_else(recover)), 100);
+    EXPECT_EQ((Result<int, int>{Error{5}}.or_else(recover).error()), "5");
+
+    Result<void, int> void_error{Error{1}};
+    EXPECT_TRUE(void_error.or_else([](int) -> Result<void, int> { return {}; }).has_value());
+}
+
+TEST(Result, TransformError) {
+    auto to_string = [](int error) { return std::to_string(error); };
+
+    auto error = halve(3).transform_error(to_string);
+    static_assert(std::is_same_v<decltype(error), Result<int, std::string>>);
+    EXPECT_EQ(error.error(), "3");
+    EXPECT_EQ(*halve(2).transform_error(to_string), 1);
+
+    Result<void, int> void_error{Error{7}};
+    EXPECT_EQ(void_error.transform_error(to_string).error(), "7");
+}
+
+TEST(Result, ValueOrElse) {
+    EXPECT_EQ(halve(4).value_or_else([](int) { return -1; }), 2);
+    EXPECT_EQ(halve(5).value_or_else([](int error) { return -error; }), -5);
+}
+
+TEST(Result, CombinatorsAreConstexpr) {
+    constexpr auto result = halve(8).and_then(halve).map([](int value) { return value + 1; });
+    static_assert(*result == 3);
+    static_assert(halve(3).transform_error([](int error) { return error * 10; }).error() == 30);
+    static_assert(halve(3).value_or_else([](int) { return 0; }) == 0);
+}
+
+TEST(Result, CombinatorsPropagateNoexcept) {
+    Result<int, int> result;
+    auto nothrow = [](int value) noexcept { return value; };
+    auto may_throw = [](int value) { return value; };
+    static_assert(noexcept(result.map(nothrow)));
+    static_assert(!noexcept(result.map(may_throw)));
+    static_assert(noexcept(result.transform_error(nothrow)));
+    static_assert(!noexcept(result.value_or_else(may_throw)));
+
+    // Copying the std::string out of an lvalue may throw, but moving it out of an rvalue can't.
+    Result<std::string, int> string_result;
+    auto recover = [](int) noexcept -> Result<std::string, int> { return Error{0}; };
+    static_assert(!noexcept(string_result.or_else(recover)));
+    static_assert(noexcept(std::move(string_result).or_else(recover)));
+}
+
+TEST(Result, CombinatorsMoveRvalues) {
+    int copies = 0;
+    Result<CopyCounter, int> result{CopyCounter{copies}};
+    auto chained = std::move(result)
+                       .map([](CopyCounter&& counter) { return std::move(counter); })
+                       .and_then([](CopyCounter&& counter) -> Result<CopyCounter, int> {
+                           return std::move(counter);
+                       })
+                       .or_else([](int) -> Result<CopyCounter, int> { return Error{0}; })
+                       .transform_error([](int error) { return error; });
+    EXPECT_TRUE(chained.has_value());
+    EXPECT_EQ(copies, 0);
+
+    // Lvalues are passed by reference, and only copied if the function copies them.
+    auto by_reference = chained.map([](CopyCounter& counter) { return counter.copies_; });
+    EXPECT_EQ(*by_reference, &copies);
+    EXPECT_EQ(copies, 0);
+    auto by_value = chained.map([](CopyCounter counter) { return counter.copies_; });
+    EXPECT_EQ(*by_value, &copies);
+    EXPECT_EQ(copies, 1);
+}
+
+namespace {
+Result<int, int> quarter(int value) {
+    DGA_TRY_ASSIGN(int half, halve(value));
+    return halve(half);
+}
+
+Result<void, std::string> checkQuarter(int value, int& output) {
+    DGA_TRY_ASSIGN(output, quarter(value).transform_error([](int e) { return std::to_string(e); }));
+    return {};
+}
+
+Result<int, std::string> checkTwice(int value) {
+    int output = 0;
+    DGA_TRY(checkQuarter(value, output));
+    DGA_TRY(checkQuarter(output * 4, output));
+    return output;
+}
+}  // namespace
+
+TEST(Result, Try) {
+    EXPECT_EQ(*quarter(12), 3);
+    EXPECT_EQ(quarter(6).error(), 3);
+    EXPECT_EQ(quarter(5).error(), 5);
+
+    int output = 0;
+    EXPECT_TRUE(checkQuarter(8, output).has_value());
+    EXPECT_EQ(output, 2);
+    EXPECT_EQ(checkQuarter(2, output).error(), "1");
+    EXPECT_EQ(output, 2);
+
+    EXPECT_EQ(*checkTwice(16), 4);
+    EXPECT_EQ(checkTwice(7).error(), "7");
+}
+
+TEST(Result, TryMovesValue) {
+    auto make = []() -> Result<std::unique_ptr<int>, int> { return std::make_unique<int>(5); };
+    auto use = [&]() -> Result<int, int> {
+        DGA_TRY_ASSIGN(auto pointer, make());
+        return *pointer;
+    };
+    EXPECT_EQ(*use(), 5);
+}
@@ -0,0 +1,50 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+// DGA_NO_EXCEPTIONS is defined manually, but this test is compiled with exceptions enabled, so
+// guards must still run during stack unwinding.
+#define DGA_NO_EXCEPTIONS
+
+#include <gtest/gtest.h>
+#include <dga/scope.h>
+
+#ifndef DGA_HAS_EXCEPTIONS
+#error DGA_HAS_EXCEPTIONS should be defined when compiling with exceptions.
+#endif
+
+namespace {
+struct Callback {
+    void operator()() noexcept {
+        (*calls)++;
+    }
+
+    int* calls;
+};
+}  // namespace
+
+TEST(ScopeFailExceptionsOverride, CalledDuringUnwinding) {
+    int calls = 0;
+    try {
+        auto guard = dga::ScopeFail{Callback{&calls}};
+        throw 42;
+    } catch (int) {
+    }
+    EXPECT_EQ(calls, 1);
+    {
+        auto guard = dga::ScopeFail{Callback{&calls}};
+    }
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(ScopeSuccessExceptionsOverride, NotCalledDuringUnwinding) {
+    int calls = 0;
+    try {
+        auto guard = dga::ScopeSuccess{Callback{&calls}};
+        throw 42;
+    } catch (int) {
+    }
+    EXPECT_EQ(calls, 0);
+    {
+        auto guard = dga::ScopeSuccess{Callback{&calls}};
+    }
+    EXPECT_EQ(calls, 1);
+}
@@ -0,0 +1,78 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <gtest/gtest.h>
+#include <dga/scope.h>
+
+// This test is compiled with exceptions disabled.
+#ifndef DGA_NO_EXCEPTIONS
+#error DGA_NO_EXCEPTIONS should be defined when compiling without exceptions.
+#endif
+
+namespace {
+struct Callback {
+    void operator()() noexcept {
+        (*calls)++;
+    }
+
+    int* calls;
+};
+}  // namespace
+
+// Without exceptions, ScopeSuccess needs no more state than ScopeExit.
+static_assert(sizeof(dga::ScopeSuccess<Callback>) == sizeof(dga::ScopeExit<Callback>));
+
+TEST(ScopeFailNoExceptions, NeverCalled) {
+    int calls = 0;
+    {
+        auto guard = dga::ScopeFail{Callback{&calls}};
+    }
+    EXPECT_EQ(calls, 0);
+}
+
+TEST(ScopeFailNoExceptions, MoveConstructor) {
+    int calls = 0;
+    {
+        auto guard1 = dga::ScopeFail{Callback{&calls}};
+        auto guard2 = dga::ScopeFail{std::move(guard1)};
+    }
+    EXPECT_EQ(calls, 0);
+}
+
+TEST(ScopeSuccessNoExceptions, EndOfScope) {
+    int calls = 0;
+    {
+        auto guard = dga::ScopeSuccess{Callback{&calls}};
+    }
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(ScopeSuccessNoExceptions, Release) {
+    int calls = 0;
+    {
+        auto guard = dga::ScopeSuccess{Callback{&calls}};
+        guard.release();
+    }
+    EXPECT_EQ(calls, 0);
+}
+
+TEST(ScopeSuccessNoExceptions, LvalueFunction) {
+    int calls = 0;
+    {
+        Callback callback{&calls};
+        auto guard = dga::ScopeSuccess{callback};
+    }
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(ScopeRollbackNoExceptions, Commit) {
+    int calls = 0;
+    {
+        auto guard = dga::ScopeRollback{Callback{&calls}};
+    }
+    EXPECT_EQ(calls, 1);
+    {
+        auto guard = dga::ScopeRollback{Callback{&calls}};
+        guard.commit();
+    }
+    EXPECT_EQ(calls, 1);
+}
@@ -3,6 +3,9 @@
 #include <gtest/gtest.h>
 #include <dga/scope.h>
 
+#include <functional>
+#include <vector>
+
 namespace {
 class ThrowOnCopy {
 public:
@@ -18,6 +21,18 @@ public:
 
     int calls = 0;
 };
+
+struct ThrowingDeleter {
+    ThrowingDeleter(int* calls) : calls(calls) {
+    }
+    ThrowingDeleter(const ThrowingDeleter&) {
+        throw 42;
+    }
+    void operator()(int) const {
+        (*calls)++;
+    }
+    int* calls;
+};
 }  // namespace
 
 TEST(ScopeExit, EndOfScope) {
@@ -156,3 +171,158 @@ TEST(ScopeSuccess, DoesntCallFunctionWhenFunctionCopyThrows) {
     EXPECT_TRUE(exception_thrown);
     EXPECT_EQ(f.calls, 0);
 }
+
+TEST(ScopeRollback, EndOfScope) {
+    int calls = 0;
+    {
+        auto guard = dga::ScopeRollback{[&] { calls++; }};
+    }
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(ScopeRollback, Commit) {
+    int calls = 0;
+    {
+        auto guard = dga::ScopeRollback{[&] { calls++; }};
+        guard.commit();
+    }
+    EXPECT_EQ(calls, 0);
+}
+
+TEST(ScopeRollback, CalledOnThrow) {
+    int calls = 0;
+    try {
+        auto guard = dga::ScopeRollback{[&] { calls++; }};
+        throw 42;
+    } catch (...) {
+        // empty handler.
+    }
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(ScopeRollback, CalledOnEarlyReturn) {
+    int calls = 0;
+    auto transaction = [&](bool fail) {
+        auto guard = dga::ScopeRollback{[&] { calls++; }};
+        if (fail) {
+            return false;
+        }
+        guard.commit();
+        return true;
+    };
+    EXPECT_TRUE(transaction(false));
+    EXPECT_EQ(calls, 0);
+    EXPECT_FALSE(transaction(true));
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(ScopeRollback, MoveConstructor) {
+    int calls = 0;
+    {
+        auto guard1 = dga::ScopeRollback{[&] { calls++; }};
+        auto guard2 = dga::ScopeRollback{std::move(guard1)};
+    }
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(UniqueResource, DeletesOnDestruction) {
+    std::vector<int> deleted;
+    {
+        auto resource = dga::UniqueResource{1, [&](int r) { deleted.push_back(r); }};
+        EXPECT_TRUE(resource.owns());
+        EXPECT_EQ(resource.get(), 1);
+    }
+    EXPECT_EQ(deleted, std::vector<int>{1});
+}
+
+TEST(UniqueResource, Release) {
+    std::vector<int> deleted;
+    {
+        auto resource = dga::UniqueResource{1, [&](int r) { deleted.push_back(r); }};
+        resource.release();
+        EXPECT_FALSE(resource.owns());
+    }
+    EXPECT_TRUE(deleted.empty());
+}
+
+TEST(UniqueResource, Reset) {
+    std::vector<int> deleted;
+    {
+        auto resource = dga::UniqueResource{1, [&](int r) { deleted.push_back(r); }};
+        resource.reset(2);
+        EXPECT_EQ(deleted, std::vector<int>{1});
+        EXPECT_EQ(resource.get(), 2);
+        resource.reset();
+        EXPECT_EQ(deleted, (std::vector<int>{1, 2}));
+        EXPECT_FALSE(resource.owns());
+    }
+    EXPECT_EQ(deleted, (std::vector<int>{1, 2}));
+}
+
+TEST(UniqueResource, MoveConstructorAndAssignment) {
+    // Lambdas aren't assignable, so move assignment needs a different deleter type.
+    using Resource = dga::UniqueResource<int, std::function<void(int)>>;
+    std::vector<int> deleted;
+    auto deleter = [&](int r) { deleted.push_back(r); };
+    {
+        auto resource1 = Resource{1, deleter};
+        auto resource2 = Resource{std::move(resource1)};
+        EXPECT_FALSE(resource1.owns());
+        EXPECT_TRUE(resource2.owns());
+
+        auto resource3 = Resource{3, deleter};
+        resource3 = std::move(resource2);
+        EXPECT_EQ(deleted, std::vector<int>{3});
+        EXPECT_EQ(resource3.get(), 1);
+    }
+    EXPECT_EQ(deleted, (std::vector<int>{3, 1}));
+}
+
+TEST(UniqueResource, PointerAccess) {
+    struct Object {
+        int value;
+    };
+    int deleted = 0;
+    {
+        Object object{42};
+        auto resource = dga::UniqueResource{&object, [&](Object*) { deleted++; }};
+        EXPECT_EQ((*resource).value, 42);
+        EXPECT_EQ(resource->value, 42);
+    }
+    EXPECT_EQ(deleted, 1);
+}
+
+TEST(UniqueResource, MakeChecked) {
+    int deleted = 0;
+    auto deleter = [&](int) { deleted++; };
+    {
+        auto invalid = dga::makeUniqueResourceChecked(-1, -1, deleter);
+        EXPECT_FALSE(invalid.owns());
+        auto valid = dga::makeUniqueResourceChecked(3, -1, deleter);
+        EXPECT_TRUE(valid.owns());
+    }
+    EXPECT_EQ(deleted, 1);
+}
+
+TEST(UniqueResource, DeletesWhenDeleterCopyThrows) {
+    int calls = 0;
+    ThrowingDeleter deleter{&calls};
+    bool exception_thrown = false;
+    try {
+        dga::UniqueResource<int, ThrowingDeleter> resource{1, deleter};
+    } catch (...) {
+        exception_thrown = true;
+    }
+    EXPECT_TRUE(exception_thrown);
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(UniqueResource, MakeCheckedWhenDeleterCopyThrows) {
+    int calls = 0;
+    ThrowingDeleter deleter{&calls};
+    // The deleter must not be called with the invalid value.
+    EXPECT_THROW(dga::makeUniqueResourceChecked(-1, -1, deleter), int);
+    EXPECT_EQ(calls, 0);
+    EXPECT_THROW(dga::makeUniqueResourceChecked(3, -1, deleter), int);
+    EXPECT_EQ(calls, 1);
+}
@@ -0,0 +1,97 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <gtest/gtest.h>
+#include <dga/semaphore.h>
+
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+template <typename T> class SemaphoreTest : public testing::Test {};
+
+using SemaphoreTypes = testing::Types<dga::Semaphore, dga::LightweightSemaphore>;
+TYPED_TEST_SUITE(SemaphoreTest, SemaphoreTypes);
+
+TYPED_TEST(SemaphoreTest, TryWait) {
+    TypeParam semaphore{1};
+    EXPECT_TRUE(semaphore.try_wait());
+    EXPECT_FALSE(semaphore.try_wait());
+    semaphore.notify();
+    EXPECT_TRUE(semaphore.try_wait());
+}
+
+TYPED_TEST(SemaphoreTest, WaitFor) {
+    TypeParam semaphore;
+    EXPECT_FALSE(semaphore.wait_for(1ms));
+    semaphore.notify();
+    EXPECT_TRUE(semaphore.wait_for(1ms));
+}
+
+TYPED_TEST(SemaphoreTest, WaitUntil) {
+    TypeParam semaphore;
+    EXPECT_FALSE(semaphore.wait_until(std::chrono::steady_clock::now() + 1ms));
+    semaphore.notify();
+    EXPECT_TRUE(semaphore.wait_until(std::chrono::system_clock::now() + 1ms));
+}
+
+TYPED_TEST(SemaphoreTest, WaitForNotifyFromOtherThread) {
+    TypeParam semaphore;
+    std::thread thread{[&] {
+        std::this_thread::sleep_for(10ms);
+        semaphore.notify();
+    }};
+    EXPECT_TRUE(semaphore.wait_for(10s));
+    thread.join();
+}
+
+TYPED_TEST(SemaphoreTest, Batch) {
+    TypeParam semaphore;
+    semaphore.notify(3);
+    semaphore.wait(2);
+    EXPECT_TRUE(semaphore.try_wait());
+    EXPECT_FALSE(semaphore.try_wait());
+
+    std::thread thread{[&] {
+        for (int i = 0; i < 4; ++i) {
+            std::this_thread::sleep_for(1ms);
+            semaphore.notify();
+        }
+    }};
+    semaphore.wait(4);
+    thread.join();
+    EXPECT_FALSE(semaphore.try_wait());
+}
+
+TYPED_TEST(SemaphoreTest, ProducerConsumer) {
+    constexpr int kThreads = 4;
+    constexpr int kItemsPerThread = 10000;
+
+    TypeParam semaphore;
+    std::atomic<int> consumed{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&] {
+            for (int j = 0; j < kItemsPerThread; ++j) {
+                semaphore.wait();
+                consumed++;
+            }
+        });
+    }
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&] {
+            for (int j = 0; j < kItemsPerThread; ++j) {
+                if (j % 2 == 0) {
+                    semaphore.notify();
+                } else {
+                    semaphore.notify(1);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(consumed, kThreads * kItemsPerThread);
+    EXPECT_FALSE(semaphore.try_wait());
+}
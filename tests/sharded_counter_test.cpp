@@ -0,0 +1,90 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <gtest/gtest.h>
+#include <dga/sharded_counter.h>
+
+#include <thread>
+#include <vector>
+
+using dga::u64;
+
+TEST(ShardedCounter, ShardCount) {
+    EXPECT_GE(dga::ShardedCounter{}.shardCount(), 1u);
+    EXPECT_EQ(dga::ShardedCounter{0}.shardCount(), 1u);
+    EXPECT_EQ(dga::ShardedCounter{5}.shardCount(), 8u);
+    EXPECT_EQ(dga::ShardedCounter{100000}.shardCount(), dga::ShardedCounter::kMaxShardCount);
+}
+
+TEST(ShardedCounter, AddAndLoad) {
+    dga::ShardedCounter counter{4};
+    EXPECT_EQ(counter.load(), 0u);
+    counter.add();
+    counter.add(10);
+    EXPECT_EQ(counter.load(), 11u);
+    EXPECT_EQ(counter.reset(), 11u);
+    EXPECT_EQ(counter.load(), 0u);
+}
+
+TEST(ShardedCounter, Threads) {
+    constexpr int kThreads = 8;
+    constexpr int kIncrements = 10000;
+    dga::ShardedCounter counter{4};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&] {
+            for (int j = 0; j < kIncrements; ++j) {
+                counter.add();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(counter.load(), u64(kThreads) * kIncrements);
+}
+
+TEST(ShardedCounter, ResetDuringUpdatesLosesNothing) {
+    constexpr int kIncrements = 100000;
+    dga::ShardedCounter counter{2};
+    std::thread writer{[&] {
+        for (int i = 0; i < kIncrements; ++i) {
+            counter.add();
+        }
+    }};
+    u64 total = 0;
+    for (int i = 0; i < 100; ++i) {
+        total += counter.reset();
+    }
+    writer.join();
+    total += counter.reset();
+    EXPECT_EQ(total, u64(kIncrements));
+}
+
+TEST(ShardedGauge, AddAndSub) {
+    dga::ShardedGauge gauge{4};
+    gauge.add(5);
+    gauge.sub();
+    EXPECT_EQ(gauge.load(), 4);
+    gauge.sub(10);
+    EXPECT_EQ(gauge.load(), -6);
+    EXPECT_EQ(gauge.reset(), -6);
+    EXPECT_EQ(gauge.load(), 0);
+}
+
+TEST(ShardedGauge, IncrementAndDecrementOnDifferentThreads) {
+    constexpr int kIterations = 10000;
+    dga::ShardedGauge in_flight{4};
+    std::thread up{[&] {
+        for (int i = 0; i < kIterations; ++i) {
+            in_flight.add();
+        }
+    }};
+    std::thread down{[&] {
+        for (int i = 0; i < kIterations; ++i) {
+            in_flight.sub();
+        }
+    }};
+    up.join();
+    down.join();
+    EXPECT_EQ(in_flight.load(), 0);
+}
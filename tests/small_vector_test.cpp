@@ -0,0 +1,223 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <gtest/gtest.h>
+#include <dga/arena.h>
+#include <dga/small_vector.h>
+#include <dga/string_algorithms.h>
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+// An allocator that counts the number of allocations it has made.
+template <typename T> struct CountingAllocator {
+    using value_type = T;
+
+    static inline int allocations = 0;
+
+    CountingAllocator() noexcept = default;
+
+    template <typename U> CountingAllocator(const CountingAllocator<U>&) noexcept {
+    }
+
+    T* allocate(std::size_t n) {
+        ++allocations;
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        std::allocator<T>{}.deallocate(p, n);
+    }
+
+    template <typename U> bool operator==(const CountingAllocator<U>&) const noexcept {
+        return true;
+    }
+
+    template <typename U> bool operator!=(const CountingAllocator<U>&) const noexcept {
+        return false;
+    }
+};
+
+// A type that is relocatable, but not trivially copyable.
+struct Relocatable {
+    std::unique_ptr<int> value;
+};
+}  // namespace
+
+template <> struct dga::is_trivially_relocatable<Relocatable> : std::true_type {};
+
+TEST(SmallVector, InlineUntilFull) {
+    dga::SmallVector<int, 4> v;
+    EXPECT_TRUE(v.empty());
+    EXPECT_TRUE(v.isInline());
+    EXPECT_EQ(v.capacity(), 4);
+    for (int i = 0; i < 4; ++i) {
+        v.push_back(i);
+    }
+    EXPECT_TRUE(v.isInline());
+    v.push_back(4);
+    EXPECT_FALSE(v.isInline());
+    EXPECT_GE(v.capacity(), 5);
+    EXPECT_EQ(v.size(), 5);
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(v[i], i);
+    }
+    EXPECT_EQ(v.front(), 0);
+    EXPECT_EQ(v.back(), 4);
+    EXPECT_EQ(v.at(2), 2);
+    EXPECT_THROW(v.at(5), std::out_of_range);
+}
+
+TEST(SmallVector, StrSplitAllocatesNothing) {
+    using Vector = dga::SmallVector<std::string_view, 8, CountingAllocator<std::string_view>>;
+    CountingAllocator<std::string_view>::allocations = 0;
+    Vector tokens;
+    dga::strSplit("GET /index.html HTTP/1.1", ' ', std::back_inserter(tokens));
+    ASSERT_EQ(tokens.size(), 3);
+    EXPECT_EQ(tokens[1], "/index.html");
+    EXPECT_EQ(CountingAllocator<std::string_view>::allocations, 0);
+
+    dga::strSplit("a b c d e f g h i", ' ', std::back_inserter(tokens));
+    EXPECT_EQ(tokens.size(), 12);
+    EXPECT_EQ(tokens.back(), "i");
+    EXPECT_EQ(CountingAllocator<std::string_view>::allocations, 1);
+}
+
+TEST(SmallVector, NonTrivialElements) {
+    auto counter = std::make_shared<int>(0);
+    {
+        dga::SmallVector<std::shared_ptr<int>, 2> v;
+        for (int i = 0; i < 10; ++i) {
+            v.emplace_back(counter);
+        }
+        EXPECT_EQ(counter.use_count(), 11);
+        v.pop_back();
+        EXPECT_EQ(counter.use_count(), 10);
+        v.erase(v.begin(), v.begin() + 3);
+        EXPECT_EQ(counter.use_count(), 7);
+        EXPECT_EQ(v.size(), 6);
+    }
+    EXPECT_EQ(counter.use_count(), 1);
+
+    dga::SmallVector<std::string, 2> strings{"a", "b", "c"};
+    strings.insert(strings.begin() + 1, "x");
+    EXPECT_EQ(strings, (dga::SmallVector<std::string, 2>{"a", "x", "b", "c"}));
+}
+
+TEST(SmallVector, RelocatableTypes) {
+    dga::SmallVector<Relocatable, 2> v;
+    for (int i = 0; i < 10; ++i) {
+        v.push_back(Relocatable{std::make_unique<int>(i)});
+    }
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(*v[i].value, i);
+    }
+    v.shrink_to_fit();
+    EXPECT_EQ(v.capacity(), 10);
+    v.resize(2);
+    v.shrink_to_fit();
+    EXPECT_TRUE(v.isInline());
+    EXPECT_EQ(*v[1].value, 1);
+}
+
+TEST(SmallVector, PushBackOwnElement) {
+    dga::SmallVector<std::string, 2> v{"a long string that is not stored inline", "b"};
+    v.push_back(v[0]);
+    EXPECT_EQ(v[2], "a long string that is not stored inline");
+    v.insert(v.begin(), 3, v[1]);
+    EXPECT_EQ(v.size(), 6);
+    EXPECT_EQ(v[0], "b");
+    EXPECT_EQ(v[2], "b");
+    EXPECT_EQ(v[3], "a long string that is not stored inline");
+}
+
+TEST(SmallVector, AssignOwnElement) {
+    const std::string a = "a long string that is not stored inline";
+    const std::string b = "another long string that is not stored inline";
+    dga::SmallVector<std::string, 2> v{"x", a};
+    // Fewer elements than before.
+    v.assign(1, v[1]);
+    EXPECT_EQ(v, (dga::SmallVector<std::string, 2>{a}));
+    // More elements, within the capacity.
+    v[0] = b;
+    v.assign(2, v[0]);
+    EXPECT_EQ(v, (dga::SmallVector<std::string, 2>{b, b}));
+    // More elements than the capacity.
+    v[1] = a;
+    v.assign(5, v[1]);
+    EXPECT_EQ(v.size(), 5);
+    EXPECT_TRUE(std::all_of(v.begin(), v.end(), [&](const std::string& s) { return s == a; }));
+}
+
+TEST(SmallVector, InsertAndErase) {
+    dga::SmallVector<int, 4> v{1, 2, 3};
+    v.insert(v.begin(), 0);
+    v.insert(v.end(), {4, 5, 6});
+    std::vector<int> more{7, 8};
+    v.insert(v.end(), more.begin(), more.end());
+    EXPECT_EQ(v, (dga::SmallVector<int, 4>{0, 1, 2, 3, 4, 5, 6, 7, 8}));
+    v.erase(v.begin() + 1);
+    v.erase(v.end() - 2, v.end());
+    EXPECT_EQ(v, (dga::SmallVector<int, 4>{0, 2, 3, 4, 5, 6}));
+    v.resize(8, 9);
+    EXPECT_EQ(v.back(), 9);
+    v.resize(1);
+    EXPECT_EQ(v.size(), 1);
+    v.clear();
+    EXPECT_TRUE(v.empty());
+}
+
+TEST(SmallVector, CopyMoveAndSwap) {
+    dga::SmallVector<std::string, 2> small{"a"};
+    dga::SmallVector<std::string, 2> large{"b", "c", "d"};
+    auto small_copy = small;
+    auto large_copy = large;
+    EXPECT_EQ(small_copy, small);
+    EXPECT_EQ(large_copy, large);
+
+    // Moving a heap allocated vector steals its buffer.
+    const std::string* large_data = large.data();
+    auto moved = std::move(large);
+    EXPECT_EQ(moved.data(), large_data);
+    EXPECT_TRUE(large.empty());  // NOLINT(bugprone-use-after-move)
+    EXPECT_TRUE(large.isInline());
+
+    auto moved_small = std::move(small);
+    EXPECT_EQ(moved_small, small_copy);
+
+    swap(moved, moved_small);
+    EXPECT_EQ(moved, small_copy);
+    EXPECT_EQ(moved_small, large_copy);
+    EXPECT_TRUE(moved.isInline());
+    EXPECT_FALSE(moved_small.isInline());
+
+    dga::SmallVector<std::string, 2> other{"x", "y"};
+    other.swap(moved);
+    EXPECT_EQ(other, small_copy);
+    EXPECT_EQ(moved, (dga::SmallVector<std::string, 2>{"x", "y"}));
+
+    other = large_copy;
+    EXPECT_EQ(other, large_copy);
+    other = std::move(moved);
+    EXPECT_EQ(other.size(), 2);
+    EXPECT_LT(large_copy, other);
+}
+
+TEST(SmallVector, Arena) {
+    dga::Arena arena;
+    {
+        auto rewind = arena.scopedRewind();
+        dga::ArenaSmallVector<std::string_view, 4> tokens{arena};
+        dga::strSplit("a,b,c", ',', std::back_inserter(tokens));
+        EXPECT_EQ(arena.bytesUsed(), 0);
+        dga::strSplit("d,e,f", ',', std::back_inserter(tokens));
+        EXPECT_GT(arena.bytesUsed(), 0);
+        EXPECT_EQ(tokens.size(), 6);
+        EXPECT_EQ(tokens[5], "f");
+    }
+    EXPECT_EQ(arena.bytesUsed(), 0);
+}
@@ -31,6 +31,85 @@ TEST(StrSplit, SplitMultipleDelim) {
     EXPECT_THAT(strings, ElementsAre("100", "", "200"));
 }
 
+TEST(StrSplit, SplitToStringViews) {
+    std::string input = "100-200-300";
+    std::vector<std::string_view> strings;
+    dga::strSplit(input, '-', std::back_inserter(strings));
+    EXPECT_THAT(strings, ElementsAre("100", "200", "300"));
+
+    // Tokens should point into the original buffer.
+    ASSERT_EQ(strings.size(), 3);
+    EXPECT_EQ(strings[0].data(), input.data());
+    EXPECT_EQ(strings[2].data(), input.data() + 8);
+}
+
+TEST(StrSplit, SplitLongInput) {
+    // Exercise the block-at-a-time scan with delimiters on and around block boundaries.
+    std::string input;
+    std::vector<std::string> expected;
+    for (int i = 0; i < 40; ++i) {
+        expected.emplace_back(std::string(std::size_t(i % 7), char('a' + i % 26)));
+        input += expected.back();
+        input += '-';
+    }
+    input += "end";
+    expected.emplace_back("end");
+
+    std::vector<std::string_view> strings;
+    dga::strSplit(input, '-', std::back_inserter(strings));
+    EXPECT_THAT(strings, testing::ElementsAreArray(expected));
+}
+
+TEST(StrSplitAny, Split) {
+    std::vector<std::string_view> strings;
+    dga::strSplitAny("100-200,300;;400-", ",;-", std::back_inserter(strings));
+    EXPECT_THAT(strings, ElementsAre("100", "200", "300", "", "400"));
+}
+
+TEST(StrSplitAny, NoDelims) {
+    std::vector<std::string_view> strings;
+    dga::strSplitAny("100-200", "", std::back_inserter(strings));
+    EXPECT_THAT(strings, ElementsAre("100-200"));
+}
+
+TEST(StrSplitAny, ManyDelims) {
+    // More delimiters than can be compared in a single block.
+    std::string input = "a0b1c2d3e4f5g6h7i8j9k";
+    std::vector<std::string_view> strings;
+    dga::strSplitAny(input, "0123456789", std::back_inserter(strings));
+    EXPECT_THAT(strings, ElementsAre("a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k"));
+}
+
+TEST(StrCount, Count) {
+    EXPECT_EQ(dga::strCount("", '-'), 0);
+    EXPECT_EQ(dga::strCount("100-200", '-'), 1);
+    EXPECT_EQ(dga::strCount("---", '-'), 3);
+
+    std::string input(1000, 'a');
+    for (std::size_t i = 0; i < input.size(); i += 3) {
+        input[i] = '-';
+    }
+    EXPECT_EQ(dga::strCount(input, '-'), 334);
+}
+
+TEST(StrSplitRange, Empty) {
+    auto range = dga::strSplitRange("", '-');
+    EXPECT_EQ(range.begin(), range.end());
+}
+
+TEST(StrSplitRange, MatchesStrSplit) {
+    for (std::string_view input : {"100-200", "-100-200-", "100--200", "-", "--", "100"}) {
+        std::vector<std::string_view> expected;
+        dga::strSplit(input, '-', std::back_inserter(expected));
+
+        std::vector<std::string_view> tokens;
+        for (std::string_view token : dga::strSplitRange(input, '-')) {
+            tokens.push_back(token);
+        }
+        EXPECT_EQ(tokens, expected) << "input: " << input;
+    }
+}
+
 TEST(StrJoin, Empty) {
     std::vector<std::string> strings;
     EXPECT_EQ(dga::strJoin(strings.begin(), strings.end(), "-"), "");
@@ -50,6 +129,42 @@ TEST(StrJoin, MultipleElements) {
     EXPECT_EQ(dga::strJoin(strings.begin(), strings.end(), "-"), "100-200-300");
 }
 
+TEST(StrJoin, StringViews) {
+    std::vector<std::string_view> strings{"100", "", "300"};
+    EXPECT_EQ(dga::strJoin(strings.begin(), strings.end(), ", "), "100, , 300");
+}
+
+TEST(StrJoin, CStrings) {
+    const char* strings[] = {"a", "b", "c"};
+    EXPECT_EQ(dga::strJoin(std::begin(strings), std::end(strings), "/"), "a/b/c");
+}
+
+TEST(StrJoin, NonStrings) {
+    std::vector<int> numbers{1, 2, 3};
+    EXPECT_EQ(dga::strJoin(numbers.begin(), numbers.end(), "-"), "1-2-3");
+}
+
+TEST(StrJoin, InputIterator) {
+    std::istringstream ss("100 200 300");
+    std::istream_iterator<std::string> first{ss};
+    std::istream_iterator<std::string> last;
+    EXPECT_EQ(dga::strJoin(first, last, "-"), "100-200-300");
+}
+
+TEST(StrJoin, AppendToOutput) {
+    std::vector<std::string> strings{"100", "200"};
+    std::string output = "prefix:";
+    dga::strJoin(output, strings.begin(), strings.end(), "-");
+    EXPECT_EQ(output, "prefix:100-200");
+
+    // Reusing the buffer shouldn't need to grow it again.
+    output.clear();
+    auto capacity = output.capacity();
+    dga::strJoin(output, strings.begin(), strings.end(), "-");
+    EXPECT_EQ(output, "100-200");
+    EXPECT_EQ(output.capacity(), capacity);
+}
+
 TEST(StrReplaceAll, Empty) {
     std::string input;
     EXPECT_EQ(dga::strReplaceAll(input, "a", "the"), input);
@@ -73,4 +188,233 @@ TEST(StrReplaceAll, MultipleMatches) {
 TEST(StrReplaceAll, ConsecutiveMatches) {
     std::string input = "aaaaa";
     EXPECT_EQ(dga::strReplaceAll(input, "a", "bb"), "bbbbbbbbbb");
-}
\ No newline at end of file
+}
+
+TEST(StrReplaceAll, EmptySearch) {
+    std::string input = "abc";
+    EXPECT_EQ(dga::strReplaceAll(input, "", "x"), input);
+}
+
+TEST(StrReplaceAll, ShrinkingAndGrowing) {
+    std::string input;
+    for (int i = 0; i < 1000; ++i) {
+        input += "{{x}}.";
+    }
+    std::string shrunk = dga::strReplaceAll(input, "{{x}}", "y");
+    EXPECT_EQ(shrunk.size(), 2000);
+    EXPECT_EQ(dga::strReplaceAll(shrunk, "y", "{{x}}"), input);
+}
+
+TEST(StrReplaceMany, Empty) {
+    EXPECT_EQ(dga::strReplaceMany("", {{"a", "b"}}), "");
+    EXPECT_EQ(dga::strReplaceMany("abc", {}), "abc");
+}
+
+TEST(StrReplaceMany, MultiplePatterns) {
+    EXPECT_EQ(dga::strReplaceMany("{name} is {age}", {{"{name}", "Bob"}, {"{age}", "42"}}),
+              "Bob is 42");
+}
+
+TEST(StrReplaceMany, ReplacementsAreNotRescanned) {
+    EXPECT_EQ(dga::strReplaceMany("ab", {{"a", "b"}, {"b", "a"}}), "ba");
+}
+
+TEST(StrReplaceMany, LeftmostLongest) {
+    // Leftmost match wins, even if a match that overlaps it ends earlier.
+    EXPECT_EQ(dga::strReplaceMany("abcd", {{"bc", "X"}, {"abcd", "Y"}}), "Y");
+    EXPECT_EQ(dga::strReplaceMany("xabcy", {{"bc", "X"}, {"abcd", "Y"}}), "xaXy");
+
+    // Longest match wins at the same position.
+    EXPECT_EQ(dga::strReplaceMany("abcd", {{"a", "1"}, {"ab", "2"}, {"abc", "3"}}), "3d");
+
+    // A match that is found while looking for a longer one is not lost.
+    EXPECT_EQ(dga::strReplaceMany("ab cd", {{"ab", "1"}, {"cd", "2"}, {"abxxxxxxxx", "3"}}),
+              "1 2");
+}
+
+TEST(StrReplaceMany, OverlappingMatches) {
+    EXPECT_EQ(dga::strReplaceMany("aaaaa", {{"aa", "b"}}), "bba");
+    EXPECT_EQ(dga::strReplaceMany("she sells", {{"he", "1"}, {"she", "2"}, {"hers", "3"}}),
+              "2 sells");
+}
+
+TEST(StrReplaceMany, ReuseTable) {
+    dga::StrReplaceTable table{{"&", "&amp;"}, {"<", "&lt;"}, {">", "&gt;"}};
+    EXPECT_EQ(dga::strReplaceMany("<a>", table), "&lt;a&gt;");
+    EXPECT_EQ(dga::strReplaceMany("a & b", table), "a &amp; b");
+}
+
+TEST(StrReplaceMany, MatchesStrReplaceAll) {
+    const char* patterns[] = {"a", "aa", "ab", "ba", "aba"};
+    const char* inputs[] = {"", "a", "aaa", "abababa", "babbaabaa", "xxaxxabxxbaxx"};
+    for (const char* pattern : patterns) {
+        for (const char* input : inputs) {
+            EXPECT_EQ(dga::strReplaceMany(input, {{pattern, "<>"}}),
+                      dga::strReplaceAll(input, pattern, "<>"))
+                << "pattern: " << pattern << ", input: " << input;
+        }
+    }
+}
+
+namespace {
+// Feeds 's' to 'splitter' 'chunk_size' bytes at a time, and returns every token.
+std::vector<std::string> splitStream(dga::StreamSplitter& splitter, std::string_view s,
+                                     std::size_t chunk_size) {
+    std::vector<std::string> tokens;
+    auto on_token = [&](std::string_view token) { tokens.emplace_back(token); };
+    for (std::size_t i = 0; i < s.size(); i += chunk_size) {
+        splitter.feed(s.substr(i, chunk_size), on_token);
+    }
+    splitter.finish(on_token);
+    return tokens;
+}
+}  // namespace
+
+TEST(StreamSplitter, SingleChunk) {
+    dga::StreamSplitter splitter{','};
+    EXPECT_THAT(splitStream(splitter, "a,b,,c,", 100), ElementsAre("a", "b", "", "c"));
+    EXPECT_THAT(splitStream(splitter, "", 100), IsEmpty());
+}
+
+TEST(StreamSplitter, TokensAcrossChunks) {
+    dga::StreamSplitter splitter{'\n'};
+    std::vector<std::string> tokens;
+    auto on_token = [&](std::string_view token) { tokens.emplace_back(token); };
+    splitter.feed("hel", on_token);
+    EXPECT_THAT(tokens, IsEmpty());
+    EXPECT_EQ(splitter.pending(), "hel");
+    splitter.feed("lo\nwor", on_token);
+    EXPECT_THAT(tokens, ElementsAre("hello"));
+    splitter.feed("", on_token);
+    splitter.feed("ld", on_token);
+    splitter.feed("\n", on_token);
+    EXPECT_THAT(tokens, ElementsAre("hello", "world"));
+    EXPECT_EQ(splitter.pending(), "");
+    splitter.finish(on_token);
+    EXPECT_THAT(tokens, ElementsAre("hello", "world"));
+}
+
+TEST(StreamSplitter, TokensInsideChunkAreNotCopied) {
+    dga::StreamSplitter splitter{' '};
+    std::string_view chunk = "one two three";
+    std::vector<std::string_view> views;
+    splitter.feed(chunk, [&](std::string_view token) { views.push_back(token); });
+    ASSERT_THAT(views, ElementsAre("one", "two"));
+    EXPECT_EQ(views[0].data(), chunk.data());
+    EXPECT_EQ(views[1].data(), chunk.data() + 4);
+    EXPECT_EQ(splitter.pending(), "three");
+}
+
+TEST(StreamSplitter, MatchesStrSplitForAnyChunkSize) {
+    std::string input;
+    for (int i = 0; i < 50; ++i) {
+        input += std::string(std::size_t(i % 7), char('a' + i % 26));
+        input += (i % 3 == 0) ? ";" : ",";
+    }
+    input += "tail";
+    std::vector<std::string> expected;
+    dga::strSplitAny(input, ",;", std::back_inserter(expected));
+    for (std::size_t chunk_size : {1, 2, 3, 7, 16, 31, 32, 33, 64, 1000}) {
+        dga::StreamSplitter splitter{std::string_view{",;"}};
+        EXPECT_EQ(splitStream(splitter, input, chunk_size), expected) << chunk_size;
+    }
+}
+
+TEST(StreamSplitter, Reset) {
+    dga::StreamSplitter splitter{','};
+    std::vector<std::string> tokens;
+    auto on_token = [&](std::string_view token) { tokens.emplace_back(token); };
+    splitter.feed("a,partial", on_token);
+    splitter.reset();
+    splitter.feed("b,", on_token);
+    splitter.finish(on_token);
+    EXPECT_THAT(tokens, ElementsAre("a", "b"));
+}
+
+TEST(StrTrim, Trim) {
+    EXPECT_EQ(dga::strTrim(""), "");
+    EXPECT_EQ(dga::strTrim(" \t\n\v\f\r"), "");
+    EXPECT_EQ(dga::strTrim("  a b  "), "a b");
+    EXPECT_EQ(dga::strTrimLeft("  a b  "), "a b  ");
+    EXPECT_EQ(dga::strTrimRight("  a b  "), "  a b");
+    EXPECT_EQ(dga::strTrim("\xA0x\xA0"), "\xA0x\xA0");
+}
+
+TEST(StrCase, ToLowerAndUpper) {
+    // Long enough to exercise the SIMD loop, followed by a scalar tail.
+    const std::string mixed = "Content-Type: TEXT/html; Charset=UTF-8 [@`{] \xC3\x89t\xC3\xA9";
+    EXPECT_EQ(dga::strToLowerAscii(mixed),
+              "content-type: text/html; charset=utf-8 [@`{] \xC3\x89t\xC3\xA9");
+    EXPECT_EQ(dga::strToUpperAscii(mixed),
+              "CONTENT-TYPE: TEXT/HTML; CHARSET=UTF-8 [@`{] \xC3\x89T\xC3\xA9");
+    std::string in_place = mixed;
+    dga::strToLowerAsciiInPlace(in_place);
+    EXPECT_EQ(in_place, dga::strToLowerAscii(mixed));
+    dga::strToUpperAsciiInPlace(in_place);
+    EXPECT_EQ(in_place, dga::strToUpperAscii(mixed));
+}
+
+TEST(StrCase, MatchesScalarForAllBytes) {
+    std::string all;
+    for (int repeat = 0; repeat < 3; ++repeat) {
+        for (int c = 0; c < 256; ++c) {
+            all += static_cast<char>(c);
+        }
+    }
+    const std::string lower = dga::strToLowerAscii(all);
+    const std::string upper = dga::strToUpperAscii(all);
+    ASSERT_EQ(lower.size(), all.size());
+    for (std::size_t i = 0; i < all.size(); ++i) {
+        const char c = all[i];
+        EXPECT_EQ(lower[i], (c >= 'A' && c <= 'Z') ? char(c + 32) : c) << i;
+        EXPECT_EQ(upper[i], (c >= 'a' && c <= 'z') ? char(c - 32) : c) << i;
+    }
+    EXPECT_TRUE(dga::strEqualsIgnoreCase(lower, upper));
+}
+
+TEST(StrCase, EqualsIgnoreCase) {
+    EXPECT_TRUE(dga::strEqualsIgnoreCase("", ""));
+    EXPECT_TRUE(dga::strEqualsIgnoreCase("Content-Length", "content-LENGTH"));
+    EXPECT_FALSE(dga::strEqualsIgnoreCase("Content-Length", "Content-Lengt"));
+    EXPECT_FALSE(dga::strEqualsIgnoreCase("[", "{"));
+    EXPECT_FALSE(dga::strEqualsIgnoreCase("@", "`"));
+    const std::string a = "X-Forwarded-For-Some-Very-Long-Header-Name";
+    std::string b = dga::strToUpperAscii(a);
+    EXPECT_TRUE(dga::strEqualsIgnoreCase(a, b));
+    b[20] = '_';
+    EXPECT_FALSE(dga::strEqualsIgnoreCase(a, b));
+}
+
+TEST(StrAffix, StartsAndEndsWith) {
+    EXPECT_TRUE(dga::strStartsWith("hello", ""));
+    EXPECT_TRUE(dga::strStartsWith("hello", "he"));
+    EXPECT_FALSE(dga::strStartsWith("hello", "hello!"));
+    EXPECT_FALSE(dga::strStartsWith("hello", "He"));
+    EXPECT_TRUE(dga::strEndsWith("hello", "llo"));
+    EXPECT_FALSE(dga::strEndsWith("hello", "LLO"));
+    EXPECT_FALSE(dga::strEndsWith("lo", "hello"));
+    EXPECT_TRUE(dga::strStartsWithIgnoreCase("Hello", "hE"));
+    EXPECT_TRUE(dga::strEndsWithIgnoreCase("Hello", "LLO"));
+    EXPECT_FALSE(dga::strEndsWithIgnoreCase("lo", "hello"));
+    static_assert(dga::strStartsWith("constexpr", "const"));
+    static_assert(dga::strTrim("  constexpr ") == "constexpr");
+}
+
+TEST(StrFindIgnoreCase, Find) {
+    EXPECT_EQ(dga::strFindIgnoreCase("", ""), 0u);
+    EXPECT_EQ(dga::strFindIgnoreCase("abc", ""), 0u);
+    EXPECT_EQ(dga::strFindIgnoreCase("abc", "", 3), 3u);
+    EXPECT_EQ(dga::strFindIgnoreCase("abc", "", 4), std::string_view::npos);
+    EXPECT_EQ(dga::strFindIgnoreCase("abc", "abcd"), std::string_view::npos);
+    EXPECT_EQ(dga::strFindIgnoreCase("Hello World", "WORLD"), 6u);
+    EXPECT_EQ(dga::strFindIgnoreCase("Hello World", "o"), 4u);
+    EXPECT_EQ(dga::strFindIgnoreCase("Hello World", "O", 5), 7u);
+    EXPECT_EQ(dga::strFindIgnoreCase("Hello World", "xyz"), std::string_view::npos);
+    EXPECT_EQ(dga::strFindIgnoreCase("1+1=2", "=2"), 3u);
+
+    std::string haystack(100, 'a');
+    haystack += "KeepAlive";
+    EXPECT_EQ(dga::strFindIgnoreCase(haystack, "keep-alive"), std::string_view::npos);
+    EXPECT_EQ(dga::strFindIgnoreCase(haystack, "AKEEPALIVE"), 99u);
+    EXPECT_EQ(dga::strFindIgnoreCase(haystack, "alive"), 104u);
+}
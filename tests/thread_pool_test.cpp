@@ -0,0 +1,115 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <gtest/gtest.h>
+#include <dga/thread_pool.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+TEST(WaitGroup, Threads) {
+    constexpr int kThreads = 4;
+    dga::WaitGroup group{kThreads};
+    EXPECT_FALSE(group.try_wait());
+    std::atomic<int> counter{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&] {
+            counter++;
+            group.done();
+        });
+    }
+    group.wait();
+    EXPECT_TRUE(group.try_wait());
+    EXPECT_EQ(counter, kThreads);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+TEST(ThreadPool, DefaultThreadCount) {
+    dga::ThreadPool pool;
+    EXPECT_GE(pool.thread_count(), 1);
+}
+
+TEST(ThreadPool, Submit) {
+    constexpr int kTasks = 1000;
+    dga::ThreadPool pool{4};
+    EXPECT_EQ(pool.thread_count(), 4);
+    dga::WaitGroup group;
+    std::atomic<int> counter{0};
+    for (int i = 0; i < kTasks; ++i) {
+        pool.submit(group, [&] { counter++; });
+    }
+    pool.wait(group);
+    EXPECT_EQ(counter, kTasks);
+}
+
+TEST(ThreadPool, SubmitMoveOnly) {
+    dga::ThreadPool pool{2};
+    dga::WaitGroup group;
+    auto value = std::make_unique<int>(42);
+    int result = 0;
+    pool.submit(group, [&result, value = std::move(value)] { result = *value; });
+    pool.wait(group);
+    EXPECT_EQ(result, 42);
+}
+
+TEST(ThreadPool, DestructorRunsPendingTasks) {
+    std::atomic<int> counter{0};
+    {
+        dga::ThreadPool pool{2};
+        for (int i = 0; i < 100; ++i) {
+            pool.submit([&] { counter++; });
+        }
+    }
+    EXPECT_EQ(counter, 100);
+}
+
+TEST(ThreadPool, NestedSubmit) {
+    constexpr int kOuter = 16;
+    constexpr int kInner = 64;
+    dga::ThreadPool pool{4};
+    dga::WaitGroup group;
+    std::atomic<int> counter{0};
+    for (int i = 0; i < kOuter; ++i) {
+        pool.submit(group, [&] {
+            dga::WaitGroup inner;
+            for (int j = 0; j < kInner; ++j) {
+                pool.submit(inner, [&] { counter++; });
+            }
+            pool.wait(inner);
+        });
+    }
+    pool.wait(group);
+    EXPECT_EQ(counter, kOuter * kInner);
+}
+
+TEST(ThreadPool, ParallelFor) {
+    constexpr int kCount = 100000;
+    dga::ThreadPool pool{4};
+    std::vector<int> values(kCount, 0);
+    pool.parallel_for(0, kCount, 256, [&](int i) { values[i] += i; });
+    for (int i = 0; i < kCount; ++i) {
+        ASSERT_EQ(values[i], i);
+    }
+
+    // Empty ranges and ranges smaller than the grain size.
+    int calls = 0;
+    pool.parallel_for(5, 5, 1, [&](int) { calls++; });
+    pool.parallel_for(5, 0, 1, [&](int) { calls++; });
+    EXPECT_EQ(calls, 0);
+    pool.parallel_for(0, 3, 100, [&](int) { calls++; });
+    EXPECT_EQ(calls, 3);
+}
+
+TEST(ThreadPool, NestedParallelFor) {
+    dga::ThreadPool pool{4};
+    std::atomic<long long> sum{0};
+    pool.parallel_for(std::size_t(0), std::size_t(64), std::size_t(1), [&](std::size_t i) {
+        pool.parallel_for(std::size_t(0), std::size_t(100), std::size_t(10),
+                          [&](std::size_t j) { sum += static_cast<long long>(i * j); });
+    });
+    EXPECT_EQ(sum, (63 * 64 / 2) * (99 * 100 / 2));
+}
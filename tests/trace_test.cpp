@@ -0,0 +1,230 @@
+/* Base library
+ * Written by David Avedissian (c) 2018-2020 (git@dga.dev)  */
+#include <gtest/gtest.h>
+#include <dga/trace.h>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef DGA_ENABLE_TRACING
+#error "trace_test must be built with DGA_ENABLE_TRACING"
+#endif
+
+namespace {
+const dga::TraceSite* findSite(const char* name) {
+    const dga::TraceSite* found = nullptr;
+    dga::TraceSite::forEach([&](const dga::TraceSite& site) {
+        if (std::strcmp(site.name(), name) == 0) {
+            found = &site;
+        }
+    });
+    return found;
+}
+
+std::size_t countEvents(const std::vector<dga::TraceEvent>& events, const char* name) {
+    return std::size_t(std::count_if(events.begin(), events.end(), [&](const dga::TraceEvent& e) {
+        return std::strcmp(e.name, name) == 0;
+    }));
+}
+
+void tracedFunction() {
+    DGA_TRACE_SCOPE("tracedFunction");
+}
+}  // namespace
+
+TEST(LatencyHistogram, Buckets) {
+    using H = dga::LatencyHistogram;
+    for (dga::u64 value : {dga::u64(0), dga::u64(1), dga::u64(31), dga::u64(32), dga::u64(33),
+                           dga::u64(1000), dga::u64(123456789), ~dga::u64(0)}) {
+        const std::size_t index = H::bucketIndex(value);
+        ASSERT_LT(index, H::kBucketCount);
+        EXPECT_LE(H::bucketLowerBound(index), value);
+        EXPECT_GE(H::bucketUpperBound(index), value);
+    }
+    // Buckets are contiguous.
+    for (std::size_t i = 1; i < H::kBucketCount; ++i) {
+        ASSERT_EQ(H::bucketLowerBound(i), H::bucketUpperBound(i - 1) + 1);
+    }
+    EXPECT_EQ(H::bucketUpperBound(H::kBucketCount - 1), ~dga::u64(0));
+}
+
+TEST(LatencyHistogram, Percentiles) {
+    dga::LatencyHistogram histogram;
+    EXPECT_EQ(histogram.percentile(0.5), 0);
+    EXPECT_EQ(histogram.min(), 0);
+    for (dga::u64 i = 1; i <= 10000; ++i) {
+        histogram.record(i * 1000);
+    }
+    EXPECT_EQ(histogram.count(), 10000);
+    EXPECT_EQ(histogram.min(), 1000);
+    EXPECT_EQ(histogram.max(), 10000000);
+    EXPECT_DOUBLE_EQ(histogram.mean(), 5000500.0);
+    const auto within = [](dga::u64 actual, double expected) {
+        return std::abs(double(actual) - expected) <= expected / 32;
+    };
+    EXPECT_TRUE(within(histogram.percentile(0.5), 5000000));
+    EXPECT_TRUE(within(histogram.percentile(0.99), 9900000));
+    EXPECT_TRUE(within(histogram.percentile(0.999), 9990000));
+    EXPECT_EQ(histogram.percentile(1.0), 10000000);
+
+    dga::LatencyHistogram other;
+    other.record(1, 10000);
+    histogram.merge(other);
+    EXPECT_EQ(histogram.count(), 20000);
+    EXPECT_EQ(histogram.min(), 1);
+    EXPECT_EQ(histogram.percentile(0.25), 1);
+    histogram.reset();
+    EXPECT_EQ(histogram.count(), 0);
+}
+
+TEST(AtomicLatencyHistogram, ConcurrentRecords) {
+    static dga::AtomicLatencyHistogram histogram;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([t] {
+            for (dga::u64 i = 0; i < 10000; ++i) {
+                histogram.record(i + dga::u64(t));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const dga::LatencyHistogram snapshot = histogram.load();
+    EXPECT_EQ(snapshot.count(), 40000);
+    EXPECT_EQ(snapshot.min(), 0);
+    EXPECT_EQ(snapshot.max(), 10002);
+    histogram.reset();
+    EXPECT_EQ(histogram.load().count(), 0);
+}
+
+TEST(AtomicLatencyHistogram, RecordExclusive) {
+    dga::AtomicLatencyHistogram histogram;
+    for (dga::u64 value : {dga::u64(5), dga::u64(1), dga::u64(1000)}) {
+        histogram.recordExclusive(value);
+    }
+    const dga::LatencyHistogram snapshot = histogram.load();
+    EXPECT_EQ(snapshot.count(), 3);
+    EXPECT_EQ(snapshot.min(), 1);
+    EXPECT_EQ(snapshot.max(), 1000);
+    EXPECT_DOUBLE_EQ(snapshot.mean(), 1006.0 / 3);
+}
+
+TEST(Trace, ScopeRecordsIntervals) {
+    for (int i = 0; i < 100; ++i) {
+        tracedFunction();
+    }
+    const dga::TraceSite* site = findSite("tracedFunction");
+    ASSERT_NE(site, nullptr);
+    EXPECT_EQ(site->histogram().count(), 100);
+
+    const std::vector<dga::TraceEvent> events = dga::collectTraceEvents();
+    EXPECT_EQ(countEvents(events, "tracedFunction"), 100);
+    EXPECT_TRUE(std::is_sorted(events.begin(), events.end(),
+                               [](const dga::TraceEvent& a, const dga::TraceEvent& b) {
+                                   return a.begin < b.begin;
+                               }));
+    for (const dga::TraceEvent& event : events) {
+        EXPECT_LE(event.begin, event.end);
+    }
+}
+
+TEST(Trace, NestedScopes) {
+    {
+        DGA_TRACE_SCOPE("outer");
+        {
+            DGA_TRACE_SCOPE("inner");
+            DGA_TRACE_SCOPE("inner sibling");
+        }
+    }
+    const std::vector<dga::TraceEvent> events = dga::collectTraceEvents();
+    auto find = [&](const char* name) {
+        return *std::find_if(events.begin(), events.end(), [&](const dga::TraceEvent& e) {
+            return std::strcmp(e.name, name) == 0;
+        });
+    };
+    const dga::TraceEvent outer = find("outer");
+    const dga::TraceEvent inner = find("inner");
+    EXPECT_LE(outer.begin, inner.begin);
+    EXPECT_GE(outer.end, inner.end);
+    EXPECT_EQ(outer.thread_id, inner.thread_id);
+}
+
+TEST(Trace, RingBufferKeepsLatestEvents) {
+    constexpr std::size_t kCount = dga::detail::TraceBuffer::kCapacity + 1000;
+    std::thread thread{[] {
+        for (std::size_t i = 0; i < kCount; ++i) {
+            DGA_TRACE_SCOPE("ring");
+        }
+    }};
+    thread.join();
+    const std::vector<dga::TraceEvent> events = dga::collectTraceEvents();
+    // The oldest event in a full buffer may be dropped, as a reader can't tell whether the writer is
+    // about to overwrite it.
+    EXPECT_GE(countEvents(events, "ring"), dga::detail::TraceBuffer::kCapacity - 1);
+    EXPECT_LE(countEvents(events, "ring"), dga::detail::TraceBuffer::kCapacity);
+    EXPECT_EQ(findSite("ring")->histogram().count(), kCount);
+}
+
+TEST(Trace, ThreadsHaveSeparateIds) {
+    std::vector<dga::u32> ids(2);
+    for (int t = 0; t < 2; ++t) {
+        std::thread thread{[] { DGA_TRACE_SCOPE("per thread"); }};
+        thread.join();
+    }
+    std::vector<dga::u32> seen;
+    for (const dga::TraceEvent& event : dga::collectTraceEvents()) {
+        if (std::strcmp(event.name, "per thread") == 0) {
+            seen.emplace_back(event.thread_id);
+        }
+    }
+    ASSERT_EQ(seen.size(), 2);
+    EXPECT_NE(seen[0], seen[1]);
+}
+
+TEST(Trace, HistogramMergesThreads) {
+    constexpr int kThreads = 4;
+    constexpr int kCalls = 1000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([] {
+            for (int i = 0; i < kCalls; ++i) {
+                DGA_TRACE_SCOPE("shared site");
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    // The threads have exited, but their histograms are kept.
+    const dga::TraceSite* site = findSite("shared site");
+    ASSERT_NE(site, nullptr);
+    EXPECT_EQ(site->histogram().count(), kThreads * kCalls);
+}
+
+TEST(Trace, ChromeTraceJson) {
+    {
+        DGA_TRACE_SCOPE("json \"quoted\"");
+    }
+    std::ostringstream out;
+    dga::writeChromeTrace(out);
+    const std::string json = out.str();
+    EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0);
+    EXPECT_NE(json.find("{\"name\":\"json \\\"quoted\\\"\",\"ph\":\"X\",\"pid\":1,\"tid\":"),
+              std::string::npos);
+    EXPECT_EQ(json.substr(json.size() - 4), "\n]}\n");
+}
+
+TEST(Trace, Summary) {
+    tracedFunction();
+    std::ostringstream out;
+    dga::writeTraceSummary(out);
+    EXPECT_NE(out.str().find("tracedFunction: count="), std::string::npos);
+    EXPECT_NE(out.str().find(" p99="), std::string::npos);
+    EXPECT_GT(dga::TraceClock::nanosecondsPerTick(), 0.0);
+}